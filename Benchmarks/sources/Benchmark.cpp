@@ -0,0 +1,114 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Benchmark.h"
+#include "Mona/File.h"
+#include <chrono>
+
+using namespace std;
+
+static atomic<Mona::UInt64> _Allocations(0);
+static atomic<Mona::UInt64> _AllocatedBytes(0);
+
+// Global replacement to count allocations of the whole process (MonaBase and MonaCore shared libraries included)
+void* operator new(size_t size) {
+	_Allocations.fetch_add(1, memory_order_relaxed);
+	_AllocatedBytes.fetch_add(size, memory_order_relaxed);
+	void* pMemory = malloc(size ? size : 1);
+	if (!pMemory)
+		throw bad_alloc();
+	return pMemory;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept { try { return operator new(size); } catch (...) { return NULL; } }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return operator new(size, nothrow); }
+void operator delete(void* pMemory) noexcept { free(pMemory); }
+void operator delete[](void* pMemory) noexcept { free(pMemory); }
+void operator delete(void* pMemory, size_t) noexcept { free(pMemory); }
+void operator delete[](void* pMemory, size_t) noexcept { free(pMemory); }
+
+namespace Mona {
+
+UInt64 Benchmark::Allocations() { return _Allocations.load(memory_order_relaxed); }
+UInt64 Benchmark::AllocatedBytes() { return _AllocatedBytes.load(memory_order_relaxed); }
+
+void Benchmark::Test::run(UInt32 minTime, string& result) {
+	DEBUG(name, " now running during ", minTime, "ms...");
+	BenchFunction(); // warm up, creates static fixtures
+
+	UInt64 iterations(0), units(0);
+	UInt64 allocations(Allocations()), bytes(AllocatedBytes());
+	chrono::steady_clock::time_point start(chrono::steady_clock::now());
+	Int64 elapsed;
+	do {
+		units += BenchFunction();
+		++iterations;
+	} while ((elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()) < Int64(minTime) * 1000000);
+	allocations = Allocations() - allocations;
+	bytes = AllocatedBytes() - bytes;
+
+	if (!units)
+		WARN(name, " has processed no ", unit);
+	double count(units ? double(units) : 1);
+	String ns(String::Format<double>("%.1f", elapsed / count)), allocated(String::Format<double>("%.1f", bytes / count)), allocs(String::Format<double>("%.2f", allocations / count));
+	// one JSON object by line, sorted by name, to allow a diff between two runs
+	String::Append(result, "{\"name\":\"", name, "\",\"unit\":\"", unit, "\",\"iterations\":", iterations, ",\"units\":", units,
+		",\"ns\":", ns, ",\"bytes\":", allocated, ",\"allocations\":", allocs, "}\n");
+	NOTE(name, " ", ns, " ns/", unit, ", ", allocated, " bytes/", unit, ", ", allocs, " allocations/", unit, " (x", iterations, ")");
+}
+
+int Benchmark::main() {
+	UInt32 minTime(1000);
+	getNumber("arguments.time", minTime);
+	const char* filter = getString("arguments.filter");
+
+	string results;
+	for (auto& it : Benchmarks()) {
+		if (!filter || String::ICompare(it.first, filter, strlen(filter)) == 0)
+			it.second->run(minTime, results);
+	}
+
+	const char* output = getString("arguments.output");
+	if (output) {
+		Exception ex;
+		File file(output, File::MODE_WRITE);
+		if (!file.write(ex, results.data(), results.size())) {
+			ERROR(ex);
+			return EXIT_CANTCREAT;
+		}
+	} else
+		cout << results;
+	return EXIT_OK;
+}
+
+void Benchmark::defineOptions(Exception& ex, Options& options) {
+
+	options.add(ex, "filter", "f", "Run only benchmarks whose name starts with this prefix (FLV, AMF...), case insensitive.")
+		.argument("prefix");
+
+	options.add(ex, "time", "t", "Minimal measure time of every benchmark in milliseconds. Default value is 1000.")
+		.argument("ms");
+
+	options.add(ex, "output", "o", "File where writing results (one JSON object by benchmark and by line), on standard output otherwise.")
+		.argument("file");
+
+	// defines here your options applications
+	Application::defineOptions(ex, options);
+}
+
+} // namespace Mona
@@ -0,0 +1,84 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#pragma once
+
+#include "Mona/Application.h"
+
+namespace Mona {
+
+/*!
+Microbenchmarks runner, every benchmark returns the number of units (frames, messages...) processed by one call,
+it's repeated until a minimal time and results are given by unit: nanoseconds, allocated bytes and allocations.
+Allocations are counted process-wide by a global operator new replacement (see Benchmark.cpp) */
+struct Benchmark : private Application {
+	struct Test : virtual Object {
+		Test(const char* name, const char* unit) : name(name), unit(unit) {}
+
+		const char* name;
+		const char* unit;
+
+		/*!
+		Warm up one time (fixtures creation is excluded from measure), then repeat during at least minTime ms */
+		void run(UInt32 minTime, std::string& result);
+	private:
+		virtual UInt32 BenchFunction() = 0;
+	};
+
+	template<typename BenchType>
+	static bool AddBenchmark(const char* name, const char* unit) {
+		Benchmarks().emplace(SET, std::forward_as_tuple(name), std::forward_as_tuple(std::make_unique<BenchType>(name, unit)));
+		return true;
+	}
+	static int Run(const std::string& version, int argc, const char* argv[]) {
+		static Benchmark App(version);
+		return App.run(argc, argv);
+	};
+
+	static UInt64 Allocations();
+	static UInt64 AllocatedBytes();
+
+private:
+	Benchmark(const std::string& version) : _version(version) { setString("description", "MonaCore microbenchmarks"); }
+
+	static std::map<std::string, unique<Test>, String::IComparator>& Benchmarks() {
+		static std::map<std::string, unique<Test>, String::IComparator> _Benchmarks;
+		return _Benchmarks;
+	}
+
+	///// MAIN
+	int main();
+
+	const char* defineVersion() { return _version.c_str(); }
+
+	void defineOptions(Exception& ex, Options& options);
+
+	const std::string	_version;
+};
+
+/// Macro for adding new benchmarks in a Bench cpp, UNIT is the name of the unit counted by the returned value
+#define ADD_BENCHMARK(NAME, UNIT) struct NAME##BENCH : Benchmark::Test { \
+	NAME##BENCH(const char* name, const char* unit) : Benchmark::Test(name, unit) {}\
+	UInt32 BenchFunction();\
+private:\
+	static const bool _BenchCreated;\
+};\
+const bool NAME##BENCH::_BenchCreated = Benchmark::AddBenchmark<NAME##BENCH>(#NAME, UNIT);\
+UInt32 NAME##BENCH::BenchFunction()
+
+} // namespace Mona
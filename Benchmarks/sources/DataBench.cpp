@@ -0,0 +1,102 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Benchmark.h"
+#include "Mona/AMFWriter.h"
+#include "Mona/AMFReader.h"
+#include "Mona/JSONWriter.h"
+#include "Mona/JSONReader.h"
+
+using namespace Mona;
+using namespace std;
+
+namespace DataBench {
+
+#define MESSAGES 100 // by call
+
+/*!
+RTMP onMetaData message of a usual encoder */
+static void WriteMetaData(DataWriter& writer) {
+	writer.writeString(EXPAND("onMetaData"));
+	writer.beginObject();
+	writer.writeNumberProperty("duration", 0);
+	writer.writeNumberProperty("width", 1280);
+	writer.writeNumberProperty("height", 720);
+	writer.writeNumberProperty("videodatarate", 2500);
+	writer.writeNumberProperty("framerate", 25);
+	writer.writeNumberProperty("videocodecid", 7);
+	writer.writeNumberProperty("audiodatarate", 128);
+	writer.writeNumberProperty("audiosamplerate", 44100);
+	writer.writeNumberProperty("audiosamplesize", 16);
+	writer.writeBooleanProperty("stereo", true);
+	writer.writeNumberProperty("audiocodecid", 10);
+	writer.writeStringProperty("encoder", "Lavf58.29.100");
+	writer.writeNumberProperty("filesize", 0);
+	writer.writePropertyName("keyframes");
+	writer.beginArray(10);
+	for (UInt8 i = 0; i < 10; ++i)
+		writer.writeNumber(i * 2.0);
+	writer.endArray();
+	writer.endObject();
+}
+
+template<typename WriterType, typename ...Args>
+static Packet Message(Args... args) {
+	shared<Buffer> pBuffer(SET);
+	{
+		WriterType writer(*pBuffer, args ...);
+		WriteMetaData(writer);
+	} // JSONWriter closes its array on destruction
+	return Packet(pBuffer);
+}
+
+template<typename WriterType, typename ...Args>
+static UInt32 Write(Args... args) {
+	for (UInt32 i = 0; i < MESSAGES; ++i) {
+		shared<Buffer> pBuffer(SET);
+		WriterType writer(*pBuffer, args ...);
+		WriteMetaData(writer);
+	}
+	return MESSAGES;
+}
+
+template<typename ReaderType>
+static UInt32 Read(const Packet& message) {
+	for (UInt32 i = 0; i < MESSAGES; ++i)
+		ReaderType(message).read(DataWriter::Null());
+	return MESSAGES;
+}
+
+ADD_BENCHMARK(AMF0Writer, "message") { return Write<AMFWriter>(true); }
+ADD_BENCHMARK(AMF3Writer, "message") { return Write<AMFWriter>(false); }
+ADD_BENCHMARK(JSONWriter, "message") { return Write<JSONWriter>(); }
+
+ADD_BENCHMARK(AMF0Reader, "message") {
+	static const Packet _Message(Message<AMFWriter>(true));
+	return Read<AMFReader>(_Message);
+}
+ADD_BENCHMARK(AMF3Reader, "message") {
+	static const Packet _Message(Message<AMFWriter>(false));
+	return Read<AMFReader>(_Message);
+}
+ADD_BENCHMARK(JSONReader, "message") {
+	static const Packet _Message(Message<JSONWriter>());
+	return Read<JSONReader>(_Message);
+}
+
+}
@@ -0,0 +1,150 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Fixture.h"
+#include "Mona/MPEG4.h"
+
+using namespace std;
+
+namespace Mona {
+
+#define DURATION	10000 // ms
+
+// Baseline 640x480 parameters
+static const UInt8 SPS[] = { 0x67, 0x42, 0x00, 0x1E, 0x95, 0xA8, 0x28, 0x0F, 0x64 };
+static const UInt8 PPS[] = { 0x68, 0xCE, 0x3C, 0x80 };
+
+static void Fill(Buffer& buffer, UInt32 size, UInt32& seed) {
+	// deterministic pseudo random bytes in [1, 254] range: never a NAL start code or a MP3 sync word
+	UInt32 position = buffer.size();
+	buffer.resize(position + size);
+	UInt8* data = buffer.data() + position;
+	while (size--) {
+		seed = seed * 1103515245 + 12345;
+		*data++ = UInt8(1 + (seed >> 16) % 254);
+	}
+}
+
+Fixture::Fixture(UInt8 content) : count(0) {
+	UInt32 seed(1);
+	vector<unique<Media::Base>> videos, audios;
+
+	if (content & VIDEO) {
+		Media::Video::Tag tag(Media::Video::CODEC_H264);
+		tag.frame = Media::Video::FRAME_CONFIG;
+		shared<Buffer> pBuffer(SET);
+		BinaryWriter writer(*pBuffer);
+		writer.write32(sizeof(SPS)).write(SPS, sizeof(SPS)).write32(sizeof(PPS)).write(PPS, sizeof(PPS)); // Mona config format, NALs with their size
+		videos.emplace_back(make_unique<Media::Video>(tag, Packet(pBuffer)));
+		for (UInt32 i = 0; i < DURATION / 40; ++i) {
+			tag.time = i * 40;
+			tag.frame = (i % 50) ? Media::Video::FRAME_INTER : Media::Video::FRAME_KEY;
+			UInt32 size = tag.frame == Media::Video::FRAME_KEY ? 60000 : (8000 + ((i * 37) % 11) * 200);
+			pBuffer.set();
+			BinaryWriter(*pBuffer).write32(size - 4).write8(tag.frame == Media::Video::FRAME_KEY ? 0x65 : 0x41);
+			Fill(*pBuffer, size - 5, seed);
+			videos.emplace_back(make_unique<Media::Video>(tag, Packet(pBuffer)));
+		}
+	} else if (content & TEXT) {
+		// time tags for subtitles writers
+		Media::Video::Tag tag(Media::Video::CODEC_H264);
+		for (UInt32 time = 0; time < DURATION; time += 1000) {
+			tag.time = time;
+			videos.emplace_back(make_unique<Media::Video>(tag, Packet::Null()));
+		}
+	}
+
+	if (content & AAC) {
+		Media::Audio::Tag tag(Media::Audio::CODEC_AAC);
+		tag.rate = 44100;
+		tag.channels = 2;
+		tag.isConfig = true;
+		shared<Buffer> pBuffer(SET);
+		pBuffer->resize(2);
+		MPEG4::WriteAudioConfig(2, tag.rate, tag.channels, pBuffer->data()); // AAC-LC
+		audios.emplace_back(make_unique<Media::Audio>(tag, Packet(pBuffer)));
+		tag.isConfig = false;
+		for (UInt32 i = 0; (tag.time = UInt32(UInt64(i) * 1024 * 1000 / tag.rate)) < DURATION; ++i) {
+			pBuffer.set();
+			Fill(*pBuffer, 340 + (i * 13) % 64, seed);
+			audios.emplace_back(make_unique<Media::Audio>(tag, Packet(pBuffer)));
+		}
+	} else if (content & MP3) {
+		Media::Audio::Tag tag(Media::Audio::CODEC_MP3);
+		tag.rate = 44100;
+		tag.channels = 2;
+		for (UInt32 i = 0; (tag.time = UInt32(UInt64(i) * 1152 * 1000 / tag.rate)) < DURATION; ++i) {
+			shared<Buffer> pBuffer(SET);
+			pBuffer->append(EXPAND("\xFF\xFB\x90\x64")); // MPEG-1 layer 3, 128kbps, 44.1kHz, no padding => 417 bytes
+			Fill(*pBuffer, 413, seed);
+			audios.emplace_back(make_unique<Media::Audio>(tag, Packet(pBuffer)));
+		}
+	}
+
+	// interleave by time, video first on same time
+	auto itVideo = videos.begin(), itAudio = audios.begin();
+	while (itVideo != videos.end() || itAudio != audios.end()) {
+		auto& it = (itAudio == audios.end() || (itVideo != videos.end() && ((Media::Video&)**itVideo).tag.time <= ((Media::Audio&)**itAudio).tag.time)) ? itVideo : itAudio;
+		if (**it)
+			++count;
+		medias.emplace_back(move(*it++));
+		if (!(content & TEXT) || &it != &itVideo)
+			continue;
+		// subtitle after every second video time
+		UInt32 time = ((Media::Video&)*medias.back()).tag.time;
+		if (time % 1000)
+			continue;
+		shared<Buffer> pBuffer(SET);
+		String::Append(*pBuffer, "Subtitle ", time / 1000, " of the benchmark fixture");
+		medias.emplace_back(make_unique<Media::Data>(Media::Data::TYPE_TEXT, Packet(pBuffer), 1));
+		++count;
+	}
+}
+
+void Fixture::write(MediaWriter& writer, const MediaWriter::OnWrite& onWrite, bool multiTracks) const {
+	writer.beginMedia(onWrite);
+	for (const unique<Media::Base>& pMedia : medias) {
+		UInt8 track = multiTracks ? pMedia->track : 0;
+		switch (pMedia->type) {
+			case Media::TYPE_AUDIO:
+				writer.writeAudio(track, ((const Media::Audio&)*pMedia).tag, *pMedia, onWrite);
+				break;
+			case Media::TYPE_VIDEO:
+				writer.writeVideo(track, ((const Media::Video&)*pMedia).tag, *pMedia, onWrite);
+				break;
+			default:
+				writer.writeData(track, ((const Media::Data&)*pMedia).tag, *pMedia, onWrite);
+		}
+	}
+	writer.endMedia(onWrite);
+}
+
+Recording::Recording(const Fixture& fixture, MediaWriter& writer, bool multiTracks) {
+	shared<Buffer> pBuffer(SET);
+	fixture.write(writer, [&pBuffer](const Packet& packet) { pBuffer->append(packet.data(), packet.size()); }, multiTracks);
+	stream.set(pBuffer);
+}
+
+Recording::Recording(const Fixture& fixture) {
+	shared<Buffer> pBuffer(SET);
+	for (const unique<Media::Base>& pMedia : fixture.medias)
+		pBuffer->append(pMedia->data(), pMedia->size());
+	stream.set(pBuffer);
+}
+
+} // namespace Mona
@@ -0,0 +1,64 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Media.h"
+#include "Mona/MediaWriter.h"
+
+namespace Mona {
+
+/*!
+Synthetic live stream of 10 seconds with realistic frame sizes and timestamps, medias interleaved by time:
+- VIDEO, H264 25fps ~2Mbps with a key frame every 2 seconds, SPS and PPS config first
+- AAC, 44.1kHz stereo ~128kbps, AudioSpecificConfig first
+- MP3, 44.1kHz stereo 128kbps, MPEG-1 layer 3 frames with their header
+- TEXT, one subtitle by second (timed by an empty video tag when there is no VIDEO, as SRT/VTT writers expect)
+Payloads contain no zero byte to never emulate a NAL start code */
+struct Fixture : virtual Object {
+	enum Content : UInt8 {
+		VIDEO	= 1,
+		AAC		= 2,
+		MP3		= 4,
+		TEXT	= 8
+	};
+	Fixture(UInt8 content);
+
+	/*!
+	Write the whole fixture from beginMedia to endMedia,
+	multiTracks=false writes on track 0 for single track writers (MediaTrackWriter as NAL or ADTS) */
+	void write(MediaWriter& writer, const MediaWriter::OnWrite& onWrite, bool multiTracks = true) const;
+
+	std::vector<unique<Media::Base>>	medias;
+	/*!
+	Medias count excepting empty time tags of subtitles */
+	UInt32								count;
+};
+
+/*!
+Fixture serialized one time by a writer to feed its reader,
+or raw concatenation of media packets without writer (MP3 elementary stream) */
+struct Recording : virtual Object {
+	Recording(const Fixture& fixture, MediaWriter& writer, bool multiTracks = true);
+	Recording(const Fixture& fixture);
+
+	Packet stream;
+};
+
+} // namespace Mona
@@ -0,0 +1,190 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Benchmark.h"
+#include "Fixture.h"
+#include "Mona/MediaReader.h"
+#include "Mona/Segment.h"
+#include "Mona/MPEG4.h"
+#include "Mona/RTPWriter.h"
+#include "Mona/RTP_H264.h"
+#include "Mona/RTP_AAC.h"
+#include "Mona/RTP_MPEG.h"
+
+using namespace Mona;
+using namespace std;
+
+namespace MediaBench {
+
+#define CHUNK_SIZE 0xFFFF // like a socket reception
+
+/*!
+Count the medias given by a reader */
+struct Counter : Media::Source, virtual Object {
+	Counter() : count(0) {}
+	UInt32 count;
+private:
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) { ++count; }
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) { ++count; }
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track) { ++count; }
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) {}
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track) {}
+	void flush() {}
+	void reset() {}
+};
+
+static const Fixture& AudioVideo() { static const Fixture _Fixture(Fixture::VIDEO | Fixture::AAC); return _Fixture; }
+static const Fixture& Video() { static const Fixture _Fixture(Fixture::VIDEO); return _Fixture; }
+static const Fixture& AAC() { static const Fixture _Fixture(Fixture::AAC); return _Fixture; }
+static const Fixture& MP3() { static const Fixture _Fixture(Fixture::MP3); return _Fixture; }
+static const Fixture& Text() { static const Fixture _Fixture(Fixture::TEXT); return _Fixture; }
+
+static UInt32 Write(MediaWriter& writer, const Fixture& fixture, bool multiTracks = true) {
+	fixture.write(writer, [](const Packet& packet) {}, multiTracks);
+	return fixture.count;
+}
+
+static UInt32 Read(MediaReader& reader, const Recording& recording) {
+	Counter counter;
+	for (UInt32 position = 0; position < recording.stream.size(); position += CHUNK_SIZE)
+		reader.read(Packet(recording.stream, recording.stream.data() + position, min<UInt32>(CHUNK_SIZE, recording.stream.size() - position)), counter);
+	reader.flush(counter);
+	return counter.count;
+}
+
+// WRITERS
+
+ADD_BENCHMARK(FLVWriter, "frame") { return Write(*MediaWriter::New("flv"), AudioVideo()); }
+ADD_BENCHMARK(TSWriter, "frame") { return Write(*MediaWriter::New("ts"), AudioVideo()); }
+ADD_BENCHMARK(MP4Writer, "frame") { return Write(*MediaWriter::New("mp4"), AudioVideo()); }
+ADD_BENCHMARK(MonaWriter, "frame") { return Write(*MediaWriter::New("mona"), AudioVideo()); }
+ADD_BENCHMARK(NALWriter, "frame") { return Write(*MediaWriter::New("h264"), Video(), false); }
+ADD_BENCHMARK(ADTSWriter, "frame") { return Write(*MediaWriter::New("aac"), AAC(), false); }
+ADD_BENCHMARK(SRTWriter, "cue") { return Write(*MediaWriter::New("srt"), Text()); }
+ADD_BENCHMARK(VTTWriter, "cue") { return Write(*MediaWriter::New("vtt"), Text()); }
+ADD_BENCHMARK(RTP_H264Writer, "frame") { RTPWriter<RTP_H264> writer(96); return Write(writer, Video()); }
+ADD_BENCHMARK(RTP_AACWriter, "frame") { RTPWriter<RTP_AAC> writer(97); return Write(writer, AAC()); }
+ADD_BENCHMARK(RTP_MPEGWriter, "frame") { RTPWriter<RTP_MPEG> writer(14); return Write(writer, MP3()); }
+
+// READERS, fed with the output of their writer (RTP profiles have no parsing implemented yet)
+
+ADD_BENCHMARK(FLVReader, "frame") {
+	static const Recording _Recording(AudioVideo(), *MediaWriter::New("flv"));
+	return Read(*MediaReader::New("flv"), _Recording);
+}
+ADD_BENCHMARK(TSReader, "frame") {
+	static const Recording _Recording(AudioVideo(), *MediaWriter::New("ts"));
+	return Read(*MediaReader::New("ts"), _Recording);
+}
+ADD_BENCHMARK(MP4Reader, "frame") {
+	static const Recording _Recording(AudioVideo(), *MediaWriter::New("mp4"));
+	return Read(*MediaReader::New("mp4"), _Recording);
+}
+ADD_BENCHMARK(MonaReader, "frame") {
+	static const Recording _Recording(AudioVideo(), *MediaWriter::New("mona"));
+	return Read(*MediaReader::New("mona"), _Recording);
+}
+ADD_BENCHMARK(NALReader, "frame") {
+	static const Recording _Recording(Video(), *MediaWriter::New("h264"), false);
+	return Read(*MediaReader::New("h264"), _Recording);
+}
+ADD_BENCHMARK(ADTSReader, "frame") {
+	static const Recording _Recording(AAC(), *MediaWriter::New("aac"), false);
+	return Read(*MediaReader::New("aac"), _Recording);
+}
+ADD_BENCHMARK(MP3Reader, "frame") {
+	static const Recording _Recording(MP3()); // elementary stream, MP3 frames have their header
+	return Read(*MediaReader::New("mp3"), _Recording);
+}
+ADD_BENCHMARK(SRTReader, "cue") {
+	static const Recording _Recording(Text(), *MediaWriter::New("srt"));
+	return Read(*MediaReader::New("srt"), _Recording);
+}
+ADD_BENCHMARK(VTTReader, "cue") {
+	static const Recording _Recording(Text(), *MediaWriter::New("vtt"));
+	return Read(*MediaReader::New("vtt"), _Recording);
+}
+
+// SCANNING, Annex B start codes as NALNetReader does it on TS payloads (see MPEG4::FindStartCode)
+
+ADD_BENCHMARK(StartCodeScan, "NAL") {
+	static const Recording _Recording(Video(), *MediaWriter::New("h264"), false);
+	const Packet& stream = _Recording.stream;
+	UInt32 count = 0;
+	UInt8 zeros = 0;
+	for (UInt32 position = 0; position < stream.size(); position += 184) {
+		const UInt8* cur = stream.data() + position;
+		const UInt8* end = cur + min<UInt32>(184, stream.size() - position);
+		while ((cur = MPEG4::FindStartCode(cur, end, zeros))) {
+			zeros = 0;
+			++count;
+		}
+	}
+	return count;
+}
+
+// SEGMENT, live segment in memory (see Segments): bytes and allocations by media added, and iteration
+
+static const Media::Properties& Properties() {
+	static Media::Properties _Properties;
+	if (!_Properties.count()) {
+		_Properties.setNumber("width", 1280);
+		_Properties.setNumber("height", 720);
+		_Properties.setNumber("framerate", 25);
+		_Properties.setNumber("audiosamplerate", 44100);
+		_Properties.setNumber("audiochannels", 2);
+	}
+	return _Properties;
+}
+
+static Segment& Fill(Segment& segment, const Fixture& fixture) {
+	// properties first, as Segments rewrites them at the beginning of every segment
+	Media::Data::Type type(Media::Data::TYPE_UNKNOWN);
+	const Packet& properties = Properties().data(type);
+	segment.add(type, properties, 0, true);
+	for (const unique<Media::Base>& pMedia : fixture.medias) {
+		switch (pMedia->type) {
+			case Media::TYPE_AUDIO:
+				segment.add(((const Media::Audio&)*pMedia).tag, *pMedia, pMedia->track);
+				break;
+			case Media::TYPE_VIDEO:
+				segment.add(((const Media::Video&)*pMedia).tag, *pMedia, pMedia->track);
+				break;
+			default:
+				segment.add(((const Media::Data&)*pMedia).tag, *pMedia, pMedia->track, ((const Media::Data&)*pMedia).isProperties);
+		}
+	}
+	return segment;
+}
+
+ADD_BENCHMARK(SegmentAdd, "frame") {
+	Segment segment;
+	segment.reserve(AudioVideo().medias.size() + 1); // as Segments does with the count of the previous segment (+ properties)
+	return Fill(segment, AudioVideo()).count();
+}
+ADD_BENCHMARK(SegmentIterate, "frame") {
+	static Segment _Segment;
+	if (!_Segment)
+		Fill(_Segment, AudioVideo());
+	Counter counter;
+	for (const Segment::Record& media : _Segment)
+		media.write(counter);
+	return counter.count;
+}
+
+}
@@ -69,19 +69,76 @@ struct Buffer : Binary, virtual Object {
 		static std::atomic_flag  _Mutex;
 		static unique<Allocator> _PAllocator;
 	};
-private:
+
+	/*!
+	Owner of buffers (protocol, publication, subsystem) to account their live bytes when tagging mode is enabled:
+	- a buffer is accounted to the tag of the Scope of its allocation ("other" without scope), until a new owner adopts it
+	- live bytes by owner are exposed in mona_buffer_bytes metric (see Metrics)
+	Tags are never deleted, a buffer can outlive its owner, so their count is limited to MAX_COUNT: beyond a new owner "prefix/name"
+	shares the common tag of its prefix, named with a star in place of the name, and a new owner without prefix shares "other" */
+	struct Tag : virtual Object {
+		enum { MAX_COUNT = 256 };
+		/*!
+		Get tag of owner, created on first call */
+		static Tag&	Get(const std::string& owner);
+		/*!
+		Disabled by default, enable it before allocations to account */
+		static void	Enable(bool enable) { _Enabled.store(enable, std::memory_order_relaxed); }
+		static bool	Enabled() { return _Enabled.load(std::memory_order_relaxed); }
+
+		const std::string	owner;
+		/*!
+		Capacity of buffers alive owned by this tag */
+		Int64	bytes() const { return _bytes.load(std::memory_order_relaxed); }
+
+		/*!
+		Account the buffer to this tag from now, when it is retained by an other owner than its allocator (publication segments for example) */
+		Tag&	adopt(const shared<const Binary>& pBinary);
+
+		/*!
+		Tag buffers allocated by the current thread during its life-time */
+		struct Scope;
+	private:
+		Tag(const std::string& owner);
+		static Tag& Current() { return _PCurrent ? *_PCurrent : Other(); }
+		static Tag& Other();
+
+		std::atomic<Int64>	_bytes;
+
+		static std::atomic<bool>	_Enabled;
+		static thread_local Tag*	_PCurrent;
+		friend struct Buffer;
+	};
+protected:
+	/*!
+	Static buffer on external data, without deallocation and which can't exceed size */
 	Buffer(UInt32 size, void* buffer);
+private:
+	/*!
+	Account a new allocation of _capacity which replaces oldCapacity (see Tag) */
+	void				account(UInt32 oldCapacity);
 
 	UInt32				_offset;
 	UInt8*				_data;
 	UInt32				_size;
 	UInt32				_capacity;
 	UInt8*				_buffer;
+	std::atomic<Tag*>	_pTag;
 
 
 	friend struct BinaryWriter;
 };
 
+struct Buffer::Tag::Scope : virtual Object {
+	Scope(Tag& tag) : _pPrevious(_PCurrent) { _PCurrent = &tag; }
+	/*!
+	NULL keeps the current tag */
+	Scope(Tag* pTag) : _pPrevious(_PCurrent) { if (pTag) _PCurrent = pTag; }
+	~Scope() { _PCurrent = _pPrevious; }
+private:
+	Tag* _pPrevious;
+};
+
 
 
 
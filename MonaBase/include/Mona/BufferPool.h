@@ -28,10 +28,7 @@ struct BufferPool : Buffer::Allocator, private Thread, virtual Object {
 	~BufferPool() { stop(); }
 
 private:
-	UInt8* alloc(UInt32& capacity) {
-		UInt8* buffer = _buffers[computeIndex(capacity)].pop();
-		return buffer ? buffer : new UInt8[capacity];
-	}
+	UInt8* alloc(UInt32& capacity);
 	void   free(UInt8* buffer, UInt32 capacity) { _buffers[computeIndex(capacity)].push(buffer); }
 
 	bool run(Exception& ex, const volatile bool& requestStop);
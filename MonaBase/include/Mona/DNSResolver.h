@@ -0,0 +1,132 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/HostEntry.h"
+#include "Mona/UDPSocket.h"
+#include "Mona/TCPClient.h"
+#include "Mona/Timer.h"
+#include "Mona/Path.h"
+#include <deque>
+
+namespace Mona {
+
+/*!
+Asynchronous DNS resolver, alternative to blocking DNS::HostByName:
+- speaks DNS protocol with name servers of the system (or setServers) through IOSocket, A and AAAA requests in parallel,
+UDP first and TCP if the answer is truncated
+- hosts file and IP address are resolved without request
+- each request has a random id and its own UDP socket (random ephemeral source port given by the system) against spoofing
+- results are cached according to the TTL of the answers (maxCached hosts), and concurrent resolutions of a same host share the same requests
+Has to be used on the thread of IOSocket handler and timer (the main thread) */
+struct DNSResolver : virtual Object {
+	/*!
+	Resolution result, ex is set on failure (host not found, timeout...) */
+	typedef Event<void(const Exception& ex, const HostEntry& host)> OnResolved;
+
+	DNSResolver(IOSocket& io, const Timer& timer);
+	~DNSResolver();
+
+	IOSocket&	io;
+
+	/*!
+	Name servers, on construction the system ones (resolv.conf on posix), 127.0.0.1:53 otherwise */
+	const std::vector<SocketAddress>& servers() const { return _servers; }
+	void		setServers(const std::vector<SocketAddress>& servers) { _servers = servers; }
+	/*!
+	Timeout in ms before to retry a request on the next server (2000 by default) */
+	UInt32		timeout() const { return _timeout; }
+	void		setTimeout(UInt32 timeout) { _timeout = timeout ? timeout : 1; }
+	/*!
+	Number of tries of a request before to fail (3 by default) */
+	UInt8		attempts() const { return _attempts; }
+	void		setAttempts(UInt8 attempts) { _attempts = attempts ? attempts : 1; }
+
+	/*!
+	Load an hosts file (on construction the system one is loaded), replaces the previous entries */
+	bool		loadHosts(Exception& ex, const Path& path);
+
+	/*!
+	Maximum hosts cached (1024 by default), when full expired entries are removed, then the one which expires first */
+	UInt32		maxCached() const { return _maxCached; }
+	void		setMaxCached(UInt32 maxCached) { _maxCached = maxCached; }
+
+	UInt32		pending() const { return _queries.size(); }
+	UInt32		cached() const { return _cache.size(); }
+	void		clearCache() { _cache.clear(); }
+
+	/*!
+	Resolve hostname, onResolved is always raised asynchronously on handler thread,
+	a onResolved expired before the end of the resolution is just not raised */
+	void		resolve(const std::string& hostname, const OnResolved& onResolved) { resolve(hostname.c_str(), onResolved); }
+	void		resolve(const char* hostname, const OnResolved& onResolved);
+
+private:
+	struct Query : virtual Object {
+		Query(const std::string& name) : name(name), pending(0), ttl(0xFFFFFFFF) {}
+		const std::string		name;
+		HostEntry				host;
+		std::deque<OnResolved>	subscribers; // deque to never copy an Event (weak link)
+		UInt8					pending; // requests running
+		UInt32					ttl;
+		Exception				ex;
+	};
+	struct Request : virtual Object {
+		Request(const shared<Query>& pQuery, UInt16 type) : pQuery(pQuery), type(type), attempts(0), server(0) {}
+		shared<Query>		pQuery;
+		const UInt16		type; // A or AAAA
+		Time				time;
+		UInt8				attempts;
+		UInt8				server;
+		shared<UDPSocket>	pUDP;
+		shared<TCPClient>	pTCP; // truncated UDP answer
+	};
+	struct Cache : virtual Object {
+		Cache(const HostEntry& host, UInt32 ttl) : host(host), expiration(Time::Now() + ttl * 1000ll) {}
+		const HostEntry	host;
+		const Int64		expiration;
+	};
+
+	void send(UInt16 id, Request& request);
+	void sendTCP(UInt16 id, Request& request);
+	/*!
+	Parse answer of request id, returns false if it's not a valid answer to ignore */
+	bool answer(UInt16 id, const UInt8* data, UInt32 size, bool tcp);
+	void finish(std::map<UInt16, Request>::iterator& it, const Exception& ex);
+	void cache(const Query& query);
+	void raise(const OnResolved& onResolved, const Exception& ex, const HostEntry& host);
+
+	static bool ReadName(BinaryReader& reader, std::string& name);
+
+	const Timer&						_timer;
+	Timer::OnTimer						_onTimer;
+	std::vector<SocketAddress>			_servers;
+	UInt32								_timeout;
+	UInt8								_attempts;
+	UInt32								_maxCached;
+
+	std::map<std::string, HostEntry>	_hosts;
+	std::map<std::string, Cache>		_cache;
+	std::map<std::string, shared<Query>>_queries;
+	std::map<UInt16, Request>			_requests;
+	std::deque<shared<UDPSocket>>		_udpClosings; // UDP requests finished, released on next timer raising
+	std::deque<shared<TCPClient>>		_closings; // TCP requests finished, released on next timer raising
+};
+
+
+} // namespace Mona
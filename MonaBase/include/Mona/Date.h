@@ -39,6 +39,10 @@ struct Date : Time, virtual Object {
 	static const char* FORMAT_SORTABLE;				/// 2005-01-01 12:00:00
 
 	static bool  IsLeapYear(Int32 year) { return (year % 400 == 0) || (!(year & 3) && year % 100); }
+	/*!
+	Quick check of the ISO 8601 shape, "YYYY-MM-DD" alone or followed by 'T' (or ' ' for FORMAT_SORTABLE), or "YYYYMMDDT",
+	allows to avoid a parsing attempt on every string which can't be a ISO 8601 date (values of JSON, query, etc.) */
+	static bool  IsISO8601(const char* value, std::size_t size);
 
 	// build a NOW date, not initialized (is null)
 	// /!\ Keep 'Type' to avoid confusion with "build from time" constructor, if a explicit Int32 offset is to set, use Date::setOffset or "build from time" contructor
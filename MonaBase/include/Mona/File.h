@@ -26,7 +26,7 @@ namespace Mona {
 File is a Path file with read and write operation,
 it's performance oriented, supports UTF8 path, and can be used with IOFile to work in a asynchronous way */
 struct File : virtual Object {
-	typedef Event<void(shared<Buffer>& pBuffer, bool end)>	OnReaden;
+	typedef Event<void(shared<const Buffer>& pBuffer, bool end)>	OnReaden; // pBuffer is read-only, it can be a slice of file mapping (see FileCache)
 	typedef Event<void(const Exception&)>					OnError;
 	typedef Event<void(bool deletion)>						OnFlush;
 	NULLABLE(!_loaded)
@@ -36,7 +36,7 @@ struct File : virtual Object {
 	If pBuffer is reseted, no onReaden is callen (data captured),
 	If returns > 0 it continue reading operation (reads returned size) */
 	struct Decoder : virtual Object {
-		virtual UInt32 decode(shared<Buffer>& pBuffer, bool end) = 0;
+		virtual UInt32 decode(shared<const Buffer>& pBuffer, bool end) = 0;
 		virtual void onRelease(File& file) {}
 	};
 
@@ -94,6 +94,8 @@ struct File : virtual Object {
 	Create file or folder */
 	bool				create(Exception& ex) { return write(ex, NULL, 0); }
 
+	/*!
+	Move the reading/writing position, in reading mode it can be called by the Decoder to get a random access */
 	bool				reset(UInt64 position = 0);
 
 private:
@@ -120,6 +122,8 @@ private:
 	UInt16						_decodingTrack;
 	const Handler*				_pHandler; // to diminue size of Action+Handle
 	friend struct IOFile;
+	friend struct FileCache;
+	friend struct Socket;
 };
 
 
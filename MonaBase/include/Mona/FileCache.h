@@ -0,0 +1,103 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/File.h"
+#include "Mona/FileWatcher.h"
+#include <list>
+#include <mutex>
+#include <atomic>
+
+namespace Mona {
+
+struct IOFile;
+/*!
+Memory mapped files cache used by IOFile to read hot files (static files, segments) without disk reading and buffer allocation:
+a file is mapped one time and readen buffers are read-only slices of the mapping which stays alive while a slice is used.
+Cache is limited by a byte budget (LRU eviction), and entries are invalidated on file change (IOFile writing or FileWatcher).
+Just files stable (unchanged since stableDelay) and smaller than maxFileSize are cached.
+Mapping is private and the file size is checked again on every read to fallback on disk reading if the file has been truncated,
+/!\ however a truncation by an other process during the reading of a slice stays a fatal error (SIGBUS) */
+struct FileCache : virtual Object {
+	FileCache(IOFile& io) : _io(io), _budget(0), _maxFileSize(0x1000000), _stableDelay(2000), _size(0), _count(0), _hits(0), _misses(0) {}
+	~FileCache() { clear(); }
+
+	/*!
+	Budget in bytes of mapped files, 0 disables the cache (default) */
+	UInt64	budget() const { return _budget; }
+	void	setBudget(UInt64 budget);
+	/*!
+	Maximum size of a cached file (16MB by default) */
+	UInt32	maxFileSize() const { return _maxFileSize; }
+	void	setMaxFileSize(UInt32 size) { _maxFileSize = size; }
+	/*!
+	Time in ms without change before to cache a file (2 seconds by default), to not cache a file in progress */
+	UInt32	stableDelay() const { return _stableDelay; }
+	void	setStableDelay(UInt32 delay) { _stableDelay = delay; }
+
+	UInt64	size() const { return _size; }
+	UInt32	count() const { return _count; }
+	UInt64	hits() const { return _hits; }
+	UInt64	misses() const { return _misses; }
+
+	/*!
+	Read size bytes from file position (readen) in a read-only slice of the file mapping,
+	returns null if file is not cacheable (mode, size, unstable or truncated file, or cache disabled) */
+	shared<const Buffer> read(File& file, UInt32 size);
+
+	void	invalidate(const std::string& path);
+	void	clear();
+
+private:
+	struct Map : Buffer, virtual Object {
+		Map(void* data, UInt32 size) : Buffer(size, data) {}
+		~Map();
+	};
+	struct Slice : Buffer, virtual Object {
+		Slice(const shared<Map>& pMap, UInt32 offset, UInt32 size) : Buffer(size, pMap->data() + offset), _pMap(pMap) {}
+	private:
+		shared<Map> _pMap;
+	};
+	struct Entry : virtual Object {
+		Entry(std::list<std::string>::iterator it) : it(it), lastChange(0) {}
+		std::list<std::string>::iterator	it; // LRU position
+		shared<Map>							pMap;
+		Int64								lastChange;
+		shared<const FileWatcher>			pWatcher;
+		FileWatcher::OnUpdate				onUpdate;
+	};
+
+	shared<Map> map(File& file);
+	void		erase(std::map<std::string, Entry>::iterator& it);
+
+	IOFile&							_io;
+	std::atomic<UInt64>				_budget;
+	std::atomic<UInt32>				_maxFileSize;
+	std::atomic<UInt32>				_stableDelay;
+	std::atomic<UInt64>				_size;
+	std::atomic<UInt32>				_count;
+	std::atomic<UInt64>				_hits;
+	std::atomic<UInt64>				_misses;
+
+	std::mutex						_mutex;
+	std::map<std::string, Entry>	_entries;
+	std::list<std::string>			_lru; // front = more recent
+};
+
+
+} // namespace Mona
@@ -32,7 +32,9 @@ If path has the form \directory\*, it's watching all files/folder in directory (
 If path has the form \directory\*.*, it's watching all files in directory (and sub directory in MODE_HEAVY)
 If path has the form \directory\*.ext, it's watching all files with ext in directory (and sub directory in MODE_HEAVY)
 If path has the form \directory\name.*, it's watching all files with name in directory (and sub directory in MODE_HEAVY)
-If path has the form \directory\* /, it's watching all folders in directory (and sub drectory in MODE_HEAVY) */
+If path has the form \directory\* /, it's watching all folders in directory (and sub drectory in MODE_HEAVY)
+IOFile uses inotify on Linux to get updates without polling, it fallbacks to a polling every second (watch call)
+when inotify is unavailable or when the inotify watch limit is reached (fs.inotify.max_user_watches) */
 struct FileWatcher : virtual Object {
 	typedef Event<void(const Path& file, bool firstWatch)>	OnUpdate;
 
@@ -47,6 +49,7 @@ struct FileWatcher : virtual Object {
 
 
 private:
+	bool	match(const Path& file) const;
 	void	watchFile(std::map<Path, std::pair<Time, bool>, String::IComparator>& lastChanges, const Path& file, const OnUpdate& onUpdate);
 
 	std::map<Path, std::pair<Time, bool>, String::IComparator> _lastChanges;
@@ -56,6 +59,20 @@ private:
 	const char* _baseName;
 	bool		_justFolder;
 
+#if !defined(_WIN32) && !defined(_BSD)
+	/*!
+	Add inotify watches on folders concerned (recursively in MODE_HEAVY),
+	returns false if impossible (watch limit reached for example), polling is required in this case */
+	bool	notify(Exception& ex, int fd);
+	bool	notify(Exception& ex, int fd, const std::string& folder);
+	/*!
+	Process an inotify event, returns false if watching has to fallback to polling */
+	bool	notified(Exception& ex, int fd, int wd, UInt32 mask, const char* name);
+	void	update(const Path& file);
+
+	std::map<int, std::string> _folders; // inotify watch descriptor => folder
+#endif
+
 	//// Used by IOFile /////////////////////
 	OnUpdate    onUpdate;
 	friend struct IOFile;
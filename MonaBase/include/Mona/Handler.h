@@ -20,13 +20,14 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include "Mona/Runner.h"
 #include "Mona/Event.h"
 #include "Mona/Signal.h"
+#include "Mona/Metrics.h"
 #include <deque>
 
 namespace Mona {
 
 struct Handler : virtual Object {
-	Handler(Signal& signal) : _pSignal(&signal) {}
-	Handler() : _pSignal(NULL) {}
+	Handler(Signal& signal) : _pSignal(&signal), _queued(0) {}
+	Handler() : _pSignal(NULL), _queued(0) {}
 
 	void	 reset(Signal& signal);
 	UInt32	 flush(bool last=false);
@@ -39,7 +40,10 @@ struct Handler : virtual Object {
 		std::lock_guard<std::mutex> lock(_mutex);
 		if (!_pSignal)
 			return false;
+		if (_runners.empty())
+			_queued = Metrics::Microseconds(); // wait time of the batch = wait time of its first runner
 		_runners.emplace_back(std::forward<RunnerType>(pRunner));
+		++Queue;
 		_pSignal->set();
 		return true;
 	}
@@ -91,10 +95,16 @@ struct Handler : virtual Object {
 			FATAL_ERROR("Impossible to queue ", TypeOf(onResult));
 	}
 
+	/*!
+	Runners queued and waiting their execution, and wait time in queue (of the first runner of each flush) */
+	static Metrics::Gauge		Queue;
+	static Metrics::Histogram	Wait;
+
 private:
 
 	mutable std::mutex					_mutex;
 	mutable std::deque<shared<Runner>>	_runners;
+	mutable Int64						_queued;
 	Signal*								_pSignal;
 };
 
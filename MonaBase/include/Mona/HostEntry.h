@@ -37,6 +37,7 @@ public:
 
 	// Creates an empty HostEntry.
 	HostEntry() {}
+	HostEntry(const HostEntry& other) : _name(other._name), _aliases(other._aliases), _addresses(other._addresses) {}
 
 	// Creates the HostEntry from the data in a hostent structure.
 	void set(Exception& ex, const hostent& entry);
@@ -53,6 +54,8 @@ public:
 	const std::set<IPAddress>&	addresses() const { return _addresses;}
 
 private:
+	friend struct DNSResolver;
+
 	std::string					_name;
 	std::vector<std::string>	_aliases;
 	std::set<IPAddress>			_addresses;
@@ -21,6 +21,8 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include "Mona/ThreadPool.h"
 #include "Mona/Packet.h"
 #include "Mona/FileWatcher.h"
+#include "Mona/FileCache.h"
+#include <atomic>
 
 
 namespace Mona {
@@ -30,7 +32,8 @@ IOFile performs asynchrone writing and reading operation,
 It uses a Thread::ProcessorCount() threads with low priority to load/read/write files
 Indeed even if SSD drive allows parallel reading and writing operation every operation sollicate too the CPU,
 so it's useless to try to exceeds number of CPU core (Thread::ProcessorCount() has been tested and approved with file load)
-Trick: shared<File> pFile becomes "unique" when there is no more usage by parallel thread */
+Trick: shared<File> pFile becomes "unique" when there is no more usage by parallel thread
+Reading uses the cache of mapped files when enabled (see FileCache), in this case readen buffers are read-only */
 struct IOFile : virtual Object, Thread { // Thread is for file watching!
 
 	IOFile(const Handler& handler, const ThreadPool& threadPool, UInt16 cores=0);
@@ -38,6 +41,7 @@ struct IOFile : virtual Object, Thread { // Thread is for file watching!
 
 	const Handler&	  handler;
 	const ThreadPool& threadPool;
+	FileCache		  cache;
 
 	/*!
 	Subscribe read */
@@ -89,6 +93,7 @@ struct IOFile : virtual Object, Thread { // Thread is for file watching!
 	void join();
 private:
 	bool run(Exception& ex, const volatile bool& requestStop);
+	void stop() override; // wake up the watching thread before to stop it
 
 	struct Action;
 	struct WAction;
@@ -98,6 +103,11 @@ private:
 	ThreadPool								_threadPool; // Pool of threads for writing/reading disk operation
 	std::vector<shared<const FileWatcher>>	_watchers;
 	std::mutex								_mutexWatchers;
+#if !defined(_WIN32) && !defined(_BSD)
+	std::atomic<int>						_notifyFD; // inotify, 0 if not created, -1 if unavailable, published after _eventFD and _readFD
+	int										_eventFD; // pipe to wake up the watching thread
+	int										_readFD;
+#endif
 };
 
 
@@ -0,0 +1,279 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/String.h"
+#include <functional>
+#include <atomic>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Mona {
+
+#define METRICS_SHARDS	16
+
+/*!
+Metrics registry exposed in Prometheus text format (version 0.0.4):
+- Counter, Gauge and Histogram are static objects registered by their construction, recording is lock-free
+and spread on per-thread shards (no cache line contention between threads), reading sums the shards
+- Collector is a callback to write on demand values already computed elsewhere (sessions count, byte rates, etc.)
+- Trace propagates a sampled reception time along the processing chain to measure latency by stage */
+struct Metrics : virtual Static {
+	struct Writer;
+
+	struct Metric : virtual Object {
+		enum Type {
+			TYPE_COUNTER = 0,
+			TYPE_GAUGE,
+			TYPE_HISTOGRAM,
+			TYPE_SUMMARY
+		};
+		const Type			type;
+		const char* const	name;
+		const char* const	help;
+		/*!
+		Optional labels formatted as Prometheus, 'protocol="HTTP"' for example */
+		const char* const	labels;
+
+		virtual ~Metric();
+	protected:
+		Metric(Type type, const char* name, const char* help, const char* labels);
+	private:
+		virtual void write(Writer& writer) const = 0;
+		friend struct Metrics;
+	};
+
+	struct Counter : Metric, virtual Object {
+		Counter(const char* name, const char* help, const char* labels = NULL) : Metric(TYPE_COUNTER, name, help, labels) {}
+
+		Counter& operator++() { return operator+=(1); }
+		Counter& operator+=(UInt64 value) { _shards[Shard()].value.fetch_add(value, std::memory_order_relaxed); return self; }
+		UInt64	 operator()() const;
+	private:
+		void write(Writer& writer) const;
+
+		struct alignas(64) Slot { // one cache line by shard
+			std::atomic<UInt64> value;
+		};
+		Slot _shards[METRICS_SHARDS] = {};
+	};
+
+	struct Gauge : Metric, virtual Object {
+		Gauge(const char* name, const char* help, const char* labels = NULL) : Metric(TYPE_GAUGE, name, help, labels) {}
+
+		Gauge& operator++() { return operator+=(1); }
+		Gauge& operator--() { return operator+=(-1); }
+		Gauge& operator+=(Int64 value) { _shards[Shard()].value.fetch_add(value, std::memory_order_relaxed); return self; }
+		Gauge& operator-=(Int64 value) { return operator+=(-value); }
+		Int64  operator()() const;
+	private:
+		void write(Writer& writer) const;
+
+		struct alignas(64) Slot {
+			std::atomic<Int64>	value;
+		};
+		Slot _shards[METRICS_SHARDS] = {};
+	};
+
+	/*!
+	HDR-style histogram: log-linear buckets, 8 by power of two (precision 12.5%) up to 2^40,
+	exposed with a bucket by power of two. scale is the divider to get the exposed unit,
+	1000000 by default for values recorded in microseconds and exposed in seconds (Prometheus convention) */
+	struct Histogram : Metric, virtual Object {
+		enum {
+			SUB_BITS = 3,
+			SUB_BUCKETS = 1 << SUB_BITS,
+			POWERS = 40,
+			BUCKETS = SUB_BUCKETS * (POWERS - SUB_BITS + 1) + 1 // +1 for overflow
+		};
+		Histogram(const char* name, const char* help, const char* labels = NULL, double scale = 1000000);
+		~Histogram();
+
+		const double scale;
+
+		void	record(UInt64 value) {
+			Slot& slot = _shards[Shard()];
+			slot.buckets[ComputeIndex(value)].fetch_add(1, std::memory_order_relaxed);
+			slot.sum.fetch_add(value, std::memory_order_relaxed);
+		}
+		UInt64	count() const;
+		UInt64	sum() const;
+		/*!
+		Value upper bound under which fall rate of the values (0.99 for the 99th percentile) */
+		UInt64	percentile(double rate) const;
+		static UInt64 Percentile(const UInt64* buckets, UInt64 count, double rate);
+	
+		/*!
+		Value v is classified with v-1 to get exactly the "less or equal" bucket semantic of Prometheus on power of two limits */
+		static UInt16 ComputeIndex(UInt64 value) {
+			if (value && --value >= SUB_BUCKETS) {
+				UInt8 power = Log2(value);
+				if (power >= POWERS)
+					return BUCKETS - 1;
+				return SUB_BUCKETS * (power - SUB_BITS + 1) + ((value >> (power - SUB_BITS)) & (SUB_BUCKETS - 1));
+			}
+			return UInt16(value);
+		}
+	private:
+		static UInt8 Log2(UInt64 value) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return UInt8(index);
+#else
+			return UInt8(63 - __builtin_clzll(value));
+#endif
+		}
+		void write(Writer& writer) const;
+
+		struct Slot {
+			std::atomic<UInt64> buckets[BUCKETS];
+			std::atomic<UInt64> sum;
+		};
+		Slot* _shards;
+	};
+
+	/*!
+	Single thread distribution with the Histogram buckets, to sample values owned by an object (publication for example),
+	written as a Prometheus summary */
+	struct Samples : virtual Object {
+		Samples() { clear(); }
+
+		void	record(UInt64 value) {
+			++_buckets[Histogram::ComputeIndex(value)];
+			++_count;
+			_sum += value;
+			if (value > _max)
+				_max = value;
+		}
+		UInt64	count() const { return _count; }
+		UInt64	sum() const { return _sum; }
+		UInt64	max() const { return _max; }
+		UInt64	percentile(double rate) const { return Histogram::Percentile(_buckets, _count, rate); }
+		void	clear();
+		/*!
+		Write 0.5, 0.9 and 0.99 quantiles with sum and count, scale to get the exposed unit (see Histogram) */
+		void	write(Writer& writer, const char* name, const char* help, const char* labels, double scale = 1000000) const;
+	private:
+		UInt64	_buckets[Histogram::BUCKETS];
+		UInt64	_count;
+		UInt64	_sum;
+		UInt64	_max;
+	};
+
+	/*!
+	Trace of a sampled reception, in microseconds (see Microseconds()):
+	IOSocket starts it on reception (1 on Trace::Rate), decoding runs in its scope, so runners created meanwhile
+	capture it and stamp their queueing time, then Handler restores it on the handler thread while running them.
+	So the receiver of a media can measure each stage from its reception (decoding, handler waiting, processing) */
+	struct Trace {
+		Trace() : received(0), queued(0), ran(0) {}
+		explicit operator bool() const { return received ? true : false; }
+
+		Int64 received;
+		Int64 queued;
+		Int64 ran;
+
+		/*!
+		Trace of the current thread, empty if not traced */
+		static const Trace& Current() { return _Current; }
+		/*!
+		Returns a new trace 1 time on Rate, an empty trace otherwise */
+		static Trace Sample();
+		/*!
+		Sampling rate, 1 trace by Rate receptions, 0 disables it (by default) */
+		static std::atomic<UInt32> Rate;
+
+		/*!
+		Set the trace of the current thread during its life-time */
+		struct Scope;
+	private:
+		static thread_local Trace _Current;
+	};
+
+	/*!
+	Callback called on Metrics::Write to add values, registered during its life-time */
+	struct Collector : virtual Object {
+		typedef std::function<void(Writer& writer)> Function;
+		Collector(Function&& function);
+		~Collector();
+	private:
+		Function _function;
+		friend struct Metrics;
+	};
+
+	struct Writer : virtual Object {
+		/*!
+		Write a sample, HELP and TYPE lines are written on first sample of a name,
+		so samples of a same name have to be written successively */
+		template<typename ValueType>
+		Writer& write(Metric::Type type, const char* name, const char* help, const char* labels, ValueType value) {
+			header(type, name, help);
+			return sample(name, "", labels, value);
+		}
+		template<typename ValueType>
+		Writer& write(Metric::Type type, const char* name, const char* suffix, const char* help, const char* labels, ValueType value) {
+			header(type, name, help);
+			return sample(name, suffix, labels, value);
+		}
+		/*!
+		Escape a label value (backslash, double-quote and line feed) */
+		static std::string& Escape(const char* value, std::string& buffer);
+	private:
+		Writer(std::string& text) : _text(text) {}
+		void header(Metric::Type type, const char* name, const char* help);
+		template<typename ValueType>
+		Writer& sample(const char* name, const char* suffix, const char* labels, ValueType value) {
+			String::Append(_text, name, suffix);
+			if (labels && *labels)
+				String::Append(_text, '{', labels, '}');
+			String::Append(_text, ' ', value, '\n');
+			return self;
+		}
+
+		std::string&	_text;
+		std::string		_name;
+		friend struct Metrics;
+	};
+
+	/*!
+	Append all the metrics to text in Prometheus text format */
+	static std::string& Write(std::string& text);
+
+	/*!
+	Monotonic clock in microseconds to measure durations */
+	static Int64 Microseconds() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+private:
+	static UInt8 Shard() { return _Shard < METRICS_SHARDS ? _Shard : NewShard(); }
+	static UInt8 NewShard();
+
+	static thread_local UInt8 _Shard;
+};
+
+struct Metrics::Trace::Scope : virtual Object {
+	Scope(const Trace& trace) : _previous(_Current) { _Current = trace; }
+	~Scope() { _Current = _previous; }
+private:
+	Trace _previous;
+};
+
+} // namespace Mona
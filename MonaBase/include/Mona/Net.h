@@ -226,6 +226,13 @@ struct Net : virtual Object {
 		virtual Time	sendTime() const = 0;
 		virtual UInt64	sendByteRate() const = 0;
 		virtual double	sendLostRate() const { return 0; }
+		/*!
+		Ratio of bytes retransmitted, 0 if not managed by the protocol */
+		virtual double	sendRepeatRate() const { return 0; }
+		/*!
+		Congestion window in bytes and pacing rate in bytes/s, 0 if not managed by the protocol */
+		virtual UInt32	sendWindow() const { return 0; }
+		virtual UInt64	sendPacingRate() const { return 0; }
 
 		virtual UInt64	queueing() const = 0;
 
@@ -39,10 +39,10 @@ struct Parameters : String::Object<Parameters> {
 		const_iterator  _end;
 	};
 
-	Parameters() : version(0) {}
-	Parameters(std::initializer_list<value_type>&& params) : _pMap(SET, std::move(params)), version(0) {}
-	Parameters(std::nullptr_t) : version(0) {}
-	Parameters(Parameters&& other) : version(other.version) { setParams(std::move(other));  }
+	Parameters() : version(0), _indexed(0) {}
+	Parameters(std::initializer_list<value_type>&& params) : _pMap(SET, std::move(params)), version(0), _indexed(0) { reindex(); }
+	Parameters(std::nullptr_t) : version(0), _indexed(0) {}
+	Parameters(Parameters&& other) : version(other.version), _indexed(0) { setParams(std::move(other));  }
 
 	Parameters&		  setParams(Parameters&& other);
 	const Parameters& parameters() const { return self; }
@@ -109,9 +109,15 @@ struct Parameters : String::Object<Parameters> {
 	Just to match STD container (see MapWriter) */
 	template<typename ValueType>
 	std::pair<const_iterator, bool> emplace(const std::string& key, ValueType&& value) {
-		if (!_pMap)
-			_pMap.set();
-		const auto& it = _pMap->emplace(key, std::string());
+		if (_pMap && !_pMap.unique()) {
+			// shared map, copy it just if value changes
+			const auto& it = _pMap->find(key);
+			if (it != _pMap->end() && it->second.compare(value) == 0)
+				return std::make_pair(it, false);
+		}
+		const auto& it = mutableParams().emplace(key, std::string());
+		if (it.second)
+			index(*it.first);
 		if (it.second || it.first->second.compare(value) != 0) {
 			it.first->second = std::forward<ValueType>(value);
 			onParamChange(it.first->first, &it.first->second);
@@ -123,7 +129,7 @@ struct Parameters : String::Object<Parameters> {
 	static const Parameters& Null() { static const Parameters Null({}); return Null; }
 
 protected:
-	Parameters(const Parameters& other) : version(other.version) { setParams(other); }
+	Parameters(const Parameters& other) : version(other.version), _indexed(0) { setParams(other); }
 	Parameters& setParams(const Parameters& other);
 
 	virtual void onParamChange(const std::string& key, const std::string* pValue) { ++(UInt32&)version; onChange(key, pValue); }
@@ -133,11 +139,26 @@ private:
 	virtual const std::string* onParamUnfound(const std::string& key) const { return onUnfound(key); }
 	virtual void onParamInit() {}
 
-	const std::map<std::string, std::string, String::IComparator>& params() const { if (!_pMap) ((Parameters&)self).onParamInit(); return _pMap ? *_pMap : *Null()._pMap; }
+	typedef std::map<std::string, std::string, String::IComparator> MapType;
+
+	const MapType& params() const { if (!_pMap) ((Parameters&)self).onParamInit(); return _pMap ? *_pMap : *Null()._pMap; }
+	/*!
+	Map to change, copied before if shared with an other Parameters (copy-on-write) */
+	MapType&	mutableParams();
 
-	// shared because a lot more faster than using st::map move constructor!
+	/*!
+	Case-insensitive hash index (open addressing) of entries to find a key without tree walk on big maps,
+	maintained just by changes to keep const reading thread-safe */
+	const value_type*	search(const std::string& key) const;
+	void				index(const value_type& entry);
+	void				unindex(const value_type& entry);
+	void				reindex();
+
+	// shared because a lot more faster than using st::map move constructor, and allows to share the map between copies until a change
 	// Also build _pMap just if required, and then not erase it but clear it (more faster that reset the shared)
-	shared<std::map<std::string, std::string, String::IComparator>>	_pMap;
+	shared<MapType>												_pMap;
+	std::vector<std::pair<UInt32, const value_type*>>		_index; // hash => entry, empty if not built
+	UInt32													_indexed; // slots used (erased included)
 };
 
 
@@ -19,16 +19,23 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include "Mona/Mona.h"
 #include "Mona/Thread.h"
 #include "Mona/Logs.h"
+#include "Mona/Metrics.h"
 
 namespace Mona {
 
 
 struct Runner : virtual Object {
-	Runner(const char* name) : name(name), noLog(Logs::Logging()), noDump(Logs::Dumping())  {}
+	Runner(const char* name) : name(name), noLog(Logs::Logging()), noDump(Logs::Dumping()), trace(Metrics::Trace::Current())  {
+		if (trace)
+			trace.queued = Metrics::Microseconds();
+	}
 
 	const char* name;
 	bool noLog;
 	bool noDump;
+	/*!
+	Trace of the thread which has created the runner, restored by Handler while running it */
+	Metrics::Trace trace;
 
 	template <typename ...Args>
 	void run(Args&&... args) {
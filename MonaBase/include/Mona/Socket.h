@@ -26,6 +26,7 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 namespace Mona {
 
+struct File;
 struct Socket : virtual Object, Net::Stats {
 	typedef Event<void(shared<Buffer>& pBuffer, const SocketAddress& address)>	  OnReceived;
 	typedef Event<void(const shared<Socket>& pSocket)>							  OnAccept;
@@ -80,6 +81,11 @@ struct Socket : virtual Object, Net::Stats {
 
 	virtual UInt32		available() const;
 	UInt64				queueing() const { return _queueing; }
+
+	/*!
+	Owner of the buffers allocated by reception, decoding and sending queue, "socket" by default (see Buffer::Tag) */
+	Buffer::Tag&		bufferTag() const { return *_pBufferTag.load(std::memory_order_relaxed); }
+	void				setBufferTag(Buffer::Tag& tag) { _pBufferTag.store(&tag, std::memory_order_relaxed); }
 	
 	const SocketAddress& address() const;
 	const SocketAddress& peerAddress() const { return _peerAddress; }
@@ -146,6 +152,17 @@ struct Socket : virtual Object, Net::Stats {
 	int			 write(Exception& ex, const Packet& packet, int flags = 0) { return write(ex, packet, SocketAddress::Wildcard(), flags); }
 	int			 write(Exception& ex, const Packet& packet, const SocketAddress& address, int flags = 0);
 	/*!
+	Sequential and safe writing of a file region sent by the kernel without user space copy (sendfile), requires canSendFile(),
+	queues as write(packet) what can't be sent immediatly (pFile is hold until sent) */
+	int			 write(Exception& ex, const shared<const File>& pFile, UInt64 offset, UInt64 size);
+	/*!
+	True if socket can send a file region with sendfile: TCP socket on Linux (see TLS::Socket for TLS) */
+	virtual bool canSendFile() const;
+	/*!
+	True if packets queued can be sent by one gather system call on flush (up to IOV_MAX packets with sendmsg),
+	stream socket without coalescing by default, a socket which transforms data in sendTo has to disable it */
+	virtual bool canGather() const { return type == TYPE_STREAM && !coalescing(); }
+	/*!
 	Flush packets, return false on socket error */
 	bool		 flush(Exception& ex) { return flush(ex, false); }
 
@@ -166,6 +183,11 @@ protected:
 	Socket(NET_SOCKET id, const sockaddr& addr, Type type=TYPE_STREAM);
 	virtual Socket* newSocket(Exception& ex, NET_SOCKET sockfd, const sockaddr& addr) { return new Socket(sockfd, (sockaddr&)addr); }
 	virtual int		receive(Exception& ex, void* buffer, UInt32 size, int flags, SocketAddress* pAddress);
+	virtual int		sendFile(Exception& ex, const File& file, UInt64 offset, UInt32 size);
+	/*!
+	Maximum size to coalesce small packets queued in a single sendTo on flush (0 by default = one sendTo by packet),
+	only data already queued are gathered, a packet is never delayed to wait the next ones */
+	virtual UInt32	coalescing() const { return 0; }
 
 
 	void			send(UInt32 count) { _sendTime = Time::Now(); _sendByteRate += count; }
@@ -227,16 +249,31 @@ private:
 	}
 
 	struct Sending : Packet, virtual Object {
-		Sending(const Packet& packet, const SocketAddress& address, int flags) : Packet(std::move(packet)), address(address), flags(flags) {}
+		Sending(const Packet& packet, const SocketAddress& address, int flags) : Packet(std::move(packet)), address(address), flags(flags), offset(0), rest(0), queued(Metrics::Trace::Rate ? Metrics::Microseconds() : 0) {}
+		Sending(const shared<const File>& pFile, UInt64 offset, UInt64 size, const SocketAddress& address) : pFile(pFile), offset(offset), rest(size), address(address), flags(0), queued(Metrics::Trace::Rate ? Metrics::Microseconds() : 0) {}
 
 		const SocketAddress address;
 		const int			flags;
+		const Int64			queued; // to measure the wait time by backpressure, 0 if metrics tracing is disabled (Metrics::Trace::Rate)
+		// file region sending (sendfile)
+		const shared<const File> pFile;
+		UInt64					 offset;
+		UInt64					 rest;
 	};
 
+	/*!
+	Copy in _gathering the packets queued compatible with the first one up to size bytes, returns count of sendings concerned */
+	UInt32 gather(UInt32 size);
+	/*!
+	Send the packets queued compatible with the first one in one system call, size is assigned with the size to send */
+	int	   sendV(Exception& ex, UInt32& size);
+
 	Exception					_ex;
 	mutable std::mutex			_mutexSending;
 	std::deque<Sending>			_sendings;
+	Buffer						_gathering; // staging buffer reused to coalesce sendings (or to gather their buffer descriptors)
 	std::atomic<UInt64>			_queueing;
+	std::atomic<Buffer::Tag*>	_pBufferTag;
 
 	std::atomic<Int64>			_recvTime;
 	ByteRate					_recvByteRate;
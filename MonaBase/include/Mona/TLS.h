@@ -20,7 +20,9 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include "Mona/Mona.h"
 #include "Mona/Crypto.h"
 #include "Mona/Socket.h"
+#include "Mona/Path.h"
 #include OpenSSL(ssl.h)
+#include <deque>
 
 
 namespace Mona {
@@ -30,18 +32,53 @@ struct TLS : virtual Object {
 	static bool Create(Exception& ex, const std::string& cert, const std::string& key, shared<TLS>& pTLS, const SSL_METHOD* method = SSLv23_method()) { return Create(ex, cert.c_str(), key.c_str(), pTLS, method); }
 	static bool Create(Exception& ex, const char* cert, const char* key, shared<TLS>& pTLS, const SSL_METHOD* method = SSLv23_method());
 
+	/*!
+	Count of TLS sockets running in kernel TLS mode (kTLS), see TLS::Socket */
+	static UInt32 KTLSSockets() { return _KTLSSockets; }
+
+	/*!
+	Server session cache to resume a session by its ID (size entries max, timeout in seconds), size=0 disables it.
+	A TLS created with a certificate has a cache of 16384 sessions for 300 seconds */
+	void	setSessionCache(UInt32 size, UInt32 timeout = 300);
+	/*!
+	Session tickets (stateless resumption) with keys generated in memory and rotated every rotation seconds,
+	the previous key stays valid during one more rotation to renew tickets. rotation=0 disables tickets.
+	A TLS created with a certificate rotates every 3600 seconds */
+	void	setTicketRotation(UInt32 rotation);
+	UInt32	ticketRotation() const { return _ticketRotation; }
+	/*!
+	Load the certificates of directory to select them by SNI (server name indication), the certificate of creation stays the default one.
+	Every "name.pem" certificate requires its "name.key" private key, a certificate is selected by its subjectAltName DNS or common name (wildcard "*.domain" supported).
+	Returns the count of certificates loaded, call it before any socket usage */
+	UInt32	loadCertificates(Exception& ex, const Path& directory);
+	UInt32	certificates() const { return _certificates.size(); }
+
+	UInt64	fullHandshakes() const { return _fullHandshakes; }
+	UInt64	resumedHandshakes() const { return _resumedHandshakes; }
+	/*!
+	Records written in user space TLS (kTLS excluded) and their payload bytes, recordBytes()/records() gives the average record size */
+	UInt64	records() const { return _records; }
+	UInt64	recordBytes() const { return _recordBytes; }
+
 
 	struct Socket : virtual Object, Mona::Socket {
 		// http://fm4dd.com/openssl/sslconnect.htm
 		// https://wiki.openssl.org/index.php/Simple_TLS_Server
 		/*
-		If pTLS is null it becomes a normal socket */
+		If pTLS is null it becomes a normal socket.
+		On Linux with OpenSSL 3 the record layer is offloaded to the kernel after handshake when possible (kTLS, fallback on user space TLS otherwise):
+		sending becomes plain socket operations (and sendfile possible), reception stays on SSL_read which gets records already decrypted */
 		Socket(Type type, const shared<TLS>& pTLS);
 		~Socket();
 
 		const shared<TLS>	pTLS;
 
 		bool  isSecure() const { return pTLS ? true : false; }
+		/*!
+		True if sending is offloaded to the kernel (kTLS) */
+		bool  isKTLS() const { return _ktls; }
+		bool  canSendFile() const { return (!pTLS || _ktls) && Mona::Socket::canSendFile(); }
+		bool  canGather() const { return (!pTLS || _ktls) && Mona::Socket::canGather(); }
 
 		UInt32  available() const;
 	
@@ -52,7 +89,14 @@ struct TLS : virtual Object {
 
 	private:
 		int	 receive(Exception& ex, void* buffer, UInt32 size, int flags, SocketAddress* pAddress);
+		int	 sendFile(Exception& ex, const File& file, UInt64 offset, UInt32 size);
+		/*!
+		Small packets queued are coalesced in full size records (one MAC and syscall instead of one by packet) */
+		UInt32 coalescing() const { return pTLS && !_ktls ? SSL3_RT_MAX_PLAIN_LENGTH : 0; }
 		bool flush(Exception& ex, bool deleting) override;
+		/*!
+		Count the handshake when finished, and check if the kernel has taken the sending record layer, call it under _mutex */
+		void handshaked();
 		bool close(Socket::ShutdownType type = SHUTDOWN_BOTH);
 
 		Mona::Socket* newSocket(Exception& ex, NET_SOCKET sockfd, const sockaddr& addr);
@@ -96,14 +140,45 @@ struct TLS : virtual Object {
 
 		ssl_st*				_ssl;
 		mutable std::mutex	_mutex;
+		std::atomic<bool>	_ktls; // set on reception thread (handshake), read on sending threads
+		bool				_handshaked;
 	};
 
 
-	~TLS() { SSL_CTX_free(_pCTX); }
+	~TLS();
 private:
-	TLS(SSL_CTX* pCTX) : _pCTX(pCTX) {}
+	TLS(SSL_CTX* pCTX);
+
+	struct TicketKey : virtual Object {
+		TicketKey();
+		UInt8		name[16];
+		UInt8		aes[32];
+		UInt8		hmac[32];
+		const Int64	time;
+	};
+	/*!
+	Select the ticket key to encrypt (name and iv are written) or decrypt (name is read) a ticket, and copy its HMAC key in hmac,
+	returns -1 on error, 0 if unknown key, 1 if found, 2 if found but ticket has to be renewed */
+	int				ticketKey(UInt8* name, UInt8* iv, EVP_CIPHER_CTX* pCipher, bool encrypt, UInt8 (&hmac)[32]);
+	void			configure(SSL_CTX* pCTX);
+	static int		SelectCertificate(SSL* ssl, int* alert, void* arg);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	static int		TicketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* pCipher, EVP_MAC_CTX* pMAC, int encrypt);
+#else
+	static int		TicketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* pCipher, HMAC_CTX* pMAC, int encrypt);
+#endif
 	
-	SSL_CTX*  _pCTX;
+	SSL_CTX*					_pCTX;
+	std::map<std::string, SSL_CTX*>	_certificates; // SNI name => context
+	std::atomic<UInt32>			_ticketRotation;
+	std::mutex					_ticketMutex;
+	std::deque<TicketKey>		_ticketKeys; // front = current
+	std::atomic<UInt64>			_fullHandshakes;
+	std::atomic<UInt64>			_resumedHandshakes;
+	std::atomic<UInt64>			_records;
+	std::atomic<UInt64>			_recordBytes;
+
+	static std::atomic<UInt32> _KTLSSockets;
 };
 
 
@@ -16,6 +16,9 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 #include "Mona/Buffer.h"
 #include "Mona/Exceptions.h"
+#include "Mona/Metrics.h"
+#include <map>
+#include <mutex>
 
 using namespace std;
 
@@ -51,20 +54,107 @@ void Buffer::Allocator::Free(UInt8* buffer, UInt32 size) {
 	Unlock();
 }
 
+
+atomic<bool>				Buffer::Tag::_Enabled(false);
+thread_local Buffer::Tag*	Buffer::Tag::_PCurrent(NULL);
+
+struct Tags : map<string, Buffer::Tag*>, virtual Object {
+	std::mutex mutex;
+};
+static Tags& GetTags() {
+	// never deleted, buffers can be released after the static destructions
+	static Tags* PTags(new Tags());
+	return *PTags;
+}
+
+static Metrics::Collector _TagsCollector([](Metrics::Writer& writer) {
+	if (!Buffer::Tag::Enabled())
+		return;
+	Tags& tags = GetTags();
+	lock_guard<std::mutex> lock(tags.mutex);
+	string owner;
+	for (auto& it : tags) {
+		Int64 bytes = it.second->bytes();
+		if (bytes) // owner without buffers alive (publication closed for example) disappears
+			writer.write(Metrics::Metric::TYPE_GAUGE, "mona_buffer_bytes", "Live bytes of buffers by owner (tagging mode)", String("owner=\"", Metrics::Writer::Escape(it.first.c_str(), owner), '"').c_str(), bytes);
+	}
+});
+
+Buffer::Tag::Tag(const string& owner) : owner(owner), _bytes(0) {}
+
+Buffer::Tag& Buffer::Tag::Get(const string& owner) {
+	Tags& tags = GetTags();
+	lock_guard<std::mutex> lock(tags.mutex);
+	auto it = tags.lower_bound(owner);
+	if (it != tags.end() && it->first == owner)
+		return *it->second;
+	if (tags.size() < MAX_COUNT)
+		return *tags.emplace_hint(it, owner, new Tag(owner))->second;
+	// too many owners (publication names for example), share the tag of its prefix
+	size_t slash = owner.find('/');
+	string shared(slash == string::npos ? "other" : owner.substr(0, slash + 1).append("*"));
+	it = tags.lower_bound(shared);
+	if (it == tags.end() || it->first != shared)
+		it = tags.emplace_hint(it, shared, new Tag(shared));
+	return *it->second;
+}
+
+Buffer::Tag& Buffer::Tag::Other() {
+	static Tag& Other(Get("other"));
+	return Other;
+}
+
+Buffer::Tag& Buffer::Tag::adopt(const shared<const Binary>& pBinary) {
+	if (!pBinary || !Enabled())
+		return self;
+	const Buffer* pBuffer = dynamic_cast<const Buffer*>(pBinary.get());
+	if (!pBuffer || !pBuffer->_buffer)
+		return self; // static buffer
+	Tag* pTag = const_cast<Buffer*>(pBuffer)->_pTag.exchange(this);
+	if (pTag == this)
+		return self;
+	// buffer shared by a packet is immutable, its capacity doesn't change
+	Int64 capacity = pBuffer->_capacity + pBuffer->_offset;
+	_bytes.fetch_add(capacity, memory_order_relaxed);
+	if (pTag)
+		pTag->_bytes.fetch_sub(capacity, memory_order_relaxed);
+	return self;
+}
+
+
 static UInt8 _Empty;
 
-Buffer::Buffer(UInt32 size) : _offset(0), _size(size), _capacity(size) {
+Buffer::Buffer(UInt32 size) : _offset(0), _size(size), _capacity(size), _pTag(NULL) {
 	_data = _buffer = (size ? Allocator::Alloc(_capacity) : &_Empty);
+	if (size)
+		account(0);
 }
-Buffer::Buffer(const void* data, UInt32 size) : _offset(0), _size(size), _capacity(size) {
+Buffer::Buffer(const void* data, UInt32 size) : _offset(0), _size(size), _capacity(size), _pTag(NULL) {
 	memcpy(_data = _buffer = (size ? Allocator::Alloc(_capacity) : &_Empty), data, size);
+	if (size)
+		account(0);
 }
 
-Buffer::Buffer(UInt32 size, void* buffer) : _offset(0), _data(BIN buffer), _size(size),_capacity(size), _buffer(NULL) {}
+Buffer::Buffer(UInt32 size, void* buffer) : _offset(0), _data(BIN buffer), _size(size),_capacity(size), _buffer(NULL), _pTag(NULL) {}
 
 Buffer::~Buffer() {
-	if (_buffer && (_capacity+=_offset))
+	if (_buffer && (_capacity+=_offset)) {
+		Tag* pTag = _pTag.load(memory_order_relaxed);
+		if (pTag)
+			pTag->_bytes.fetch_sub(_capacity, memory_order_relaxed);
 		Allocator::Free(_buffer, _capacity);
+	}
+}
+
+void Buffer::account(UInt32 oldCapacity) {
+	Tag* pTag = _pTag.load(memory_order_relaxed);
+	if (!pTag) {
+		if (!Tag::Enabled())
+			return;
+		_pTag.store(pTag = &Tag::Current(), memory_order_relaxed);
+		oldCapacity = 0; // was not accounted
+	}
+	pTag->_bytes.fetch_add(Int64(_capacity) - oldCapacity, memory_order_relaxed);
 }
 
 Buffer& Buffer::append(const void* data, UInt32 size) {
@@ -140,6 +230,7 @@ Buffer& Buffer::resize(UInt32 size, bool preserveData) {
 	// deallocate if was allocated
 	if (oldCapacity)
 		Allocator::Free(_buffer, oldCapacity);
+	account(oldCapacity);
 
 	_size = size;
 	_buffer=_data;
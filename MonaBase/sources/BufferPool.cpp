@@ -15,6 +15,7 @@ details (or else see http://mozilla.org/MPL/2.0/).
 */
 
 #include "Mona/BufferPool.h"
+#include "Mona/Metrics.h"
 
 
 using namespace std;
@@ -22,6 +23,19 @@ using namespace std;
 
 namespace Mona {
 
+static Metrics::Counter Hits("mona_bufferpool_hits_total", "Buffer allocations served by the pool");
+static Metrics::Counter Misses("mona_bufferpool_misses_total", "Buffer allocations missed by the pool and allocated on the heap");
+
+UInt8* BufferPool::alloc(UInt32& capacity) {
+	UInt8* buffer = _buffers[computeIndex(capacity)].pop();
+	if (buffer) {
+		++Hits;
+		return buffer;
+	}
+	++Misses;
+	return new UInt8[capacity];
+}
+
 UInt8* BufferPool::Buffers::pop() {
 	if (empty())
 		return NULL;
@@ -0,0 +1,480 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+#include "Mona/DNSResolver.h"
+#include "Mona/BinaryWriter.h"
+#include "Mona/File.h"
+#include "Mona/Util.h"
+#include "Mona/Logs.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace Mona {
+
+enum {
+	TYPE_A = 1,
+	TYPE_CNAME = 5,
+	TYPE_AAAA = 28
+};
+
+static bool ForEachLine(Exception& ex, const Path& path, const function<void(vector<string>& words)>& forEach) {
+	File file(path, File::MODE_READ);
+	Buffer buffer(UInt32(file.size()));
+	int readen = file.read(ex, buffer.data(), buffer.size());
+	if (readen < 0)
+		return false;
+	buffer.resize(readen);
+	vector<string> words;
+	String::ForEach forEachLine([&](UInt32 index, const char* line) {
+		const char* comment = strpbrk(line, "#;");
+		words.clear();
+		String::Split(line, comment ? (comment - line) : string::npos, " \t", words, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+		if (!words.empty())
+			forEach(words);
+		return true;
+	});
+	String::Split(STR buffer.data(), buffer.size(), "\r\n", forEachLine, SPLIT_IGNORE_EMPTY);
+	return true;
+}
+
+
+DNSResolver::DNSResolver(IOSocket& io, const Timer& timer) : io(io), _timer(timer), _timeout(2000), _attempts(3), _maxCached(1024) {
+	_onTimer = [this](UInt32 delay) {
+		for (shared<UDPSocket>& pUDP : _udpClosings) {
+			pUDP->onPacket = nullptr;
+			pUDP->onError = nullptr;
+		}
+		_udpClosings.clear();
+		for (shared<TCPClient>& pTCP : _closings) {
+			pTCP->onData = nullptr;
+			pTCP->onError = nullptr;
+		}
+		_closings.clear();
+		UInt32 timeout = _timeout;
+		auto it = _requests.begin();
+		while (it != _requests.end()) {
+			Request& request = it->second;
+			Int64 elapsed = request.time.elapsed();
+			if (elapsed < _timeout) {
+				if ((_timeout - elapsed) < timeout)
+					timeout = UInt32(_timeout - elapsed);
+				++it;
+				continue;
+			}
+			if (request.attempts >= _attempts) {
+				Exception ex;
+				ex.set<Ex::Net::Address::Ip>("DNS resolution timeout (hostname=", request.pQuery->name, ")");
+				finish(it, ex);
+				continue;
+			}
+			// try again on the next server
+			if (request.pTCP)
+				sendTCP(it->first, request);
+			else
+				send(it->first, request);
+			++it;
+		}
+		// stay alive to release the sockets of requests finished on this raising
+		return (_requests.empty() && _udpClosings.empty() && _closings.empty()) ? 0 : timeout;
+	};
+
+	// system name servers
+	Exception ex;
+#if defined(_WIN32)
+	ULONG size(0);
+	GetNetworkParams(NULL, &size);
+	Buffer buffer(size);
+	FIXED_INFO* pInfo = (FIXED_INFO*)buffer.data();
+	if (GetNetworkParams(pInfo, &size) == ERROR_SUCCESS) {
+		for (IP_ADDR_STRING* pServer = &pInfo->DnsServerList; pServer; pServer = pServer->Next) {
+			IPAddress host;
+			if (host.set(ex, pServer->IpAddress.String))
+				_servers.emplace_back(host, 53);
+		}
+	}
+	const char* root = getenv("SystemRoot");
+	Path hosts(root ? root : "C:\\Windows", "\\System32\\drivers\\etc\\hosts");
+#else
+	ForEachLine(ex, "/etc/resolv.conf", [this](vector<string>& words) {
+		IPAddress host;
+		Exception ex;
+		if (words.size() > 1 && words[0] == "nameserver" && host.set(ex, words[1]))
+			_servers.emplace_back(host, 53);
+	});
+	Path hosts("/etc/hosts");
+#endif
+	if (_servers.empty())
+		_servers.emplace_back(IPAddress::Loopback(), 53);
+	if (!loadHosts(ex = nullptr, hosts))
+		DEBUG("DNSResolver hosts file, ", ex);
+}
+
+DNSResolver::~DNSResolver() {
+	_timer.set(_onTimer, 0);
+	for (auto& it : _requests) {
+		if (it.second.pUDP)
+			_udpClosings.emplace_back(move(it.second.pUDP));
+		if (it.second.pTCP)
+			_closings.emplace_back(move(it.second.pTCP));
+	}
+	for (shared<UDPSocket>& pUDP : _udpClosings) {
+		pUDP->onPacket = nullptr;
+		pUDP->onError = nullptr;
+	}
+	for (shared<TCPClient>& pTCP : _closings) {
+		pTCP->onData = nullptr;
+		pTCP->onError = nullptr;
+	}
+}
+
+bool DNSResolver::loadHosts(Exception& ex, const Path& path) {
+	map<string, HostEntry> hosts;
+	if (!ForEachLine(ex, path, [&hosts](vector<string>& words) {
+		IPAddress address;
+		Exception ex;
+		if (words.size() < 2 || !address.set(ex, words[0]))
+			return;
+		for (UInt32 i = 1; i < words.size(); ++i) {
+			HostEntry& host = hosts[String::ToLower(words[i])];
+			if (host._name.empty()) {
+				// first name of the line is the canonical name, following are aliases
+				host._name = words[1];
+				host._aliases.assign(words.begin() + 2, words.end());
+			}
+			host._addresses.emplace(address);
+		}
+	}))
+		return false;
+	_hosts = move(hosts);
+	return true;
+}
+
+void DNSResolver::resolve(const char* hostname, const OnResolved& onResolved) {
+	string name(hostname);
+	String::ToLower(name);
+	if (!name.empty() && name.back() == '.')
+		name.pop_back();
+	HostEntry host;
+	Exception ex;
+	if (name.empty()) {
+		ex.set<Ex::Net::Address::Ip>("empty hostname");
+		return raise(OnResolved(onResolved), ex, host);
+	}
+
+	// IP address?
+	IPAddress address;
+	if (address.set(ex, name)) {
+		host._name = move(name);
+		host._addresses.emplace(address);
+		return raise(OnResolved(onResolved), ex, host);
+	}
+	ex = nullptr;
+
+	// hosts file?
+	const auto& itHost = _hosts.find(name);
+	if (itHost != _hosts.end())
+		return raise(OnResolved(onResolved), ex, itHost->second);
+
+	// cache?
+	const auto& itCache = _cache.find(name);
+	if (itCache != _cache.end()) {
+		if (itCache->second.expiration > Time::Now())
+			return raise(OnResolved(onResolved), ex, itCache->second.host);
+		_cache.erase(itCache);
+	}
+
+	// resolution already running?
+	auto itQuery = _queries.lower_bound(name);
+	if (itQuery != _queries.end() && itQuery->first == name) {
+		itQuery->second->subscribers.emplace_back(onResolved);
+		return;
+	}
+
+	// check hostname validity (labels of 63 bytes maximum and 253 characters maximum)
+	size_t start = 0;
+	do {
+		size_t end = name.find('.', start);
+		if (end == string::npos)
+			end = name.size();
+		if (end == start || (end - start) > 63 || name.size() > 253) {
+			ex.set<Ex::Net::Address::Ip>("Invalid hostname ", name);
+			return raise(OnResolved(onResolved), ex, host);
+		}
+		start = end + 1;
+	} while (start < name.size());
+
+	// A and AAAA requests in parallel
+	shared<Query>& pQuery = _queries.emplace_hint(itQuery, name, nullptr)->second;
+	pQuery.set(name).subscribers.emplace_back(onResolved);
+	for (UInt16 type : { TYPE_A, TYPE_AAAA }) {
+		// random id by request, not predictable from a previous one (protection against spoofing)
+		UInt16 id;
+		do {
+			id = Util::Random<UInt16>();
+		} while (_requests.count(id));
+		send(id, _requests.emplace(piecewise_construct, forward_as_tuple(id), forward_as_tuple(pQuery, type)).first->second);
+		++pQuery->pending;
+	}
+	if (!_onTimer.nextRaising() || _onTimer.nextRaising() > (Time::Now() + _timeout))
+		_timer.set(_onTimer, _timeout);
+}
+
+static shared<Buffer> WriteRequest(UInt16 id, UInt16 type, const string& name, bool tcp) {
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	if (tcp)
+		writer.write16(0); // size
+	// header: id, recursion desired, 1 question
+	writer.write16(id).write16(0x0100).write16(1).write16(0).write16(0).write16(0);
+	// question
+	String::ForEach forEach([&writer](UInt32 index, const char* label) {
+		writer.write8(UInt8(strlen(label))).write(label, strlen(label));
+		return true;
+	});
+	String::Split(name, ".", forEach);
+	writer.write8(0).write16(type).write16(1); // class IN
+	if (tcp)
+		BinaryWriter(pBuffer->data(), 2).write16(pBuffer->size() - 2);
+	return pBuffer;
+}
+
+void DNSResolver::send(UInt16 id, Request& request) {
+	request.server = request.attempts++ % _servers.size();
+	request.time.update();
+	if (!request.pUDP) {
+		// socket by request, its source port is a random ephemeral port of the system (protection against spoofing)
+		request.pUDP.set(io);
+		request.pUDP->onError = [](const Exception& ex) { WARN("DNSResolver, ", ex); };
+		request.pUDP->onPacket = [this, id, pUDP = request.pUDP.get()](shared<Buffer>& pBuffer, const SocketAddress& address) {
+			const auto& it = _requests.find(id);
+			// check that the answer comes from the server requested
+			if (it == _requests.end() || it->second.pUDP.get() != pUDP || it->second.pTCP || pBuffer->size() < 2 || BinaryReader(pBuffer->data(), 2).read16() != id ||
+				it->second.server >= _servers.size() || address != _servers[it->second.server] || !answer(id, pBuffer->data(), pBuffer->size(), false))
+				DEBUG("Unexpected DNS answer from ", address);
+		};
+	}
+	shared<Buffer> pBuffer = WriteRequest(id, request.type, request.pQuery->name, false);
+	Exception ex;
+	AUTO_WARN(request.pUDP->send(ex, Packet(pBuffer), _servers[request.server]), "DNS request");
+}
+
+void DNSResolver::sendTCP(UInt16 id, Request& request) {
+	if (request.pTCP) {
+		// new attempt, on the next server
+		request.server = request.attempts++ % _servers.size();
+		_closings.emplace_back(move(request.pTCP));
+	}
+	request.time.update();
+	request.pTCP.set(io);
+	request.pTCP->onError = [](const Exception& ex) { DEBUG("DNSResolver TCP, ", ex); }; // timeout will do the job
+	request.pTCP->onData = [this, id, pTCP = request.pTCP.get()](Packet& buffer) -> UInt32 {
+		if (buffer.size() < 2)
+			return buffer.size();
+		UInt16 size = BinaryReader(buffer.data(), 2).read16();
+		if (buffer.size() < (size + 2u))
+			return buffer.size(); // wait more
+		const auto& it = _requests.find(id);
+		if (it == _requests.end() || it->second.pTCP.get() != pTCP || !answer(id, buffer.data() + 2, size, true))
+			DEBUG("Unexpected DNS answer from ", pTCP->socket()->peerAddress());
+		return 0;
+	};
+	shared<Buffer> pBuffer = WriteRequest(id, request.type, request.pQuery->name, true);
+	Exception ex;
+	if (!request.pTCP->connect(ex, _servers[request.server]) || !request.pTCP->send(ex, Packet(pBuffer)))
+		DEBUG("DNSResolver TCP, ", ex); // timeout will do the job
+}
+
+bool DNSResolver::answer(UInt16 id, const UInt8* data, UInt32 size, bool tcp) {
+	auto it = _requests.find(id);
+	Request& request = it->second;
+	Query& query = *request.pQuery;
+	BinaryReader reader(data, size);
+	reader.next(2); // id
+	UInt16 flags = reader.read16();
+	if (!(flags & 0x8000))
+		return false; // not an answer
+	UInt16 questions = reader.read16();
+	UInt16 answers = reader.read16();
+	reader.next(4); // authority and additional records
+
+	// question has to match the request (protection against spoofing)
+	string name;
+	if (questions != 1 || !ReadName(reader, name) || String::ICompare(name, query.name) != 0 || reader.read16() != request.type || reader.read16() != 1)
+		return false;
+
+	if (flags & 0x0200) { // truncated!
+		if (!tcp) {
+			sendTCP(id, request);
+			return true;
+		}
+		// keep the records received
+	}
+
+	Exception ex;
+	switch (flags & 0x0F) {
+		case 0: // no error
+			break;
+		case 3:
+			ex.set<Ex::Net::Address::Ip>("Host ", query.name, " not found");
+			break;
+		default:
+			ex.set<Ex::Net::Address::Ip>("DNS server ", _servers[request.server], " error ", flags & 0x0F, " (hostname=", query.name, ")");
+	}
+
+	while (!ex && answers-- && ReadName(reader, name)) {
+		UInt16 type = reader.read16();
+		reader.next(2); // class
+		UInt32 ttl = reader.read32();
+		UInt16 length = reader.read16();
+		if (length > reader.available())
+			break;
+		switch (type) {
+			case TYPE_A:
+				if (length == sizeof(in_addr)) {
+					in_addr address;
+					memcpy(&address, reader.current(), length);
+					query.host._addresses.emplace(address);
+					query.ttl = min(query.ttl, ttl);
+				}
+				break;
+			case TYPE_AAAA:
+				if (length == sizeof(in6_addr)) {
+					in6_addr address;
+					memcpy(&address, reader.current(), length);
+					query.host._addresses.emplace(address);
+					query.ttl = min(query.ttl, ttl);
+				}
+				break;
+			case TYPE_CNAME: {
+				// name is an alias of the canonical name
+				BinaryReader cname(data, size);
+				cname.next(reader.position());
+				if (!ReadName(cname, query.host._name))
+					break;
+				if (find(query.host._aliases.begin(), query.host._aliases.end(), name) == query.host._aliases.end())
+					query.host._aliases.emplace_back(move(name));
+				query.ttl = min(query.ttl, ttl);
+				break;
+			}
+			default:;
+		}
+		reader.next(length);
+	}
+	finish(it, ex);
+	return true;
+}
+
+void DNSResolver::finish(map<UInt16, Request>::iterator& it, const Exception& ex) {
+	shared<Query> pQuery(move(it->second.pQuery));
+	if (it->second.pUDP)
+		_udpClosings.emplace_back(move(it->second.pUDP));
+	if (it->second.pTCP)
+		_closings.emplace_back(move(it->second.pTCP));
+	it = _requests.erase(it);
+	if (ex && !pQuery->ex)
+		pQuery->ex = ex;
+	if (--pQuery->pending)
+		return;
+	_queries.erase(pQuery->name);
+	if (pQuery->host._addresses.empty()) {
+		if (!pQuery->ex)
+			pQuery->ex.set<Ex::Net::Address::Ip>("No ip found for host ", pQuery->name);
+	} else {
+		pQuery->ex = nullptr;
+		if (pQuery->host._name.empty())
+			pQuery->host._name = pQuery->name;
+		if (pQuery->ttl)
+			cache(*pQuery);
+	}
+	for (const OnResolved& onResolved : pQuery->subscribers)
+		raise(onResolved, pQuery->ex, pQuery->host);
+}
+
+void DNSResolver::cache(const Query& query) {
+	if (!_maxCached)
+		return;
+	if (_cache.size() >= _maxCached) {
+		// full, remove expired entries
+		Int64 now = Time::Now();
+		auto it = _cache.begin();
+		while (it != _cache.end()) {
+			if (it->second.expiration <= now)
+				it = _cache.erase(it);
+			else
+				++it;
+		}
+		// always full, remove the entries which expire first
+		while (_cache.size() >= _maxCached) {
+			auto itFirst = _cache.begin();
+			for (it = itFirst; it != _cache.end(); ++it) {
+				if (it->second.expiration < itFirst->second.expiration)
+					itFirst = it;
+			}
+			_cache.erase(itFirst);
+		}
+	}
+	_cache.emplace(piecewise_construct, forward_as_tuple(query.name), forward_as_tuple(query.host, query.ttl));
+}
+
+void DNSResolver::raise(const OnResolved& onResolved, const Exception& ex, const HostEntry& host) {
+	struct Result : Runner, virtual Object {
+		// share function of onResolved which is a weak copy of the subscriber
+		Result(const OnResolved& onResolved, const Exception& ex, const HostEntry& host) : Runner("DNSResolved"), _onResolved(move(onResolved)), _ex(ex), _host(host) {}
+		bool run(Exception&) { _onResolved(_ex, _host); return true; }
+	private:
+		OnResolved	_onResolved;
+		Exception	_ex;
+		HostEntry	_host;
+	};
+	io.handler.queue<Result>(onResolved, ex, host);
+}
+
+bool DNSResolver::ReadName(BinaryReader& reader, string& name) {
+	name.clear();
+	UInt32 end = 0; // position after the name when compressed
+	UInt8 jumps = 0;
+	while (reader.available()) {
+		UInt8 length = reader.read8();
+		if (!length) {
+			if (end)
+				reader.reset(end);
+			return true;
+		}
+		if ((length & 0xC0) == 0xC0) {
+			// compression pointer
+			if (!reader.available() || ++jumps > 16)
+				return false; // loop!
+			UInt16 offset = ((length & 0x3F) << 8) | reader.read8();
+			if (!end)
+				end = reader.position();
+			if (offset >= reader.size())
+				return false;
+			reader.reset(offset);
+			continue;
+		}
+		if ((length & 0xC0) || length > reader.available())
+			return false;
+		if (!name.empty())
+			name += '.';
+		name.append(STR reader.current(), length);
+		reader.next(length);
+	}
+	return false;
+}
+
+
+} // namespace Mona
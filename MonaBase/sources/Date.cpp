@@ -707,6 +707,22 @@ bool Date::update(Exception& ex, const char* current, size_t size, const char* f
 	return true;
 }
 
+bool Date::IsISO8601(const char* value, size_t size) {
+	if (size == string::npos)
+		size = strlen(value);
+	if (size < 9)
+		return false;
+	for (UInt8 i = 0; i < 4; ++i) {
+		if (!isdigit(value[i]))
+			return false;
+	}
+	if (value[4] != '-') // compact YYYYMMDDT
+		return isdigit(value[4]) && isdigit(value[5]) && isdigit(value[6]) && isdigit(value[7]) && value[8] == 'T';
+	if (size < 10 || !isdigit(value[5]) || !isdigit(value[6]) || value[7] != '-' || !isdigit(value[8]) || !isdigit(value[9]))
+		return false;
+	return size == 10 || value[10] == 'T' || value[10] == ' ';
+}
+
 bool Date::parseAuto(Exception& ex, const char* data, size_t count) {
 
 	size_t length(0),tPos(0);
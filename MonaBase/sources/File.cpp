@@ -24,6 +24,7 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include <unistd.h>
 #if defined(_BSD) && !defined(lseek64) // not defined on 64 bit systems
 	#define lseek64 lseek
+	#define pread64 pread
 	#define off64_t off_t
 #endif
 #endif
@@ -193,10 +194,18 @@ bool File::reset(UInt64 position) {
 	_readen = position;
 #if defined(_WIN32)
 	LARGE_INTEGER offset;
-	offset.QuadPart = -(LONGLONG)_written.exchange(position) + position; // move relating APPEND possible mode!
-	SetFilePointerEx((HANDLE)_handle, offset, NULL, FILE_CURRENT);
+	if (mode) {
+		offset.QuadPart = -(LONGLONG)_written.exchange(position) + position; // move relating APPEND possible mode!
+		SetFilePointerEx((HANDLE)_handle, offset, NULL, FILE_CURRENT);
+	} else { // read => absolute position (random access)
+		offset.QuadPart = position;
+		SetFilePointerEx((HANDLE)_handle, offset, NULL, FILE_BEGIN);
+	}
 #else
-	lseek64(_handle, -(off64_t )_written.exchange(position) + position, SEEK_CUR);
+	if (mode)
+		lseek64(_handle, -(off64_t )_written.exchange(position) + position, SEEK_CUR); // move relating APPEND possible mode!
+	else // read => absolute position (random access)
+		lseek64(_handle, position, SEEK_SET);
 #endif
 	return true;
 }
@@ -212,12 +221,17 @@ int File::read(Exception& ex, void* data, UInt32 size) {
 		ex.set<Ex::Permission>(_path, " read unauthorized in writing, append or deletion mode");
 		return -1;
 	}
+	// read on _readen position, it can have been moved without the file pointer (see FileCache)
 #if defined(_WIN32)
 	DWORD readen;
-	if (!ReadFile((HANDLE)_handle, data, size, &readen, NULL))
-		readen = -1;
+	OVERLAPPED overlapped;
+	memset(&overlapped, 0, sizeof(overlapped));
+	overlapped.Offset = DWORD(_readen & 0xFFFFFFFF);
+	overlapped.OffsetHigh = DWORD(_readen >> 32);
+	if (!ReadFile((HANDLE)_handle, data, size, &readen, &overlapped))
+		readen = GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
 #else
-	ssize_t readen = ::read(_handle, data, size);
+	ssize_t readen = ::pread64(_handle, data, size, _readen);
 #endif
 	if (readen < 0) {
 		ex.set<Ex::System::File>("Impossible to read ", _path, " (size=", size, ")");
@@ -0,0 +1,164 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+#include "Mona/FileCache.h"
+#include "Mona/IOFile.h"
+#include "Mona/Logs.h"
+#include "Mona/Metrics.h"
+#if !defined(_WIN32)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+namespace Mona {
+
+static Metrics::Counter Hits("mona_filecache_hits_total", "File readings served by a memory mapping of the file cache");
+static Metrics::Counter Misses("mona_filecache_misses_total", "File readings missed by the file cache (file not mapped or changed)");
+static Metrics::Gauge   Mapped("mona_filecache_bytes", "Bytes of files mapped in the file cache");
+
+FileCache::Map::~Map() {
+#if defined(_WIN32)
+	UnmapViewOfFile(data());
+#else
+	munmap(data(), size());
+#endif
+}
+
+void FileCache::setBudget(UInt64 budget) {
+	_budget = budget;
+	lock_guard<mutex> lock(_mutex);
+	while (_size > _budget && !_lru.empty()) {
+		auto it = _entries.find(_lru.back());
+		erase(it);
+	}
+}
+
+shared<const Buffer> FileCache::read(File& file, UInt32 size) {
+	if (!_budget || file.mode)
+		return nullptr;
+	Exception ex;
+	if (!file.load(ex))
+		return nullptr; // File::read will report the error
+	UInt64 fileSize = file.size();
+	if (!fileSize || fileSize > _maxFileSize || file.readen() >= fileSize || (Time::Now() - file.lastChange()) < _stableDelay)
+		return nullptr; // empty, too big or in progress (can be always in writing)
+	shared<Map> pMap = map(file);
+	if (!pMap)
+		return nullptr;
+	// check again the real size to not read a mapping on a truncated file (SIGBUS)
+#if defined(_WIN32)
+	LARGE_INTEGER current;
+	if (!GetFileSizeEx((HANDLE)file._handle, &current) || UInt64(current.QuadPart) < pMap->size()) {
+#else
+	struct stat current;
+	if (fstat(file._handle, &current) || UInt64(current.st_size) < pMap->size()) {
+#endif
+		invalidate(file.path());
+		return nullptr;
+	}
+	UInt32 offset = UInt32(file.readen());
+	if (size > (pMap->size() - offset))
+		size = pMap->size() - offset;
+	file._readen += size;
+	return shared<Slice>(SET, pMap, offset, size);
+}
+
+shared<FileCache::Map> FileCache::map(File& file) {
+	lock_guard<mutex> lock(_mutex);
+	auto it = _entries.find(file.path());
+	if (it != _entries.end()) {
+		if (it->second.lastChange == file.lastChange() && it->second.pMap->size() == file.size()) {
+			++_hits;
+			++Hits;
+			_lru.splice(_lru.begin(), _lru, it->second.it);
+			return it->second.pMap;
+		}
+		erase(it); // file changed
+	}
+	++_misses;
+	++Misses;
+	if (file.size() > _budget)
+		return nullptr;
+
+	// map the file with its handle already opened
+	UInt32 size = UInt32(file.size());
+#if defined(_WIN32)
+	HANDLE handle = CreateFileMapping((HANDLE)file._handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	void* data = handle ? MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, size) : NULL;
+	if (handle)
+		CloseHandle(handle); // the view keeps the mapping
+	if (!data) {
+#else
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file._handle, 0);
+	if (data == MAP_FAILED) {
+#endif
+		WARN("Impossible to map ", file.path(), " in cache");
+		return nullptr;
+	}
+
+	_lru.emplace_front(file.path());
+	Entry& entry = _entries.emplace(piecewise_construct, forward_as_tuple(file.path()), forward_as_tuple(_lru.begin())).first->second;
+	entry.pMap.set(data, size);
+	entry.lastChange = file.lastChange();
+	_size += size;
+	Mapped += size;
+	++_count;
+
+	// invalidate on file change
+	entry.onUpdate = [this, path = file.path()](const Path& file, bool firstWatch) {
+		if (!firstWatch)
+			invalidate(path);
+	};
+	entry.pWatcher.set(Path(file.path()));
+	_io.watch(entry.pWatcher, entry.onUpdate);
+
+	// respect budget
+	while (_size > _budget && _lru.size() > 1) {
+		it = _entries.find(_lru.back());
+		erase(it);
+	}
+	return entry.pMap;
+}
+
+void FileCache::erase(std::map<string, Entry>::iterator& it) {
+	_size -= it->second.pMap->size();
+	Mapped -= it->second.pMap->size();
+	--_count;
+	_lru.erase(it->second.it);
+	it = _entries.erase(it);
+}
+
+void FileCache::invalidate(const string& path) {
+	if (!_count)
+		return;
+	lock_guard<mutex> lock(_mutex);
+	auto it = _entries.find(path);
+	if (it != _entries.end())
+		erase(it);
+}
+
+void FileCache::clear() {
+	lock_guard<mutex> lock(_mutex);
+	_entries.clear();
+	_lru.clear();
+	Mapped -= _size;
+	_size = 0;
+	_count = 0;
+}
+
+} // namespace Mona
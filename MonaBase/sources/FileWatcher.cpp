@@ -15,6 +15,9 @@ details (or else see http://mozilla.org/MPL/2.0/).
 */
 
 #include "Mona/FileWatcher.h"
+#if !defined(_WIN32) && !defined(_BSD)
+	#include <sys/inotify.h>
+#endif
 
 
 namespace Mona {
@@ -36,16 +39,8 @@ int FileWatcher::watch(Exception &ex, const OnUpdate& onUpdate) {
 		// List files/folders from parent folder!
 		FileSystem::ForEach forEach([this, &onUpdate, &count, &lastChanges](const string& file, UInt16 level) {
 			Path path(file);
-			if (_justFolder && !path.isFolder())
-				return true; // just folders!
-			if (_ext) { // just files!
-				if (path.isFolder())
-					return true;
-				if (*_ext != '*' && String::ICompare(path.extension(), _ext) != 0)
-					return true; // don't match *.extension!
-			}
-			if (_baseName && String::ICompare(path.baseName(), _baseName) != 0)
-				return true; // don't match *.extension!
+			if (!match(path))
+				return true;
 			++count;
 			watchFile(lastChanges, path, onUpdate);
 			return !_baseName || (_ext && *_ext == '*');
@@ -70,6 +65,26 @@ int FileWatcher::watch(Exception &ex, const OnUpdate& onUpdate) {
 
 }
 
+bool FileWatcher::match(const Path& file) const {
+	if (mode != FileSystem::MODE_HEAVY) {
+		if (_baseName && (!_ext || *_ext != '*'))
+			return String::ICompare(file, path) == 0; // simple file or folder
+		if (String::ICompare(file.parent(), path.parent()) != 0)
+			return false; // not in the directory
+	}
+	if (_justFolder && !file.isFolder())
+		return false; // just folders!
+	if (_ext) { // just files!
+		if (file.isFolder())
+			return false;
+		if (*_ext != '*' && String::ICompare(file.extension(), _ext) != 0)
+			return false; // don't match *.extension!
+	}
+	if (_baseName && String::ICompare(file.baseName(), _baseName) != 0)
+		return false; // don't match name.*
+	return true;
+}
+
 void FileWatcher::watchFile(map<Path, pair<Time, bool>, String::IComparator>& lastChanges, const Path& path, const OnUpdate& onUpdate) {
 	// if path doesn't exist path.lastChange()==0
 	pair<Time, bool>& lastChange = _lastChanges.emplace(path, pair<Time, bool>(0, false)).first->second;
@@ -88,4 +103,105 @@ void FileWatcher::watchFile(map<Path, pair<Time, bool>, String::IComparator>& la
 	}
 }
 
+#if !defined(_WIN32) && !defined(_BSD)
+
+bool FileWatcher::notify(Exception& ex, int fd) {
+	if (!notify(ex, fd, path.parent()))
+		return false;
+	if (mode != FileSystem::MODE_HEAVY)
+		return true;
+	bool success = true;
+	FileSystem::ForEach forEach([this, &ex, fd, &success](const string& file, UInt16 level) {
+		if (file.back() == '/' && success) // folder
+			success = notify(ex, fd, file);
+		return success;
+	});
+	FileSystem::ListFiles(ex, path.parent(), forEach, mode);
+	return success;
+}
+
+bool FileWatcher::notify(Exception& ex, int fd, const string& folder) {
+	// folder empty for a relative path in the current directory, keep it empty to build files as matched by path
+	int wd = inotify_add_watch(fd, folder.empty() ? "." : folder.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_ONLYDIR);
+	if (wd < 0) {
+		if (errno == ENOSPC)
+			ex.set<Ex::System::File>("inotify watch limit reached, increase fs.inotify.max_user_watches to watch ", folder);
+		else
+			ex.set<Ex::System::File>("Cannot watch ", folder, " with inotify");
+		return false;
+	}
+	_folders[wd] = folder;
+	return true;
+}
+
+bool FileWatcher::notified(Exception& ex, int fd, int wd, UInt32 mask, const char* name) {
+	if (mask & IN_Q_OVERFLOW) {
+		// events lost, check everything in a polling way
+		watch(ex, onUpdate);
+		return true;
+	}
+	const auto& it = _folders.find(wd);
+	if (it == _folders.end())
+		return true; // event of one other watcher
+	if (mask & IN_IGNORED) {
+		// folder deleted, if it's the root folder polling is required to detect its recreation
+		if (String::ICompare(it->second, path.parent()) == 0) {
+			ex.set<Ex::Unfound>(it->second, " deleted");
+			_folders.erase(it);
+			return false;
+		}
+		_folders.erase(it);
+		return true;
+	}
+	if (!name || !*name)
+		return true;
+	bool isFolder = (mask & IN_ISDIR) ? true : false;
+	Path file(it->second, name, isFolder ? "/" : "");
+
+	if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+		// deletion (or move) of the file, and of the folder content if folder
+		auto itChange = _lastChanges.lower_bound(file);
+		while (itChange != _lastChanges.end() && String::ICompare(itChange->first, file, isFolder ? file.length() : string::npos) == 0) {
+			Path deleted(itChange->first);
+			itChange = _lastChanges.erase(itChange);
+			if (!deleted.exists(true)) // refresh, and can have been recreated immediatly
+				onUpdate(deleted, false);
+		}
+		return true;
+	}
+
+	if (isFolder && mode == FileSystem::MODE_HEAVY && (mask & (IN_CREATE | IN_MOVED_TO))) {
+		// new sub folder, watch it and its content (it can have been filled before the watch)
+		if (!notify(ex, fd, file))
+			return false;
+		bool success = true;
+		FileSystem::ForEach forEach([this, &ex, fd, &success](const string& file, UInt16 level) {
+			Path path(file);
+			if (path.isFolder() && success)
+				success = notify(ex, fd, file);
+			if (match(path))
+				update(path);
+			return success;
+		});
+		FileSystem::ListFiles(ex, file, forEach, mode);
+		if (!success)
+			return false;
+	}
+
+	if (!isFolder && (mask & IN_CREATE))
+		return true; // wait IN_CLOSE_WRITE to get a complete file
+	if (match(file))
+		update(file);
+	return true;
+}
+
+void FileWatcher::update(const Path& file) {
+	pair<Time, bool>& lastChange = _lastChanges.emplace(file, pair<Time, bool>(0, false)).first->second;
+	lastChange.first = file.lastChange(true);
+	lastChange.second = true; // signal done
+	onUpdate(file, false);
+}
+
+#endif
+
 } // namespace Mona
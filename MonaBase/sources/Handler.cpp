@@ -22,8 +22,12 @@ using namespace std;
 
 namespace Mona {
 
+Metrics::Gauge		Handler::Queue("mona_handler_queue", "Runners queued to a thread handler and waiting their execution");
+Metrics::Histogram	Handler::Wait("mona_handler_wait_seconds", "Wait time of runners in a thread handler queue");
+
 void Handler::reset(Signal& signal) {
 	std::lock_guard<std::mutex> lock(_mutex);
+	Queue -= _runners.size(); // runners dropped, no more waiting
 	_runners.clear();
 	_pSignal = &signal;
 }
@@ -32,13 +36,22 @@ UInt32 Handler::flush(bool last) {
 	// Flush all what is possible now, and not dynamically in real-time (in rechecking _runners)
 	// to keep the possibility to do something else between two flushs!
 	deque<shared<Runner>> runners;
+	Int64 queued;
 	{
 		lock_guard<mutex> lock(_mutex);
 		if(last)
 			_pSignal = NULL;
 		runners = move(_runners);
+		queued = _queued;
+	}
+	if (!runners.empty()) {
+		Queue -= runners.size();
+		Wait.record(Metrics::Microseconds() - queued);
 	}
 	for (shared<Runner>& pRunner : runners) {
+		if (pRunner->trace)
+			pRunner->trace.ran = Metrics::Microseconds();
+		Metrics::Trace::Scope trace(pRunner->trace);
 		pRunner->run('.', pRunner->name); // '.' to signal that its a sub-runner, wait the name of the thread in htop
 		pRunner.reset(); // release resources
 	}
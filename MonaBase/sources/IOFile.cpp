@@ -15,12 +15,27 @@ details (or else see http://mozilla.org/MPL/2.0/).
 */
 
 #include "Mona/IOFile.h"
+#include "Mona/Logs.h"
+#include "Mona/Metrics.h"
 #include <list>
+#if !defined(_WIN32) && !defined(_BSD)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 using namespace std;
 
 namespace Mona {
 
+static Metrics::Gauge Queueing("mona_iofile_queueing_bytes", "Bytes queued to be written in files");
+
+static Buffer::Tag& BufferTag() {
+	static Buffer::Tag& Tag(Buffer::Tag::Get("file"));
+	return Tag;
+}
+
 struct IOFile::Action : Runner, virtual Object {
 	Action(const char* name, const Handler& handler, const shared<File>& pFile) : Runner(name), _pFile(pFile) {
 		pFile->_pHandler = &handler;
@@ -82,12 +97,31 @@ private:
 };
 
 IOFile::IOFile(const Handler& handler, const ThreadPool& threadPool, UInt16 cores) :
-	handler(handler), threadPool(threadPool), _threadPool(Thread::PRIORITY_LOW, cores*2), Thread("FileWatching") { // 2*CPU => because disk speed can be at maximum 2x more than memory, and Low priority to not impact main thread pool
+	handler(handler), threadPool(threadPool), _threadPool(Thread::PRIORITY_LOW, cores*2), Thread("FileWatching"), cache(self) { // 2*CPU => because disk speed can be at maximum 2x more than memory, and Low priority to not impact main thread pool
+#if !defined(_WIN32) && !defined(_BSD)
+	_notifyFD = _eventFD = _readFD = 0;
+#endif
 }
 
 IOFile::~IOFile() {
 	join();
+	cache.clear(); // release its file watchers
 	stop(); // file watchers!
+#if !defined(_WIN32) && !defined(_BSD)
+	if (_notifyFD > 0) {
+		::close(_notifyFD);
+		::close(_eventFD);
+		::close(_readFD);
+	}
+#endif
+}
+
+void IOFile::stop() {
+#if !defined(_WIN32) && !defined(_BSD)
+	if (_notifyFD > 0) // wake up poll
+		while (::write(_eventFD, "", 1) < 0 && errno == EINTR);
+#endif
+	Thread::stop();
 }
 
 void IOFile::join() {
@@ -111,68 +145,80 @@ void IOFile::load(const shared<File>& pFile) {
 
 void IOFile::read(const shared<File>& pFile, UInt32 size) {
 	struct ReadFile : Action {
-		ReadFile(const Handler& handler, const shared<File>& pFile, const ThreadPool& threadPool, UInt32 size) : Action("ReadFile", handler, pFile), _threadPool(threadPool), _size(size) {}
+		ReadFile(const Handler& handler, const shared<File>& pFile, const ThreadPool& threadPool, FileCache& cache, UInt32 size) : Action("ReadFile", handler, pFile), _threadPool(threadPool), _cache(cache), _size(size) {}
 	private:
 		struct Handle : Action::Handle, virtual Object {
-			Handle(const char* name, shared<File>& pFile, shared<Buffer>& pBuffer, bool end) :
+			Handle(const char* name, shared<File>& pFile, shared<const Buffer>& pBuffer, bool end) :
 				Action::Handle(name, pFile), _pBuffer(move(pBuffer)), _end(end) {}
 		private:
 			void handle(File& file) { file._onReaden(_pBuffer, _end); }
-			shared<Buffer>	_pBuffer;
+			shared<const Buffer>	_pBuffer;
 			bool   _end;
 		};
 		bool process(Exception& ex, shared<File>& pFile) override {
 			if (pFile.unique())
 				return true; // useless to read here, nobody to receive it!
+			Buffer::Tag::Scope bufferTag(BufferTag()); // reading and decoding buffers
 			// take the required size just if not exceeds file size to avoid to allocate a too big buffer (expensive)
 			// + use pFile->size() without refreshing to use as same size as caller has gotten it (for example to write a content-length in header)
 			UInt64 available = pFile->size() - pFile->readen();
-			shared<Buffer>	pBuffer(SET, UInt32(min(available, _size)));
-			pBuffer.set(UInt32(min(available, _size)));
-			int readen = pFile->read(ex, pBuffer->data(), pBuffer->size());
-			if (readen < 0)
-				return false;
-			if ((_size=readen) < pBuffer->size())
-				pBuffer->resize(readen, true);
+			// try first a slice of file mapping (hot file)
+			shared<const Buffer> pBuffer = _cache.read(*pFile, UInt32(min(available, _size)));
+			if (pBuffer)
+				_size = pBuffer->size();
+			else {
+				shared<Buffer> pReaden(SET, UInt32(min(available, _size)));
+				int readen = pFile->read(ex, pReaden->data(), pReaden->size());
+				if (readen < 0)
+					return false;
+				if ((_size = readen) < pReaden->size())
+					pReaden->resize(readen, true);
+				pBuffer = move(pReaden);
+			}
 			if (pFile->_pDecoder) {
 				struct Decoding : Action, virtual Object {
-					Decoding(shared<File>& pFile, const ThreadPool& threadPool, shared<Buffer>& pBuffer, bool end) :
-						_pThread(ThreadQueue::Current()), _threadPool(threadPool), _end(end), Action("DecodingFile", *pFile->_pHandler, pFile), _pBuffer(move(pBuffer)) {
+					Decoding(shared<File>& pFile, const ThreadPool& threadPool, FileCache& cache, shared<const Buffer>& pBuffer, bool end) :
+						_pThread(ThreadQueue::Current()), _threadPool(threadPool), _cache(cache), _end(end), Action("DecodingFile", *pFile->_pHandler, pFile), _pBuffer(move(pBuffer)) {
 						pFile.reset();
 					}
 				private:
 					bool process(Exception& ex, shared<File>& pFile) override {
 						if (pFile.unique())
 							return true; // useless to decode here, nobody to receive it!
+						Buffer::Tag::Scope bufferTag(BufferTag());
 						UInt32 decoded = pFile->_pDecoder->decode(_pBuffer, _end);
 						// decoded=wantToRead!
-						if(decoded && !_end)
-							_pThread->queue<ReadFile>(*pFile->_pHandler, pFile, _threadPool, decoded);
+						// decoder can have moved reading position (File::reset), so check _end with readen rather
+						if(decoded && (!_end || pFile->readen() < pFile->size()))
+							_pThread->queue<ReadFile>(*pFile->_pHandler, pFile, _threadPool, _cache, decoded);
 						if (_pBuffer)
 							handle<ReadFile::Handle>(_pBuffer, _end);
 						return true;
 					}
-					shared<Buffer>		_pBuffer;
+					shared<const Buffer>	_pBuffer;
 					bool				_end;
 					const ThreadPool&	_threadPool;
+					FileCache&			_cache;
 					ThreadQueue*		_pThread;
 				};
-				_threadPool.queue<Decoding>(pFile->_decodingTrack, pFile, _threadPool, pBuffer, _size == available);
+				_threadPool.queue<Decoding>(pFile->_decodingTrack, pFile, _threadPool, _cache, pBuffer, _size == available);
 			} else
 				handle<Handle>(pBuffer, _size == available);
 			return true;
 		}
 		UInt32				_size;
 		const ThreadPool&	_threadPool;
+		FileCache&			_cache;
 	};
 	// always do the job even if size==0 to get a onReaden event!
-	_threadPool.queue<ReadFile>(pFile->_ioTrack, handler, pFile, threadPool, size);
+	_threadPool.queue<ReadFile>(pFile->_ioTrack, handler, pFile, threadPool, cache, size);
 }
 
 void IOFile::write(const shared<File>& pFile, const Packet& packet) {
 	struct WriteFile : Action { 
-		WriteFile(const Handler& handler, const shared<File>& pFile, const Packet& packet) : _packet(move(packet)), Action("WriteFile", handler, pFile) {
+		WriteFile(const Handler& handler, const shared<File>& pFile, FileCache& cache, const Packet& packet) : _packet(move(packet)), _cache(cache), Action("WriteFile", handler, pFile) {
 			pFile->_queueing += _packet.size();
+			Queueing += _packet.size();
 		}
 	private:
 		struct Handle : Action::Handle, virtual Object {
@@ -186,6 +232,8 @@ void IOFile::write(const shared<File>& pFile, const Packet& packet) {
 		bool process(Exception& ex, shared<File>& pFile) override {
 			// No check pFile.unique => File writing full asynchronous (without any other hand on the file)
 			UInt64 queueing = (pFile->_queueing -= _packet.size());
+			Queueing -= _packet.size();
+			_cache.invalidate(pFile->path());
 			if (!pFile->write(ex, _packet.data(), _packet.size()))
 				return false;
 			if (queueing)
@@ -197,16 +245,19 @@ void IOFile::write(const shared<File>& pFile, const Packet& packet) {
 			return true;
 		}
 		Packet		 _packet;
+		FileCache&	 _cache;
 	};
 	// do the WriteFile even if packet is empty when not loaded to allow to open the file and clear its content or create the file
 	// or to allow to create the folder => if File is a Folder opened in WRITE/APPEND mode loaded is always false and write an empty packet create the folder => allow a folder creation asynchrone!
-	if(packet || !pFile->loaded())
-		_threadPool.queue<WriteFile>(pFile->_ioTrack, handler, pFile, packet);
+	if (!packet && pFile->loaded())
+		return;
+	Buffer::Tag::Scope bufferTag(BufferTag()); // packet bufferized while queued
+	_threadPool.queue<WriteFile>(pFile->_ioTrack, handler, pFile, cache, packet);
 }
 
 void IOFile::erase(const shared<File>& pFile) {
 	struct EraseFile : Action {
-		EraseFile(const Handler& handler, const shared<File>& pFile) : Action("EraseFile", handler, pFile) {}
+		EraseFile(const Handler& handler, const shared<File>& pFile, FileCache& cache) : Action("EraseFile", handler, pFile), _cache(cache) {}
 	private:
 		struct Handle : Action::Handle, virtual Object {
 			Handle(const char* name, shared<File>& pFile) : Action::Handle(name, pFile) {}
@@ -218,6 +269,7 @@ void IOFile::erase(const shared<File>& pFile) {
 		};
 		bool process(Exception& ex, shared<File>& pFile) override {
 			// No check pFile.unique => File erasing full asynchronous (without any other hand on the file)
+			_cache.invalidate(pFile->path());
 			if (!pFile->erase(ex))
 				return false;
 			if (!pFile->_flushing++) // To signal end of write!
@@ -226,13 +278,32 @@ void IOFile::erase(const shared<File>& pFile) {
 				--pFile->_flushing;
 			return true;
 		}
+		FileCache& _cache;
 	};
-	_threadPool.queue<EraseFile>(pFile->_ioTrack, handler, pFile);
+	_threadPool.queue<EraseFile>(pFile->_ioTrack, handler, pFile, cache);
 }
 
 
 void IOFile::watch(const shared<const FileWatcher>& pFileWatcher, const FileWatcher::OnUpdate& onUpdate) {
 	lock_guard<mutex> lock(_mutexWatchers);
+#if !defined(_WIN32) && !defined(_BSD)
+	if (!_notifyFD) {
+		// inotify + pipe to wake up the watching thread
+		int pipefds[2] = {};
+		int notifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notifyFD < 0 || pipe2(pipefds, O_NONBLOCK | O_CLOEXEC) != 0) {
+			WARN("inotify unavailable, file watching by polling");
+			if (notifyFD > 0)
+				::close(notifyFD);
+			_notifyFD = -1;
+		} else {
+			_readFD = pipefds[0];
+			_eventFD = pipefds[1];
+			_notifyFD = notifyFD; // publish in last, run() and stop() read _eventFD/_readFD only if _notifyFD > 0
+		}
+	} else if (_notifyFD > 0)
+		while (::write(_eventFD, "", 1) < 0 && errno == EINTR); // wake up poll to watch immediatly
+#endif
 	_watchers.emplace_back(pFileWatcher);
 	struct OnUpdate : Runner, virtual Object {
 		OnUpdate(const FileWatcher::OnUpdate& onUpdate, const Path& file, bool firstWatch) : _onUpdate(onUpdate), _file(file), _firstWatch(firstWatch), Runner("WatchUpdating") {}
@@ -249,29 +320,121 @@ void IOFile::watch(const shared<const FileWatcher>& pFileWatcher, const FileWatc
 }
 
 bool IOFile::run(Exception& ex, const volatile bool& requestStop) {
-	list<shared<const FileWatcher>> watchers;
+	list<shared<const FileWatcher>> watchers; // polling
+	list<shared<const FileWatcher>> notifiers; // inotify
+#if !defined(_WIN32) && !defined(_BSD)
+	auto unnotify = [this, &notifiers](FileWatcher& watcher) {
+		for (const auto& it : watcher._folders) {
+			bool used = false; // same folder watched by an other watcher gets the same watch descriptor
+			for (const shared<const FileWatcher>& pNotifier : notifiers) {
+				if ((used = (pNotifier.get() != &watcher && pNotifier->_folders.count(it.first))))
+					break;
+			}
+			if (!used)
+				inotify_rm_watch(_notifyFD, it.first);
+		}
+		watcher._folders.clear();
+	};
+#endif
+	Time polling;
 	while(!requestStop) {
-		Time time;
+		list<shared<const FileWatcher>> news;
 		{
 			lock_guard<mutex> lock(_mutexWatchers);
-			watchers.insert(watchers.end(), _watchers.begin(), _watchers.end());
+			news.insert(news.end(), _watchers.begin(), _watchers.end());
 			_watchers.clear();
-			if (watchers.empty()) {
-				stop(); // to set _stop immediatly!
+			if (news.empty() && watchers.empty() && notifiers.empty()) {
+				Thread::stop(); // to set _stop immediatly, no need to wake up itself!
 				break;
 			}
 		}
-		auto it = watchers.begin();
-		while (it != watchers.end()) {
-			if (it->unique()) {
-				it = watchers.erase(it);
-				continue;
+		for (const shared<const FileWatcher>& pWatcher : news) {
+			FileWatcher& watcher = (FileWatcher&)*pWatcher;
+#if !defined(_WIN32) && !defined(_BSD)
+			if (_notifyFD > 0) {
+				if (watcher.notify(ex, _notifyFD)) {
+					// first watch to signal the existing files, next updates will come from inotify
+					AUTO_ERROR(watcher.watch(ex, watcher.onUpdate) >= 0, "File watching");
+					ex = nullptr;
+					notifiers.emplace_back(pWatcher);
+					continue;
+				}
+				WARN(ex, ", ", watcher.path, " watching fallbacks to polling");
+				ex = nullptr;
+				unnotify(watcher);
 			}
-			const shared<const FileWatcher> pWatcher = *it++;
-			AUTO_ERROR(((FileWatcher&)*pWatcher).watch(ex, pWatcher->onUpdate)>=0, "File watching");
+#endif
+			AUTO_ERROR(watcher.watch(ex, watcher.onUpdate) >= 0, "File watching");
 			ex = nullptr;
+			watchers.emplace_back(pWatcher);
+		}
+
+		auto it = notifiers.begin();
+		while (it != notifiers.end()) {
+			if (!it->unique()) {
+				++it;
+				continue;
+			}
+#if !defined(_WIN32) && !defined(_BSD)
+			unnotify((FileWatcher&)**it);
+#endif
+			it = notifiers.erase(it);
+		}
+
+		if (polling.isElapsed(1000)) {
+			polling.update();
+			it = watchers.begin();
+			while (it != watchers.end()) {
+				if (it->unique()) {
+					it = watchers.erase(it);
+					continue;
+				}
+				const shared<const FileWatcher> pWatcher = *it++;
+				AUTO_ERROR(((FileWatcher&)*pWatcher).watch(ex, pWatcher->onUpdate)>=0, "File watching");
+				ex = nullptr;
+			}
+		}
+
+#if !defined(_WIN32) && !defined(_BSD)
+		if (_notifyFD > 0) {
+			pollfd fds[2];
+			fds[0].fd = _notifyFD;
+			fds[1].fd = _readFD;
+			fds[0].events = fds[1].events = POLLIN;
+			fds[0].revents = fds[1].revents = 0;
+			if (::poll(fds, 2, (int)max(1000 - polling.elapsed(), 1)) <= 0)
+				continue;
+			char buffer[4096];
+			if (fds[1].revents & POLLIN)
+				while (::read(_readFD, buffer, sizeof(buffer)) > 0); // purge wake up
+			if (!(fds[0].revents & POLLIN))
+				continue;
+			int size;
+			while ((size = ::read(_notifyFD, buffer, sizeof(buffer))) > 0) {
+				const char* cur = buffer;
+				while ((cur + sizeof(inotify_event)) <= (buffer + size)) {
+					const inotify_event& event = *(const inotify_event*)cur;
+					cur += sizeof(inotify_event) + event.len;
+					it = notifiers.begin();
+					while (it != notifiers.end()) {
+						FileWatcher& watcher = (FileWatcher&)**it;
+						if (watcher.notified(ex, _notifyFD, event.wd, event.mask, event.len ? event.name : NULL)) {
+							ex = nullptr;
+							++it;
+							continue;
+						}
+						WARN(ex, ", ", watcher.path, " watching fallbacks to polling");
+						ex = nullptr;
+						unnotify(watcher);
+						watchers.emplace_back(move(*it));
+						it = notifiers.erase(it);
+					}
+				}
+			}
+			continue;
 		}
-		if (wakeUp.wait((UInt32)max(1000 - time.elapsed(), 1)))
+#endif
+		if (wakeUp.wait((UInt32)max(1000 - polling.elapsed(), 1)))
 			break;// wait()==true means requestStop=true because there is no other wakeUp.set elsewhere
 	}
 
@@ -281,6 +444,12 @@ bool IOFile::run(Exception& ex, const volatile bool& requestStop) {
 			return false;
 		}
 	}
+	for (const shared<const FileWatcher>& pWatcher : notifiers) {
+		if (!pWatcher.unique()) {
+			ex.set<Ex::Intern>("Some file watcher are still active while IOFile is deleting");
+			return false;
+		}
+	}
 	return true;
 }
 
@@ -360,6 +360,7 @@ void IOSocket::read(const shared<Socket>& pSocket, int error) {
 				UInt32 available = pSocket->available();
 				if (!available) // always get something (maybe a new reception has been gotten since the last pSocket->available() call)
 					available = 2048; // in UDP allows to avoid a NET_EMSGSIZE error (where packet is lost!), and 2048 to be greater than max possible MTU (~1500 bytes)
+				Buffer::Tag::Scope bufferTag(pSocket->bufferTag()); // reception and decoding buffers
 				shared<Buffer>	pBuffer(SET, available);
 				SocketAddress	address;
 				int received = pSocket->receive(ex, pBuffer->data(), available, 0, &address);
@@ -384,6 +385,8 @@ void IOSocket::read(const shared<Socket>& pSocket, int error) {
 
 				pBuffer->resize(received);
 
+				// sampled reception traced along decoding and handling (see Metrics::Trace)
+				Metrics::Trace::Scope trace(Metrics::Trace::Sample());
 				// decode can't happen BEFORE onDisconnection because this call decode + push to _handler in this call!
 				if (pSocket->_pDecoder)
 					pSocket->_pDecoder->decode(pBuffer, address, pSocket);
@@ -0,0 +1,269 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or
+modify it under the terms of the the Mozilla Public License v2.0.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+Mozilla Public License v. 2.0 received along this program for more
+details (or else see http://mozilla.org/MPL/2.0/).
+
+*/
+
+
+#include "Mona/Metrics.h"
+#include <set>
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+namespace Mona {
+
+thread_local UInt8 Metrics::_Shard(0xFF);
+thread_local Metrics::Trace Metrics::Trace::_Current;
+atomic<UInt32> Metrics::Trace::Rate(0);
+
+struct Registry : virtual Object {
+	struct Comparator {
+		bool operator()(const Metrics::Metric* pMetric1, const Metrics::Metric* pMetric2) const {
+			// by name to write samples of a same name successively
+			int result = strcmp(pMetric1->name, pMetric2->name);
+			if (result)
+				return result < 0;
+			if ((result = strcmp(pMetric1->labels ? pMetric1->labels : "", pMetric2->labels ? pMetric2->labels : "")))
+				return result < 0;
+			return pMetric1 < pMetric2;
+		}
+	};
+	std::mutex							mutex;
+	set<Metrics::Metric*, Comparator>	metrics;
+	vector<Metrics::Collector*>			collectors;
+};
+static Registry& GetRegistry() {
+	// function static to be built before the first static metric
+	static Registry Registry;
+	return Registry;
+}
+
+
+UInt8 Metrics::NewShard() {
+	static atomic<UInt8> Shards(0);
+	return _Shard = (Shards++ % METRICS_SHARDS);
+}
+
+string& Metrics::Write(string& text) {
+	Registry& registry = GetRegistry();
+	lock_guard<std::mutex> lock(registry.mutex);
+	Writer writer(text);
+	for (const Metric* pMetric : registry.metrics)
+		pMetric->write(writer);
+	for (const Collector* pCollector : registry.collectors)
+		pCollector->_function(writer);
+	return text;
+}
+
+
+Metrics::Metric::Metric(Type type, const char* name, const char* help, const char* labels) : type(type), name(name), help(help), labels(labels) {
+	Registry& registry = GetRegistry();
+	lock_guard<std::mutex> lock(registry.mutex);
+	registry.metrics.emplace(this);
+}
+
+Metrics::Metric::~Metric() {
+	Registry& registry = GetRegistry();
+	lock_guard<std::mutex> lock(registry.mutex);
+	registry.metrics.erase(this);
+}
+
+UInt64 Metrics::Counter::operator()() const {
+	UInt64 value(0);
+	for (const Slot& slot : _shards)
+		value += slot.value.load(memory_order_relaxed);
+	return value;
+}
+void Metrics::Counter::write(Writer& writer) const {
+	writer.write(type, name, help, labels, operator()());
+}
+
+Int64 Metrics::Gauge::operator()() const {
+	Int64 value(0);
+	for (const Slot& slot : _shards)
+		value += slot.value.load(memory_order_relaxed);
+	return value;
+}
+void Metrics::Gauge::write(Writer& writer) const {
+	writer.write(type, name, help, labels, operator()());
+}
+
+
+Metrics::Histogram::Histogram(const char* name, const char* help, const char* labels, double scale) : Metric(TYPE_HISTOGRAM, name, help, labels), scale(scale), _shards(new Slot[METRICS_SHARDS]()) {
+}
+
+Metrics::Histogram::~Histogram() {
+	delete [] _shards;
+}
+
+UInt64 Metrics::Histogram::count() const {
+	UInt64 count(0);
+	for (UInt8 i = 0; i < METRICS_SHARDS; ++i) {
+		for (const atomic<UInt64>& bucket : _shards[i].buckets)
+			count += bucket.load(memory_order_relaxed);
+	}
+	return count;
+}
+
+UInt64 Metrics::Histogram::sum() const {
+	UInt64 sum(0);
+	for (UInt8 i = 0; i < METRICS_SHARDS; ++i)
+		sum += _shards[i].sum.load(memory_order_relaxed);
+	return sum;
+}
+
+UInt64 Metrics::Histogram::percentile(double rate) const {
+	UInt64 buckets[BUCKETS] = {};
+	UInt64 count(0);
+	for (UInt8 i = 0; i < METRICS_SHARDS; ++i) {
+		for (UInt16 j = 0; j < BUCKETS; ++j) {
+			UInt64 value = _shards[i].buckets[j].load(memory_order_relaxed);
+			buckets[j] += value;
+			count += value;
+		}
+	}
+	return Percentile(buckets, count, rate);
+}
+
+UInt64 Metrics::Histogram::Percentile(const UInt64* buckets, UInt64 count, double rate) {
+	if (!count)
+		return 0;
+	UInt64 rank = UInt64(ceil(count * min(max(rate, 0.0), 1.0)));
+	if (!rank)
+		rank = 1;
+	for (UInt16 i = 0; i < BUCKETS; ++i) {
+		if (buckets[i] < rank) {
+			rank -= buckets[i];
+			continue;
+		}
+		if (i < SUB_BUCKETS)
+			return i + 1;
+		if (i == (BUCKETS - 1))
+			break; // overflow
+		// bucket i holds [lower, lower + step[ (with value-1 classification)
+		UInt8 shift = (i / SUB_BUCKETS) - 1;
+		return ((UInt64(SUB_BUCKETS + (i & (SUB_BUCKETS - 1))) << shift) + (1ull << shift));
+	}
+	return 1ull << POWERS;
+}
+
+void Metrics::Histogram::write(Writer& writer) const {
+	UInt64 buckets[BUCKETS] = {};
+	UInt64 sum(0);
+	for (UInt8 i = 0; i < METRICS_SHARDS; ++i) {
+		for (UInt16 j = 0; j < BUCKETS; ++j)
+			buckets[j] += _shards[i].buckets[j].load(memory_order_relaxed);
+		sum += _shards[i].sum.load(memory_order_relaxed);
+	}
+	writer.header(type, name, help);
+	String bucketLabels;
+	// a bucket by power of two, le=2^k includes the values <= 2^k (see ComputeIndex)
+	UInt64 count(0);
+	UInt16 index(0);
+	for (UInt8 power = 0; power <= POWERS; ++power) {
+		UInt16 end = power <= SUB_BITS ? (1 << power) : SUB_BUCKETS * (power - SUB_BITS + 1);
+		while (index < end)
+			count += buckets[index++];
+		bucketLabels.assign(labels ? labels : "");
+		String::Append(bucketLabels, bucketLabels.empty() ? "" : ",", "le=\"", double(1ull << power) / scale, '"');
+		writer.sample(name, "_bucket", bucketLabels.c_str(), count);
+	}
+	count += buckets[BUCKETS - 1];
+	bucketLabels.assign(labels ? labels : "");
+	String::Append(bucketLabels, bucketLabels.empty() ? "" : ",", "le=\"+Inf\"");
+	writer.sample(name, "_bucket", bucketLabels.c_str(), count);
+	writer.sample(name, "_sum", labels, sum / scale);
+	writer.sample(name, "_count", labels, count);
+}
+
+
+void Metrics::Samples::clear() {
+	memset(_buckets, 0, sizeof(_buckets));
+	_count = _sum = _max = 0;
+}
+
+void Metrics::Samples::write(Writer& writer, const char* name, const char* help, const char* labels, double scale) const {
+	static const double Quantiles[] = { 0.5, 0.9, 0.99 };
+	writer.header(Metric::TYPE_SUMMARY, name, help);
+	String quantileLabels;
+	for (double quantile : Quantiles) {
+		quantileLabels.assign(labels ? labels : "");
+		String::Append(quantileLabels, quantileLabels.empty() ? "" : ",", "quantile=\"", quantile, '"');
+		writer.sample(name, "", quantileLabels.c_str(), percentile(quantile) / scale);
+	}
+	writer.sample(name, "_sum", labels, _sum / scale);
+	writer.sample(name, "_count", labels, _count);
+}
+
+
+Metrics::Trace Metrics::Trace::Sample() {
+	static atomic<UInt32> Receptions(0);
+	Trace trace;
+	UInt32 rate = Rate.load(memory_order_relaxed);
+	if (rate && !(Receptions.fetch_add(1, memory_order_relaxed) % rate))
+		trace.received = Microseconds();
+	return trace;
+}
+
+
+Metrics::Collector::Collector(Function&& function) : _function(move(function)) {
+	Registry& registry = GetRegistry();
+	lock_guard<std::mutex> lock(registry.mutex);
+	registry.collectors.emplace_back(this);
+}
+
+Metrics::Collector::~Collector() {
+	Registry& registry = GetRegistry();
+	lock_guard<std::mutex> lock(registry.mutex);
+	for (auto it = registry.collectors.begin(); it != registry.collectors.end(); ++it) {
+		if (*it != this)
+			continue;
+		registry.collectors.erase(it);
+		break;
+	}
+}
+
+
+void Metrics::Writer::header(Metric::Type type, const char* name, const char* help) {
+	if (_name == name)
+		return;
+	static const char* Types[] = { "counter", "gauge", "histogram", "summary" };
+	String::Append(_text, "# HELP ", name, ' ', help, "\n# TYPE ", name, ' ', Types[type], '\n');
+	_name = name;
+}
+
+string& Metrics::Writer::Escape(const char* value, string& buffer) {
+	buffer.clear();
+	while (*value) {
+		switch (*value) {
+			case '\\':
+				buffer += "\\\\";
+				break;
+			case '"':
+				buffer += "\\\"";
+				break;
+			case '\n':
+				buffer += "\\n";
+				break;
+			default:
+				buffer += *value;
+		}
+		++value;
+	}
+	return buffer;
+}
+
+
+} // namespace Mona
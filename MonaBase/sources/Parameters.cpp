@@ -20,12 +20,24 @@ using namespace std;
 
 namespace Mona {
 
+#define INDEX_THRESHOLD 16 // under this count a tree walk is faster than hashing the key
+
+static UInt32 Hash(const char* value, size_t size) {
+	// FNV-1a case-insensitive
+	UInt32 hash(2166136261u);
+	while (size--)
+		hash = (hash ^ UInt8(tolower(*value++))) * 16777619u;
+	return hash;
+}
+
 Parameters& Parameters::setParams(const Parameters& other) {
 	// clear self!
 	clear();
-	// copy data
-	if (other.count())
-		_pMap.set() = *other._pMap;
+	// share data, copied on first change (copy-on-write)
+	if (other.count()) {
+		_pMap = other._pMap;
+		reindex();
+	}
 	// onChange!
 	for (auto& it : self)
 		onParamChange(it.first, &it.second);
@@ -38,6 +50,8 @@ Parameters& Parameters::setParams(Parameters&& other) {
 	// move data
 	if(other.count()) {
 		_pMap = std::move(other._pMap);
+		reindex();
+		other._index.clear();
 		// clear other
 		other.onParamClear();
 	}	
@@ -77,33 +91,112 @@ bool Parameters::getBoolean(const string& key, bool& value) const {
 }
 
 const string* Parameters::getParameter(const string& key) const {
-	const auto& it = params().find(key);
-	if (it != params().end())
-		return &it->second;
+	const MapType& map(params());
+	if (!_index.empty()) {
+		const value_type* pEntry(search(key));
+		if (pEntry)
+			return &pEntry->second;
+	} else {
+		const auto& it = map.find(key);
+		if (it != map.end())
+			return &it->second;
+	}
 	return onParamUnfound(key);
 }
 
+Parameters::MapType& Parameters::mutableParams() {
+	if (!_pMap)
+		_pMap.set();
+	else if (!_pMap.unique()) {
+		_pMap.set(*_pMap);
+		reindex(); // entries are now the ones of the copy
+	}
+	return *_pMap;
+}
+
+static const Parameters::value_type Erased; // index tombstone
+
+const Parameters::value_type* Parameters::search(const string& key) const {
+	if (_index.empty())
+		return NULL;
+	UInt32 hash(Hash(key.data(), key.size()));
+	UInt32 mask(_index.size() - 1);
+	for (UInt32 slot = hash & mask; _index[slot].second; slot = (slot + 1) & mask) {
+		if (_index[slot].first == hash && _index[slot].second != &Erased && String::ICompare(_index[slot].second->first, key) == 0)
+			return _index[slot].second;
+	}
+	return NULL;
+}
+
+void Parameters::index(const value_type& entry) {
+	if (_index.empty() || (++_indexed * 2) > _index.size())
+		return reindex(); // load factor exceeds 1/2
+	UInt32 hash(Hash(entry.first.data(), entry.first.size()));
+	UInt32 mask(_index.size() - 1);
+	UInt32 slot(hash & mask);
+	while (_index[slot].second)
+		slot = (slot + 1) & mask;
+	_index[slot] = make_pair(hash, &entry);
+}
+
+void Parameters::unindex(const value_type& entry) {
+	if (_index.empty())
+		return;
+	UInt32 mask(_index.size() - 1);
+	for (UInt32 slot = Hash(entry.first.data(), entry.first.size()) & mask; _index[slot].second; slot = (slot + 1) & mask) {
+		if (_index[slot].second == &entry) {
+			_index[slot].second = &Erased;
+			return;
+		}
+	}
+}
+
+void Parameters::reindex() {
+	_index.clear();
+	if (!_pMap || _pMap->size() < INDEX_THRESHOLD)
+		return;
+	UInt32 size(64);
+	while (size < (_pMap->size() * 4)) // room to grow before next rebuild
+		size <<= 1;
+	_index.assign(size, make_pair(0, (const value_type*)NULL));
+	UInt32 mask(size - 1);
+	for (const value_type& entry : *_pMap) {
+		UInt32 hash(Hash(entry.first.data(), entry.first.size()));
+		UInt32 slot(hash & mask);
+		while (_index[slot].second)
+			slot = (slot + 1) & mask;
+		_index[slot] = make_pair(hash, &entry);
+	}
+	_indexed = _pMap->size();
+}
+
 Parameters& Parameters::clear(const string& prefix) {
 	if (!count())
 		return self;
 	if (prefix.empty()) {
 		_pMap.reset();
+		_index.clear();
 		onParamClear();
 	} else {
 		string end(prefix);
 		end.back() = prefix.back() + 1;
-		erase(_pMap->lower_bound(prefix), _pMap->lower_bound(end));
+		MapType& map(mutableParams());
+		erase(map.lower_bound(prefix), map.lower_bound(end));
 	}
 	return self;
 }
 
 bool Parameters::erase(const string& key) {
 	// erase
-	const auto& it(params().find(key));
-	if (it != params().end()) {
+	if (params().find(key) == params().end())
+		return false;
+	MapType& map(mutableParams()); // after find to copy a shared map just if required
+	const auto& it(map.find(key));
+	if (it != map.end()) {
 		// move key because "key" parameter can be a "it->first" too, and must stay valid for onParamChange call!
 		string key(move(it->first));
-		_pMap->erase(it);
+		unindex(*it);
+		map.erase(it);
 		if (_pMap->empty())
 			clear();
 		else
@@ -117,8 +210,19 @@ Parameters::const_iterator Parameters::erase(const_iterator first, const_iterato
 		clear();
 		return end();
 	}
+	if (first == last)
+		return first;
+	if (!_pMap.unique()) {
+		// iterators of the shared map => find them in the copy
+		string from(first->first);
+		bool toEnd(last == end());
+		string to(toEnd ? string() : last->first);
+		first = mutableParams().find(from);
+		last = toEnd ? _pMap->end() : _pMap->find(to);
+	}
 	while (first != last) {
 		string key(move(first->first));
+		unindex(*first);
 		_pMap->erase(first++);
 		onParamChange(key, NULL);
 	}
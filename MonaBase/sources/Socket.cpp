@@ -16,9 +16,28 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 
 #include "Mona/Socket.h"
+#include "Mona/File.h"
 #if !defined(_WIN32)
 #include <net/if.h>
 #include <fcntl.h>
+#include <sys/uio.h>
+#include <limits.h>
+#endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+#define SENDFILE_MAX 0x7FFFF000 // maximum transferred by one sendfile call on Linux
+#define SENDV_MAX	 0x7FFFF000 // maximum transferred by one gather call (result has to fit an int)
+#if defined(_WIN32)
+#define NET_IOVEC	 WSABUF
+#define IOV_MAX		 1024
+static void SetIOVec(WSABUF& buffer, const void* data, Mona::UInt32 size) { buffer.buf = (char*)data; buffer.len = size; }
+#else
+#define NET_IOVEC	 iovec
+#if !defined(IOV_MAX)
+#define IOV_MAX		 1024
+#endif
+static void SetIOVec(iovec& buffer, const void* data, Mona::UInt32 size) { buffer.iov_base = (void*)data; buffer.iov_len = size; }
 #endif
 
 
@@ -26,11 +45,19 @@ using namespace std;
 
 namespace Mona {
 
+// measured only while metrics tracing is enabled (Metrics::Trace::Rate), to not read the clock on every packet otherwise
+static Metrics::Histogram SendWait("mona_socket_queue_seconds", "Wait time of data queued on a socket by backpressure before to be sent");
+
+static Buffer::Tag& BufferTag() {
+	static Buffer::Tag& Tag(Buffer::Tag::Get("socket"));
+	return Tag;
+}
+
 Socket::Socket(Type type) :
 #if !defined(_WIN32)
 	_pWeakThis(NULL), 
 #endif
-	_opened(false), _pDecoder(NULL), _externDecoder(false), _nonBlockingMode(false), _listening(false), _receiving(0), _queueing(0), _recvBufferSize(Net::GetRecvBufferSize()), _sendBufferSize(Net::GetSendBufferSize()), _reading(0), _sending(false), type(type), _recvTime(0), _sendTime(0), _id(NET_INVALID_SOCKET), _threadReceive(0),
+	_opened(false), _pDecoder(NULL), _externDecoder(false), _nonBlockingMode(false), _listening(false), _receiving(0), _queueing(0), _pBufferTag(&BufferTag()), _recvBufferSize(Net::GetRecvBufferSize()), _sendBufferSize(Net::GetSendBufferSize()), _reading(0), _sending(false), type(type), _recvTime(0), _sendTime(0), _id(NET_INVALID_SOCKET), _threadReceive(0),
 	onError(_onError) {
 
 	if (type < TYPE_OTHER) {
@@ -48,7 +75,7 @@ Socket::Socket(NET_SOCKET id, const sockaddr& addr, Type type) : _peerAddress(ad
 #if !defined(_WIN32)
 	_pWeakThis(NULL),
 #endif
-	_opened(false), _pDecoder(NULL), _externDecoder(false), _nonBlockingMode(false), _listening(false), _receiving(0), _queueing(0), _recvBufferSize(Net::GetRecvBufferSize()), _sendBufferSize(Net::GetSendBufferSize()), _reading(0), _sending(false), type(type), _recvTime(Time::Now()), _sendTime(0), _id(id), _threadReceive(0),
+	_opened(false), _pDecoder(NULL), _externDecoder(false), _nonBlockingMode(false), _listening(false), _receiving(0), _queueing(0), _pBufferTag(&BufferTag()), _recvBufferSize(Net::GetRecvBufferSize()), _sendBufferSize(Net::GetSendBufferSize()), _reading(0), _sending(false), type(type), _recvTime(Time::Now()), _sendTime(0), _id(id), _threadReceive(0),
 	onError(_onError) {
 
 	if (type < TYPE_OTHER)
@@ -277,8 +304,10 @@ bool Socket::accept(Exception& ex, shared<Socket>& pSocket) {
 		return false;
 	}
 	pSocket = newSocket(ex, sockfd, (sockaddr&)addr);
-	if (pSocket)
+	if (pSocket) {
+		pSocket->setBufferTag(bufferTag()); // owner of the listening socket
 		return true;
+	}
 	NET_CLOSESOCKET(sockfd);
 	return false;
 }
@@ -480,6 +509,7 @@ int Socket::sendTo(Exception& ex, const void* data, UInt32 size, const SocketAdd
 
 int Socket::write(Exception& ex, const Packet& packet, const SocketAddress& address, int flags) {
 	lock_guard<mutex> lock(_mutexSending);
+	Buffer::Tag::Scope bufferTag(self.bufferTag()); // packet bufferized if queued
 	if(!_sendings.empty()) {
 		_sendings.emplace_back(packet, address ? address : _peerAddress, flags);
 		_queueing += packet.size();
@@ -510,36 +540,138 @@ int Socket::write(Exception& ex, const Packet& packet, const SocketAddress& addr
 	return sent;
 }
 
+bool Socket::canSendFile() const {
+#if defined(__linux__)
+	return type == TYPE_STREAM;
+#else
+	return false;
+#endif
+}
+
+int Socket::sendFile(Exception& ex, const File& file, UInt64 offset, UInt32 size) {
+	if (_ex) {
+		ex = _ex;
+		return -1;
+	}
+#if defined(__linux__)
+	off_t position(offset);
+	ssize_t rc;
+	int error;
+	do {
+		rc = ::sendfile(_id, file._handle, &position, size);
+	} while (rc < 0 && (error = Net::LastError()) == NET_EINTR);
+	if (rc < 0) {
+		SetException(error, ex, " (file=", file.path(), ", offset=", offset, ", size=", size, ")");
+		return -1;
+	}
+	if (!rc && size) {
+		// end of file reached before the end of the region => truncated file
+		ex.set<Ex::Intern>("File ", file.path(), " truncated while sending (offset=", offset, ", size=", size, ")");
+		return -1;
+	}
+	send(UInt32(rc));
+	return int(rc);
+#else
+	ex.set<Ex::Unsupported>("sendfile unsupported on this platform");
+	return -1;
+#endif
+}
+
+int Socket::write(Exception& ex, const shared<const File>& pFile, UInt64 offset, UInt64 size) {
+	if (!size)
+		return 0;
+	lock_guard<mutex> lock(_mutexSending);
+	if (!_sendings.empty()) {
+		_sendings.emplace_back(pFile, offset, size, _peerAddress);
+		_queueing += size;
+		return 0;
+	}
+	_sending = true;
+	int sent = sendFile(ex, *pFile, offset, UInt32(min(size, UInt64(SENDFILE_MAX))));
+	if (sent < 0) {
+		int code = ex.cast<Ex::Net::Socket>().code;
+		if ((code == NET_ENOTCONN && _peerAddress) || code == NET_EWOULDBLOCK) {
+			// queue and wait next call to flush(), no error!
+			ex = nullptr;
+			sent = 0;
+		} else {
+			close(); // shutdown system to avoid to try to send before shutdown!
+			_sending = false;
+			return -1;
+		}
+	} else if (UInt64(sent) >= size) {
+		_sending = false;
+		return sent;
+	}
+	_sendings.emplace_back(pFile, offset + sent, size - sent, _peerAddress);
+	_queueing += size - sent;
+	return sent;
+}
+
 bool Socket::flush(Exception& ex, bool deleting) {
-	UInt32 written(0);
+	UInt64 written(0);
 
 	unique_lock<mutex> lock(_mutexSending, defer_lock);
 	if (!deleting)
 		lock.lock();
+	UInt32 coalescing(this->coalescing());
+	bool gathering(canGather());
 	int sent(0);
 	while(sent>=0 && !_sendings.empty()) {
 		Sending& sending(_sendings.front());
-		sent = sendTo(ex, sending.data(), sending.size(), sending.address, sending.flags);
+		UInt32 size;
+		if (sending.pFile) {
+			size = UInt32(min(sending.rest, UInt64(SENDFILE_MAX)));
+			sent = sendFile(ex, *sending.pFile, sending.offset, size);
+		} else if (gathering && _sendings.size() > 1)
+			sent = sendV(ex, size);
+		else if (sending.size() < coalescing && _sendings.size() > 1 && gather(coalescing) > 1)
+			sent = sendTo(ex, _gathering.data(), size = _gathering.size(), sending.address, sending.flags);
+		else
+			sent = sendTo(ex, sending.data(), size = sending.size(), sending.address, sending.flags);
 		if (sent >= 0) {
 			written += sent;
-			if (UInt32(sent) < sending.size()) {
-				// can't send more!
-				sending += sent;
-				break;
-			}
-		} else {
-			int code = ex.cast<Ex::Net::Socket>().code;
-			if ((code == NET_ENOTCONN && _peerAddress) || code == NET_EWOULDBLOCK) {
-				// is connecting, can't send more now (wait onFlush)
-				ex = nullptr;
-				break;
-			}
-			if (type == TYPE_STREAM) {
-				// fail to send few reliable data, shutdown send!
-				if(!deleting)
-					close(); // shutdown system to avoid to try to send before shutdown!
-				return false;
+			if (sending.pFile) {
+				sending.offset += sent;
+				if ((sending.rest -= sent)) {
+					if (UInt32(sent) < size)
+						break; // can't send more!
+					continue; // sendfile maximum size reached, continue
+				}
+				if (sending.queued)
+					SendWait.record(Metrics::Microseconds() - sending.queued);
+				_sendings.pop_front();
+				continue;
 			}
+			// release the packets sent (several if gathered), at least the first if empty
+			UInt32 rest(sent);
+			Int64 now(Metrics::Trace::Rate ? Metrics::Microseconds() : 0);
+			do {
+				Sending& front(_sendings.front());
+				if (rest < front.size()) {
+					front += rest;
+					break;
+				}
+				rest -= front.size();
+				if (now && front.queued)
+					SendWait.record(now - front.queued);
+				_sendings.pop_front();
+			} while (rest && !_sendings.empty());
+			if (UInt32(sent) < size)
+				break; // can't send more!
+			continue;
+		}
+		int code = ex.cast<Ex::Net::Socket>().code;
+		if ((code == NET_ENOTCONN && _peerAddress) || code == NET_EWOULDBLOCK) {
+			// is connecting, can't send more now (wait onFlush)
+			ex = nullptr;
+			break;
+		}
+		if (type == TYPE_STREAM) {
+			// fail to send few reliable data, shutdown send!
+			if(!deleting)
+				close(); // shutdown system to avoid to try to send before shutdown!
+			return false;
 		}
 		_sendings.pop_front();
 	}
@@ -548,6 +680,73 @@ bool Socket::flush(Exception& ex, bool deleting) {
 	return true;
 }
 
+int Socket::sendV(Exception& ex, UInt32& size) {
+	if (_ex) {
+		ex = _ex;
+		return -1;
+	}
+	// gather the packets queued with the same flags in one system call, _gathering is used to store the buffer descriptors
+	const Sending& first(_sendings.front());
+	int flags(first.flags);
+#if defined(MSG_NOSIGNAL)
+	flags |= MSG_NOSIGNAL;
+#endif
+	UInt32 count(0), max(UInt32(min(_sendings.size(), size_t(IOV_MAX))));
+	size = 0;
+	_gathering.resize(max * sizeof(NET_IOVEC), false);
+	NET_IOVEC* buffers((NET_IOVEC*)_gathering.data());
+	for (const Sending& sending : _sendings) {
+		if (count == max || sending.pFile || sending.flags != first.flags)
+			break;
+		UInt32 rest(min(sending.size(), SENDV_MAX - size));
+		SetIOVec(buffers[count++], sending.data(), rest);
+		if ((size += rest) == SENDV_MAX)
+			break;
+	}
+
+	int rc;
+	int error;
+	do {
+#if defined(_WIN32)
+		DWORD sent;
+		rc = WSASend(_id, buffers, count, &sent, flags, NULL, NULL) ? -1 : int(sent);
+#else
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = buffers;
+		message.msg_iovlen = count;
+		rc = ::sendmsg(_id, &message, flags);
+#endif
+	} while (rc < 0 && (error = Net::LastError()) == NET_EINTR);
+	if (rc < 0) {
+		SetException(error, ex, " (address=", _peerAddress, ", size=", size, ", buffers=", count, ", flags=", flags, ")");
+		return -1;
+	}
+	if (!_address)
+		_address.set(IPAddress::Loopback(), 0); // to advise that address is computable
+	send(rc);
+	return rc;
+}
+
+UInt32 Socket::gather(UInt32 size) {
+	// same data prefix on retry (sendings are released only when sent), required by TLS which repeats a write blocked
+	_gathering.clear();
+	const Sending& first(_sendings.front());
+	UInt32 count(0);
+	for (const Sending& sending : _sendings) {
+		if (sending.pFile || sending.flags != first.flags || sending.address != first.address)
+			break;
+		++count;
+		UInt32 rest(size - _gathering.size());
+		if (sending.size() >= rest) {
+			_gathering.append(sending.data(), rest);
+			break;
+		}
+		_gathering.append(sending.data(), sending.size());
+	}
+	return count;
+}
+
 
 
 } // namespace Mona
@@ -16,20 +16,27 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 
 #include "Mona/TLS.h"
+#include "Mona/FileSystem.h"
+#include "Mona/Logs.h"
+#include "Mona/Metrics.h"
+#include OpenSSL(rand.h)
+#include OpenSSL(x509v3.h)
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	#include OpenSSL(core_names.h)
+#endif
 
 
 using namespace std;
 
 namespace Mona {
 
+static Metrics::Counter FullHandshakes("mona_tls_handshakes_total", "TLS handshakes completed", "type=\"full\"");
+static Metrics::Counter ResumedHandshakes("mona_tls_handshakes_total", "TLS handshakes completed", "type=\"resumed\"");
+
 bool TLS::Create(Exception& ex, shared<TLS>& pTLS, const SSL_METHOD* method) {
 	// load and configure in constructor to be thread safe!
 	SSL_CTX* pCTX(SSL_CTX_new(method));
 	if (pCTX) {
-		/* If the underlying BIO is blocking, SSL_read()/SSL_write() will only return, once the read operation has been finished or an error occurred,
-		except when a renegotiation take place, in which case a SSL_ERROR_WANT_READ may occur.
-		This behaviour can be controlled with the SSL_MODE_AUTO_RETRY flag of the SSL_CTX_set_mode call. */
-		SSL_CTX_set_mode(pCTX, SSL_MODE_AUTO_RETRY);
 		pTLS = new TLS(pCTX);
 		return true;
 	}
@@ -43,11 +50,12 @@ bool TLS::Create(Exception& ex, const char* cert, const char* key, shared<TLS>&
 	if (pCTX) {
 		// cert.pem & key.pem
 		if (SSL_CTX_use_certificate_file(pCTX, cert, SSL_FILETYPE_PEM) == 1 && SSL_CTX_use_PrivateKey_file(pCTX, key, SSL_FILETYPE_PEM) == 1) {
-			/* If the underlying BIO is blocking, SSL_read()/SSL_write() will only return, once the read operation has been finished or an error occurred,
-			except when a renegotiation take place, in which case a SSL_ERROR_WANT_READ may occur.
-			This behaviour can be controlled with the SSL_MODE_AUTO_RETRY flag of the SSL_CTX_set_mode call. */
-			SSL_CTX_set_mode(pCTX, SSL_MODE_AUTO_RETRY);
 			pTLS = new TLS(pCTX);
+			// server => resumption by session cache and tickets
+			pTLS->setSessionCache(0x4000);
+			pTLS->setTicketRotation(3600);
+			SSL_CTX_set_tlsext_servername_callback(pCTX, SelectCertificate);
+			SSL_CTX_set_tlsext_servername_arg(pCTX, pTLS.get());
 			return true;
 		}
 		SSL_CTX_free(pCTX);
@@ -56,9 +64,192 @@ bool TLS::Create(Exception& ex, const char* cert, const char* key, shared<TLS>&
 	return false;
 }
 
-TLS::Socket::Socket(Type type, const shared<TLS>& pTLS) : pTLS(pTLS), Mona::Socket(type), _ssl(NULL) {}
+std::atomic<UInt32> TLS::_KTLSSockets(0);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int TLS::TicketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* pCipher, EVP_MAC_CTX* pMAC, int encrypt) {
+#else
+int TLS::TicketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* pCipher, HMAC_CTX* pMAC, int encrypt) {
+#endif
+	UInt8 hmac[32];
+	int result = ((TLS*)SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)))->ticketKey(name, iv, pCipher, encrypt ? true : false, hmac);
+	if (result <= 0)
+		return result;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM params[] = {
+		OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, (void*)hmac, 32),
+		OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"SHA256", 0),
+		OSSL_PARAM_construct_end()
+	};
+	if (!EVP_MAC_CTX_set_params(pMAC, params))
+		return -1;
+#else
+	if (!HMAC_Init_ex(pMAC, hmac, 32, EVP_sha256(), NULL))
+		return -1;
+#endif
+	return result;
+}
+
+TLS::TicketKey::TicketKey() : time(Time::Now()) {
+	if (RAND_bytes(name, sizeof(name)) != 1 || RAND_bytes(aes, sizeof(aes)) != 1 || RAND_bytes(hmac, sizeof(hmac)) != 1)
+		FATAL_ERROR("Impossible to generate TLS ticket key, ", Crypto::LastErrorMessage());
+}
+
+TLS::TLS(SSL_CTX* pCTX) : _pCTX(pCTX), _ticketRotation(0), _fullHandshakes(0), _resumedHandshakes(0), _records(0), _recordBytes(0) {
+	configure(pCTX);
+}
+
+TLS::~TLS() {
+	for (auto& it : _certificates)
+		SSL_CTX_free(it.second); // one reference by name
+	SSL_CTX_free(_pCTX);
+}
+
+void TLS::configure(SSL_CTX* pCTX) {
+	SSL_CTX_set_app_data(pCTX, this);
+	// same session context for every certificate to resume a session after a SNI selection
+	SSL_CTX_set_session_id_context(pCTX, (const UInt8*)EXPAND("Mona"));
+	/* If the underlying BIO is blocking, SSL_read()/SSL_write() will only return, once the read operation has been finished or an error occurred,
+	except when a renegotiation take place, in which case a SSL_ERROR_WANT_READ may occur.
+	This behaviour can be controlled with the SSL_MODE_AUTO_RETRY flag of the SSL_CTX_set_mode call. */
+	SSL_CTX_set_mode(pCTX, SSL_MODE_AUTO_RETRY);
+	/* A SSL_write blocked has to be repeated with the same data, but a flush can repeat it from an other coalescing buffer
+	with the same prefix and more data queued (see Socket::coalescing) */
+	SSL_CTX_set_mode(pCTX, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#if defined(SSL_OP_ENABLE_KTLS)
+	// Kernel TLS when available (Linux "tls" module and cipher supported by the kernel), OpenSSL falls back on user space otherwise
+	SSL_CTX_set_options(pCTX, SSL_OP_ENABLE_KTLS);
+#endif
+}
+
+void TLS::setSessionCache(UInt32 size, UInt32 timeout) {
+	if (!size) {
+		SSL_CTX_set_session_cache_mode(_pCTX, SSL_SESS_CACHE_OFF);
+		return;
+	}
+	// OpenSSL removes the oldest session when full, and flushes expired sessions regularly
+	SSL_CTX_set_session_cache_mode(_pCTX, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_sess_set_cache_size(_pCTX, size);
+	SSL_CTX_set_timeout(_pCTX, timeout);
+}
+
+void TLS::setTicketRotation(UInt32 rotation) {
+	_ticketRotation = rotation;
+	if (!rotation) {
+		SSL_CTX_set_options(_pCTX, SSL_OP_NO_TICKET);
+		return;
+	}
+	SSL_CTX_clear_options(_pCTX, SSL_OP_NO_TICKET);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(_pCTX, TicketKeyCallback);
+#else
+	SSL_CTX_set_tlsext_ticket_key_cb(_pCTX, TicketKeyCallback);
+#endif
+}
 
-TLS::Socket::Socket(NET_SOCKET sockfd, const sockaddr& addr, const shared<TLS>& pTLS) : pTLS(pTLS), Mona::Socket(sockfd, addr), _ssl(NULL) {}
+int TLS::ticketKey(UInt8* name, UInt8* iv, EVP_CIPHER_CTX* pCipher, bool encrypt, UInt8 (&hmac)[32]) {
+	Int64 rotation(_ticketRotation * 1000ll);
+	if (!rotation)
+		return 0;
+	lock_guard<mutex> lock(_ticketMutex);
+	Int64 now(Time::Now());
+	if (_ticketKeys.empty() || (now - _ticketKeys.front().time) >= rotation)
+		_ticketKeys.emplace_front(); // new current key
+	// a previous key decrypts yet during one rotation
+	while (_ticketKeys.size() > 1 && (now - _ticketKeys.back().time) >= 2 * rotation)
+		_ticketKeys.pop_back();
+
+	if (encrypt) {
+		const TicketKey& key = _ticketKeys.front();
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1 || !EVP_EncryptInit_ex(pCipher, EVP_aes_256_cbc(), NULL, key.aes, iv))
+			return -1;
+		memcpy(name, key.name, sizeof(key.name));
+		memcpy(hmac, key.hmac, sizeof(hmac));
+		return 1;
+	}
+	for (const TicketKey& key : _ticketKeys) {
+		if (memcmp(name, key.name, sizeof(key.name)) != 0)
+			continue;
+		if (!EVP_DecryptInit_ex(pCipher, EVP_aes_256_cbc(), NULL, key.aes, iv))
+			return -1;
+		memcpy(hmac, key.hmac, sizeof(hmac));
+		return &key == &_ticketKeys.front() ? 1 : 2; // renew ticket encrypted with a previous key
+	}
+	return 0; // unknown or expired key => full handshake
+}
+
+UInt32 TLS::loadCertificates(Exception& ex, const Path& directory) {
+	UInt32 count(0);
+	FileSystem::ListFiles(ex, directory, [&](const string& file, UInt16 level) {
+		Path cert(file);
+		if (String::ICompare(cert.extension(), "pem") != 0)
+			return true;
+		Path key(cert.parent(), cert.baseName(), ".key");
+		SSL_CTX* pCTX(SSL_CTX_new(SSLv23_method()));
+		if (!pCTX || !key.exists() || SSL_CTX_use_certificate_chain_file(pCTX, cert.c_str()) != 1 || SSL_CTX_use_PrivateKey_file(pCTX, key.c_str(), SSL_FILETYPE_PEM) != 1) {
+			WARN("Certificate ", cert.name(), " ignored, ", key.exists() ? Crypto::LastErrorMessage() : "no private key file");
+			if (pCTX)
+				SSL_CTX_free(pCTX);
+			return true;
+		}
+		configure(pCTX);
+		// names of certificate: subjectAltName DNS or common name
+		vector<string> names;
+		X509* pX509(SSL_CTX_get0_certificate(pCTX));
+		GENERAL_NAMES* pNames((GENERAL_NAMES*)X509_get_ext_d2i(pX509, NID_subject_alt_name, NULL, NULL));
+		if (pNames) {
+			for (int i = 0; i < sk_GENERAL_NAME_num(pNames); ++i) {
+				const GENERAL_NAME* pName(sk_GENERAL_NAME_value(pNames, i));
+				if (pName->type == GEN_DNS)
+					names.emplace_back(STR ASN1_STRING_get0_data(pName->d.dNSName), ASN1_STRING_length(pName->d.dNSName));
+			}
+			GENERAL_NAMES_free(pNames);
+		}
+		if (names.empty()) {
+			char name[256];
+			int size(X509_NAME_get_text_by_NID(X509_get_subject_name(pX509), NID_commonName, name, sizeof(name)));
+			if (size > 0)
+				names.emplace_back(name, size);
+		}
+		for (string& name : names) {
+			auto it = _certificates.emplace(String::ToLower(name), pCTX);
+			if (!it.second) {
+				WARN("Certificate ", cert.name(), " ignored for ", name, ", already defined");
+				continue;
+			}
+			SSL_CTX_up_ref(pCTX);
+			DEBUG("Certificate ", cert.name(), " loaded for ", name);
+		}
+		if (names.empty()) {
+			WARN("Certificate ", cert.name(), " ignored, no DNS name");
+		} else
+			++count;
+		SSL_CTX_free(pCTX); // references are hold by _certificates
+		return true;
+	});
+	return count;
+}
+
+int TLS::SelectCertificate(SSL* ssl, int* alert, void* arg) {
+	const map<string, SSL_CTX*>& certificates = ((TLS*)arg)->_certificates;
+	const char* name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+	if (!name || certificates.empty())
+		return SSL_TLSEXT_ERR_NOACK; // default certificate
+	string host(name);
+	auto it = certificates.find(String::ToLower(host));
+	if (it == certificates.end()) {
+		// wildcard certificate?
+		size_t dot = host.find('.');
+		if (dot == string::npos || (it = certificates.find(String("*", host.c_str() + dot))) == certificates.end())
+			return SSL_TLSEXT_ERR_NOACK; // default certificate
+	}
+	SSL_set_SSL_CTX(ssl, it->second);
+	return SSL_TLSEXT_ERR_OK;
+}
+
+TLS::Socket::Socket(Type type, const shared<TLS>& pTLS) : pTLS(pTLS), Mona::Socket(type), _ssl(NULL), _ktls(false), _handshaked(false) {}
+
+TLS::Socket::Socket(NET_SOCKET sockfd, const sockaddr& addr, const shared<TLS>& pTLS) : pTLS(pTLS), Mona::Socket(sockfd, addr), _ssl(NULL), _ktls(false), _handshaked(false) {}
 
 TLS::Socket::~Socket() {
 	if (!_ssl)
@@ -70,6 +261,27 @@ TLS::Socket::~Socket() {
 	if(!SSL_in_init(_ssl)) // just if required (causes an error while init)
 		SSL_shutdown(_ssl);
 	SSL_free(_ssl);
+	if (_ktls)
+		--_KTLSSockets;
+}
+
+void TLS::Socket::handshaked() {
+	// once after handshake and without SSL operation in progress (a SSL_write to retry for example)
+	if (_handshaked || !SSL_is_init_finished(_ssl) || !SSL_want_nothing(_ssl))
+		return;
+	_handshaked = true;
+	if (SSL_session_reused(_ssl)) {
+		++pTLS->_resumedHandshakes;
+		++ResumedHandshakes;
+	} else {
+		++pTLS->_fullHandshakes;
+		++FullHandshakes;
+	}
+	if (!BIO_get_ktls_send(SSL_get_wbio(_ssl)))
+		return;
+	_ktls = true;
+	++_KTLSSockets;
+	DEBUG("Kernel TLS sending for ", peerAddress());
 }
 
 UInt32 TLS::Socket::available() const {
@@ -145,27 +357,41 @@ int TLS::Socket::receive(Exception& ex, void* buffer, UInt32 size, int flags, So
 		lock.lock();
 	}
 
+	// with kTLS reception SSL_read reads records already decrypted by the kernel, and keeps the handling of control records (alert, key update...)
 	int result = catchResult(ex, SSL_read(_ssl, buffer, size), " (from=", peerAddress(), ", size=", size, ")");
 	// assign pAddress (no other way possible here)
 	if(pAddress)
 		pAddress->set(peerAddress());
-	if(result > 0)
+	if (result > 0) {
 		Mona::Socket::receive(result);
+		handshaked();
+	}
 	return result;
 }
 
 int TLS::Socket::sendTo(Exception& ex, const void* data, UInt32 size, const SocketAddress& address, int flags) {
-	if (!pTLS)
-		return Mona::Socket::sendTo(ex, data, size, address, flags); // normal socket
+	if (!pTLS || _ktls)
+		return Mona::Socket::sendTo(ex, data, size, address, flags); // normal socket or kernel TLS (kernel makes records)
 	lock_guard<mutex> lock(_mutex);
 	if (!_ssl)
 		return Mona::Socket::sendTo(ex, data, size, address, flags); // normal socket
 	int result = catchResult(ex, SSL_write(_ssl, data, size), " (address=", address ? address : peerAddress(), ", size=", size, ")");
-	if (result > 0)
+	if (result > 0) {
 		Mona::Socket::send(result);
+		pTLS->_records += (result + SSL3_RT_MAX_PLAIN_LENGTH - 1) / SSL3_RT_MAX_PLAIN_LENGTH;
+		pTLS->_recordBytes += result;
+		handshaked();
+	}
 	return result;
 }
 
+int TLS::Socket::sendFile(Exception& ex, const File& file, UInt64 offset, UInt32 size) {
+	if (!pTLS || _ktls)
+		return Mona::Socket::sendFile(ex, file, offset, size);
+	ex.set<Ex::Unsupported>("sendfile requires kernel TLS on a TLS socket");
+	return -1;
+}
+
 bool TLS::Socket::flush(Exception& ex, bool deleting) {
 	// Call when Writable!
 	if (!pTLS || queueing() || deleting) // if queueing a SLL_Write will do the handshake!
@@ -173,6 +399,8 @@ bool TLS::Socket::flush(Exception& ex, bool deleting) {
 	// maybe WRITE event for handshake need!
 	unique_lock<mutex> lock(_mutex);
 	if (!_ssl || catchResult(ex, SSL_do_handshake(_ssl)) > 0) {
+		if (_ssl)
+			handshaked();
 		lock.unlock(); // always unlock to flush because can call TLS::sendTo which relock _mutex
 		return Mona::Socket::flush(ex, deleting);
 	}
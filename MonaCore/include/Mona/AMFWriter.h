@@ -56,6 +56,19 @@ struct AMFWriter : DataWriter, virtual Object {
 
 	static AMFWriter&    Null() { static AMFWriter Null; return Null; }
 
+	/*!
+	Message encoded one time in AMF0 and then shared by all the writers, without copy nor encoding again:
+	the per-writer parts (stream id, time and channel of RTMP/RTMFP headers) are written by the writer itself.
+	Its memory doesn't come from Buffer::Allocator to allow a static usage */
+	struct Template : Binary, virtual Object {
+		Template(const std::function<void(AMFWriter& writer)>& encoder);
+
+		const UInt8*	data() const { return BIN _data.data(); }
+		UInt32			size() const { return _data.size(); }
+	private:
+		std::string _data;
+	};
+
 private:
 	void endComplex(bool isObject);
 
@@ -63,7 +76,20 @@ private:
 
 	void writeText(const char* value,UInt32 size);
 
-	std::map<std::string,UInt32>	_stringReferences;
+	/*!
+	AMF3 string references: open addressing table (linear probing, power of 2 capacity) on strings stored contiguously,
+	reset() keeps the capacities to not allocate again for the next messages.
+	Returns the reference if the string has already been written, else adds it and returns the new count of references */
+	UInt32	stringReference(const char* value, UInt32 size);
+	struct StringRef {
+		StringRef(UInt32 hash, UInt32 offset, UInt32 size) : hash(hash), offset(offset), size(size) {}
+		UInt32 hash;
+		UInt32 offset;
+		UInt32 size;
+	};
+	std::vector<StringRef>			_strings; // index = reference
+	std::vector<UInt32>				_stringSlots; // 0 = free, else index+1 in _strings
+	std::string						_stringsData;
 	std::vector<UInt8>				_references;
 	UInt32							_amf0References;
 	bool							_amf3;
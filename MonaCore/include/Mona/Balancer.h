@@ -0,0 +1,116 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/UDPSocket.h"
+#include "Mona/DNSResolver.h"
+#include "Mona/Timer.h"
+#include "Mona/Parameters.h"
+
+namespace Mona {
+
+struct ServerAPI;
+/*!
+Load balancing between servers:
+- every node reports periodically its load (clients, egress byte rate, CPU) and the ones of nodes known to its peers by UDP (gossip),
+so a node has just to know one peer of the cluster
+- reports are signed with HMAC-SHA256 when a shared key is configured, otherwise just the reports of the peers configured are accepted,
+they carry their sending time (clocks of nodes synchronized) and explicit addresses of nodes, a report obsolete or replayed is rejected
+- on handshake a new client is redirected to the least loaded node when this node exceeds one of its thresholds
+(HTTP 307, RTMP connection rejected with redirect, RTMFP handshake redirection, see Peer::onHandshake)
+Has to be used on the server thread */
+struct Balancer : virtual Object {
+	struct Load {
+		Load() : clients(0), byteRate(0), cpu(0) {}
+		UInt32	clients;
+		UInt64	byteRate; // egress in bytes/s
+		UInt8	cpu; // percent of the machine
+	};
+	struct Node : Load {
+		Node() : id(0), time(0) {}
+		std::map<std::string, SocketAddress, String::IComparator> addresses; // protocol => public address
+		UInt64	id; // random identifier of the node, chosen on start
+		Int64	time; // reception time of this load
+	};
+	/*!
+	Records of a report, address of the node and its load, the first one is the sender */
+	typedef std::vector<std::pair<SocketAddress, Node>> Records;
+
+	Balancer(ServerAPI& api);
+	~Balancer() { stop(); }
+
+	/*!
+	Local load, updated every interval */
+	const Load&								load() const { return _load; }
+	/*!
+	Nodes known (by their balancer address) with a fresh load */
+	const std::map<SocketAddress, Node>&	nodes() const { return _nodes; }
+
+	/*!
+	Start with parameters "balancer.port" (0 = disabled), "balancer.peers" (resolved asynchronously), "balancer.key", "balancer.interval",
+	"balancer.host" (public host of this node, by default the first protocol publicHost not loopback), and thresholds "balancer.maxClients", "balancer.maxByteRate", "balancer.maxCPU" (0 = ignored) */
+	bool start(Exception& ex, const Parameters& parameters);
+	void stop();
+
+	/*!
+	Returns true and assigns redirection with the protocol address of the least loaded node
+	if this node exceeds one of its thresholds and a node less loaded exists */
+	bool redirect(const std::string& protocol, SocketAddress& redirection);
+
+	/*!
+	Write a report sent at time, with the load of the sender (address and node) then the loads of the nodes known,
+	signed with HMAC-SHA256 if key is not empty */
+	static shared<Buffer>	WriteReport(const std::string& key, Int64 time, const SocketAddress& address, const Node& node, const std::map<SocketAddress, Node>& nodes);
+	/*!
+	Check signature (if key is not empty) and version of a report, and read its sending time and its records
+	(node time relating to sending time), returns false if the report is invalid */
+	static bool				ReadReport(Exception& ex, const std::string& key, const Packet& packet, Int64& time, Records& records);
+
+private:
+	/*!
+	Load rate relating to thresholds, >= 1 means overloaded */
+	double	score(const Load& load) const;
+	void	report();
+	void	receive(const Packet& packet, const SocketAddress& address);
+	/*!
+	True if the node is this node, by its identifier or by one of its addresses (bound or public) */
+	bool	isSelf(UInt64 id, const SocketAddress& address);
+
+	ServerAPI&						_api;
+	UDPSocket						_socket;
+	Timer::OnTimer					_onTimer;
+	UInt64							_id;
+	std::string						_key;
+	IPAddress						_host;
+	std::vector<SocketAddress>		_peers;
+	std::deque<DNSResolver::OnResolved> _resolvings; // peers to resolve, released on stop to cancel
+	std::map<SocketAddress, Node>	_nodes;
+	std::map<UInt64, Int64>			_reports; // sending time of the last report by node id, to reject a replayed report
+	Load							_load;
+	UInt32							_interval;
+	UInt32							_maxClients;
+	UInt64							_maxByteRate;
+	UInt8							_maxCPU;
+	Int64							_cpuTime;
+	Int64							_cpuProcessTime;
+};
+
+
+} // namespace Mona
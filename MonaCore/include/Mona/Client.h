@@ -76,6 +76,9 @@ struct Client : Entity, virtual Object, Net::Stats {
 	Time						sendTime() const { return _pNetStats->sendTime(); }
 	UInt64						sendByteRate() const { return _pNetStats->sendByteRate(); }
 	double						sendLostRate() const { return _pNetStats->sendLostRate(); }
+	double						sendRepeatRate() const { return _pNetStats->sendRepeatRate(); }
+	UInt32						sendWindow() const { return _pNetStats->sendWindow(); }
+	UInt64						sendPacingRate() const { return _pNetStats->sendPacingRate(); }
 	
 	Writer&						writer() { return *_pWriter; }
 
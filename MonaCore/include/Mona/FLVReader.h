@@ -32,6 +32,9 @@ struct FLVReader : virtual Object, MediaReader {
 	Read fmash media header, beware you have to use previous Media::Audio/Video::Tag on every call */
 	static UInt8  ReadMediaHeader(const UInt8* data, UInt32 size, Media::Audio::Tag& tag, Media::Audio::Config& config);
 	static UInt8  ReadMediaHeader(const UInt8* data, UInt32 size, Media::Video::Tag& tag);
+
+	bool	indexable() const { return true; }
+	bool	resume(UInt64 position, Media::Source& source);
 private:
 	UInt32	parse(Packet& buffer, Media::Source& source);
 
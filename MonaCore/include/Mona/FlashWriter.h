@@ -44,6 +44,9 @@ struct FlashWriter : Writer, Media::TrackTarget, virtual Object {
 	AMFWriter&				writeAMFState(const char* name, const char* code, const char* level, const std::string& description, bool withoutClosing = false);
 	
 	AMFWriter&				writeAMFData(const std::string& name);
+	/*!
+	Write a message precompiled, see AMFWriter::Template */
+	void					writeAMFTemplate(AMF::Type type, const Packet& message) { write(type, 0, Media::Data::TYPE_AMF, message); }
 
 	void					writePong(UInt32 pingTime) { writeRaw().write16(0x0007).write32(pingTime); }
 
@@ -39,7 +39,7 @@ struct HTTPFileSender : HTTPSender, File, File::Decoder, virtual Object {
 private:
 	bool				run() override { ERROR(HTTPSender::name, " not runnable, read me with ioFile.read(pFileSender)"); return true; }
 	bool				load(Exception& ex);
-	UInt32				decode(shared<Buffer>& pBuffer, bool end) override;
+	UInt32				decode(shared<const Buffer>& pBuffer, bool end) override;
 	const std::string*	search(char c);
 	UInt32				generate(const Packet& packet, std::deque<Packet>& packets);
 
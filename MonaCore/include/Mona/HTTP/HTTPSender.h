@@ -73,6 +73,10 @@ struct HTTPSender : Runner, virtual Object {
 	Send HTTP body content */
 	bool send(const Packet& content);
 	/*!
+	Send HTTP body content from a file region by the kernel (sendfile), requires canSendFile() and a header without chunked encoding */
+	bool send(const shared<const File>& pFile, UInt64 offset, UInt64 size);
+	bool canSendFile() const { return _pSocket->canSendFile(); }
+	/*!
 	Finalize send */
 	void end();
 
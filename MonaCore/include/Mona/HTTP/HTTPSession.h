@@ -76,6 +76,7 @@ private:
 	// options
 	std::string			_index;
 	bool				_indexDirectory;
+	std::string			_metrics;
 };
 
 
@@ -59,6 +59,9 @@ struct HTTPWriter : Writer, Media::Target, virtual Object {
 	void			writeMasterPlaylist(Playlist::Master&& playlist) { newSender<HTTPMPlaylistSender>(true, std::move(playlist)); }
 
 	BinaryWriter&   writeRaw(const char* code);
+	/*!
+	Text response with a text/subMime content type, subMime has to be a literal string */
+	void			writeText(const Packet& packet, const char* subMime = "plain; charset=utf-8") { newSender<HTTPDataSender>(true, HTTP_CODE_200, MIME::TYPE_TEXT, subMime, packet); }
 	DataWriter&     writeResponse(const char* subMime);
 
 
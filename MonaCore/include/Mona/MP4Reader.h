@@ -24,14 +24,19 @@ details (or else see http://www.gnu.org/licenses/).
 namespace Mona {
 
 /*!
-/!\ Don't support mp4 file with mdat before moov, used -movflags faststart with ffmpeg to avoid it (or a fragmented mp4 file)*/
+mp4 file with mdat before moov (no -movflags faststart) is supported just with a seekable source (MediaFile::Reader):
+mdat is skipped to read moov in the tail, and then reader comes back to mdat to read samples
+Params:
+	from=UInt32 (time in ms, starts reading on the nearest keyframe before this time with the moov index, no fragmented mp4 file) */
 struct MP4Reader : virtual Object, MediaReader {
 	// http://atomicparsley.sourceforge.net/mpeg-4files.html
 	// https://www.adobe.com/content/dam/Adobe/en/devnet/flv/pdfs/video_file_format_spec_v10.pdf
 	// https://developer.apple.com/library/content/documentation/QuickTime/QTFF/QTFFChap2/qtff2.html
 	// https://w3c.github.io/media-source/isobmff-byte-stream-format.html
 	// With fragments box = > http://l.web.umkc.edu/lizhu/teaching/2016sp.video-communication/ref/mp4.pdf
-	MP4Reader() : _propVersion(0), _boxes(1), _position(0), _failed(false), _offset(0), _videos(0), _audios(0), _datas(0), _firstMoov(true), _sequence(0) {}
+	MP4Reader() : _propVersion(0), _boxes(1), _failed(false), _offset(0), _videos(0), _audios(0), _datas(0), _firstMoov(true), _sequence(0), _mdat(0), _moov(0), _from(0) {}
+
+	void setParams(const Parameters& parameters) { parameters.getNumber("from", _from = 0); }
 
 private:
 	
@@ -40,16 +45,19 @@ private:
 		const char* name() const { return _size ? _name : "undefined"; }
 
 		UInt32 code() const { return _size ? FOURCC(_name[0], _name[1], _name[2], _name[3]) : 0; }
-		operator UInt32() const { return _rest; }
-		UInt32 contentSize() const { return _size-8; }
-		UInt32 size() const { return _size; }
+		operator UInt32() const { return range<UInt32>(_rest); } // saturated on a 64 bits box, see rest()
+		UInt64 rest() const { return _rest; }
+		UInt64 contentSize() const { return _size - _header; }
+		UInt64 size() const { return _size; }
+		UInt8  headerSize() const { return _header; } // 8, or 16 with a 64 bits largesize
 		Box& operator=(BinaryReader& reader); // assign _name, _rest and _size
-		Box& operator=(std::nullptr_t) { _size = _rest = 0; return self; }
-		Box& operator-=(UInt32 readen);
+		Box& operator=(std::nullptr_t) { _size = _rest = 0; _header = 8; return self; }
+		Box& operator-=(UInt64 readen);
 	private:
 		char	_name[4];
-		UInt32	_size;
-		UInt32  _rest;
+		UInt64	_size;
+		UInt64  _rest;
+		UInt8	_header;
 	};
 
 
@@ -109,16 +117,19 @@ private:
 		std::vector<UInt32>			sizes;   // stsz
 		Durations					durations; // stts
 		std::deque<Repeat>			compositionOffsets; // ctts
+		std::vector<UInt32>			keys; // stss, empty means that all samples are keyframes
 
 	private:
 		UInt8 _track;
 	};
 
-	UInt32  parse(Packet& buffer, Media::Source& source);
+	UInt32  parse(Packet& packet, Media::Source& source);
 	void	onFlush(Packet& buffer, Media::Source& source);
 
-	UInt32  parseData(const Packet& packet, Media::Source& source);
 	void	flushMedias(Media::Source& source);
+	/*!
+	Skip samples before the nearest keyframe of time (moov index) */
+	void	skipTo(UInt32 time);
 
 	template<typename TagType>
 	void addMedia(UInt32 time, Track& track, const TagType& tag, const Packet& packet) {
@@ -136,7 +147,9 @@ private:
 	void	frameToMedias(Track& track, UInt32 time, const Packet& packet);
 
 	UInt32										_sequence;
-	UInt32										_position;
+	UInt64										_mdat; // position of mdat to come back after moov reading (mdat before moov)
+	UInt64										_moov; // position of moov already readen (mdat before moov)
+	UInt32										_from;
 	UInt64										_offset;
 	bool										_failed;
 	UInt8										_audios;
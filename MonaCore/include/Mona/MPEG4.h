@@ -27,6 +27,14 @@ struct MPEG4 : virtual Static {
 
 	static UInt16	ReadExpGolomb(BitReader& reader);
 
+	/*!
+	Find the next 00 00 01 start code of an Annex B byte stream (AVC, HEVC) between data and end,
+	zeros is the count of 0x00 preceding data (capped to 3) to allow a start code across two calls.
+	Returns the position after the 01 byte and zeros is the count of 0x00 preceding it (2 or 3 for 00 00 00 01),
+	or null if not found and zeros is the count of 0x00 ending the data.
+	Blocks without 00 00 are skipped with SIMD (AVX2, SSE2 or NEON) or word-at-a-time */
+	static const UInt8* FindStartCode(const UInt8* data, const UInt8* end, UInt8& zeros);
+
 	static UInt8	ReadAudioConfig(const UInt8* data, UInt32 size, UInt32& rate, UInt8& channels);
 	static UInt8	ReadAudioConfig(const UInt8* data, UInt32 size, UInt8& rateIndex, UInt8& channels);
 	static UInt32	RateFromIndex(UInt8 index) {
@@ -29,6 +29,49 @@ namespace Mona {
 
 struct MediaFile : virtual Static  {
 
+	/*!
+	Keyframe index of a media file to start reading on a time (Reader "from" parameter) without reading all the file before,
+	kept in memory by media file (no file written next to the media), invalidated when media file changes (size or last change) */
+	struct Index : virtual Object {
+		enum {
+			MAX_COUNT = 256 // indexes kept in memory, the least recently used are removed beyond
+		};
+		/*!
+		Get the index built for the media file, null if missing or outdated */
+		static shared<const Index>	Get(const Path& path);
+		/*!
+		Keep the index built in memory for next requests on its media file, ends its building */
+		static void					Set(const shared<const Index>& pIndex);
+		/*!
+		Returns false if the index of the media file is already in building, otherwise starts its building which has to end with Set or Cancel */
+		static bool					Build(const Path& path);
+		static void					Cancel(const Path& path);
+
+		/*!
+		Empty index for the current state of the media file */
+		Index(const Path& path) : path(path), _size(path.size(true)), _lastChange(path.lastChange()), _video(false) {}
+
+		const Path path;
+
+		bool	empty() const { return _positions.empty(); }
+		UInt32	count() const { return _positions.size(); }
+		/*!
+		Returns true if media file has not changed since index creation */
+		bool	valid() const { return path.size(true) == _size && path.lastChange() == _lastChange; }
+		/*!
+		Add a resumable position, audio positions are kept just if there is no video (one by second) */
+		void	add(Media::Type type, UInt32 time, UInt64 position);
+		/*!
+		Get position of the nearest keyframe before time */
+		bool	find(UInt32 time, UInt64& position) const;
+
+	private:
+		std::map<UInt32, UInt64> _positions;
+		bool					 _video;
+		UInt64					 _size;
+		Int64					 _lastChange;
+	};
+
 	struct Reader : MediaStream, virtual Object {
 		static unique<MediaFile::Reader> New(Exception& ex, const char* request, Media::Source& source, const Timer& timer, IOFile& io, std::string&& format = "");
 	
@@ -54,11 +97,14 @@ struct MediaFile : virtual Static  {
 		struct Decoder : File::Decoder, private Media::Source, virtual Object {
 			typedef Event<void()>	ON(Flush);
 
-			Decoder(const Handler& handler, const shared<MediaReader>& pReader, const Path& path, const std::string& name, const shared<std::deque<unique<Media::Base>>>& pMedias) :
-				_name(name), _handler(handler), _pReader(pReader), _path(path), _pMedias(pMedias) {}
+			Decoder(IOFile& io, const shared<MediaReader>& pReader, File& file, const std::string& name, const shared<std::deque<unique<Media::Base>>>& pMedias, UInt32 from = 0);
+			~Decoder();
 
 		private:
-			UInt32 decode(shared<Buffer>& pBuffer, bool end) override;
+			UInt32 decode(shared<const Buffer>& pBuffer, bool end) override;
+			/*!
+			Called on first keyframe, resume reading on "from" time with the index or build index in background */
+			bool   resume();
 
 			void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track = 1) { if(!_mediaTimeGotten) _mediaTimeGotten = !tag.isConfig; writeMedia<Media::Audio>(tag, packet, track); }
 			void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track = 1) { if (!_mediaTimeGotten) _mediaTimeGotten = tag.frame != Media::Video::FRAME_CONFIG; writeMedia<Media::Video>(tag, packet, track); }
@@ -76,9 +122,13 @@ struct MediaFile : virtual Static  {
 			
 			shared<MediaReader>		_pReader;
 			std::string				_name;
-			const Handler&			_handler;
-			Path					_path;
+			IOFile&					_io;
+			File&					_file; // File owns its decoder, so reference is valid while decoder lives
 			bool					_mediaTimeGotten;
+			UInt32					_from;
+			bool					_keyFrame;
+			shared<File>			_pIndexing; // background index building, stopped if decoder dies before end
+			File::OnError			_onIndexingError;
 			
 			shared<std::deque<unique<Media::Base>>> _pMedias;
 		};
@@ -91,6 +141,15 @@ struct MediaFile : virtual Static  {
 		shared<File>			_pFile;
 		shared<Decoder>			_pDecoder;
 
+		struct Indexer : File::Decoder, virtual Object {
+			Indexer(unique<MediaReader>&& pReader, const Path& path) : _pReader(std::move(pReader)), _pIndex(SET, path) {}
+			~Indexer() { if (_pIndex) Index::Cancel(_pIndex->path); } // stopped before end
+		private:
+			UInt32 decode(shared<const Buffer>& pBuffer, bool end) override;
+			unique<MediaReader> _pReader;
+			shared<Index>		_pIndex;
+		};
+
 		Timer::OnTimer			_onTimer;
 		Time					_realTime;
 		shared<std::deque<unique<Media::Base>>> _pMedias;
@@ -25,6 +25,9 @@ details (or else see http://www.gnu.org/licenses/).
 namespace Mona {
 
 struct MediaReader : virtual Object, private StreamData<Media::Source&> {
+	/*!
+	Raised by an indexable reader on every position where reading can be resumed (video keyframe or audio frame) */
+	typedef Event<void(Media::Type type, UInt32 time, UInt64 position)> ON(KeyFrame);
 	
 	static unique<MediaReader> New(const char* subMime);
 	static unique<MediaReader> New(const std::string& subMime) { return New(subMime.c_str()); }
@@ -38,8 +41,32 @@ struct MediaReader : virtual Object, private StreamData<Media::Source&> {
 	MIME::Type			mime() const;
 	virtual const char*	subMime() const; // Keep virtual to allow to RTPReader to redefine it
 
+	/*!
+	Set to true by a seekable source (file) to allow reader to request a random access */
+	bool	seekable;
+	/*!
+	To call by the seekable source after read to get the position where the reader wants to continue,
+	returns false if reading has to continue sequentially */
+	bool	seeking(UInt64& position);
+
+	/*!
+	Returns true if reader raises onKeyFrame and supports resume */
+	virtual bool indexable() const { return false; }
+	/*!
+	Resume reading on a position given by onKeyFrame, requires a seekable source (see MediaFile::Reader) */
+	virtual bool resume(UInt64 position, Media::Source& source) { return false; }
+
 protected:
-	MediaReader() {}
+	MediaReader() : seekable(false), _seeking(0), _position(0) {}
+
+	/*!
+	Absolute position in the source of current which is a pointer on the buffer given to parse */
+	UInt64	position(const Packet& buffer, const UInt8* current) const { return _position - (buffer.data() + buffer.size() - current); }
+
+	/*!
+	Request the source to feed the reader from position on next read,
+	returns false if source is not seekable, in this case reader has to continue sequentially */
+	bool	seek(UInt64 position) { if (!seekable) return false; _seeking = position + 1; return true; }
 	
 	virtual void	onFlush(Packet& buffer, Media::Source& source);
 private:
@@ -49,6 +76,9 @@ private:
 	virtual UInt32	parse(Packet& buffer, Media::Source& source) = 0;
 
 	UInt32 onStreamData(Packet& buffer, Media::Source& source) { return parse(buffer, source); }
+
+	UInt64 _seeking; // position+1, 0 means no seeking
+	UInt64 _position; // position of the end of data received
 };
 
 struct MediaTrackReader : virtual Object, MediaReader {
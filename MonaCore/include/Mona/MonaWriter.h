@@ -46,7 +46,7 @@ private:
 	void write(UInt8 track, const TagType& tag, const Packet& packet, const OnWrite& onWrite, const Packet& header = Packet::Null()) {
 		if (!onWrite)
 			return;
-		UInt8 buffer[9];
+		UInt8 buffer[13]; // size + packed tag (9 bytes max)
 		BinaryWriter writer(buffer, sizeof(buffer));
 		UInt32 size = header.size() + packet.size();
 		Media::Pack(writer.write32(Media::PackedSize(tag, track) + size), tag, track);
@@ -44,7 +44,7 @@ private:
 
 	UInt8					_type;
 	Media::Video::Tag		_tag;
-	UInt8					_state;
+	UInt8					_zeros; // 0x00 preceding the current position, to detect a start code across two parse calls
 	UInt32					_position;
 	shared<Buffer>			_pNal;
 };
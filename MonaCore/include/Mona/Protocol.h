@@ -27,6 +27,9 @@ namespace Mona {
 struct ServerAPI;
 struct Protocol : virtual Object, Parameters {
 	const char*			name;
+	/*!
+	Owner of the buffers of its sockets (see Buffer::Tag) */
+	Buffer::Tag&		bufferTag;
 
 	const SocketAddress	address; // bind protocol address
 	const SocketAddress	publicAddress; // public protocol address
@@ -25,6 +25,7 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/MediaFile.h"
 #include "Mona/CCaption.h"
 #include "Mona/Segments.h"
+#include "Mona/Metrics.h"
 #include <set>
 
 namespace Mona {
@@ -66,6 +67,24 @@ struct Publication : Media::Source, Media::Properties, virtual Object {
 	};
 
 
+	/*!
+	Latency stages of the media traced (see Metrics::Trace):
+	- DECODE, from reception to its queueing to the main thread (decoding thread)
+	- WAIT, waiting in the main thread queue
+	- PROCESS, main thread processing up to the publication
+	- FLUSH, from publication to its flush to the subscriptions
+	- TOTAL, from reception to its flush to the subscriptions */
+	enum Stage {
+		STAGE_DECODE = 0,
+		STAGE_WAIT,
+		STAGE_PROCESS,
+		STAGE_FLUSH,
+		STAGE_TOTAL,
+		STAGE_COUNT
+	};
+	static const char* StageToString(Stage stage);
+
+
 	Publication(const std::string& name);
 	virtual ~Publication();
 
@@ -86,8 +105,14 @@ struct Publication : Media::Source, Media::Properties, virtual Object {
 
 	UInt16							latency() const { return _latency; }
 	UInt64							byteRate() const { return _byteRate; }
+	/*!
+	Byte rate distributed to the subscriptions (egress before subscription drops) */
+	UInt64							egressByteRate() const { return _egressByteRate; }
 	UInt64							maxByteRate() const { return _maxByteRate; }
 	double							lostRate() const { return _lostRate; }
+	/*!
+	Latencies in microseconds of the stage, NULL if no media has been traced */
+	const Metrics::Samples*			latencies(Stage stage) const { return _pLatencies ? &_pLatencies->stages[stage] : NULL; }
 	UInt32							currentTime() const;
 	UInt32							lastTime() const;
 
@@ -130,7 +155,11 @@ struct Publication : Media::Source, Media::Properties, virtual Object {
 
 private:
 	void flushProperties();
+	void trace();
 	void stopRecording();
+	/*!
+	Tag owner of medias retained by segments adopting the packet buffer, NULL if buffer tagging is disabled */
+	Buffer::Tag* bufferTag(const Packet& packet);
 
 	// Media::Properties overrides
 	void onParamChange(const std::string& key, const std::string* pValue);
@@ -138,8 +167,18 @@ private:
 
 	UInt64							_maxByteRate;
 	ByteRate						_byteRate;
+	ByteRate						_egressByteRate;
 	LostRate						_lostRate;
 
+	struct Latencies : virtual Object {
+		Latencies() : received(0), pending(0), published(0) {}
+		Metrics::Samples	stages[STAGE_COUNT];
+		Int64				received; // reception of the last media traced
+		Int64				pending; // reception of the older media traced waiting flush
+		Int64				published; // publication of the older media traced waiting flush, 0 when flushed
+	};
+	unique<Latencies>				_pLatencies;
+
 	MediaTracks<AudioTrack>			_audios;
 	MediaTracks<VideoTrack>			_videos;
 	Tracks<DataTrack>				_datas;
@@ -158,6 +197,7 @@ private:
 	// segmentation support (HLS/DASH)
 	Segments						_segments;
 	bool							_segmenting;
+	Buffer::Tag*					_pBufferTag; // owner of the medias retained, created on first need
 };
 
 
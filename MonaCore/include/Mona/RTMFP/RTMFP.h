@@ -42,7 +42,6 @@ struct RTMFP : virtual Static {
 
 
 	enum { TIMESTAMP_SCALE = 4 };
-	enum { SENDABLE_MAX = 6 };
 
 	enum {
 		SIZE_HEADER = 11,
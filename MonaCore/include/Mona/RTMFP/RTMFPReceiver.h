@@ -40,6 +40,11 @@ struct RTMFPReceiver : RTMFP::Session, virtual Object {
 	std::set<SocketAddress>	localAddresses;
 	
 	void	receive(Socket& socket, shared<Buffer>& pBuffer, const SocketAddress& address);
+
+	/*!
+	Convert the bitmap of a 0x50 ack to the ranges of a 0x51 ack (holes-1, received-1),
+	bit 0 is stage+2 (stage+1 is lost by definition) */
+	static BinaryWriter& WriteRanges(BinaryReader& bitmap, BinaryWriter& writer);
 private:
 	Buffer& write(Socket& socket, const SocketAddress& address, UInt8 type, UInt16 size);
 
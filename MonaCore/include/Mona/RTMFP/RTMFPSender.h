@@ -29,8 +29,9 @@ namespace Mona {
 
 struct RTMFPSender : Runner, virtual Object {
 	struct Packet : Mona::Packet, virtual Object {
-		Packet(shared<Buffer>& pBuffer, UInt32 fragments, bool reliable) : fragments(fragments), Mona::Packet(pBuffer), reliable(reliable), _sizeSent(0) {}
+		Packet(shared<Buffer>& pBuffer, UInt32 fragments, bool reliable) : fragments(fragments), Mona::Packet(pBuffer), reliable(reliable), sentTime(0), acked(false), _sizeSent(0) {}
 		void setSent() {
+			sentTime = Time::Now();
 			if (_sizeSent)
 				return;
 			_sizeSent = size();
@@ -40,13 +41,76 @@ struct RTMFPSender : Runner, virtual Object {
 		const bool   reliable;
 		const UInt32 fragments;
 		UInt32		 sizeSent() const { return _sizeSent; }
+		// used by sender thread
+		Int64		 sentTime; // last transmission
+		bool		 acked; // selectively acknowledged or abandoned, so not more in flight
 	private:
 		UInt32 _sizeSent;
 	};
+	/*!
+	Congestion control of a session, CUBIC window (RFC 8312) with slow start until the first loss,
+	and pacing of packets at window/RTT by a token bucket (no timer on sender thread, a paced packet waits the next ack or flush).
+	Used by the sender thread excepting window(), pacingRate() and rtt which are atomic */
+	struct Congestion : virtual Object {
+		enum {
+			WINDOW_INIT = 6, // packets
+			WINDOW_MIN = 2, // packets
+			WINDOW_MAX = 0xFFFF // packets
+		};
+		Congestion();
+
+		/*!
+		Congestion window in bytes */
+		UInt32	window() const { return _window; }
+		/*!
+		Pacing rate in bytes/s, 0 while RTT is unknown */
+		UInt64	pacingRate() const;
+		/*!
+		Bytes sent and not acknowledged */
+		UInt32	inflight() const { return _inflight; }
+
+		std::atomic<UInt16>	rtt; // smoothed RTT in ms, assigned by the session on ping
+
+		bool	sendable(UInt32 size);
+		void	sent(UInt32 size);
+		void	acked(UInt32 size);
+		/*!
+		Bytes sent which will never be acknowledged (writer failed) */
+		void	released(UInt32 size);
+		/*!
+		Loss detected by a gap in acks, one reduction by RTT */
+		void	lost();
+		/*!
+		Repetition after RTO, restarts with the minimum window */
+		void	timeout();
+		/*!
+		Time after which a packet not acknowledged whereas a packet sent after has been acknowledged is presumed lost,
+		RTT + RTT/4 of reordering window (RACK, RFC 8985) */
+		UInt32	lossDelay() const;
+	private:
+		void	reduce(Int64 now);
+		void	update(double window);
+
+		std::atomic<UInt32>	_inflight;
+		std::atomic<UInt32>	_window;
+		std::atomic<bool>	_slowStart;
+		double				_cwnd; // packets
+		double				_threshold; // packets
+		// CUBIC
+		double				_wMax;
+		double				_origin;
+		double				_k;
+		double				_estimated; // TCP friendly window
+		Int64				_epoch;
+		Int64				_lossTime;
+		// pacing
+		UInt32				_credit;
+		Int64				_creditTime;
+	};
 	struct Session : virtual Object {
 		Session(const shared<RTMFP::Session>& pSession, const shared<Socket>& pSocket) :
-			sendable(RTMFP::SENDABLE_MAX), socket(*pSocket), pEncoder(SET, *pSession->pEncoder),
-			queueing(0), _pSocket(pSocket), _pSession(pSession), sendLostRate(sendByteRate), sendTime(0) {}
+			socket(*pSocket), pEncoder(SET, *pSession->pEncoder),
+			queueing(0), _pSocket(pSocket), _pSession(pSession), sendLostRate(sendByteRate), sendRepeatRate(sendByteRate), sendTime(0) {}
 		UInt32					id() const { return _pSession->id; }
 		UInt32					farId() const { return _pSession->farId; }
 		std::atomic<Int64>&		initiatorTime() { return _pSession->initiatorTime; }
@@ -55,15 +119,24 @@ struct RTMFPSender : Runner, virtual Object {
 		std::atomic<Int64>		sendTime;
 		ByteRate				sendByteRate;
 		LostRate				sendLostRate;
+		LostRate				sendRepeatRate; // retransmission ratio
 		std::atomic<UInt64>		queueing;
-		UInt8					sendable;
+		Congestion				congestion;
 	private:
 		shared<Socket>			_pSocket;
 		shared<RTMFP::Session>	_pSession;
 	};
 	struct Queue : virtual Object, std::deque<shared<Packet>> {
 		template<typename SignatureType>
-		Queue(UInt64 id, UInt64 flowId, const SignatureType& signature) : id(id), stage(0), stageSending(0), stageAck(0), signature(STR signature.data(), signature.size()), flowId(flowId) {}
+		Queue(UInt64 id, UInt64 flowId, const SignatureType& signature) : id(id), stage(0), stageSending(0), stageAck(0), ackedTime(0), ackedStage(0), signature(STR signature.data(), signature.size()), flowId(flowId) {}
+		~Queue() {
+			if (!pSession)
+				return;
+			for (const shared<Packet>& pPacket : sending) {
+				if (!pPacket->acked)
+					pSession->congestion.released(pPacket->sizeSent());
+			}
+		}
 
 		const UInt64				id;
 		const UInt64				flowId;
@@ -73,7 +146,11 @@ struct RTMFPSender : Runner, virtual Object {
 		UInt64						stage;
 		UInt64						stageSending;
 		UInt64						stageAck;
+		// most recent transmission acknowledged (RACK), stage to order the packets sent in the same millisecond
+		Int64						ackedTime;
+		UInt64						ackedStage;
 		std::deque<shared<Packet>>	sending;
+		shared<Session>				pSession; // assigned on first sending to release its inflight bytes on deletion
 	};
 
 	// Flush usage!
@@ -88,6 +165,11 @@ protected:
 
 	shared<Queue>	pQueue;
 
+	/*!
+	Repeat a reliable packet or abandon an unreliable one, returns false on socket error */
+	bool		repeat(Packet& packet, UInt64 stage, UInt64& abandonStage, bool& oneReliable);
+	void		sendAbandon(UInt64 stage);
+
 private:
 	bool		 run(Exception& ex);
 	virtual void run() {}
@@ -101,21 +183,24 @@ private:
 	UInt8	_cmd;
 };
 
+/*!
+Acknowledgment with its ranges of fragments received after stageAck (pairs of holes-1 and received-1),
+repeats just the packets presumed lost by RACK (RFC 8985) */
 struct RTMFPAcquiter : RTMFPSender, virtual Object {
-	RTMFPAcquiter(const shared<RTMFPSender::Queue>& pQueue, UInt64 stageAck) : RTMFPSender("RTMFPAcquiter", pQueue), _stageAck(stageAck) {}
+	RTMFPAcquiter(const shared<RTMFPSender::Queue>& pQueue, UInt64 stageAck, const Mona::Packet& ranges) : RTMFPSender("RTMFPAcquiter", pQueue), _stageAck(stageAck), _ranges(std::move(ranges)) {}
 private:
 	void	run();
 
 	UInt64	_stageAck;
+	Mona::Packet	_ranges;
 };
 
+/*!
+Repetition on RTO, packets selectively acknowledged are not repeated */
 struct RTMFPRepeater : RTMFPSender, virtual Object {
-	RTMFPRepeater(const shared<RTMFPSender::Queue>& pQueue, UInt8 fragments = 0) : RTMFPSender("RTMFPRepeater", pQueue), _fragments(fragments) {}
+	RTMFPRepeater(const shared<RTMFPSender::Queue>& pQueue) : RTMFPSender("RTMFPRepeater", pQueue) {}
 private:
 	void	run();
-	void	sendAbandon(UInt64 stage);
-
-	UInt8	_fragments;
 };
 
 
@@ -58,6 +58,9 @@ private:
 	Time				sendTime() const { return _pSenderSession->sendTime.load(); }
 	UInt64				sendByteRate() const { return _pSenderSession->sendByteRate; }
 	double				sendLostRate() const { return _pSenderSession->sendLostRate; }
+	double				sendRepeatRate() const { return _pSenderSession->sendRepeatRate; }
+	UInt32				sendWindow() const { return _pSenderSession->congestion.window(); }
+	UInt64				sendPacingRate() const { return _pSenderSession->congestion.pacingRate(); }
 	UInt64				queueing() const;
 
 	void				onParameters(const Parameters& parameters);
@@ -37,7 +37,7 @@ struct RTPWriter : MediaWriter, virtual Object {
 	// /!\ Serialize bufferized packets with maximum size = MTU size configuration, ready to send on network
 	
 	template <typename ...ProfileArgs>
-	RTPWriter(UInt32 mtuSize, ProfileArgs... args) : mtuSize(mtuSize), _profile(args ...) {
+	RTPWriter(UInt32 mtuSize, ProfileArgs... args) : mtuSize(mtuSize), senderReportInterval(5000), _profile(args ...), _ssrc(0), _sequence(0), _packets(0), _bytes(0), _time(0) {
 		if (mtuSize < 32) {
 			ERROR("RTP MTU size must be superior to 32");
 			mtuSize = 32;
@@ -45,26 +45,28 @@ struct RTPWriter : MediaWriter, virtual Object {
 	}
 
 	template <typename ...ProfileArgs>
-	RTPWriter(ProfileArgs... args) : mtuSize(Net::MTU_RELIABLE_SIZE), _profile(args ...) {}
+	RTPWriter(ProfileArgs... args) : mtuSize(Net::MTU_RELIABLE_SIZE), senderReportInterval(5000), _profile(args ...), _ssrc(0), _sequence(0), _packets(0), _bytes(0), _time(0) {}
 	
 	const UInt32 mtuSize;
+	UInt32		 senderReportInterval; // RTCP sender report interval in ms
 
 	void beginMedia(const OnWrite& onWrite) {
 		_senderReportTime.update();
-		_bytes = _count = 0;
+		_bytes = _packets = 0;
 		_ssrc = Util::Random<UInt32>();
+		_sequence = Util::Random<UInt16>(); // random initial sequence number, RFC 3550 5.1
 	}
-	void writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, const OnWrite& onWrite) { write(track, tag, packet, onWrite); }
-	void writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, const OnWrite& onWrite) { write(track, tag, packet, onWrite); }
+	void writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, const OnWrite& onWrite) { write(track, tag, tag.time, packet, onWrite); }
+	void writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, const OnWrite& onWrite) { write(track, tag, tag.time + tag.compositionOffset, packet, onWrite); }
 	void endMedia(const OnWrite& onWrite) {
 		if (!onWrite)
 			return;
 		// RTCP BYE packet
-		BUFFER_RESET(_pBuffer, 0);
-		BinaryWriter writer(*_pBuffer);
-		writer.write(EXPAND("\x81\xCB\x00\x04"));		// Version (2), padding and Reception report count (1), packet type = 203 (Bye), lenght = 6
+		shared<Buffer> pBuffer(SET);
+		BinaryWriter writer(*pBuffer);
+		writer.write(EXPAND("\x81\xCB\x00\x01"));		// Version (2), padding and Source count (1), packet type = 203 (Bye), length = 1 (in 32-bit words minus one)
 		writer.write32(_ssrc);
-		onWrite(Packet(_pBuffer));
+		onWrite(Packet(pBuffer));
 	}
 	
 private:
@@ -74,7 +76,7 @@ private:
 	bool writeMedia(const Media::Video::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite) { return _profile.writeVideo(tag, reader, writer, canWrite); }
 
 	template<typename TagType>
-	void write(UInt8 track, const TagType& tag, const Packet& packet, const OnWrite& onWrite) {
+	void write(UInt8 track, const TagType& tag, UInt32 time, const Packet& packet, const OnWrite& onWrite) {
 		if (!onWrite)
 			return;
 		bool isAudio(typeid(TagType) == typeid(Media::Audio::Tag));
@@ -92,75 +94,62 @@ private:
 			_profile.track = track;
 		}
 
-		UInt32 canWrite(0);
+		_time = UInt32(UInt64(time) * _profile.clockRate(tag) / 1000);
 		BinaryReader reader(packet.data(), packet.size());
-		bool flush(!reader.available());
-	
-		while (!flush) {
-	
-			if(!_pBuffer)
-				_pBuffer.set();
-			BinaryWriter writer(*_pBuffer);
-
-			if (!writer) {
-				// Write RTP header
-				writer.write8(0x80);		// Version (2), padding and extension (0)
-				writer.write8(0x80 | _profile.playloadType); // marker always set to 1
-				writer.write16(++_count);	// Sequence number
-				writer.write32(tag.time*90);	// Timestamp
-				writer.write32(_ssrc);		// SSRC
-			
-				canWrite = mtuSize-12;
-			}
-	
-			UInt32 written(writer.size());
-			flush = writeMedia(tag, reader, writer, canWrite);
-			written -= writer.size()>written ? written : writer.size();
+		while (reader.available()) {
+			shared<Buffer> pBuffer(SET);
+			BinaryWriter writer(*pBuffer);
+			// Write RTP header
+			writer.write8(0x80);		// Version (2), padding and extension (0)
+			writer.write8(playloadType); // marker set on the last packet of the frame
+			writer.write16(++_sequence);	// Sequence number
+			writer.write32(_time);		// Timestamp
+			writer.write32(_ssrc);		// SSRC
+
+			// Fill the packet until the profile flushes it (or doesn't progress anymore)
+			UInt32 available;
+			do {
+				available = reader.available();
+			} while (!writeMedia(tag, reader, writer, UInt16(writer.size() < mtuSize ? (mtuSize - writer.size()) : 0)) && reader.available() && reader.available() < available);
 
 			/// post condition checking
-			if (!written) {
-				// no write
-				if (!flush)
-					break; // no flush + no write, stop!
-				if (writer.size() <= 12) { // just header, flush can't increase canWrite
-					ERROR(TypeOf<RTP_ProfileType>()," requires size which superior to the MTU ", mtuSize, " size configured");
-					break;
-				}
-			} else if(written>canWrite) {
-				WARN(TypeOf<RTP_ProfileType>()," packet with ", writer.size()," size exceeds the MTU ", mtuSize, " size configured");
-				canWrite = 0;
-			} else
-				canWrite -= written;
-	
-			if(flush) {
-				// flush
-				_bytes += _pBuffer->size()-12;
-				onWrite(Packet(_pBuffer));
-				if (!reader.available())
-					break; // flushed, and no more data to read!
+			if (writer.size() <= 12) { // just header
+				ERROR(TypeOf<RTP_ProfileType>()," requires size which superior to the MTU ", mtuSize, " size configured");
+				--_sequence;
+				break;
 			}
+			if (writer.size() > mtuSize)
+				WARN(TypeOf<RTP_ProfileType>(), " packet with ", writer.size(), " size exceeds the MTU ", mtuSize, " size configured");
+			if (!reader.available())
+				pBuffer->data()[1] |= 0x80; // marker, end of frame
+			++_packets;
+			_bytes += writer.size() - 12;
+			onWrite(Packet(pBuffer));
 		}
 
-		if (_senderReportTime.isElapsed(5000)) {
+		if (_senderReportTime.isElapsed(senderReportInterval)) {
 			// RTCP Sender report
-			BUFFER_RESET(_pBuffer, 0);
-			BinaryWriter writer(*_pBuffer);
-			writer.write(EXPAND("\x80\xC8\x00\x06"));		// Version (2), padding and Reception report count (0), packet type = 200 (Sender Report), lenght = 6
+			shared<Buffer> pBuffer(SET);
+			BinaryWriter writer(*pBuffer);
+			Int64 now(Time::Now());
+			writer.write(EXPAND("\x80\xC8\x00\x06"));		// Version (2), padding and Reception report count (0), packet type = 200 (Sender Report), length = 6
 			writer.write32(_ssrc);							// SSRC
-			writer.write64(0);								// NTP Timestamp (not needed)
-			writer.write32(tag.time);						// RTP Timestamp
-			writer.write32(_count);							// Packet count
-			writer.write32(_bytes);							// Octet count
-			_count = _bytes = 0;
+			writer.write32(UInt32(now / 1000 + 2208988800ll));	// NTP Timestamp, seconds since 1900
+			writer.write32(UInt32(((now % 1000) << 32) / 1000)); // NTP Timestamp, fraction
+			writer.write32(_time);							// RTP Timestamp corresponding to the NTP time
+			writer.write32(_packets);						// Sender's packet count
+			writer.write32(_bytes);							// Sender's octet count
 			_senderReportTime.update();
+			onWrite(Packet(pBuffer));
 		}
 	}
 
 	RTP_ProfileType			_profile;
-	shared<Buffer>			_pBuffer;
 	UInt32					_bytes;
-	UInt16					_count;
+	UInt32					_packets;
+	UInt16					_sequence;
 	UInt32					_ssrc;
+	UInt32					_time;
 	Time					_senderReportTime;
 	
 };
@@ -33,6 +33,9 @@ struct RTP_H264 : virtual Object {
 	const bool  supportTracks;
 	UInt8	track;
 
+	UInt32 clockRate(const Media::Audio::Tag& tag) const { return 90000; }
+	UInt32 clockRate(const Media::Video::Tag& tag) const { return 90000; }
+
 	// Write
 	bool writeAudio(const Media::Audio::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite);
 	bool writeVideo(const Media::Video::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite);
@@ -41,8 +44,8 @@ struct RTP_H264 : virtual Object {
 	void parse(UInt32 time, UInt8 extension, UInt16 lost, const Packet& packet, Media::Source& source);
 	void flush(Media::Source& source);
 private:
-	UInt32	_size;
-	UInt8	_type;
+	UInt32	_size; // rest of the current NALU
+	UInt8	_type; // NALU header
 	bool	_fragmentation;
 };
 
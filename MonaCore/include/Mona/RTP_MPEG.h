@@ -33,6 +33,9 @@ struct RTP_MPEG : virtual Object {
 	const bool  supportTracks;
 	UInt8		track;
 
+	UInt32 clockRate(const Media::Audio::Tag& tag) const { return 90000; }
+	UInt32 clockRate(const Media::Video::Tag& tag) const { return 90000; }
+
 	// Write
 	bool writeAudio(const Media::Audio::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite);
 	bool writeVideo(const Media::Video::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite);
@@ -0,0 +1,103 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Parameters.h"
+#include "Mona/Packet.h"
+#include "Mona/Path.h"
+
+namespace Mona {
+
+#define RTSP_CODE_200	"200 OK"
+#define RTSP_CODE_400	"400 Bad Request"
+#define RTSP_CODE_401	"401 Unauthorized"
+#define RTSP_CODE_404	"404 Not Found"
+#define RTSP_CODE_405	"405 Method Not Allowed"
+#define RTSP_CODE_415	"415 Unsupported Media Type"
+#define RTSP_CODE_454	"454 Session Not Found"
+#define RTSP_CODE_455	"455 Method Not Valid in This State"
+#define RTSP_CODE_459	"459 Aggregate Operation Not Allowed"
+#define RTSP_CODE_461	"461 Unsupported Transport"
+#define RTSP_CODE_500	"500 Internal Server Error"
+#define RTSP_CODE_501	"501 Not Implemented"
+#define RTSP_CODE_503	"503 Service Unavailable"
+
+struct RTSP : virtual Static {
+	// https://tools.ietf.org/html/rfc2326
+
+	enum Type {
+		TYPE_UNKNOWN = 0,
+		TYPE_OPTIONS,
+		TYPE_DESCRIBE,
+		TYPE_SETUP,
+		TYPE_PLAY,
+		TYPE_PAUSE,
+		TYPE_TEARDOWN,
+		TYPE_GET_PARAMETER,
+		TYPE_SET_PARAMETER,
+		TYPE_ANNOUNCE,
+		TYPE_RECORD
+	};
+	static Type			ParseType(const char* value, std::size_t size);
+	static const char*	TypeToString(Type type);
+	/*!
+	RTSP response code of a Session::ERROR_* */
+	static const char*	ErrorToCode(Int32 error);
+
+	/*!
+	Request header, request line + fields (case insensitive) */
+	struct Header : Parameters, virtual Object {
+		Header(const char* data, UInt32 size);
+
+		const Exception	ex;
+		RTSP::Type		type;
+		std::string		url; // absolute URL of request
+		Path			path;
+		std::string		query;
+		UInt32			cseq;
+		UInt32			contentLength;
+		std::string		session; // session ID without its parameters
+	};
+
+	/*!
+	First transport proposed by a SETUP Transport field,
+	RTP/AVP/TCP;unicast;interleaved=0-1 or RTP/AVP;unicast;client_port=5000-5001 */
+	struct Transport : virtual Object {
+		Transport(const char* value);
+
+		bool	tcp;
+		bool	multicast;
+		bool	interleaved; // interleaved channels chosen by the client
+		UInt8	channel; // RTP interleaved channel, RTCP is on channel+1
+		UInt16	clientPort; // RTP UDP port, RTCP is on clientPort+1
+	};
+
+	struct Request : Packet, virtual Object {
+		Request(shared<Header>& pHeader, const Packet& packet) : Packet(std::move(packet)), _pHeader(std::move(pHeader)) {}
+
+		const Header* operator->() const { return _pHeader.get(); }
+		const Header& operator*() const { return *_pHeader; }
+	private:
+		shared<const Header> _pHeader;
+	};
+};
+
+
+} // namespace Mona
@@ -0,0 +1,98 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/TCPSession.h"
+#include "Mona/RTSP/RTSPDecoder.h"
+#include "Mona/RTSP/RTSPStream.h"
+
+namespace Mona {
+
+/*!
+RTSP player session (DESCRIBE/SETUP/PLAY), RTP packets are received already prepared by the shared RTSPStream of the publication,
+sent as they are on TCP interleaved channels or on UDP (server ports of RTSProtocol).
+RTP-Info of PLAY response gives the sequence and time of first packet sent, so no per-viewer rewrite of RTP headers is required */
+struct RTSPSession : TCPSession, private RTSPStream::Viewer, virtual Object {
+	RTSPSession(Protocol& protocol, const shared<Socket>& pSocket);
+	~RTSPSession();
+
+private:
+	Socket::Decoder*		newDecoder();
+	RTSPDecoder::OnRequest	_onRequest;
+
+	bool	manage();
+	void	flush() {} // RTP and responses are sent immediately
+	void	kill(Int32 error = 0, const char* reason = NULL) override;
+
+	void	writeRTP(UInt8 track, const Packet& packet, bool isRTCP, bool isKey) override;
+
+	/*!
+	Assign stream name and track (0xFF if no "trackID=" control) of the request */
+	void	parseURL(const RTSP::Header& header, std::string& stream, UInt8& track);
+	/*!
+	Get the shared stream, recreate it if publication has been restarted */
+	bool	getStream(Exception& ex, const std::string& name);
+	bool	processSetup(Exception& ex, const RTSP::Header& header, const std::string& stream, UInt8 track, std::string& fields);
+	bool	processPlay(Exception& ex, const RTSP::Header& header);
+	/*!
+	Send the PLAY response pending, deferred until the first packet sent when video has to start on a key frame (packets before are not sent),
+	rtp is the RTP header of this first video packet, NULL if not sent yet (RTP-Info without video) */
+	void	sendPlay(const UInt8* rtp = NULL);
+	void	stop();
+
+	void	send(const RTSP::Header& header, const char* code, const std::string& fields = String::Empty(), const std::string& content = String::Empty()) { send(header.cseq, code, fields, content); }
+	void	send(UInt32 cseq, const char* code, const std::string& fields = String::Empty(), const std::string& content = String::Empty());
+
+	/*!
+	Subscription target and main writer of the session: RTP is written by RTSPStream,
+	it's there just to get authorization, statistics and congestion detection of the subscription */
+	struct RTSPWriter : Writer, Media::Target, virtual Object {
+		RTSPWriter(TCPSession& session) : _session(session) {}
+		UInt64	queueing() const { return _session->queueing(); }
+	private:
+		bool	beginMedia(const std::string& name) { return true; }
+		bool	writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, bool reliable) { return true; }
+		bool	writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, bool reliable) { return true; }
+		bool	writeData(UInt8 track, Media::Data::Type type, const Packet& packet, bool reliable) { return true; }
+
+		TCPSession& _session;
+	};
+
+	struct Transport {
+		Transport() : setup(false), channel(0) {}
+		bool			setup;
+		UInt8			channel; // interleaved channel if TCP
+		SocketAddress	rtp; // client address if UDP
+		SocketAddress	rtcp;
+	};
+
+	RTSPWriter			_writer;
+	Subscription*		_pSubscription;
+	shared<RTSPStream>	_pStream;
+	Transport			_transports[RTSPStream::TRACK_COUNT];
+	std::string			_sessionId; // RTSP session ID
+	bool				_waitKey;
+	UInt32				_playCSeq;
+	std::string			_playURL; // base URL of the PLAY response pending, empty if no response pending
+};
+
+
+} // namespace Mona
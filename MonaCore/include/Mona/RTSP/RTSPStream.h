@@ -0,0 +1,102 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Subscription.h"
+#include "Mona/MediaWriter.h"
+
+namespace Mona {
+
+struct ServerAPI;
+/*!
+Live stream shared by all the RTSP viewers of a publication:
+RTP packetization (FU-A fragmentation, RTCP sender reports) and SDP description are done one time for all the viewers.
+Packets are framed for TCP interleaving ('$' + channel + size) with the default channel of the track,
+an UDP viewer sends them without this 4 bytes framing, a TCP viewer on a different channel has to patch the channel byte.
+Has to be used on the server thread */
+struct RTSPStream : private Media::Target, virtual Object {
+	enum {
+		TRACK_VIDEO = 0,
+		TRACK_AUDIO,
+		TRACK_COUNT
+	};
+
+	struct Viewer : virtual Object {
+		/*!
+		RTP or RTCP packet of track, isKey = first packet of a video key frame */
+		virtual void writeRTP(UInt8 track, const Packet& packet, bool isRTCP, bool isKey) = 0;
+	};
+
+	/*!
+	Build tracks and SDP description from publication codecs */
+	RTSPStream(ServerAPI& api, const Publication& publication);
+	~RTSPStream();
+
+	const std::string	name;
+	/*!
+	SDP description, track controls are "trackID=<track>" */
+	const std::string	description;
+
+	bool	start(Exception& ex);
+	/*!
+	End of publication reached (RTCP BYE sent), a new stream has to be created to follow a new publication */
+	bool	ended() const { return _ended; }
+
+	bool	hasTrack(UInt8 track) const { return track < TRACK_COUNT && _tracks[track]; }
+	/*!
+	Default interleaved channel of track, RTCP is on channel+1 */
+	UInt8	channel(UInt8 track) const { return _tracks[track].channel; }
+	/*!
+	Sequence number and RTP time of the last RTP packet of track (RTP-Info of PLAY response), returns false if nothing sent yet */
+	bool	rtpInfo(UInt8 track, UInt16& sequence, UInt32& time) const;
+
+	void	join(Viewer& viewer) { _viewers.emplace(&viewer); }
+	void	leave(Viewer& viewer) { _viewers.erase(&viewer); }
+	UInt32	viewers() const { return _viewers.size(); }
+
+private:
+	bool beginMedia(const std::string& name);
+	bool writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, bool reliable);
+	bool writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, bool reliable);
+	bool writeData(UInt8 track, Media::Data::Type type, const Packet& packet, bool reliable) { return true; }
+	bool endMedia();
+
+	struct Track : virtual Object {
+		NULLABLE(!pWriter)
+		Track() : channel(0), sequence(0), time(0), sent(false) {}
+
+		unique<MediaWriter>		pWriter;
+		MediaWriter::OnWrite	onWrite;
+		UInt8					channel;
+		UInt16					sequence;
+		UInt32					time;
+		bool					sent;
+	};
+
+	ServerAPI&			_api;
+	Subscription		_subscription;
+	Track				_tracks[TRACK_COUNT];
+	std::set<Viewer*>	_viewers;
+	bool				_keyFrame;
+	bool				_ended;
+};
+
+
+} // namespace Mona
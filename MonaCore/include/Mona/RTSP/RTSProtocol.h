@@ -0,0 +1,55 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/TCProtocol.h"
+#include "Mona/UDPSocket.h"
+#include "Mona/RTSP/RTSPSession.h"
+
+namespace Mona {
+
+/*!
+RTSP server, one RTSPStream by publication played, RTP over UDP is sent with the same couple of sockets for all the sessions ("udpPort" and "udpPort"+1, 0 to disable UDP transport) */
+struct RTSProtocol : TCProtocol, virtual Object {
+	RTSProtocol(const char* name, ServerAPI& api, Sessions& sessions);
+	~RTSProtocol() { onConnection = nullptr; }
+
+	SocketAddress	load(Exception& ex);
+	void			manage();
+
+	/*!
+	RTP/RTCP server port, 0 if UDP transport disabled */
+	UInt16			udpPort() const { return _udpPort; }
+	bool			send(Exception& ex, const Packet& packet, const SocketAddress& address, bool isRTCP) { return (isRTCP ? _rtcp : _rtp).send(ex, packet, address); }
+
+	/*!
+	Shared stream of a publication playing, created on first request and released with its last viewer */
+	shared<RTSPStream> stream(Exception& ex, const std::string& name);
+
+private:
+	UDPSocket	_rtp;
+	UDPSocket	_rtcp;
+	UInt16		_udpPort;
+	std::map<std::string, weak<RTSPStream>>	_streams;
+};
+
+
+} // namespace Mona
@@ -39,16 +39,19 @@ public:
 	const std::string		codec;
 	const UInt16		port; // if port==0 the media is rejected!
 	std::vector<UInt8>	formats;
+	std::vector<std::string> attributes; // "a=" lines of the media, without "a=" prefix
 };
 
 struct Peer;
 class SDP : public virtual Object {
 public:
-	SDP() : supportMsId(false), version(0), sessionId(0) {}
+	SDP() : supportMsId(false), version(0), sessionId(0), sessionVersion(0) {}
 	virtual ~SDP() { clearMedias(); }
 
 	bool build(Exception& ex, const char* text);
-	void build();
+	/*!
+	Write the SDP text (RFC 4566), medias are written in name order */
+	std::string& build(std::string& text) const;
 
 	int						version;
 	std::string				user;
@@ -73,6 +76,8 @@ public:
 
 	std::map<std::string,std::vector<std::string> >	extensions;
 
+	std::vector<std::string>	attributes; // session "a=" lines not modelized, without "a=" prefix
+
 	SDPMedia*	addMedia(const std::string& name, UInt16 port, const char* codec) { return _medias.emplace(name, new SDPMedia(port, codec)).first->second; }
 	void		clearMedias();
 
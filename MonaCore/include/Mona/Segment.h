@@ -26,7 +26,7 @@ namespace Mona {
 /*!
 Class to save a segment, limited in size to UInt16 duration*/
 struct Segment : virtual Object  {
-	NULLABLE(!count())
+	NULLABLE(!count() && !_spill)
 
 	/*!
 	Format segment name in the format NAME.S### with ### duration encoded, and S the sequence number */
@@ -52,35 +52,80 @@ struct Segment : virtual Object  {
 		return Path(path.parent(), path.baseName(), '.', sequence, WriteDuration(duration, buffer), '.', path.extension());
 	}
 	
-	Segment() : _lastTime(0), _discontinuous(false) {}
+	Segment() : _lastTime(0), _discontinuous(false), _size(0) {}
 	Segment(const Segment& segment) : _lastTime(segment._lastTime), 
-		_discontinuous(segment._discontinuous), _medias(segment._medias) {
+		_discontinuous(segment._discontinuous), _medias(segment._medias), _size(segment._size), _spill(segment._spill) {
 		if (segment._pFirstTime)
 			_pFirstTime.set(*segment._pFirstTime);
 	}
 	Segment(Segment&& segment) : _lastTime(segment._lastTime), _pFirstTime(std::move(segment._pFirstTime)),
-		_discontinuous(segment._discontinuous), _medias(std::move(segment._medias)) {
+		_discontinuous(segment._discontinuous), _medias(std::move(segment._medias)), _size(segment._size), _spill(std::move(segment._spill)) {
 		segment._discontinuous = false;
+		segment._size = 0;
 	}
 
+	/*!
+	Compact media record, tag fields inlined with the content of the media kept in its received buffer:
+	no copy of media, and contiguous iteration which doesn't touch the buffers (no virtual Object to stay compact) */
+	struct Record {
+		Record(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track = 1);
+		Record(const Media::Video::Tag& tag, const Packet& packet, UInt8 track = 1);
+		Record(Media::Data::Type type, const Packet& packet, UInt8 track = 0, bool isProperties = false);
+		Record(const Record& other);
+		Record(Record&& other) noexcept;
+
+		Media::Type		type() const { return Media::Type(_type); }
+		UInt8			track() const { return _track; }
+		UInt32			time() const { return _time; }
+		bool			hasTime() const { return _type > Media::TYPE_DATA && !_isConfig; }
+		const Packet&	packet() const { return _packet; }
+		/*!
+		Write the media to source */
+		void			write(Media::Source& source) const;
+	private:
+		Record& operator=(const Record& other) = delete;
+
+		Packet				 _packet; // holds the buffer received, bufferized if need
+		UInt32				 _time;
+		UInt32				 _rate; // audio rate or video composition offset
+		UInt8				 _type;
+		UInt8				 _track;
+		UInt8				 _codec; // or data type
+		UInt8				 _info; // audio channels, video frame or data isProperties
+		bool				 _isConfig;
+	};
+
 	bool discontinuous() const { return _discontinuous; }
 
-	typedef std::vector<shared<const Media::Base>>::const_iterator const_iterator;
+	typedef std::vector<Record>::const_iterator const_iterator;
 	const_iterator	begin() const { return _medias.begin(); }
 	const_iterator	end() const { return _medias.end(); }
 
 	UInt32			count() const { return _medias.size(); }
 	UInt32			time() const { return _pFirstTime ? *_pFirstTime : 0;  }
 	UInt16			duration() const { return _pFirstTime ? UInt16(Util::Distance(*_pFirstTime, _lastTime)) : 0; }
+	/*!
+	Media bytes of the segment */
+	UInt32			size() const { return _size; }
+	/*!
+	TS file where the segment has been spilled when evicted from memory (count()==0 then), see Segments::EnableSpill */
+	const Path&		spill() const { return _spill; }
 
-	void			reset() { _discontinuous = true; _medias.clear(); _pFirstTime.reset(); }
+	void			reset() { _discontinuous = true; _medias.clear(); _pFirstTime.reset(); _size = 0; }
 
-	template<typename MediaType, typename ...Args>
+	/*!
+	Reserve room for count medias, to keep the records in one allocation */
+	void			reserve(UInt32 count) { _medias.reserve(count); }
+	/*!
+	Add a media with the arguments of one Record constructor */
+	template<typename ...Args>
 	bool			add(Args&&... args) {
-		_medias.emplace_back();
-		MediaType& media = _medias.back().set<MediaType>(std::forward<Args>(args)...);
-		if (!media.hasTime() || add(media.time()))
+		_medias.emplace_back(std::forward<Args>(args)...);
+		const Record& media = _medias.back();
+		if (!media.hasTime() || add(media.time())) {
+			_size += media.packet().size();
 			return true;
+		}
 		// rejected!
 		_medias.pop_back();
 		return false;
@@ -93,10 +138,14 @@ struct Segment : virtual Object  {
 	}
 
 private:
-	std::vector<shared<const Media::Base>> _medias;
+	friend struct Segments;
+
+	std::vector<Record>					   _medias;
 	unique<UInt32>						   _pFirstTime;
 	UInt32								   _lastTime;
 	bool								   _discontinuous;
+	UInt32								   _size;
+	Path								   _spill;
 };
 
 } // namespace Mona
@@ -19,6 +19,7 @@ details (or else see http://mozilla.org/MPL/2.0/).
 #include "Mona/Mona.h"
 #include "Mona/MediaWriter.h"
 #include "Mona/Playlist.h"
+#include "Mona/FileWriter.h"
 
 namespace Mona {
 
@@ -37,6 +38,13 @@ struct Segments : virtual Object, Media::Target, private MediaWriter {
 	/*!
 	Clear files not include in playlist  */
 	static Playlist& Clear(Playlist& playlist, UInt32 maxSegments, IOFile& io);
+	/*!
+	DVR mode, when closed segments of all publications retain more than budget bytes in memory, the oldest ones are serialized
+	in TS files in directory (asynchronous writing with io) and evicted from memory, then segment.spill() gives the file to serve */
+	static void EnableSpill(IOFile& io, const Path& directory, UInt64 budget);
+	/*!
+	Stop to spill and to erase spilled files, to call before io stops (remaining files have to be cleaned on next start) */
+	static void DisableSpill();
 	
 	struct Writer : MediaWriter, virtual Object {
 		OnSegment		onSegment;
@@ -78,14 +86,15 @@ struct Segments : virtual Object, Media::Target, private MediaWriter {
 
 	/*!
 	Not allow easly to configure "duration" (setter are available for) because in live-memory the best is to have always 1 keyframe by segment */
-	Segments(UInt8 maxSegments = DEFAULT_SEGMENTS);
+	Segments(UInt16 maxSegments = DEFAULT_SEGMENTS);
 	Segments(Segments&& segments);
+	~Segments();
 
 	UInt32		sequence() const { return _sequence; }
 	UInt32		count() const { return _segments.size(); }
 
-	const UInt8	maxSegments() const { return _maxSegments; }
-	UInt8		setMaxSegments(UInt8 maxSegments);
+	const UInt16 maxSegments() const { return _maxSegments; }
+	UInt16		setMaxSegments(UInt16 maxSegments);
 
 	UInt32		duration() const { return _duration; }
 
@@ -113,6 +122,8 @@ struct Segments : virtual Object, Media::Target, private MediaWriter {
 	bool endMedia() override;
 private:
 	void init();
+	void spill();
+	void release(Segment& segment, UInt32 sequence);
 	// private to explain that it's not necessary to call it, is made in "write"
 	bool beginMedia(const std::string& name) override;
 	// private to mark it explicitly as useless
@@ -131,22 +142,23 @@ private:
 	void writeProperties(const Media::Properties& properties, const OnWrite& onWrite) override {
 		Media::Data::Type type(Media::Data::TYPE_UNKNOWN);
 		const Packet& packet = properties.data(type);
-		addSegment<Media::Data>(type, packet, 0, true);
+		addSegment(type, packet, 0, true);
 	}
-	void writeData(UInt8 track, Media::Data::Type type, const Packet& packet, const OnWrite& onWrite) override { addSegment<Media::Data>(type, packet, track); }
-	void writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, const OnWrite& onWrite) override { addSegment<Media::Audio>(tag, packet, track); }
-	void writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, const OnWrite& onWrite) override { addSegment<Media::Video>(tag, packet, track); }
-	template <typename MediaType, typename ...Args>
+	void writeData(UInt8 track, Media::Data::Type type, const Packet& packet, const OnWrite& onWrite) override { addSegment(type, packet, track); }
+	void writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, const OnWrite& onWrite) override { addSegment(tag, packet, track); }
+	void writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, const OnWrite& onWrite) override { addSegment(tag, packet, track); }
+	template <typename ...Args>
 	void addSegment(Args&&... args) {
-		bool added = _segment.add<MediaType>(std::forward<Args>(args) ...);
+		bool added = _segment.add(std::forward<Args>(args) ...);
 		DEBUG_ASSERT(added);
 	}
 
 	std::deque<Segment>	_segments;
 	Segment				_segment;
 	UInt32				_sequence;
-	UInt8				_maxSegments;
+	UInt16				_maxSegments;
 	Writer				_writer;
+	std::map<UInt32, FileWriter> _spillings; // segments in writing on disk by sequence
 	bool				_started;
 	UInt32				_duration;
 };
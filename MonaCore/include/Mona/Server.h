@@ -74,6 +74,19 @@ private:
 
 	void  loadIniStreams();
 
+	/*!
+	Federation (edge), pull a publication unfound from the origins configured, one upstream stream by publication
+	shared by all the local subscribers and released after federation.idleTimeout seconds without subscriber */
+	void  pull(Publication& publication) override;
+	void  managePulls();
+	struct Pull : virtual Object {
+		Pull() : origin(0), idleTime(0) {}
+		shared<MediaStream>	pStream;
+		UInt8				origin; // index in _origins
+		Int64				idleTime; // time of the last subscriber leaving, 0 if subscribed
+	};
+	bool  upstream(const std::string& publication, Pull& pull);
+
 	bool			run(Exception& ex, const volatile bool& requestStop);
 
 	Handler				_handler;
@@ -85,6 +98,9 @@ private:
 	std::multimap<const char*, Publication*, String::Comparator>	_streamPublications; // contains publications initiated by ::stream
 	std::map<shared<Media::Target>, unique<Subscription>>			_streamSubscriptions; // contains susbscriptions created by ::stream target
 	std::map<std::string, Publication>								_publications;
+	std::vector<std::string>										_origins; // stream descriptions where '*' is the publication name
+	UInt32															_pullTimeout;
+	std::map<std::string, Pull>										_pulls;
 };
 
 
@@ -23,11 +23,13 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/Publication.h"
 #include "Mona/ThreadPool.h"
 #include "Mona/IOFile.h"
+#include "Mona/DNSResolver.h"
 #include "Mona/Timer.h"
 #include "Mona/TLS.h"
 #include "Mona/Protocols.h"
 #include "Mona/Client.h"
 #include "Mona/Resources.h"
+#include "Mona/Balancer.h"
 
 namespace Mona {
 
@@ -51,6 +53,9 @@ struct ServerAPI : virtual Object, Parameters {
 	shared<TLS>				pTLSClient;
 	shared<TLS>				pTLSServer;
 
+	DNSResolver				dnsResolver; // after ioSocket, asynchronous alternative to setWithDNS on main thread
+	Balancer				balancer; // after ioSocket
+
 	/*!
 	Publish a publication, stream can be in the form "name.ext?query". With extention stream is recorded, and query fills publication properties.
 	Stream in out parameter give the publication name isolated */
@@ -110,6 +115,9 @@ private:
 	Publication*			publish(Exception& ex, Path& stream, Client* pClient);
 	void					unpublish(Publication& publication, Client* pClient);
 	void					erasePublication(const std::map<std::string, Publication>::const_iterator& it);
+	/*!
+	Call when a subscription waits a publication without publisher, to pull it from an other server (see Server federation) */
+	virtual void			pull(Publication& publication) {}
 
 	std::map<std::string, Publication>&	_publications;
 
@@ -40,6 +40,10 @@ struct Sessions : virtual Object {
 	Sessions() {}
 	virtual ~Sessions();
 
+	UInt32										count() const { return _sessions.size(); }
+	std::map<UInt32, Session*>::const_iterator	begin() const { return _sessions.begin(); }
+	std::map<UInt32, Session*>::const_iterator	end() const { return _sessions.end(); }
+
 	template<typename SessionType = Session>
 	SessionType* findByAddress(Protocol& protocol, const SocketAddress& address) {
 		std::map<SocketAddress, Session*>& sessionsByAddress = this->sessionsByAddress(protocol);
@@ -33,6 +33,9 @@ struct TSReader : virtual Object, MediaReader {
 	// http://dvd.sourceforge.net/dvdinfo/pes-hdr.html
 
 	TSReader() : _propVersion(0), _syncFound(false), _syncError(false), _crcPAT(0), _audioTrack(0), _videoTrack(0), _startTime(-1) {}
+
+	bool	indexable() const { return true; }
+	bool	resume(UInt64 position, Media::Source& source);
 	
 private:
 
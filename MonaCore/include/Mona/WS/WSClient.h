@@ -36,6 +36,7 @@ private:
 	HTTPDecoder::OnResponse		_onResponse;
 	WSDecoder::OnMessage		_onMessage;
 	shared<const HTTP::Header>	_pHTTPHeader;
+	shared<WSDecoder>			_pWSDecoder; // keep the upgraded decoder alive, otherwise HTTPDecoder considers the upgrade rejected
 	std::string					_url;
 	WSWriter					_writer;
 };
@@ -24,6 +24,13 @@ using namespace std;
 
 namespace Mona {
 
+AMFWriter::Template::Template(const function<void(AMFWriter& writer)>& encoder) {
+	Buffer buffer;
+	AMFWriter writer(buffer, true);
+	encoder(writer);
+	_data.assign(STR buffer.data(), buffer.size());
+}
+
 AMFWriter::AMFWriter(Buffer& buffer, bool amf0) : _amf0References(0),_amf3(false),amf0(amf0),DataWriter(buffer) {
 
 }
@@ -33,7 +40,9 @@ void AMFWriter::reset() {
 	_levels.clear();
 	_references.clear();
 	_amf0References = 0;
-	_stringReferences.clear();
+	_strings.clear();
+	_stringsData.clear();
+	std::fill(_stringSlots.begin(), _stringSlots.end(), 0);
 	DataWriter::reset();
 }
 
@@ -95,16 +104,46 @@ void AMFWriter::writePropertyName(const char* name) {
 
 void AMFWriter::writeText(const char* value,UInt32 size) {
 	if(size>0) {
-		const auto& it = _stringReferences.emplace(SET, forward_as_tuple(value, size), forward_as_tuple(_stringReferences.size()));
-		if (!it.second) {
+		UInt32 reference = stringReference(value, size);
+		if (reference < _strings.size()) {
 			// already exists
-			writer.write7Bit<UInt32>(it.first->second << 1, 4);
+			writer.write7Bit<UInt32>(reference << 1, 4);
 			return;
 		}
 	}
 	writer.write7Bit<UInt32>((size<<1) | 0x01, 4).write(value,size);
 }
 
+UInt32 AMFWriter::stringReference(const char* value, UInt32 size) {
+	// FNV-1a
+	UInt32 hash(2166136261u);
+	for (UInt32 i = 0; i < size; ++i)
+		hash = (hash ^ UInt8(value[i])) * 16777619u;
+	if (_stringSlots.size() < ((_strings.size() + 1) * 2)) {
+		// load factor exceeds 1/2 => grow and rehash
+		_stringSlots.assign(max(_stringSlots.size() * 2, size_t(32)), 0);
+		for (UInt32 i = 0; i < _strings.size(); ++i) {
+			UInt32 slot = _strings[i].hash & (_stringSlots.size() - 1);
+			while (_stringSlots[slot])
+				slot = (slot + 1) & (_stringSlots.size() - 1);
+			_stringSlots[slot] = i + 1;
+		}
+	}
+	UInt32 mask(_stringSlots.size() - 1);
+	UInt32 slot(hash & mask);
+	while (UInt32 index = _stringSlots[slot]) {
+		const StringRef& string = _strings[--index];
+		if (string.hash == hash && string.size == size && memcmp(_stringsData.data() + string.offset, value, size) == 0)
+			return index;
+		slot = (slot + 1) & mask;
+	}
+	// new reference
+	_stringSlots[slot] = _strings.size() + 1;
+	_strings.emplace_back(hash, _stringsData.size(), size);
+	_stringsData.append(value, size);
+	return _strings.size(); // not found
+}
+
 void AMFWriter::writeNull() {
 	writer.write8(_amf3 ? UInt8(AMF::AMF3_NULL) : UInt8(AMF::AMF0_NULL)); // marker
 }
@@ -0,0 +1,369 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/Balancer.h"
+#include "Mona/ServerAPI.h"
+#include "Mona/BinaryWriter.h"
+#include "Mona/BinaryReader.h"
+#include "Mona/Crypto.h"
+#include "Mona/Util.h"
+#include "Mona/Logs.h"
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace Mona {
+
+#define BALANCER_VERSION	3
+#define BALANCER_EXPIRATION	3 // intervals without report before to forget a node
+#define BALANCER_CLOCK_SKEW		30000 // tolerance in ms between the sending time of a report and the reception time
+
+static Int64 ProcessTime() {
+	// CPU time consumed by the process in ms
+#if defined(_WIN32)
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0;
+	return (((Int64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) + ((Int64(user.dwHighDateTime) << 32) | user.dwLowDateTime)) / 10000;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage))
+		return 0;
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000ll + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#endif
+}
+
+
+Balancer::Balancer(ServerAPI& api) : _api(api), _socket(api.ioSocket), _id(0), _interval(1000), _maxClients(0), _maxByteRate(0), _maxCPU(0), _cpuTime(0), _cpuProcessTime(0) {
+	_socket.onError = [](const Exception& ex) { DEBUG("Balancer, ", ex); }; // peer not started yet for example
+	_socket.onPacket = [this](shared<Buffer>& pBuffer, const SocketAddress& address) {
+		receive(Packet(pBuffer), address);
+	};
+	_onTimer = [this](UInt32 delay) {
+		report();
+		return _interval;
+	};
+}
+
+bool Balancer::start(Exception& ex, const Parameters& parameters) {
+	stop();
+	UInt16 port = parameters.getNumber<UInt16>("balancer.port");
+	if (!port)
+		return true; // disabled
+	if (!_socket.bind(ex, SocketAddress(IPAddress::Wildcard(), port)))
+		return false;
+	_interval = parameters.getNumber<UInt32, 1000>("balancer.interval");
+	if (!_interval)
+		_interval = 1000;
+	_maxClients = parameters.getNumber<UInt32>("balancer.maxClients");
+	_maxByteRate = parameters.getNumber<UInt64>("balancer.maxByteRate");
+	_maxCPU = parameters.getNumber<UInt8>("balancer.maxCPU");
+	parameters.getString("balancer.key", _key);
+	_id = Util::Random<UInt64>();
+	// public host of this node, explicit in reports because the source of a packet can't be trusted
+	const char* host = parameters.getString("balancer.host");
+	if (host && *host) {
+		Exception exHost;
+		if (!_host.set(exHost, host)) {
+			_resolvings.emplace_back([this, host = string(host)](const Exception& ex, const HostEntry& entry) {
+				if (!ex && !entry.addresses().empty())
+					_host = *entry.addresses().begin();
+				else
+					WARN("Balancer host ", host, ", ", ex);
+			});
+			_api.dnsResolver.resolve(host, _resolvings.back());
+		}
+	} else {
+		for (const auto& it : _api.protocols) {
+			const IPAddress& publicHost = it.second->publicAddress.host();
+			if (!publicHost.isWildcard() && !publicHost.isLoopback()) {
+				_host = publicHost;
+				break;
+			}
+		}
+		if (!_host)
+			WARN("Balancer without public host (balancer.host), peers will not redirect clients to this node");
+	}
+	const char* peers = parameters.getString("balancer.peers");
+	if (peers) {
+		String::ForEach forEach([this](UInt32 index, const char* value) {
+			SocketAddress address;
+			Exception ex;
+			if (address.set(ex, value)) {
+				_peers.emplace_back(address);
+				return true;
+			}
+			// host name, resolved without blocking the server thread
+			const char* colon = strrchr(value, ':');
+			UInt16 port;
+			if (!colon || !String::ToNumber(colon + 1, port) || !port) {
+				WARN("Balancer peer ", value, ", ", ex);
+				return true;
+			}
+			_resolvings.emplace_back([this, port, value = string(value)](const Exception& ex, const HostEntry& host) {
+				if (!ex && !host.addresses().empty())
+					_peers.emplace_back(*host.addresses().begin(), port);
+				else
+					WARN("Balancer peer ", value, ", ", ex);
+			});
+			_api.dnsResolver.resolve(string(value, colon - value), _resolvings.back());
+			return true;
+		});
+		String::Split(peers, ",", forEach, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+	}
+	_cpuTime = Time::Now();
+	_cpuProcessTime = ProcessTime();
+	_api.timer.set(_onTimer, _interval);
+	INFO("Balancer started on ", _socket->address(), " with ", _peers.size(), " peers");
+	return true;
+}
+
+void Balancer::stop() {
+	if (_onTimer)
+		_api.timer.set(_onTimer, 0);
+	_socket.close();
+	_resolvings.clear();
+	_peers.clear();
+	_nodes.clear();
+	_reports.clear();
+	_host = nullptr;
+	_load = Load();
+}
+
+double Balancer::score(const Load& load) const {
+	double score(0);
+	if (_maxClients)
+		score = max(score, double(load.clients) / _maxClients);
+	if (_maxByteRate)
+		score = max(score, double(load.byteRate) / _maxByteRate);
+	if (_maxCPU)
+		score = max(score, double(load.cpu) / _maxCPU);
+	return score;
+}
+
+bool Balancer::redirect(const string& protocol, SocketAddress& redirection) {
+	if (_nodes.empty())
+		return false;
+	double best(score(_load));
+	if (best < 1)
+		return false; // not overloaded
+	Node* pBest(NULL);
+	const SocketAddress* pAddress(NULL);
+	for (auto& it : _nodes) {
+		const auto& itAddress = it.second.addresses.find(protocol);
+		if (itAddress == it.second.addresses.end())
+			continue; // protocol not supported by this node
+		double value(score(it.second));
+		if (value >= best)
+			continue;
+		best = value;
+		pBest = &it.second;
+		pAddress = &itAddress->second;
+	}
+	if (!pBest)
+		return false; // all the nodes are more loaded
+	// estimate the new load to dispatch a burst of clients before the next report of this node
+	++pBest->clients;
+	redirection = *pAddress;
+	return true;
+}
+
+void Balancer::report() {
+	// update local load
+	Int64 now(Time::Now()), processTime(ProcessTime());
+	if (now > _cpuTime)
+		_load.cpu = UInt8(min<Int64>(100, (processTime - _cpuProcessTime) * 100 / ((now - _cpuTime) * Thread::ProcessorCount())));
+	_cpuTime = now;
+	_cpuProcessTime = processTime;
+	_load.clients = _api.clients.size();
+	_load.byteRate = 0;
+	for (const auto& it : _api.clients)
+		_load.byteRate += it.second->sendByteRate();
+
+	// forget silent nodes
+	auto it = _nodes.begin();
+	while (it != _nodes.end()) {
+		if ((now - it->second.time) > (_interval * BALANCER_EXPIRATION))
+			it = _nodes.erase(it);
+		else
+			++it;
+	}
+	// forget last reports out of the clock tolerance, a replay of them will be rejected as obsolete
+	auto itReport = _reports.begin();
+	while (itReport != _reports.end()) {
+		if ((now - itReport->second) > BALANCER_CLOCK_SKEW)
+			itReport = _reports.erase(itReport);
+		else
+			++itReport;
+	}
+
+	// report of the load of this node first, then the loads of the nodes known
+	Node local;
+	(Load&)local = _load;
+	local.id = _id;
+	local.time = now;
+	for (const auto& it : _api.protocols) {
+		if (!it.second->publicAddress)
+			continue;
+		SocketAddress address(it.second->publicAddress);
+		if (_host && (address.host().isWildcard() || address.host().isLoopback()))
+			address.set(_host, address.port()); // explicit public address, peers don't trust the source of the packet
+		local.addresses.emplace(it.first, address);
+	}
+	shared<Buffer> pBuffer = WriteReport(_key, now, _host ? SocketAddress(_host, _socket->address().port()) : SocketAddress::Wildcard(), local, _nodes);
+
+	// gossip to peers configured and nodes known
+	Packet packet(pBuffer);
+	set<SocketAddress> destinators(_peers.begin(), _peers.end());
+	for (const auto& it : _nodes)
+		destinators.emplace(it.first);
+	Exception ex;
+	for (const SocketAddress& address : destinators) {
+		if (!_socket.send(ex = nullptr, packet, address))
+			DEBUG("Balancer report to ", address, ", ", ex);
+	}
+}
+
+bool Balancer::isSelf(UInt64 id, const SocketAddress& address) {
+	if (id == _id)
+		return true;
+	const SocketAddress& bound = _socket->address();
+	if (address.port() != bound.port())
+		return false;
+	if (address.host() == bound.host())
+		return true;
+	for (const auto& it : _api.protocols) {
+		if (address.host() == it.second->publicAddress.host())
+			return true;
+	}
+	return false;
+}
+
+void Balancer::receive(const Packet& packet, const SocketAddress& address) {
+	if (_key.empty() && find(_peers.begin(), _peers.end(), address) == _peers.end()) {
+		DEBUG("Balancer report from ", address, " which is not a peer configured");
+		return;
+	}
+	Exception ex;
+	Int64 time;
+	Records records;
+	if (!ReadReport(ex, _key, packet, time, records)) {
+		DEBUG("Balancer report from ", address, ", ", ex);
+		return;
+	}
+	if (records.empty())
+		return;
+	Int64 now(Time::Now());
+	if ((now - time) > BALANCER_CLOCK_SKEW || (time - now) > BALANCER_CLOCK_SKEW) {
+		DEBUG("Balancer report from ", address, " obsolete (clocks of nodes have to be synchronized)");
+		return;
+	}
+	// sending times of a node increase, a report already received is a replay
+	Int64& last = _reports[records.front().second.id];
+	if (time <= last) {
+		DEBUG("Balancer report from ", address, " replayed");
+		return;
+	}
+	last = time;
+	for (auto& record : records) {
+		Node& node = record.second;
+		node.time = now - (time - node.time); // age of the load
+		if (!record.first || isSelf(node.id, record.first))
+			continue; // without address (public host unknown) or itself
+		if ((now - node.time) > (_interval * BALANCER_EXPIRATION))
+			continue; // obsolete
+		Node& current = _nodes[record.first];
+		if (node.time >= current.time)
+			current = move(node);
+	}
+}
+
+shared<Buffer> Balancer::WriteReport(const string& key, Int64 time, const SocketAddress& address, const Node& node, const map<SocketAddress, Node>& nodes) {
+	// version, sending time, records (load of the sender first, then the loads of the nodes known)
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	writer.write8(BALANCER_VERSION).write64(time).write7Bit<UInt32>(nodes.size() + 1);
+	auto write = [&writer, time](const SocketAddress& address, const Node& node) {
+		writer.writeString(address ? String(address) : String::Empty());
+		writer.write64(node.id).write7Bit<UInt64>(time - node.time); // age
+		writer.write7Bit<UInt32>(node.clients).write7Bit<UInt64>(node.byteRate).write8(node.cpu);
+		writer.write8(UInt8(min(node.addresses.size(), size_t(0xFF))));
+		UInt8 count(0);
+		for (const auto& it : node.addresses) {
+			if (!++count)
+				break;
+			writer.writeString(it.first).writeString(String(it.second));
+		}
+	};
+	write(address, node);
+	for (const auto& it : nodes)
+		write(it.first, it.second);
+	if (!key.empty()) {
+		UInt32 size = pBuffer->size();
+		pBuffer->resize(size + Crypto::SHA256_SIZE);
+		Crypto::HMAC::SHA256(key.data(), int(key.size()), pBuffer->data(), size, pBuffer->data() + size);
+	}
+	return pBuffer;
+}
+
+bool Balancer::ReadReport(Exception& ex, const string& key, const Packet& packet, Int64& time, Records& records) {
+	BinaryReader reader(packet.data(), packet.size());
+	if (!key.empty()) {
+		// signed report
+		UInt8 hash[Crypto::SHA256_SIZE];
+		if (packet.size() < sizeof(hash) || CRYPTO_memcmp(Crypto::HMAC::SHA256(key.data(), int(key.size()), packet.data(), packet.size() - sizeof(hash), hash), packet.data() + packet.size() - sizeof(hash), sizeof(hash))) {
+			ex.set<Ex::Protocol>("invalid signature");
+			return false;
+		}
+		reader.shrink(packet.size() - sizeof(hash));
+	}
+	if (reader.read8() != BALANCER_VERSION) {
+		ex.set<Ex::Unsupported>("report version");
+		return false;
+	}
+	time = reader.read64();
+	UInt32 count(reader.read7Bit<UInt32>());
+	string value, protocol;
+	Exception exAddress;
+	for (UInt32 i = 0; i < count && reader.available(); ++i) {
+		records.emplace_back();
+		SocketAddress& address = records.back().first;
+		if (!reader.readString(value).empty() && !address.set(exAddress = nullptr, value))
+			address.reset();
+		Node& node = records.back().second;
+		node.id = reader.read64();
+		node.time = time - reader.read7Bit<UInt64>();
+		node.clients = reader.read7Bit<UInt32>();
+		node.byteRate = reader.read7Bit<UInt64>();
+		node.cpu = reader.read8();
+		UInt8 protocols(reader.read8());
+		while (protocols--) {
+			reader.readString(protocol);
+			SocketAddress protocolAddress;
+			// explicit address required, the source of the packet is never trusted
+			if (protocolAddress.set(exAddress = nullptr, reader.readString(value)) && !protocolAddress.host().isWildcard())
+				node.addresses.emplace(move(protocol), protocolAddress);
+		}
+	}
+	return true;
+}
+
+
+} // namespace Mona
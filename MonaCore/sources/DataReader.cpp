@@ -45,7 +45,7 @@ UInt8 DataReader::ParseValue(const char* value, UInt32 size, double& number) {
 	}
 	Exception ex;
 	thread_local Date date;
-	if (date.update(ex, value, size)) {
+	if (Date::IsISO8601(value, size) && date.update(ex, value, size)) {
 		number = (double)date;
 		if (ex)
 			WARN("Parse date, ", ex);
@@ -126,6 +126,8 @@ UInt32 FLVReader::parse(Packet& buffer, Media::Source& source) {
 				_size -= 7;
 				Packet content(buffer, reader.current(), _size);
 				content += ReadMediaHeader(content.data(), content.size(), _video);
+				if (_video.frame == Media::Video::FRAME_KEY && onKeyFrame)
+					onKeyFrame(Media::TYPE_VIDEO, _video.time, position(buffer, reader.current()) - 11); // tag beginning
 				if (_video.frame == Media::Video::FRAME_CONFIG && ((_video.codec == Media::Video::CODEC_H264) || (_video.codec == Media::Video::CODEC_HEVC))) {
 					shared<Buffer> pBuffer(SET);
 					if (_video.codec == Media::Video::CODEC_HEVC)
@@ -143,7 +145,10 @@ UInt32 FLVReader::parse(Packet& buffer, Media::Source& source) {
 				UInt8 track = range<UInt8>(reader.read24());
 				_size -= 7;
 				Packet content(buffer, reader.current(), _size);
-				source.writeAudio(_audio, content += ReadMediaHeader(content.data(), content.size(), _audio, _audioConfig), track ? track : 1);
+				content += ReadMediaHeader(content.data(), content.size(), _audio, _audioConfig);
+				if (!_audio.isConfig && onKeyFrame)
+					onKeyFrame(Media::TYPE_AUDIO, _audio.time, position(buffer, reader.current()) - 11); // tag beginning
+				source.writeAudio(_audio, content, track ? track : 1);
 				break;
 			}
 			case AMF::TYPE_DATA: {
@@ -168,6 +173,16 @@ UInt32 FLVReader::parse(Packet& buffer, Media::Source& source) {
 	return 0;
 }
 
+bool FLVReader::resume(UInt64 position, Media::Source& source) {
+	if (!seek(position))
+		return false;
+	// position is a tag beginning, next byte is its type
+	_begin = false;
+	_type = AMF::TYPE_EMPTY;
+	_size = 1;
+	return true;
+}
+
 void FLVReader::onFlush(Packet& buffer, Media::Source& source) {
 	_begin = true;
 	_size = 0;
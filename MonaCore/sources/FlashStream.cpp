@@ -154,9 +154,12 @@ void FlashStream::messageHandler(const string& method, AMFReader& message, Flash
 		onStart(id, writer); // stream begin
 		writer.writeAMFStatus("NetStream.Play.Reset", "Playing and resetting " + _name); // for entiere playlist
 		writer.writeAMFStatus("NetStream.Play.Start", "Started playing "+ _name); // for item
-		AMFWriter& amf(writer.writeAMFData("|RtmpSampleAccess"));
-		amf.writeBoolean(true); // audioSampleAccess
-		amf.writeBoolean(true); // videoSampleAccess
+		static const Packet SampleAccess(shared<const AMFWriter::Template>(SET, [](AMFWriter& writer) {
+			writer.writeString(EXPAND("|RtmpSampleAccess"));
+			writer.writeBoolean(true); // audioSampleAccess
+			writer.writeBoolean(true); // videoSampleAccess
+		}));
+		writer.writeAMFTemplate(AMF::TYPE_DATA, SampleAccess);
 
 		if (_bufferTime)
 			_pSubscription->setNumber("bufferTime", _bufferTime);
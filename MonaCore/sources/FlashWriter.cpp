@@ -30,6 +30,37 @@ using namespace std;
 namespace Mona {
 
 
+/*!
+onStatus of publication (un)publishing: identical for all the subscribers of a publication,
+so encoded one time by publication change rather than one time by subscriber */
+struct StatusTemplate : virtual Object {
+	StatusTemplate(const char* code, const char* suffix) : _code(code), _suffix(suffix) {}
+
+	const Packet& operator()(const string& name) {
+		if (!_pTemplate || name != _name) {
+			_name = name;
+			_pTemplate.set([this](AMFWriter& writer) {
+				writer.writeString(EXPAND("onStatus"));
+				writer.writeNumber(0);
+				writer->write8(AMF::AMF0_NULL);
+				writer.beginObject();
+				writer.writeStringProperty("level", "status");
+				writer.writeStringProperty("code", _code);
+				writer.writeStringProperty("description", String(_name, _suffix));
+				writer.endObject();
+			});
+			_message.set(_pTemplate);
+		}
+		return _message;
+	}
+private:
+	const char*						_code;
+	const char*						_suffix;
+	std::string						_name;
+	shared<const AMFWriter::Template>	_pTemplate;
+	Packet							_message;
+};
+
 FlashWriter::FlashWriter() : _callbackHandleOnAbort(0),_callbackHandle(0), amf0(false), isMain(false), _lastTime(0) {
 }
 
@@ -130,7 +161,13 @@ AMFWriter& FlashWriter::writeAMFData(const string& name) {
 
 bool FlashWriter::beginMedia(const string& name) {
 	_pPublicationName = &name;
-	writeAMFStatus("NetStream.Play.PublishNotify", name + " is now published");
+	static thread_local StatusTemplate PublishNotify("NetStream.Play.PublishNotify", " is now published");
+	if (_callbackHandle) // callback has to be encoded
+		writeAMFStatus("NetStream.Play.PublishNotify", name + " is now published");
+	else {
+		_callbackHandleOnAbort = _callbackHandle; // as writeInvocation, callback handle restored by clear()
+		writeAMFTemplate(AMF::TYPE_INVOCATION, PublishNotify(name));
+	}
 	_firstAV = true;
 	return !closed();
 }
@@ -199,7 +236,13 @@ bool FlashWriter::writeProperties(const Media::Properties& properties) {
 
 bool FlashWriter::endMedia() {
 	_lastTime = _time;
-	writeAMFStatus("NetStream.Play.UnpublishNotify", *_pPublicationName + " is now unpublished");
+	static thread_local StatusTemplate UnpublishNotify("NetStream.Play.UnpublishNotify", " is now unpublished");
+	if (_callbackHandle) // callback has to be encoded
+		writeAMFStatus("NetStream.Play.UnpublishNotify", *_pPublicationName + " is now unpublished");
+	else {
+		_callbackHandleOnAbort = _callbackHandle; // as writeInvocation, callback handle restored by clear()
+		writeAMFTemplate(AMF::TYPE_INVOCATION, UnpublishNotify(*_pPublicationName));
+	}
 	return !closed();
 }
 
@@ -73,10 +73,11 @@ bool HTTPFileSender::load(Exception& ex) {
 	return false;
 }
 
-UInt32 HTTPFileSender::decode(shared<Buffer>& pBuffer, bool end) {
+UInt32 HTTPFileSender::decode(shared<const Buffer>& pBuffer, bool end) {
 	
 	deque<Packet> packets;
-	Packet packet(pBuffer); // capture and hold buffer until end of life of packets
+	Packet packet(pBuffer); // hold buffer until end of life of packets
+	pBuffer.reset(); // captured, no onReaden
 
 	UInt32 size;
 	if (!_properties.count()) {
@@ -86,13 +87,21 @@ UInt32 HTTPFileSender::decode(shared<Buffer>& pBuffer, bool end) {
 		size = generate(packet, packets);
 
 	// HEADER
+	shared<File> pFile;
 	if (!_mime) {
 		_mime = MIME::Read(self, _subMime);
 		if (!_mime) {
 			_mime = MIME::TYPE_APPLICATION;
 			_subMime = "octet-stream";
 		}
-		if (!send(HTTP_CODE_200, _mime, _subMime, end ? size : UINT64_MAX)) {
+		if (!end && !_properties.count() && pRequest->type != HTTP::TYPE_HEAD && canSendFile()) {
+			// content unchanged => the rest of the file is sent by the kernel (sendfile) rather reading it
+			Exception ex;
+			pFile.set(path(), File::MODE_READ);
+			if (!pFile->load(ex) || pFile->size() < File::size())
+				pFile.reset(); // file changing, read it
+		}
+		if (!send(HTTP_CODE_200, _mime, _subMime, end ? size : (pFile ? File::size() : UINT64_MAX))) {
 			this->end(); // to avoid to read again
 			return 0;
 		}
@@ -105,7 +114,12 @@ UInt32 HTTPFileSender::decode(shared<Buffer>& pBuffer, bool end) {
 				return 0;
 			}
 		}
-		if(!end)
+		if (pFile) {
+			if (!send(pFile, readen(), File::size() - readen())) {
+				this->end(); // to avoid to read again
+				return 0;
+			}
+		} else if(!end)
 			return HTTPSender::flushing() ? 0 : 0xFFFF; // wait next!
 	}
 	// END
@@ -61,9 +61,9 @@ bool HTTPSegmentSender::run() {
 	while(_itMedia != _segment.end()) {
 		if (HTTPSender::flushing())
 			return false;; // socket queueing, wait!
-		const Media::Base* pMedia = (_itMedia++)->get();
-		_lastTime = pMedia->time(); // fix time (have to be strictly absolute, subscription is on a isolated segment)
-		_subscription.writeMedia(*pMedia);
+		const Segment::Record& media = *_itMedia++;
+		_lastTime = media.time(); // fix time (have to be strictly absolute, subscription is on a isolated segment)
+		media.write(_subscription);
 		if (!_pWriter)
 			return true; // connection death!
 	}
@@ -109,6 +109,23 @@ bool HTTPSender::send(const Packet& content) {
 	return content ? socketSend(content) : true;
 }
 
+bool HTTPSender::send(const shared<const File>& pFile, UInt64 offset, UInt64 size) {
+	if (_end)
+		return false;
+	if (pRequest->type == HTTP::TYPE_HEAD || !size)
+		return true;
+	DEBUG_ASSERT(!_chunked);
+	Exception ex;
+	int result = _pSocket->write(ex, pFile, offset, size);
+	if (ex || result < 0)
+		DEBUG(ex);
+	if (result >= 0)
+		return true;
+	// no shutdown required, already done by write!
+	_end = true; //  end!
+	return false;
+}
+
 bool HTTPSender::send(const char* code, MIME::Type mime, const char* subMime, UInt64 extraSize) {
 	if (_end)
 		return false;
@@ -23,6 +23,7 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/ByteReader.h"
 #include "Mona/SplitReader.h"
 #include "Mona/WS/WSSession.h"
+#include "Mona/Metrics.h"
 
 
 using namespace std;
@@ -204,7 +205,7 @@ bool HTTPSession::handshake(HTTP::Request& request) {
 	if (!peer.onHandshake(redirection))
 		return true;
 	HTTP_BEGIN_HEADER(_pWriter->writeRaw(HTTP_CODE_307))
-		HTTP_ADD_HEADER("Location", self->isSecure() ? "https://" : "http://", redirection, request->path, request.file.isFolder() ? "" : request.file.name())
+		HTTP_ADD_HEADER("Location", self->isSecure() ? "https://" : "http://", redirection, request->path, '/', request.file.isFolder() ? "" : request.file.name())
 	HTTP_END_HEADER
 	kill();
 	return false;
@@ -233,6 +234,14 @@ void HTTPSession::onParameters(const Parameters& parameters) {
 		else
 			FileSystem::GetName(_index); // Redirect to the file (get name to prevent path insertion)
 	}
+	// metrics path in root, disabled by default
+	if (parameters.getString("metrics", _metrics)) {
+		if (String::IsFalse(_metrics))
+			_metrics.clear();
+		else if (String::IsTrue(_metrics))
+			_metrics = "metrics";
+	} else
+		_metrics.clear();
 }
 
 bool HTTPSession::manage() {
@@ -363,6 +372,16 @@ bool HTTPSession::processGet(Exception& ex, HTTP::Request& request, QueryReader&
 	
 	Path& file(request.file);
 
+	// Metrics in Prometheus text format
+	if (!_metrics.empty() && !request->path.length() && String::ICompare(file.name(), _metrics) == 0) {
+		shared<Buffer> pBuffer(SET);
+		string text;
+		Metrics::Write(text);
+		pBuffer->append(text.data(), text.size());
+		_pWriter->writeText(Packet(pBuffer), "plain; version=0.0.4");
+		return true;
+	}
+
 	// Priority on client method
 	if (file.extension().empty() && invoke(ex, request, parameters)) // can be method if not a file (can be a folder)
 		return true;
@@ -483,6 +502,17 @@ bool HTTPSession::processGet(Exception& ex, HTTP::Request& request, QueryReader&
 							return false;
 						}
 						if (!duration || duration == segment.duration()) {
+							if (segment.spill()) {
+								// DVR, segment spilled on disk in TS, send it as file (zero-copy)
+								const char* subMime;
+								if (MIME::Read(file, subMime) != MIME::TYPE_VIDEO || String::ICompare(subMime, EXPAND("mp2t")) != 0) {
+									ex.set<Ex::Unsupported>("Segment ", sequence, " of publication ", publication, " available only in TS format");
+									return false;
+								}
+								Parameters properties;
+								_pWriter->writeFile(segment.spill(), properties);
+								return true;
+							}
 							Parameters params;
 							MapWriter<Parameters> writeParams(params);
 							parameters.read(writeParams);
@@ -20,11 +20,70 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/Logs.h"
 #include "Mona/Util.h"
 #include <sstream>
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define BLOCK_SIZE 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SSE2
+	#define BLOCK_SIZE 16
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define NEON
+	#define BLOCK_SIZE 16
+#else
+	#define BLOCK_SIZE 8
+#endif
 
 using namespace std;
 
 namespace Mona {
 
+/*!
+Skip blocks of string content which don't contain the structural characters '"' or '\\',
+returns the first block position which contains one of them or the end of blocks (data remaining <= block) */
+static const UInt8* SkipBlocks(const UInt8* cur, const UInt8* end) {
+#if defined(__AVX2__)
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)cur);
+		if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash))))
+			break;
+	}
+#elif defined(SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		__m128i block = _mm_loadu_si128((const __m128i*)cur);
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash))))
+			break;
+	}
+#elif defined(NEON)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		uint8x16_t block = vld1q_u8(cur);
+		uint64x2_t halves = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backslash)));
+		if (vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1))
+			break;
+	}
+#else
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		UInt64 value;
+		memcpy(&value, cur, 8);
+		UInt64 quotes(value ^ 0x2222222222222222ULL), backslashes(value ^ 0x5C5C5C5C5C5C5C5CULL);
+		// 0x80 on each null byte (exact, without carry propagation)
+		quotes = ~(((quotes & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | quotes | 0x7F7F7F7F7F7F7F7FULL);
+		backslashes = ~(((backslashes & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | backslashes | 0x7F7F7F7F7F7F7F7FULL);
+		if (quotes | backslashes)
+			break;
+	}
+#endif
+	return cur;
+}
+
+
 
 JSONReader::JSONReader(const Packet& packet) : _pos(reader.position()), DataReader(packet), _isValid(false) {
 
@@ -104,7 +163,7 @@ UInt8 JSONReader::followingType() {
 		if (!value)
 			return END;
 		Exception ex;
-		if (_date.update(ex,value,_size))
+		if (Date::IsISO8601(value, _size) && _date.update(ex,value,_size))
 			return DATE;
 		return STRING;
 	}
@@ -302,18 +361,15 @@ bool JSONReader::readOne(UInt8 type, DataWriter& writer) {
 const char* JSONReader::jumpToString(UInt32& size) {
 	if (!jumpTo('"'))
 		return NULL;
-	const UInt8* cur(reader.current()+1);
-	const UInt8* end(cur+reader.available()-1);
-	size = 0;
-	while (cur<end && *cur != '"') {
-		if (*cur== '\\') {
-			++size;
-			if (++cur == end)
-				break;
-		}
-		++size;
+	const UInt8* begin(reader.current()+1);
+	const UInt8* end(begin+reader.available()-1);
+	const UInt8* cur(begin);
+	while (cur<end && *(cur = SkipBlocks(cur, end)) != '"') {
+		if (*cur == '\\' && ++cur == end)
+			break;
 		++cur;
 	}
+	size = cur - begin;
 	if(cur==end) {
 		reader.next(reader.available());
 		ERROR("JSON malformed, marker \" end of text not found");
@@ -352,11 +408,9 @@ bool JSONReader::countArrayElement(UInt32& count) {
 
 		// skip string
 		if (*cur == '"') {
-			while (++cur<end && *cur != '"') {
-				if (*cur== '\\') {
-					if (++cur == end)
-						break;
-				}
+			while (++cur<end && *(cur = SkipBlocks(cur, end)) != '"') {
+				if (*cur == '\\' && ++cur == end)
+					break;
 			}
 			if(cur==end) {
 				reader.next(reader.available());
@@ -148,14 +148,28 @@ static const char* _MacLangs[149]{
 MP4Reader::Box& MP4Reader::Box::operator=(BinaryReader& reader) {
 	if (reader.available() < 8)
 		return operator=(nullptr); // rest = 0!
+	UInt32 position = reader.position();
 	_size = reader.read32();
-	if (_size < 8) {
+	if (_size == 1) {
+		// 64 bits largesize after the name (large mdat)
+		if (reader.available() < 12) {
+			reader.reset(position); // wait the complete header
+			return operator=(nullptr);
+		}
+		reader.read(4, _name);
+		_size = reader.read64();
+		_header = 16;
+	} else {
+		if (_size >= 8)
+			reader.read(4, _name);
+		_header = 8;
+	}
+	if (_size < _header) {
 		_size = 0;
 		ERROR("Bad box format without 4 char name");
 		return operator=(reader); // try to continue to read
 	}
-	reader.read(4, _name);
-	_rest = _size-8;
+	_rest = _size - _header;
 	return _rest ? self : operator=(reader); // if empty, continue to read!
 }
 
@@ -164,7 +178,7 @@ struct Lost : Media::Base, virtual Object {
 	const UInt32 lost;
 };
 
-MP4Reader::Box& MP4Reader::Box::operator-=(UInt32 readen) {
+MP4Reader::Box& MP4Reader::Box::operator-=(UInt64 readen) {
 	if (readen >= _rest)
 		_rest = 0;
 	else
@@ -172,13 +186,7 @@ MP4Reader::Box& MP4Reader::Box::operator-=(UInt32 readen) {
 	return *this;
 }
 
-UInt32 MP4Reader::parse(Packet& buffer, Media::Source& source) {
-	UInt32 rest = parseData(buffer, source);
-	_position += buffer.size() - rest;
-	return rest;
-}
-
-UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
+UInt32 MP4Reader::parse(Packet& packet, Media::Source& source) {
 
 	BinaryReader reader(packet.data(), packet.size());
 
@@ -206,6 +214,8 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 				_boxes.emplace_back();
 				continue;
 			case FOURCC('m', 'o', 'o', 'v'): // MOOV
+				if (_moov && (box.rest() < box.contentSize() || (position(packet, reader.current()) - box.headerSize()) == _moov))
+					break; // moov already readen before mdat (mdat before moov), skip it!
 				// Reset resources =>
 				_times.clear(); // force to flush all Medias!
 				if (!_firstMoov) {
@@ -225,7 +235,7 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 				_boxes.emplace_back();
 				continue;
 			case FOURCC('m', 'o', 'o', 'f'): // MOOF
-				_offset = _position + reader.position() - 8;
+				_offset = position(packet, reader.current()) - box.headerSize();
 				_chunks.clear();
 				_boxes.emplace_back();
 				continue;
@@ -235,7 +245,7 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 					ERROR("Media header box not through a Track box");
 					break;
 				}
-				if (reader.available()<22)
+				if (reader.available() < max(UInt32(box), 22u)) // wait the complete box, to not parse it again on a rest
 					return reader.available();
 				BinaryReader mdhd(reader.current(), 22);
 				UInt8 version = mdhd.read8();
@@ -262,7 +272,7 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 			}
 			case FOURCC('m', 'f', 'h', 'd'): { // MFHD
 				// Movie fragment header
-				if (reader.available()<8)
+				if (reader.available() < max(UInt32(box), 8u)) // wait the complete box, to not parse it again on a rest
 					return reader.available();
 				BinaryReader mfhd(reader.current(), 8);
 				mfhd.next(4); // skip version + flags
@@ -275,7 +285,7 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 					break;
 				_medias.emplace_hint(_medias.end(),
 					_times.empty() ? (_medias.empty() ? 0 : _medias.rbegin()->first) : _times.begin()->first,
-					new Lost(range<UInt32>(_offset - _position)) // lost approximation
+					new Lost(range<UInt32>(_offset - position(packet, packet.data()))) // lost approximation
 				);
 				break;
 			}
@@ -285,7 +295,7 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 					ERROR("Extended language box not through a Track box");
 					break;
 				}
-				if (reader.available()<6)
+				if (reader.available() < max(UInt32(box), 6u)) // wait the complete box, to not parse it again on a rest
 					return reader.available();
 				BinaryReader elng(reader.current(), 6);
 				elng.next(4); // version + flags
@@ -503,6 +513,22 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 					track.sizes.emplace_back(stsz.read32());
 				break;
 			}
+			case FOURCC('s', 't', 's', 's'): { // STSS
+				// Sync sample
+				if (_tracks.empty()) {
+					ERROR("Sync sample box not through a Track box");
+					break;
+				}
+				if (reader.available()<box)
+					return reader.available();
+				Track& track = _tracks.back();
+				BinaryReader stss(reader.current(), box);
+				stss.next(4); // version + flags
+				UInt32 count = stss.read32();
+				while (count-- && stss.available() >= 4)
+					track.keys.emplace_back(stss.read32());
+				break;
+			}
 			case FOURCC('e', 'l', 's', 't'): { // ELST
 				// Edit list box
 				if (_tracks.empty()) {
@@ -726,9 +752,20 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 				// DATA
 				if (_failed)
 					break;
+				if (_tracks.empty() && box.rest() == box.contentSize()) {
+					// mdat before moov, skip mdat to read moov in the tail, and come back after
+					UInt64 mdat = position(packet, reader.current()) - box.headerSize();
+					if (seek(mdat + box.size())) {
+						if (!_mdat)
+							_mdat = mdat;
+						_boxes.resize(1);
+						_boxes.back() = nullptr;
+						return 0;
+					}
+				}
 				while(reader.available()) {
 					if (_tracks.empty()) {
-						ERROR("No tracks information before mdat (No support of mdat box before moov box)");
+						ERROR("No tracks information before mdat (No support of mdat box before moov box without seekable source)");
 						_failed = true;
 						break;
 					}
@@ -736,9 +773,18 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 						break;
 
 					// consume
-					UInt32 value = reader.position() + _position;				
-					if (value < _chunks.begin()->first)
-						box -= reader.next(UInt32(_chunks.begin()->first - value));
+					UInt64 gap = position(packet, reader.current());
+					if (gap < _chunks.begin()->first) {
+						gap = _chunks.begin()->first - gap;
+						if (gap > reader.available() && seek(_chunks.begin()->first)) {
+							// random access to the next chunk rather read useless data
+							box -= gap;
+							flushMedias(source);
+							return 0;
+						}
+						box -= reader.next(UInt32(gap));
+					}
+					UInt32 value;
 
 					Track& track = *_chunks.begin()->second;
 					if (!track.timeStep) {
@@ -896,20 +942,34 @@ UInt32 MP4Reader::parseData(const Packet& packet, Media::Source& source) {
 				break;
 			}
 			default: // unknown or ignored
-				if(box == box.contentSize())
+				if(box.rest() == box.contentSize())
 					TRACE("Undefined box ", box.name(), " (size=", box.size(), ")");
 		}
 
 		if ((box -= reader.next(box))) // consume
 			continue;
 		// pop last box
-		UInt32 size;
+		UInt64 size;
 		do {
 			size = _boxes.back().size();
+			code = _boxes.back().code();
 			_boxes.pop_back();
 		} while (!_boxes.empty() && !(_boxes.back() -= size)); // remove parent box if empty one time box children removed!
 
 		_boxes.emplace_back(); // always at less one box!
+
+		if (code == FOURCC('m', 'o', 'o', 'v') && _boxes.size() == 1) {
+			if (_from) {
+				skipTo(_from);
+				_from = 0;
+			}
+			if (_mdat && !_moov) {
+				// moov readen after mdat, come back to mdat to read samples
+				_moov = position(packet, reader.current()) - size;
+				if (seek(_mdat))
+					return 0;
+			}
+		}
 		
 	} while (reader.available());
 
@@ -942,6 +1002,87 @@ void MP4Reader::flushMedias(Media::Source& source) {
 	_medias.erase(_medias.begin(), it);
 }
 
+void MP4Reader::skipTo(UInt32 time) {
+	// Find the nearest keyframe time on the first video track
+	UInt32 keyTime = time;
+	for (Track& track : _tracks) {
+		if (track.types.empty() || track.types.front() != Media::TYPE_VIDEO)
+			continue;
+		keyTime = 0;
+		double sampleTime = track.time;
+		UInt32 sample = 0;
+		auto itKey = track.keys.begin();
+		for (const Repeat& repeat : track.durations) {
+			UInt32 count = repeat.count;
+			while (count-- && UInt32(round(sampleTime)) <= time) {
+				++sample; // stss sample number starts to 1
+				while (itKey != track.keys.end() && *itKey < sample)
+					++itKey;
+				if (track.keys.empty() || (itKey != track.keys.end() && *itKey == sample))
+					keyTime = UInt32(round(sampleTime));
+				sampleTime += repeat.value*track.timeStep;
+			}
+		}
+		break;
+	}
+	if (!keyTime)
+		return;
+	DEBUG("MP4Reader starts on keyframe ", keyTime, "ms (from=", time, ")");
+
+	// Skip samples before keyTime on every track, without reading them
+	set<Track*> tracks; // tracks positioned
+	auto it = _chunks.begin();
+	while (it != _chunks.end() && tracks.size() < _tracks.size()) {
+		Track& track = *it->second;
+		if (tracks.count(&track) || !track.timeStep || track.durations.empty() || track.changes.empty()) {
+			tracks.emplace(&track);
+			++it;
+			continue;
+		}
+		auto itChange = track.changes.begin();
+		if (track.chunk < itChange->first)
+			track.chunk = itChange->first;
+		UInt32 samples = itChange->second >> 32;
+		UInt64 offset = it->first;
+		while (track.sample < samples) {
+			UInt32 sampleTime = UInt32(round(track.time));
+			if (sampleTime >= keyTime)
+				break;
+			UInt32 index = track.sample + track.samples;
+			offset += index < track.sizes.size() ? track.sizes[index] : track.size;
+			// consume times reference
+			auto itTime = _times.find(sampleTime);
+			if (itTime != _times.end() && !--itTime->second)
+				_times.erase(itTime);
+			if (!track.compositionOffsets.empty() && !--track.compositionOffsets.front().count)
+				track.compositionOffsets.pop_front();
+			// determine next time
+			Repeat& repeat = track.durations.front();
+			track.time += repeat.value*track.timeStep;
+			if (track.durations.size() > 1 && !--repeat.count)
+				track.durations.pop_front();
+			++track.sample;
+		}
+		if (track.sample < samples) {
+			// keyTime reached, chunk starts now on this sample
+			tracks.emplace(&track);
+			if (offset == it->first) {
+				++it;
+				continue;
+			}
+			it = _chunks.erase(it);
+			_chunks.emplace(offset, &track);
+			continue;
+		}
+		// whole chunk skipped
+		it = _chunks.erase(it);
+		if (++itChange != track.changes.end() && ++track.chunk >= itChange->first)
+			track.changes.erase(track.changes.begin());
+		track.samples += samples;
+		track.sample = 0;
+	}
+}
+
 void MP4Reader::onFlush(Packet& buffer, Media::Source& source) {
 	// release resources
 	_times.clear(); // to force media flush (and clear _medias)
@@ -952,7 +1093,8 @@ void MP4Reader::onFlush(Packet& buffer, Media::Source& source) {
 	_tracks.clear();
 	_ids.clear();
 
-	_offset = _position = 0;
+	_offset = 0;
+	_mdat = _moov = 0;
 	_firstMoov = true;
 
 	MediaReader::onFlush(buffer, source);
@@ -16,11 +16,91 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 #include "Mona/MPEG4.h"
 #include "Mona/Logs.h"
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define BLOCK_SIZE 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SSE2
+	#define BLOCK_SIZE 16
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define NEON
+	#define BLOCK_SIZE 16
+#else
+	#define BLOCK_SIZE 8
+#endif
 
 using namespace std;
 
 namespace Mona {
 
+/*!
+Skip blocks which don't contain 00 00 (start code or emulation prevention 00 00 03),
+returns the first block position which contains a 00 00 or the end of blocks (data remaining < block + 1) */
+static const UInt8* SkipBlocks(const UInt8* cur, const UInt8* end) {
+#if defined(__AVX2__)
+	const __m256i zero = _mm256_setzero_si256();
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		// bytes i and i+1 null
+		__m256i pairs = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)cur), zero), _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(cur + 1)), zero));
+		if (_mm256_movemask_epi8(pairs))
+			break;
+	}
+#elif defined(SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		// bytes i and i+1 null
+		__m128i pairs = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)cur), zero), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(cur + 1)), zero));
+		if (_mm_movemask_epi8(pairs))
+			break;
+	}
+#elif defined(NEON)
+	const uint8x16_t zero = vdupq_n_u8(0);
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		// bytes i and i+1 null
+		uint8x16_t pairs = vandq_u8(vceqq_u8(vld1q_u8(cur), zero), vceqq_u8(vld1q_u8(cur + 1), zero));
+		uint64x2_t halves = vreinterpretq_u64_u8(pairs);
+		if (vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1))
+			break;
+	}
+#else
+	for (; (end - cur) > BLOCK_SIZE; cur += BLOCK_SIZE) {
+		UInt64 value, next;
+		memcpy(&value, cur, 8);
+		memcpy(&next, cur + 1, 8);
+		// 0x80 on each null byte (exact, without carry propagation)
+		value = ~(((value & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | value | 0x7F7F7F7F7F7F7F7FULL);
+		next = ~(((next & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | next | 0x7F7F7F7F7F7F7F7FULL);
+		if (value & next)
+			break;
+	}
+#endif
+	return cur;
+}
+
+const UInt8* MPEG4::FindStartCode(const UInt8* cur, const UInt8* end, UInt8& zeros) {
+	const UInt8* block(cur); // end of the block to read byte per byte
+	while (cur < end) {
+		if (!zeros && cur >= block) {
+			// A skipped block has no 00 00, so it can't end with a 00 preceding a 00 => zeros stays valid
+			if ((cur = SkipBlocks(cur, end)) == end)
+				break;
+			block = cur + BLOCK_SIZE;
+		}
+		UInt8 value(*cur++);
+		if (!value) {
+			if (zeros < 3)
+				++zeros; // more than 3 zeros... no problem
+			continue;
+		}
+		if (value == 0x01 && zeros >= 2)
+			return cur;
+		zeros = 0;
+	}
+	return NULL;
+}
+
 UInt8 MPEG4::ReadAudioConfig(const UInt8* data, UInt32 size, UInt32& rate, UInt8& channels) {
 	UInt8 rateIndex;
 	UInt8 type(ReadAudioConfig(data, size, rateIndex, channels));
@@ -20,11 +20,77 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/TSWriter.h"
 #include "Mona/M3U8.h"
 #include "Mona/Logs.h"
+#include <list>
+#include <set>
 
 using namespace std;
 
 namespace Mona {
 
+static mutex											_IndexesMutex;
+static list<shared<const MediaFile::Index>>				_Indexes; // the most recently used first
+static map<string, list<shared<const MediaFile::Index>>::iterator>	_IndexesByPath;
+static set<string>										_Indexings; // indexes in building
+
+shared<const MediaFile::Index> MediaFile::Index::Get(const Path& path) {
+	lock_guard<mutex> lock(_IndexesMutex);
+	const auto& it = _IndexesByPath.find(path);
+	if (it == _IndexesByPath.end())
+		return nullptr;
+	if ((*it->second)->valid()) {
+		_Indexes.splice(_Indexes.begin(), _Indexes, it->second);
+		return _Indexes.front();
+	}
+	// media file has changed!
+	_Indexes.erase(it->second);
+	_IndexesByPath.erase(it);
+	return nullptr;
+}
+
+void MediaFile::Index::Set(const shared<const Index>& pIndex) {
+	lock_guard<mutex> lock(_IndexesMutex);
+	_Indexings.erase(pIndex->path);
+	const auto& it = _IndexesByPath.emplace(pIndex->path, _Indexes.end()).first;
+	if (it->second != _Indexes.end())
+		_Indexes.erase(it->second);
+	_Indexes.emplace_front(pIndex);
+	it->second = _Indexes.begin();
+	while (_Indexes.size() > MAX_COUNT) {
+		_IndexesByPath.erase(_Indexes.back()->path);
+		_Indexes.pop_back();
+	}
+}
+
+bool MediaFile::Index::Build(const Path& path) {
+	lock_guard<mutex> lock(_IndexesMutex);
+	return _Indexings.emplace(path).second;
+}
+
+void MediaFile::Index::Cancel(const Path& path) {
+	lock_guard<mutex> lock(_IndexesMutex);
+	_Indexings.erase(path);
+}
+
+void MediaFile::Index::add(Media::Type type, UInt32 time, UInt64 position) {
+	if (type == Media::TYPE_VIDEO) {
+		if (!_video) {
+			_video = true;
+			_positions.clear(); // audio positions are useless when there is video
+		}
+	} else if (_video || (!_positions.empty() && (time - _positions.rbegin()->first) < 1000))
+		return; // audio just if no video, one by second
+	_positions.emplace(time, position);
+}
+
+bool MediaFile::Index::find(UInt32 time, UInt64& position) const {
+	auto it = _positions.upper_bound(time);
+	if (it == _positions.begin())
+		return false;
+	position = (--it)->second;
+	return true;
+}
+
+
 unique<MediaFile::Reader> MediaFile::Reader::New(Exception& ex, const char* request, Media::Source& source, const Timer& timer, IOFile& io, string&& format) {
 	Path path(move(format));
 	if (!(request = MediaStream::Format(ex, MediaStream::TYPE_FILE, request, path)))
@@ -35,21 +101,6 @@ unique<MediaFile::Reader> MediaFile::Reader::New(Exception& ex, const char* requ
 	return make_unique<MediaFile::Reader>(path, move(pReader), source, timer, io);
 }
 
-UInt32 MediaFile::Reader::Decoder::decode(shared<Buffer>& pBuffer, bool end) {
-	DUMP_RESPONSE(_name.c_str(), pBuffer->data(), pBuffer->size(), _path);
-	Packet packet(pBuffer); // to capture pBuffer!
-	if (!_pReader || _pReader.unique())
-		return 0;
-	_mediaTimeGotten = false;
-	_pReader->read(packet, self);
-	if (end)
-		_pReader.reset(); // no flush, because will be done by the main thread (end of file call stop())
-	else if(!_mediaTimeGotten)
-		return packet.size(); // continue to read if no flush
-	_handler.queue(onFlush);
-	return 0;
-}
-
 static bool ReadMediaTime(Media::Base& media, UInt32& time) {
 	switch (media.type) {
 		case Media::TYPE_AUDIO: {
@@ -71,6 +122,91 @@ static bool ReadMediaTime(Media::Base& media, UInt32& time) {
 	return false;
 }
 
+MediaFile::Reader::Decoder::Decoder(IOFile& io, const shared<MediaReader>& pReader, File& file, const string& name, const shared<deque<unique<Media::Base>>>& pMedias, UInt32 from) :
+	_name(name), _io(io), _pReader(pReader), _file(file), _pMedias(pMedias), _from(from), _keyFrame(false) {
+	if (_from)
+		_pReader->onKeyFrame = [this](Media::Type type, UInt32 time, UInt64 position) { _keyFrame = true; };
+}
+
+MediaFile::Reader::Decoder::~Decoder() {
+	if (_pReader)
+		_pReader->onKeyFrame = nullptr;
+}
+
+bool MediaFile::Reader::Decoder::resume() {
+	// Headers and configs are readen (first keyframe), find the "from" position with the index
+	UInt32 from = _from;
+	_from = 0;
+	_pReader->onKeyFrame = nullptr;
+	shared<const Index> pIndex = Index::Get(_file.path());
+	if (!pIndex) {
+		unique<MediaReader> pReader = MediaReader::New(_pReader->subMime());
+		if (!pReader || !Index::Build(_file.path()))
+			return false; // index building already running for an other reader
+		DEBUG("No index of ", _file.path(), ", build it in background to allow next random access");
+		Indexer* pIndexer = new Indexer(move(pReader), _file.path());
+		_pIndexing.set(_file.path(), File::MODE_READ);
+		_onIndexingError = [](const Exception& ex) { WARN("Index building, ", ex); };
+		_io.subscribe(_pIndexing, pIndexer, nullptr, _onIndexingError);
+		_io.read(_pIndexing);
+		return false;
+	}
+	UInt64 position;
+	if (!pIndex->find(from, position) || !_pReader->resume(position, self))
+		return false;
+	// remove medias readen before the jump, keep just configs and properties
+	auto it = _pMedias->begin();
+	while (it != _pMedias->end()) {
+		UInt32 time;
+		if (*it && ReadMediaTime(**it, time))
+			it = _pMedias->erase(it);
+		else
+			++it;
+	}
+	DEBUG(_name, " resumes on ", position, " position (from=", from, "ms)");
+	return true;
+}
+
+UInt32 MediaFile::Reader::Indexer::decode(shared<const Buffer>& pBuffer, bool end) {
+	if (!_pReader->onKeyFrame)
+		_pReader->onKeyFrame = [this](Media::Type type, UInt32 time, UInt64 position) { _pIndex->add(type, time, position); };
+	_pReader->read(Packet(pBuffer), Media::Source::Null());
+	pBuffer.reset(); // no onReaden
+	if (!end)
+		return 0xFFFF; // continue to read
+	DEBUG("Index of ", _pIndex->path, " built with ", _pIndex->count(), " positions");
+	Index::Set(_pIndex);
+	_pIndex.reset(); // built
+	return 0;
+}
+
+UInt32 MediaFile::Reader::Decoder::decode(shared<const Buffer>& pBuffer, bool end) {
+	DUMP_RESPONSE(_name.c_str(), pBuffer->data(), pBuffer->size(), _file.path());
+	Packet packet(pBuffer);
+	pBuffer.reset(); // captured, no onReaden
+	if (!_pReader || _pReader.unique())
+		return 0;
+	_mediaTimeGotten = false;
+	_pReader->read(packet, self);
+	if (_keyFrame && _from && resume())
+		_mediaTimeGotten = false; // medias before the jump removed
+	UInt64 position;
+	bool seeking = _pReader->seeking(position);
+	if (seeking) {
+		// random access required by the reader
+		if (_file.reset(position))
+			end = false;
+		else
+			WARN(_name, " impossible to seek to position ", position, " in ", _file.path());
+	}
+	if (end)
+		_pReader.reset(); // no flush, because will be done by the main thread (end of file call stop())
+	else if(!_mediaTimeGotten)
+		return seeking ? 0xFFFF : packet.size(); // continue to read if no flush (0xFFFF after seeking, see IOFile::read)
+	_io.handler.queue(onFlush);
+	return 0;
+}
+
 MediaFile::Reader::Reader(const Path& path, unique<MediaReader>&& pReader, Media::Source& source, const Timer& timer, IOFile& io) :
 		path(path), io(io), _pReader(move(pReader)), timer(timer), _pMedias(SET),
 		MediaStream(TYPE_FILE, source, "Stream source file://...", Path(path.parent()).name(), '/', path.baseName(), '.', path.extension().empty() ? pReader->format() : path.extension().c_str()),
@@ -127,9 +263,13 @@ bool MediaFile::Reader::starting(const Parameters& parameters) {
 	}
 	_pReader->setParams(parameters);
 	_realTime =	0; // reset realTime
-	Decoder* pDecoder = new Decoder(io.handler, _pReader, path, source.name(), _pMedias);
-	pDecoder->onFlush = _onFlush = [this]() { timer.set(_onTimer, _onTimer()); };
+	_pReader->seekable = true; // file allows random access
 	_pFile.set(path, File::MODE_READ);
+	UInt32 from = 0;
+	if (_pReader->indexable()) // else reader manages itself "from" parameter (MP4)
+		parameters.getNumber("from", from);
+	Decoder* pDecoder = new Decoder(io, _pReader, *_pFile, source.name(), _pMedias, from);
+	pDecoder->onFlush = _onFlush = [this]() { timer.set(_onTimer, _onTimer()); };
 	io.subscribe(_pFile, pDecoder, nullptr, _onFileError);
 	io.read(_pFile);
 	return run();
@@ -95,14 +95,25 @@ unique<MediaReader> MediaReader::New(const char* subMime) {
 }
 
 void MediaReader::read(const Packet& packet, Media::Source& source) {
-	if (packet) // keep the check on packet (no sense for empty packet here!)
-		addStreamData(packet, 0xFFFFFFFF, source);
+	if (!packet)
+		return; // keep the check on packet (no sense for empty packet here!)
+	_position += packet.size();
+	addStreamData(packet, 0xFFFFFFFF, source);
 }
 void MediaReader::flush(Media::Source& source) {
 	shared<Buffer> pBuffer;
 	Packet buffer(clearStreamData(pBuffer));
+	_position = 0;
 	onFlush(buffer, source);
 }
+bool MediaReader::seeking(UInt64& position) {
+	if (!_seeking)
+		return false;
+	_position = position = _seeking - 1;
+	_seeking = 0;
+	clearStreamData(); // next data are not contiguous
+	return true;
+}
 void MediaReader::onFlush(Packet& buffer, Media::Source& source) {
 	source.reset();
 	source.flush(); // flush after reset!
@@ -254,14 +254,14 @@ bool MediaSocket::Writer::beginMedia(const string& name) {
 	if (streaming)
 		return true; // MBR switch!
 
-	send<Send>(); // First media, send the beginMedia!
 	if (type == TYPE_HTTP) { // HTTP
-		// send HTTP Header request!
+		// send HTTP Header request before beginMedia which is sent asynchronously by the thread pool!
 		if (!SendHTTPHeader(_httpAnswer? HTTP::TYPE_UNKNOWN : HTTP::TYPE_POST, _pSocket, request, _pWriter->mime(), _pWriter->subMime(), source.name().c_str(), description)) {
 			stop();
 			return false;
 		}
 	}
+	send<Send>(); // First media, send the beginMedia!
 	return true;
 }
 
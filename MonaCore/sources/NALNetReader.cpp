@@ -26,10 +26,10 @@ using namespace std;
 namespace Mona {
 
 template <>
-NALNetReader<AVC>::NALNetReader(UInt8 track) : MediaTrackReader(track), _tag(Media::Video::CODEC_H264), _state(0), _type(0xFF), _position(0) {}
+NALNetReader<AVC>::NALNetReader(UInt8 track) : MediaTrackReader(track), _tag(Media::Video::CODEC_H264), _zeros(0), _type(0xFF), _position(0) {}
 
 template <>
-NALNetReader<HEVC>::NALNetReader(UInt8 track) : MediaTrackReader(track), _tag(Media::Video::CODEC_HEVC), _state(0), _type(0xFF), _position(0) {}
+NALNetReader<HEVC>::NALNetReader(UInt8 track) : MediaTrackReader(track), _tag(Media::Video::CODEC_HEVC), _zeros(0), _type(0xFF), _position(0) {}
 
 template <class VideoType>
 UInt32 NALNetReader<VideoType>::parse(Packet& buffer, Media::Source& source) {
@@ -38,42 +38,16 @@ UInt32 NALNetReader<VideoType>::parse(Packet& buffer, Media::Source& source) {
 	const UInt8* end(buffer.data() + buffer.size());
 	const UInt8* nal(cur);	// assume that the copy will be from start-of-data
 
-
-	while(cur<end) {
-		
-		UInt8 value(*cur++);
-
-		// About 00 00 01 and 00 00 00 01 difference => http://stackoverflow.com/questions/23516805/h264-nal-unit-prefixes
-	
-		switch(_state) {
-			case 0:
-				if(value == 0x00)
-					_state = 1;
-				break;
-			case 1:
-				_state = value == 0x00 ? 2 : 0;
-				break;
-			case 2:
-				if (value == 0x00) {  // 3 zeros
-					_state = 3;
-					break;
-				}
-			case 3:
-				if(value == 0x00)  // more than 2 or 3 zeros... no problem  
-					break; // state stays at 3 (or 2)
-				if (value == 0x01) {
-					writeNal(nal, cur - nal, source, true);
-					nal = cur;
-					_type = 0xFF; // new NAL!	
-				}
-			default:
-				_state = 0;
-				break;
-		} // switch _scState
+	// About 00 00 01 and 00 00 00 01 difference => http://stackoverflow.com/questions/23516805/h264-nal-unit-prefixes
+	while ((cur = MPEG4::FindStartCode(cur, end, _zeros))) {
+		writeNal(nal, cur - nal, source, true);
+		nal = cur;
+		_type = 0xFF; // new NAL!
+		_zeros = 0;
 	}
 
-	if (cur != nal)
-		writeNal(nal, cur - nal, source);
+	if (nal != end)
+		writeNal(nal, end - nal, source);
 
 	return 0;
 }
@@ -137,7 +111,7 @@ void NALNetReader<VideoType>::writeNal(const UInt8* data, UInt32 size, Media::So
 	}
 	_pNal->append(data, size);
 	if (eon)
-		_pNal->resize(_pNal->size() - _state - 1, true); // trim off the [0] 0 0 1
+		_pNal->resize(_pNal->size() - _zeros - 1, true); // trim off the [0] 0 0 1
 	if(flush)
 		flushNal(source);
 }
@@ -159,7 +133,7 @@ template <class VideoType>
 void NALNetReader<VideoType>::onFlush(Packet& buffer, Media::Source& source) {
 	flushNal(source);
 	_type = 0xFF;
-	_state = 0;
+	_zeros = 0;
 	MediaTrackReader::onFlush(buffer, source);
 }
 
@@ -125,6 +125,8 @@ bool Peer::setServerAddress(const SocketAddress& address) {
 
 SocketAddress& Peer::onHandshake(SocketAddress& redirection) {
 	_api.onHandshake(path,  protocol, address, properties(), redirection);
+	if (!redirection) // application has priority, then load balancing
+		_api.balancer.redirect(protocol, redirection);
 	if (redirection)
 		INFO(protocol, " redirection from ", serverAddress, " to ", redirection);
 	return redirection;
@@ -24,11 +24,11 @@ using namespace std;
 namespace Mona {
 
 Protocol::Protocol(const char* name, ServerAPI& api, Sessions& sessions) :
-	name(name), api(api), sessions(sessions), _pGateway(NULL) {
+	name(name), bufferTag(Buffer::Tag::Get(name)), api(api), sessions(sessions), _pGateway(NULL) {
 }
 
 Protocol::Protocol(const char* name, Protocol& gateway) :
-	name(name), api(gateway.api), sessions(gateway.sessions), _pGateway(&gateway) {
+	name(name), bufferTag(Buffer::Tag::Get(name)), api(gateway.api), sessions(gateway.sessions), _pGateway(&gateway) {
 	// copy parameters from gateway (publicHost, publicPort,  etc...)
 	for (const auto& it : gateway)
 		setParameter(it.first, it.second);
@@ -47,6 +47,7 @@ SocketAddress Protocol::load(Exception& ex) {
 }
 
 Socket& Protocol::initSocket(Socket& socket) {
+	socket.setBufferTag(bufferTag);
 	Exception ex;
 	AUTO_WARN(socket.processParams(ex, self), name, " socket");
 	DEBUG(name, " set ", socket, " socket buffers set to ", socket.recvBufferSize(), "B in reception and ", socket.sendBufferSize(),"B in sends");
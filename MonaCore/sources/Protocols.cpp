@@ -25,7 +25,7 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/HTTP/HTTProtocol.h"
 #include "Mona/WS/WSProtocol.h"
 #include "Mona/STUN/STUNProtocol.h"
-//#include "Mona/RTSP/RTSProtocol.h"
+#include "Mona/RTSP/RTSProtocol.h"
 #include "Mona/SRT/SRTProtocol.h"
 
 using namespace std;
@@ -44,7 +44,7 @@ void Protocols::load(ServerAPI& api, Sessions& sessions) {
 #if defined(SRT_API)
 	load<SRTProtocol>("SRT", api, sessions);
 #endif
-	//loadProtocol<RTSProtocol>("RTSP", api, sessions);
+	load<RTSProtocol>("RTSP", api, sessions);
 }
 
 
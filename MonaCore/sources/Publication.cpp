@@ -25,9 +25,14 @@ using namespace std;
 
 namespace Mona {
 
+const char* Publication::StageToString(Stage stage) {
+	static const char* Strings[] = { "decode", "wait", "process", "flush", "total" };
+	return Strings[stage];
+}
+
 Publication::Publication(const string& name): _latency(0), segments(_segments), _segments(0), _segmenting(false),
 	audios(_audios), videos(_videos), datas(_datas), _lostRate(_byteRate), _maxByteRate(0), _propVersion(0),
-	_publishing(0),_new(false), _newLost(false), _name(name) {
+	_publishing(0),_new(false), _newLost(false), _name(name), _pBufferTag(NULL) {
 	DEBUG("New publication ",name);
 	_segments.onSegment = [this](UInt16 duration) {
 		DEBUG("New ", _name, " segment of ", duration, "ms (segments: ", _segments.sequence(), "-", _segments.sequence() + _segments.count() - 1, ", maxDuration: ", _segments.maxDuration(),")");
@@ -51,6 +56,14 @@ Publication::~Publication() {
 	DEBUG("Publication ",_name," deleted");
 }
 
+Buffer::Tag* Publication::bufferTag(const Packet& packet) {
+	if (!Buffer::Tag::Enabled())
+		return NULL; // no tag to create, tags are never deleted
+	if (!_pBufferTag)
+		_pBufferTag = &Buffer::Tag::Get("publication/" + _name);
+	return &_pBufferTag->adopt(packet.buffer());
+}
+
 UInt32 Publication::currentTime() const {
 	if (_videos.empty())
 		return _audios.lastTime;
@@ -125,12 +138,13 @@ void Publication::start(unique<MediaFile::Writer>&& pRecorder) {
 	if (!_publishing) { // new publication
 		_publishing = -1; // starting but not need to reset currently
 		_propVersion = version; // useless to dispatch metadata changes, will be done on next media by Subscriber side!
+		_pLatencies.reset(); // new latencies
 		INFO("Publication ", _name, ' ', self, " started");
 	} else
 		reset(); // set _publishing=-1
 	// no flush here, wait first flush or first media to allow to subscribe to onProperties event for a publisher!
 
-	UInt8 segments;
+	UInt32 segments;
 	_segmenting = false;
 	if (pRecorder) { // start recording
 		stopRecording();
@@ -146,7 +160,7 @@ void Publication::start(unique<MediaFile::Writer>&& pRecorder) {
 	}
 	// start or stop live segmenting
 	const char* strSegments = _segmenting ? NULL : getString("segments");
-	if (_segments.setMaxSegments(strSegments ? String::ToNumber<UInt8, Segments::DEFAULT_SEGMENTS>(strSegments) : 0)) {
+	if (_segments.setMaxSegments(strSegments ? String::ToNumber<UInt16, Segments::DEFAULT_SEGMENTS>(strSegments) : 0)) {
 		_segmenting = true;
 		segments = _segments.maxSegments();
 		_segments.setMaxDuration(getNumber<UInt16>("duration"));
@@ -223,6 +237,12 @@ void Publication::flush() {
 		_maxByteRate = byteRate;
 	// set publishing to 1 (invalid reset)
 	_publishing = 1;
+	if (_pLatencies && _pLatencies->published) {
+		Int64 now = Metrics::Microseconds();
+		_pLatencies->stages[STAGE_FLUSH].record(now - _pLatencies->published);
+		_pLatencies->stages[STAGE_TOTAL].record(now - _pLatencies->pending);
+		_pLatencies->published = 0;
+	}
 	// send properties if need
 	flushProperties(); 
 	if (!_new)
@@ -249,11 +269,31 @@ void Publication::flush() {
 }
 
 
+void Publication::trace() {
+	const Metrics::Trace& trace = Metrics::Trace::Current();
+	if (!trace || !trace.ran)
+		return; // not traced or not received through the main thread queue
+	if (!_pLatencies)
+		_pLatencies.set();
+	else if (_pLatencies->received == trace.received)
+		return; // already traced (reception decoded in several medias)
+	Int64 now = Metrics::Microseconds();
+	_pLatencies->stages[STAGE_DECODE].record(trace.queued - trace.received);
+	_pLatencies->stages[STAGE_WAIT].record(trace.ran - trace.queued);
+	_pLatencies->stages[STAGE_PROCESS].record(now - trace.ran);
+	_pLatencies->received = trace.received;
+	if (_pLatencies->published)
+		return; // keep the older one waiting flush
+	_pLatencies->pending = trace.received;
+	_pLatencies->published = now;
+}
+
 void Publication::writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) {
 	if (!_publishing) {
 		ERROR("Audio packet on publication ", _name, " stopped");
 		return;
 	}
+	trace();
 	_audios.lastTime = tag.time;
 
 	// create track
@@ -270,11 +310,15 @@ void Publication::writeAudio(const Media::Audio::Tag& tag, const Packet& packet,
 	_new = true;
 	//INFO(name()," audio ",tag.time);
 	for (Subscription* pSubscription : subscriptions) {
-		if (pSubscription->pPublication == this || !pSubscription->pPublication)
-			pSubscription->writeAudio(tag, packet, track);
+		if (pSubscription->pPublication != this && pSubscription->pPublication)
+			continue; // subscriber not yet subscribed
+		_egressByteRate += packet.size() + sizeof(tag);
+		pSubscription->writeAudio(tag, packet, track);
 	}
-	if (_segments)
+	if (_segments) {
+		Buffer::Tag::Scope bufferTag(this->bufferTag(packet)); // retained by segments (bufferized in this scope if need)
 		_segments.writeAudio(track, tag, packet);
+	}
 
 	// Hold config packet after video distribution to avoid to distribute two times config packet if subscription call beginMedia
 	if (pAudio && tag.isConfig)
@@ -286,6 +330,7 @@ void Publication::writeVideo(const Media::Video::Tag& tag, const Packet& packet,
 		ERROR("Video packet on stopped ", _name, " publication");
 		return;
 	}
+	trace();
 	_publishing = 1;
 	_videos.lastTime = tag.time;
 
@@ -336,13 +381,19 @@ void Publication::writeVideo(const Media::Video::Tag& tag, const Packet& packet,
 		if (pSubscription->pPublication != this && pSubscription->pPublication)
 			continue; // subscriber not yet subscribed
 		if (offsetCC && (!pSubscription->datas.pSelection || *pSubscription->datas.pSelection)) { // if a data track is selected => send without CC!
-			if (packet.size() > offsetCC)
+			if (packet.size() > offsetCC) {
+				_egressByteRate += packet.size() - offsetCC + sizeof(tag);
 				pSubscription->writeVideo(tag, packet + offsetCC, track); // without CC
-		} else
+			}
+		} else {
+			_egressByteRate += packet.size() + sizeof(tag);
 			pSubscription->writeVideo(tag, packet, track); // with CC
+		}
 	}
-	if (_segments)
+	if (_segments) {
+		Buffer::Tag::Scope bufferTag(this->bufferTag(packet));
 		_segments.writeVideo(track, tag, packet);
+	}
 
 	// Hold config packet after video distribution to avoid to distribute two times config packet if subscription call beginMedia
 	if (pVideo && tag.frame == Media::Video::FRAME_CONFIG && packet) // don't save the config "empty" (keep alive data stream!)
@@ -354,6 +405,7 @@ void Publication::writeData(Media::Data::Type type, const Packet& packet, UInt8
 		ERROR("Data packet on ", _name, " publication stopped");
 		return;
 	}
+	trace();
 	_publishing = 1;
 
 	if (type != Media::Data::TYPE_TEXT) { // else has no handler!
@@ -385,11 +437,15 @@ void Publication::writeData(Media::Data::Type type, const Packet& packet, UInt8
 	_datas.byteRate += packet.size();
 	_new = true;
 	for (Subscription* pSubscription : subscriptions) {
-		if (pSubscription->pPublication == this || !pSubscription->pPublication)
-			pSubscription->writeData(type, packet, track);
+		if (pSubscription->pPublication != this && pSubscription->pPublication)
+			continue; // subscriber not yet subscribed
+		_egressByteRate += packet.size();
+		pSubscription->writeData(type, packet, track);
 	}
-	if (_segments)
+	if (_segments) {
+		Buffer::Tag::Scope bufferTag(this->bufferTag(packet));
 		_segments.writeData(track, type, packet);
+	}
 }
 
 void Publication::onParamChange(const string& key, const string* pValue) {
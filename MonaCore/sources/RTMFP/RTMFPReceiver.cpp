@@ -151,23 +151,12 @@ void RTMFPReceiver::receive(Socket& socket, shared<Buffer>& pBuffer, const Socke
 					const auto& it = acks.emplace(id, Packet());
 					if (it.second || it.first->second) { // to avoid to override a RTMFPWriter fails!
 						if(type == 0x50) {
-							// convert to 0x51!
-							const UInt8* begin(message.current());
-							message.read7Bit<UInt64>(10); // stage!
-							UInt8* lostBuffer(BIN message.current());
-							UInt32 lostCount(0);
-							while (message.available()) {
-								UInt8 bits(message.read8());
-								for (UInt8 i = 0; i < 8; ++i) {
-									if (bits & 1) {
-										message.next(message.available());
-										break;
-									}
-									++lostCount;
-									bits >>= 1;
-								}
-							}
-							it.first->second.set(Packet(packet, begin, (lostBuffer - begin) + BinaryWriter(lostBuffer, 4).write7Bit<UInt64>(lostCount).size()));
+							// convert bitmap to 0x51 ranges
+							shared<Buffer> pAck(SET);
+							BinaryWriter writer(*pAck);
+							writer.write7Bit<UInt64>(message.read7Bit<UInt64>(10), 10); // stage!
+							WriteRanges(message, writer);
+							it.first->second.set(Packet(pAck));
 						} else
 							it.first->second.set(Packet(packet, message.current(), message.available()));
 					}
@@ -388,4 +377,26 @@ void RTMFPReceiver::Flow::onFragment(UInt64 stage, UInt8 flags, const Packet& pa
 		_output(id, _lost, packet);
 }
 
+BinaryWriter& RTMFPReceiver::WriteRanges(BinaryReader& bitmap, BinaryWriter& writer) {
+	UInt32 holes(1), received(0);
+	while (bitmap.available()) {
+		UInt8 bits(bitmap.read8());
+		for (UInt8 i = 0; i < 8; ++i, bits >>= 1) {
+			if (bits & 1) {
+				++received;
+				continue;
+			}
+			if (received) {
+				writer.write7Bit<UInt64>(holes - 1, 10).write7Bit<UInt64>(received - 1, 10);
+				holes = received = 0;
+			}
+			++holes;
+		}
+	}
+	if (received)
+		writer.write7Bit<UInt64>(holes - 1, 10).write7Bit<UInt64>(received - 1, 10);
+	return writer;
+}
+
+
 } // namespace Mona
@@ -18,30 +18,150 @@ details (or else see http://www.gnu.org/licenses/).
 
 #include "Mona/RTMFP/RTMFPSender.h"
 #include "Mona/BinaryWriter.h"
+#include "Mona/BinaryReader.h"
 #include "Mona/Logs.h"
 
 using namespace std;
 
 namespace Mona {
 
+#define CUBIC_C		0.4
+#define CUBIC_BETA	0.7
+#define RTT_DEFAULT	100 // ms, RTT assumed while unknown
+
+RTMFPSender::Congestion::Congestion() : rtt(0), _inflight(0), _window(0), _slowStart(true), _threshold(WINDOW_MAX),
+	_wMax(0), _origin(0), _k(0), _estimated(0), _epoch(0), _lossTime(0), _credit(WINDOW_INIT * RTMFP::SIZE_PACKET), _creditTime(Time::Now()) {
+	update(WINDOW_INIT);
+}
+
+UInt64 RTMFPSender::Congestion::pacingRate() const {
+	UInt16 rtt(this->rtt);
+	if (!rtt)
+		return 0;
+	// gain of 2 in slow start to let window doubling, 1.25 otherwise to fill the window
+	return UInt64(_window) * (_slowStart ? 2000 : 1250) / rtt;
+}
+
+bool RTMFPSender::Congestion::sendable(UInt32 size) {
+	UInt32 inflight(_inflight);
+	if (!inflight)
+		return true; // nothing to clock the sending, always one packet possible
+	if ((inflight + size) > _window)
+		return false;
+	UInt64 rate(pacingRate());
+	if (!rate)
+		return true;
+	Int64 now(Time::Now());
+	if (now > _creditTime) {
+		// burst limited to a quarter of window, acks arrive more often than every RTT/4
+		UInt32 burst(max(_window / 4, UInt32(WINDOW_MIN * RTMFP::SIZE_PACKET)));
+		_credit = UInt32(min<UInt64>(_credit + rate * (now - _creditTime) / 1000, burst));
+		_creditTime = now;
+	}
+	return _credit >= size;
+}
+
+void RTMFPSender::Congestion::sent(UInt32 size) {
+	_inflight += size;
+	_credit = _credit > size ? (_credit - size) : 0;
+}
+
+void RTMFPSender::Congestion::released(UInt32 size) {
+	UInt32 inflight(_inflight);
+	while (!_inflight.compare_exchange_weak(inflight, inflight > size ? (inflight - size) : 0));
+}
+
+void RTMFPSender::Congestion::acked(UInt32 size) {
+	UInt32 inflight(_inflight);
+	bool limited((inflight * 2) < _window); // application limited, window not used so not grown
+	released(size);
+	if (limited)
+		return;
+	double acked(double(size) / RTMFP::SIZE_PACKET);
+	double cwnd(_cwnd);
+	if (cwnd < _threshold) {
+		update(cwnd + acked); // slow start
+		return;
+	}
+	Int64 now(Time::Now());
+	if (!_epoch) {
+		// new congestion avoidance epoch
+		_epoch = now;
+		_origin = max(_wMax, cwnd);
+		_k = cbrt((_origin - cwnd) / CUBIC_C);
+		_estimated = cwnd;
+	}
+	UInt16 rtt(this->rtt ? this->rtt.load() : RTT_DEFAULT);
+	double t((now - _epoch + rtt) / 1000.0);
+	double target(_origin + CUBIC_C * pow(t - _k, 3));
+	// TCP friendly region, Reno growth with the same average window
+	_estimated += 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA) * acked / cwnd;
+	if (target < _estimated)
+		target = _estimated;
+	if (target > cwnd)
+		cwnd += min(target - cwnd, cwnd / 2) * acked / cwnd; // at most 1.5 x window by RTT
+	else
+		cwnd += acked / (100 * cwnd);
+	update(cwnd);
+}
+
+void RTMFPSender::Congestion::lost() {
+	Int64 now(Time::Now());
+	if ((now - _lossTime) < (rtt ? rtt.load() : RTT_DEFAULT))
+		return; // same congestion event
+	reduce(now);
+	update(_threshold);
+}
+
+void RTMFPSender::Congestion::timeout() {
+	reduce(Time::Now());
+	update(WINDOW_MIN);
+}
+
+UInt32 RTMFPSender::Congestion::lossDelay() const {
+	UInt16 rtt(this->rtt ? this->rtt.load() : RTT_DEFAULT);
+	return rtt + max(rtt / 4, 1);
+}
+
+void RTMFPSender::Congestion::reduce(Int64 now) {
+	_lossTime = now;
+	// fast convergence: release bandwidth for new flows if the window has not reached its previous maximum
+	_wMax = _cwnd < _wMax ? (_cwnd * (1 + CUBIC_BETA) / 2) : _cwnd;
+	_threshold = max<double>(_cwnd * CUBIC_BETA, WINDOW_MIN);
+	_epoch = 0;
+}
+
+void RTMFPSender::Congestion::update(double cwnd) {
+	if (cwnd < WINDOW_MIN)
+		cwnd = WINDOW_MIN;
+	else if (cwnd > WINDOW_MAX)
+		cwnd = WINDOW_MAX;
+	_cwnd = cwnd;
+	_slowStart = cwnd < _threshold;
+	_window = UInt32(cwnd * RTMFP::SIZE_PACKET);
+}
+
+
 bool RTMFPSender::run(Exception&) {	
 	run();
 	if (!pQueue)
 		return true;
 
 	// Flush Queue!
-	while (pSession->sendable && !pQueue->empty()) {
-		TRACE("Stage ", pQueue->stageSending+1, " sent");
+	while (!pQueue->empty()) {
 		shared<Packet>& pPacket(pQueue->front());
-		if (!RTMFP::Send(pSession->socket, *pPacket, address)) {
-			pSession->sendable = 0;
+		if (!pSession->congestion.sendable(pPacket->size()))
+			break; // wait ack
+		TRACE("Stage ", pQueue->stageSending+1, " sent");
+		if (!RTMFP::Send(pSession->socket, *pPacket, address))
 			break;
-		}
-		--pSession->sendable;
 		pSession->sendTime = Time::Now();
 		pSession->sendByteRate += pPacket->size();
 		pSession->queueing -= pPacket->size();
 		pPacket->setSent();
+		pSession->congestion.sent(pPacket->sizeSent());
+		if (!pQueue->pSession)
+			pQueue->pSession = pSession;
 		pQueue->stageSending += pPacket->fragments;
 		pQueue->sending.emplace_back(pPacket);
 		pQueue->pop_front();
@@ -62,49 +182,128 @@ void RTMFPAcquiter::run() {
 		ERROR("stageAck ", _stageAck, " superior to sending stage ", pQueue->stageSending, " on writer ", pQueue->id);
 		_stageAck = pQueue->stageSending;
 	}
+	UInt32 acked(0);
+	auto ack = [this, &acked](Packet& packet, UInt64 stage) {
+		packet.acked = true;
+		acked += packet.sizeSent();
+		if (packet.sentTime < pQueue->ackedTime || (packet.sentTime == pQueue->ackedTime && stage < pQueue->ackedStage))
+			return;
+		pQueue->ackedTime = packet.sentTime;
+		pQueue->ackedStage = stage;
+	};
 	while (!pQueue->sending.empty() && _stageAck > pQueue->stageAck) {
-		pQueue->stageAck += pQueue->sending.front()->fragments;
+		Packet& packet(*pQueue->sending.front());
+		pQueue->stageAck += packet.fragments;
+		if (!packet.acked)
+			ack(packet, pQueue->stageAck);
 		pQueue->sending.pop_front();
-		pSession->sendable = RTMFP::SENDABLE_MAX; // has progressed, can send max!
 	}
+
+	// SACK, ranges of fragments received after _stageAck
+	BinaryReader reader(_ranges.data(), _ranges.size());
+	UInt64 stage(pQueue->stageAck); // last stage of the previous packet
+	UInt64 first(_stageAck), last;
+	auto it(pQueue->sending.begin());
+	while (reader.available()) {
+		first += reader.read7Bit<UInt64>(10) + 2; // holes-1
+		last = first + reader.read7Bit<UInt64>(10); // received-1
+		for (; it != pQueue->sending.end() && stage < last; ++it) {
+			Packet& packet(**it);
+			UInt64 end(stage + packet.fragments);
+			if (end >= first && !packet.acked)
+				ack(packet, end); // one fragment received means whole packet received
+			if (end > last)
+				break; // packet on the next range
+			stage = end;
+		}
+		first = last;
+	}
+	if (acked)
+		pSession->congestion.acked(acked); // has progressed, window grows and base run continues the sending
+
+	// RACK, packets sent before the most recent acknowledged one and not acknowledged after reordering delay are presumed lost
+	if (!pQueue->ackedTime)
+		return;
+	Int64 now(Time::Now());
+	UInt32 delay(pSession->congestion.lossDelay());
+	UInt64 abandonStage(0);
+	bool oneReliable(false), lost(false);
+	UInt32 sendable(0);
+	stage = pQueue->stageAck;
+	for (shared<Packet>& pPacket : pQueue->sending) {
+		stage += pPacket->fragments;
+		if (pPacket->acked || pPacket->sentTime > pQueue->ackedTime || (pPacket->sentTime == pQueue->ackedTime && stage > pQueue->ackedStage) || (now - pPacket->sentTime) < delay) {
+			if (pPacket->reliable)
+				oneReliable = true; // can't abandon beyond, receiver would drop it
+			continue;
+		}
+		if (!lost) {
+			pSession->congestion.lost();
+			// repeat at most one window of packets
+			sendable = max(pSession->congestion.window() / RTMFP::SIZE_PACKET, 1u);
+			lost = true;
+		}
+		if (!repeat(*pPacket, stage, abandonStage, oneReliable))
+			break;
+		if (pPacket->reliable && !--sendable)
+			break;
+	}
+	if (abandonStage)
+		sendAbandon(abandonStage);
 }
 
 void RTMFPRepeater::run() {
-	// REPEAT
-	bool oneReliable = false;
-	UInt64 abandonStage = 0;
-	UInt64 stage = pQueue->stageAck;
-	UInt8 sendable(RTMFP::SENDABLE_MAX);
+	// REPEAT on RTO
+	UInt64 abandonStage(0);
+	UInt64 stage(pQueue->stageAck);
+	bool oneReliable(false);
+	UInt32 sendable(0);
 	for (shared<Packet>& pPacket : pQueue->sending) {
-		DEBUG("Stage ", stage + 1, " repeated");
 		stage += pPacket->fragments;
-		if (pPacket->reliable) {
-			oneReliable = true;
-			if (abandonStage) {
-				sendAbandon(abandonStage);
-				abandonStage = 0;
-			}
-			if (!RTMFP::Send(pSession->socket, *pPacket, address)) {
-				pSession->sendable = 0; // pause sending!
-				break;
-			}
-			if (!--sendable)
-				break;
-		} else if (!oneReliable) {
-			abandonStage = stage;
-			pSession->sendLostRate += pPacket->sizeSent();
+		if (pPacket->acked) {
+			if (pPacket->reliable)
+				oneReliable = true; // can't abandon beyond, receiver would drop it
+			continue;
 		}
-		if (_fragments) {
-			if (pPacket->fragments >= _fragments)
-				break;
-			_fragments -= pPacket->fragments;
+		if (pPacket->reliable && !sendable) {
+			// congestion event, restart with minimum window and repeat at most one window of packets
+			pSession->congestion.timeout();
+			sendable = max(pSession->congestion.window() / RTMFP::SIZE_PACKET, 1u);
 		}
+		if (!repeat(*pPacket, stage, abandonStage, oneReliable))
+			break;
+		if (pPacket->reliable && !--sendable)
+			break;
 	}
 	if (abandonStage)
 		sendAbandon(abandonStage);
 }
 
-void RTMFPRepeater::sendAbandon(UInt64 stage) {
+bool RTMFPSender::repeat(Packet& packet, UInt64 stage, UInt64& abandonStage, bool& oneReliable) {
+	if (!packet.reliable) {
+		if (!oneReliable) {
+			// unreliable lost, abandon it
+			abandonStage = stage;
+			packet.acked = true;
+			pSession->sendLostRate += packet.sizeSent();
+			pSession->congestion.released(packet.sizeSent());
+		}
+		return true;
+	}
+	oneReliable = true;
+	if (abandonStage) {
+		sendAbandon(abandonStage);
+		abandonStage = 0;
+	}
+	DEBUG("Stage ", stage - packet.fragments + 1, " repeated");
+	if (!RTMFP::Send(pSession->socket, packet, address))
+		return false;
+	packet.setSent();
+	pSession->sendRepeatRate += packet.size();
+	return true;
+}
+
+void RTMFPSender::sendAbandon(UInt64 stage) {
 	shared<Buffer> pBuffer;
 	BinaryWriter writer(RTMFP::InitBuffer(pBuffer, pSession->initiatorTime()));
 	writer.write8(0x10).write16(2 + Binary::Get7BitSize<UInt64>(pQueue->id, 10) + Binary::Get7BitSize<UInt64>(stage, 10));
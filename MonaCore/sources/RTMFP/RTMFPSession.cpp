@@ -184,8 +184,10 @@ void RTMFPSession::init(const shared<RTMFP::Session>& pSession) {
 			return kill(flush.ping);
 
 		// PING
-		if (flush.ping >= 0)
+		if (flush.ping >= 0) {
 			peer.setPing(flush.ping);
+			_pSenderSession->congestion.rtt = max<UInt16>(peer.ping(), 1);
+		}
 
 		// KEEPALIVE
 		if (flush.keepalive)
@@ -202,10 +204,7 @@ void RTMFPSession::init(const shared<RTMFP::Session>& pSession) {
 				// ACK
 				BinaryReader reader(ack.data(), ack.size());
 				UInt64 stage(reader.read7Bit<UInt64>(10));
-				UInt32 lostCount(0);
-				if (reader.available())
-					lostCount += UInt32(reader.read7Bit<UInt64>(10)) + 1;
-				itWriter->second->acquit(stage, lostCount);
+				itWriter->second->acquit(stage, Packet(ack, reader.current(), reader.available()));
 			} else // FAIL
 				itWriter->second->fail("Writer rejected on session ", name());
 		}
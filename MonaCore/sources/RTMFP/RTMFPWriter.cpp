@@ -26,7 +26,7 @@ namespace Mona {
 
 
 RTMFPWriter::RTMFPWriter(UInt64 id, UInt64 flowId, const Binary& signature, RTMFP::Output& output) :
-		_repeatDelay(0), _output(output), _stageAck(0), _lostCount(0), _pQueue(SET, id, flowId, signature) {
+		_repeatDelay(0), _output(output), _stageAck(0), _pQueue(SET, id, flowId, signature) {
 }
 
 void RTMFPWriter::fail() {
@@ -35,7 +35,7 @@ void RTMFPWriter::fail() {
 
 	// clear resources excepting QoS to detect this lost flow of data
 	_stageAck = 0;
-	_repeatDelay = _lostCount = 0;
+	_repeatDelay = 0;
 	_pQueue.set(_output.resetWriter(_pQueue->id), _pQueue->flowId, _pQueue->signature);
 }
 
@@ -45,39 +45,24 @@ void RTMFPWriter::closing(Int32 code, const char* reason) {
 		newMessage(true); // Send a MESSAGE_END just in the case where the receiver has been created
 }
 
-void RTMFPWriter::acquit(UInt64 stageAck, UInt32 lostCount) {
-	TRACE("Ack ", stageAck, " on writer ", _pQueue->id," (lostCount=",lostCount,")");
+void RTMFPWriter::acquit(UInt64 stageAck, const Packet& ranges) {
+	TRACE("Ack ", stageAck, " on writer ", _pQueue->id, " (ranges=", ranges.size(), ")");
 	// have to continue to become consumed even if writer closed!
 	if (stageAck > _stageAck) {
 		// progress!
 		_stageAck = stageAck;
-		_lostCount = 0;
 		// reset repeat time on progression!
 		_repeatDelay = _output.rto();
 		_repeatTime.update();
-		// continue sending
-		_output.send(shared<RTMFPAcquiter>(SET, _pQueue, _stageAck));
-		return;
-	}
-	if (!lostCount) {
+	} else if (!ranges) {
 		DEBUG("Ack ", stageAck, " obsolete on writer ", _pQueue->id);
 		return;
 	}
-	if (lostCount > _lostCount) {
-		/// emulate ERTO-timeout=ping if lost infos =>
-		// repeating is caused by a gap in ack-range, it can be a packet lost or an non-ordering transfer
-		// to avoid a self-sustaining congestion repeated just the first missing packet if lost infos are present
-		// and just once time (raising=true, to emulate first RTMFP ERTO=ping), let do the trigger after
-		repeatMessages(_lostCount = lostCount);
-	}
+	// continue sending, and repeat just packets presumed lost from ack ranges (SACK)
+	_output.send(shared<RTMFPAcquiter>(SET, _pQueue, stageAck, ranges));
 }
 
-void RTMFPWriter::repeatMessages(UInt32 lostCount) {
-	if (lostCount) {
-		// means that there is something lost! We can start a repeation without wait end of current sending
-		_output.send(shared<RTMFPRepeater>(SET, _pQueue, lostCount>0xFF ? 0xFF : lostCount));
-		return;
-	}
+void RTMFPWriter::repeatMessages() {
 	if (!_pQueue.unique())
 		return; // wait next! is sending, wait before to repeat packets
 	// REPEAT!
@@ -0,0 +1,56 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/RTP_AAC.h"
+#include "Mona/Logs.h"
+
+using namespace std;
+
+namespace Mona {
+
+bool RTP_AAC::writeAudio(const Media::Audio::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite) {
+	if (tag.codec != Media::Audio::CODEC_AAC) {
+		ERROR("RTP_AAC profile supports only AAC audio codec");
+		return false;
+	}
+	if (writer.size() <= 12) { // After header (new RTP packet)
+		if (canWrite <= 4)
+			return true;
+		writer.write16(16); // AU-headers-length in bits
+		writer.write16(UInt16(reader.size() << 3)); // AU-size (13 bits) + AU-Index (3 bits) = 0, AU-size stays the full size on fragments
+		canWrite -= 4;
+	}
+	if (canWrite > reader.available())
+		canWrite = reader.available();
+	writer.write(reader.current(), canWrite);
+	reader.next(canWrite);
+	return true;
+}
+
+bool RTP_AAC::writeVideo(const Media::Video::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite) {
+	ERROR("RTP_AAC is an audio RTP profile and can't write any video frame");
+	return false;
+}
+
+void RTP_AAC::parse(UInt32 time, UInt8 extension, UInt16 lost, const Packet& packet, Media::Source& source) {
+	ERROR("RTP_AAC profile has no parsing ability implemented yet");
+}
+void RTP_AAC::flush(Media::Source& source) {}
+
+
+} // namespace Mona
@@ -34,61 +34,49 @@ bool RTP_H264::writeVideo(const Media::Video::Tag& tag, BinaryReader& reader, Bi
 		ERROR("RTP_H264 profile supports only H264 video codec");
 		return false;
 	}
-	if (canWrite < 3)
-		return true; // flush! require at less 3 bytes available to write
-	canWrite -= 2;
+	if (!reader.position())
+		_size = 0; // new frame
+	if (writer.size() > 12)
+		return true; // one NALU or fragment by packet (packetization-mode=1)
 
 	if (!_size) {
 		do {
-			if (!reader.available()) {
-				_size = 0;
+			if (!reader.available())
 				return true; // flush
-			}
 			_size = reader.read32();
 			if (_size > reader.available())
 				_size = reader.available();
 		} while (!_size);
-		--_size;
-		_type = reader.read8() & 0x1F;
-		/// NRI info => The value of NRI MUST be the  maximum of all the NAL units carried in the aggregation packet
-		// https://www.ietf.org/rfc/rfc3984.txt
-		// 6, 9, 10, 11 or 12 => NRI=00
-		// 5 (key), 7 or 8 (config) => NRI=11
-		// 1, 2 (inter) => NRI=10
-		// 3, 4 (inter) => NRI=01
-		if (tag.frame == Media::Video::FRAME_CONFIG || tag.frame == Media::Video::FRAME_KEY)
-			_type |= 0x60; // NRI=11
-		else if(tag.frame && tag.frame<Media::Video::FRAME_INFO)
-			_type |= 0x40; // NRI=10
+		_type = *reader.current();
 		_fragmentation = false;
 	}
 
-	if (!writer) {
-		// After header
-		if (_fragmentation || _size >= canWrite) {
-			// Fragmentation 
-			if (_size < canWrite)
-				canWrite = _size;
-			writer.write8((_type & 0x60) | 28); // FU-A => (F(0)|NRI(3)|FU-A(28))
-			writer.write8((_fragmentation ? 0 : 0x80) | (_size==canWrite ? 0x40 : 0) | (_type&0x1F)); // Start flag and End flag
-			writer.write(reader.current(), canWrite);
-			reader.next(canWrite);
-			_size -= canWrite;
-			_fragmentation = true;
-			return true;
-		}
-
-		// here 0<=_size<canWrite(>=1, so >=3) => aggregation maybe possible
-		writer.write8((_type & 0x60) | 24);// STAP-A => (F(0)|NRI(3)|STAP-A(24))			
-	} else if(_size > canWrite)  // End of aggregation, new nal in new packet!
+	if (!_fragmentation && _size <= canWrite) {
+		// Single NAL unit packet
+		writer.write(reader.current(), _size);
+		reader.next(_size);
+		_size = 0;
 		return true;
+	}
 
-	// aggregation, _size<canWrite
-	writer.write16(_size);
-	writer.write(reader.current(), _size);
-	reader.next(_size);
-	_size = 0;
-	return false; // no flush always
+	// Fragmentation FU-A
+	if (canWrite < 3)
+		return true; // requires at less 3 bytes available to write
+	if (!_fragmentation) {
+		// NALU header is replaced by FU indicator and FU header
+		reader.next(1);
+		--_size;
+	}
+	canWrite -= 2;
+	if (_size < canWrite)
+		canWrite = _size;
+	writer.write8((_type & 0xE0) | 28); // FU indicator => (F|NRI|FU-A(28))
+	writer.write8((_fragmentation ? 0 : 0x80) | (_size == canWrite ? 0x40 : 0) | (_type & 0x1F)); // Start flag, End flag and NALU type
+	writer.write(reader.current(), canWrite);
+	reader.next(canWrite);
+	_size -= canWrite;
+	_fragmentation = _size ? true : false;
+	return true;
 }
 
 void RTP_H264::parse(UInt32 time, UInt8 extension, UInt16 lost, const Packet& packet, Media::Source& source) {
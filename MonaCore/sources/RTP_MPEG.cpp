@@ -24,10 +24,10 @@ using namespace std;
 namespace Mona {
 
 bool RTP_MPEG::writeAudio(const Media::Audio::Tag& tag, BinaryReader& reader, BinaryWriter& writer, UInt16 canWrite) {
-	if (!writer) { // After header (new RTP packet)
-		if (canWrite < 4)
-			return false;
-		writer.write32(0); // Frag_offset 
+	if (writer.size() <= 12) { // After header (new RTP packet)
+		if (canWrite <= 4)
+			return true;
+		writer.write16(0).write16(reader.position()); // MBZ + Frag_offset
 		canWrite -= 4;
 	}
 
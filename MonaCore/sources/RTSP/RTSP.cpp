@@ -0,0 +1,162 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/RTSP/RTSP.h"
+#include "Mona/URL.h"
+#include "Mona/Session.h"
+
+using namespace std;
+
+
+namespace Mona {
+
+RTSP::Header::Header(const char* data, UInt32 size) : type(TYPE_UNKNOWN), cseq(0), contentLength(0) {
+	String::ForEach forEach([this](UInt32 index, const char* line) {
+		if (!index) {
+			// METHOD URL RTSP/1.0
+			const char* url(strchr(line, ' '));
+			if (!url || !(type = ParseType(line, url - line))) {
+				((Exception&)ex).set<Ex::Protocol>("Unknown RTSP request ", line);
+				return false;
+			}
+			String::TrimLeft(url);
+			const char* end(strchr(url, ' '));
+			if (!end || String::ICompare(end + 1, EXPAND("RTSP/")) != 0) {
+				((Exception&)ex).set<Ex::Protocol>("Invalid RTSP request line ", line);
+				return false;
+			}
+			this->url.assign(url, end - url);
+			string host;
+			size_t size(this->url.size());
+			const char* request = URL::Parse(this->url.data(), size, host);
+			request = URL::ParseRequest(request, size, path, REQUEST_FORCE_RELATIVE);
+			query.assign(request, size);
+			return true;
+		}
+		// Key: Value
+		const char* value(strchr(line, ':'));
+		if (!value)
+			return true; // ignore malformed field
+		String::Scoped scoped(value);
+		String::TrimLeft(++value);
+		value = setString(line, value).c_str();
+		if (String::ICompare(line, "cseq") == 0)
+			String::ToNumber(value, cseq);
+		else if (String::ICompare(line, "content-length") == 0)
+			String::ToNumber(value, contentLength);
+		else if (String::ICompare(line, "session") == 0)
+			session.assign(value, strcspn(value, ";")); // without ";timeout=..."
+		return true;
+	});
+	String::Split(data, size, "\r\n", forEach, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+	if (!ex && !type)
+		((Exception&)ex).set<Ex::Protocol>("Empty RTSP request");
+}
+
+RTSP::Transport::Transport(const char* value) : tcp(false), multicast(false), interleaved(false), channel(0), clientPort(0) {
+	String::ForEach forEach([this](UInt32 index, const char* field) {
+		if (!index) {
+			tcp = String::ICompare(field, "RTP/AVP/TCP") == 0;
+			return true;
+		}
+		if (String::ICompare(field, "multicast") == 0)
+			multicast = true;
+		else if (String::ICompare(field, EXPAND("interleaved=")) == 0)
+			interleaved = String::ToNumber(field + 12, strcspn(field + 12, "-"), channel);
+		else if (String::ICompare(field, EXPAND("client_port=")) == 0)
+			String::ToNumber(field + 12, strcspn(field + 12, "-"), clientPort);
+		return true;
+	});
+	String::Split(value, strcspn(value, ","), ";", forEach, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+}
+
+RTSP::Type RTSP::ParseType(const char* value, size_t size) {
+	switch (size) {
+		case 4:
+			if (String::ICompare(value, size, "PLAY") == 0)
+				return TYPE_PLAY;
+			break;
+		case 5:
+			if (String::ICompare(value, size, "SETUP") == 0)
+				return TYPE_SETUP;
+			if (String::ICompare(value, size, "PAUSE") == 0)
+				return TYPE_PAUSE;
+			break;
+		case 6:
+			if (String::ICompare(value, size, "RECORD") == 0)
+				return TYPE_RECORD;
+			break;
+		case 7:
+			if (String::ICompare(value, size, "OPTIONS") == 0)
+				return TYPE_OPTIONS;
+			break;
+		case 8:
+			if (String::ICompare(value, size, "DESCRIBE") == 0)
+				return TYPE_DESCRIBE;
+			if (String::ICompare(value, size, "TEARDOWN") == 0)
+				return TYPE_TEARDOWN;
+			if (String::ICompare(value, size, "ANNOUNCE") == 0)
+				return TYPE_ANNOUNCE;
+			break;
+		case 13:
+			if (String::ICompare(value, size, "GET_PARAMETER") == 0)
+				return TYPE_GET_PARAMETER;
+			if (String::ICompare(value, size, "SET_PARAMETER") == 0)
+				return TYPE_SET_PARAMETER;
+			break;
+	}
+	return TYPE_UNKNOWN;
+}
+
+const char* RTSP::TypeToString(Type type) {
+	switch (type) {
+		case TYPE_OPTIONS:			return "OPTIONS";
+		case TYPE_DESCRIBE:			return "DESCRIBE";
+		case TYPE_SETUP:			return "SETUP";
+		case TYPE_PLAY:				return "PLAY";
+		case TYPE_PAUSE:			return "PAUSE";
+		case TYPE_TEARDOWN:			return "TEARDOWN";
+		case TYPE_GET_PARAMETER:	return "GET_PARAMETER";
+		case TYPE_SET_PARAMETER:	return "SET_PARAMETER";
+		case TYPE_ANNOUNCE:			return "ANNOUNCE";
+		case TYPE_RECORD:			return "RECORD";
+		default: break;
+	}
+	return "UNKNOWN";
+}
+
+const char* RTSP::ErrorToCode(Int32 error) {
+	switch (error) {
+		case Session::ERROR_REJECTED:
+			return RTSP_CODE_401; // Unauthorized
+		case Session::ERROR_UNFOUND:
+			return RTSP_CODE_404; // Not Found
+		case Session::ERROR_PROTOCOL:
+			return RTSP_CODE_400; // Bad Request
+		case Session::ERROR_UNSUPPORTED:
+			return RTSP_CODE_501; // Not Implemented
+		case Session::ERROR_UNAVAILABLE:
+		case Session::ERROR_SERVER:
+			return RTSP_CODE_503; // Service unavailable
+		default:
+			return RTSP_CODE_500; // Internal server error
+	}
+}
+
+
+} // namespace Mona
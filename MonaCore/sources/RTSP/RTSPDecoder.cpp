@@ -0,0 +1,68 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/RTSP/RTSPDecoder.h"
+#include "Mona/Logs.h"
+
+using namespace std;
+
+namespace Mona {
+
+void RTSPDecoder::decode(shared<Buffer>& pBuffer, const SocketAddress& address, const shared<Socket>& pSocket) {
+	if (!addStreamData(Packet(pBuffer), pSocket->recvBufferSize(), *pSocket)) {
+		ERROR("RTSP message exceeds buffer maximum ", pSocket->recvBufferSize(), " size");
+		pSocket->shutdown(Socket::SHUTDOWN_RECV); // no more reception
+	}
+}
+
+UInt32 RTSPDecoder::onStreamData(Packet& buffer, Socket& socket) {
+	do {
+		if (!_pHeader) {
+			if (*buffer.data() == '$') {
+				// Interleaved binary data of client (RTCP receiver reports), ignored
+				if (buffer.size() < 4)
+					return buffer.size();
+				UInt32 size(4 + ((buffer.data()[2] << 8) | buffer.data()[3]));
+				if (buffer.size() < size)
+					return buffer.size();
+				buffer += size;
+				continue;
+			}
+			// Wait the end of header
+			const UInt8* end(buffer.data() + 3);
+			while (end < (buffer.data() + buffer.size()) && (*end != '\n' || memcmp(end - 3, EXPAND("\r\n\r\n")) != 0))
+				++end;
+			if (end >= (buffer.data() + buffer.size()))
+				return buffer.size();
+			UInt32 size(end + 1 - buffer.data());
+			DUMP_REQUEST("RTSP", buffer.data(), size, socket.peerAddress());
+			_pHeader.set(STR buffer.data(), size);
+			buffer += size;
+		}
+		// Content
+		if (buffer.size() < _pHeader->contentLength)
+			return buffer.size();
+		Packet content(buffer, buffer.data(), _pHeader->contentLength);
+		buffer += _pHeader->contentLength;
+		_handler.queue(onRequest, _pHeader, content);
+	} while (buffer);
+	return 0;
+}
+
+
+} // namespace Mona
@@ -0,0 +1,315 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+
+#include "Mona/RTSP/RTSPSession.h"
+#include "Mona/RTSP/RTSProtocol.h"
+#include "Mona/Util.h"
+
+using namespace std;
+
+namespace Mona {
+
+RTSPSession::RTSPSession(Protocol& protocol, const shared<Socket>& pSocket) : TCPSession(protocol, pSocket), _writer(self), _pSubscription(NULL), _waitKey(false), _playCSeq(0),
+	_onRequest([this](RTSP::Request& request) {
+		const RTSP::Header& header(*request);
+		if (header.ex) {
+			send(header, RTSP_CODE_400);
+			return kill(TO_ERROR(header.ex));
+		}
+		if (!_sessionId.empty() && !header.session.empty() && header.session != _sessionId)
+			return send(header, RTSP_CODE_454);
+		if (!_playURL.empty())
+			sendPlay(); // still waiting a key frame, answer PLAY before this new request
+
+		string stream;
+		UInt8 track;
+		parseURL(header, stream, track);
+
+		Exception ex;
+		if (!peer) {
+			// onConnection on the first request, application is the parent folder of the stream
+			peer.onConnection(ex, _writer, *self);
+			if (ex) {
+				send(header, RTSP::ErrorToCode(Session::ToError(ex)));
+				return kill(TO_ERROR(ex));
+			}
+		}
+
+		string fields;
+		switch (header.type) {
+			case RTSP::TYPE_OPTIONS:
+				return send(header, RTSP_CODE_200, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n");
+			case RTSP::TYPE_DESCRIBE:
+				if (!getStream(ex, stream))
+					break;
+				String::Append(fields, "Content-Base: ", header.url);
+				if (header.url.back() != '/')
+					fields += '/';
+				fields.append("\r\nContent-Type: application/sdp\r\n");
+				return send(header, RTSP_CODE_200, fields, _pStream->description);
+			case RTSP::TYPE_SETUP:
+				if (!processSetup(ex, header, stream, track, fields)) {
+					if (ex.cast<Ex::Unsupported>())
+						return send(header, RTSP_CODE_461);
+					break;
+				}
+				return send(header, RTSP_CODE_200, fields);
+			case RTSP::TYPE_PLAY:
+				if (!processPlay(ex, header))
+					break;
+				if (!_waitKey)
+					sendPlay(); // RTP-Info gives the next packet
+				// else response deferred to the first key packet
+				_pStream->join(self);
+				return;
+			case RTSP::TYPE_PAUSE:
+				if (_pStream)
+					_pStream->leave(self);
+				return send(header, RTSP_CODE_200);
+			case RTSP::TYPE_TEARDOWN:
+				stop();
+				send(header, RTSP_CODE_200);
+				_sessionId.clear();
+				return;
+			case RTSP::TYPE_GET_PARAMETER: // keepalive
+			case RTSP::TYPE_SET_PARAMETER:
+				return send(header, RTSP_CODE_200);
+			case RTSP::TYPE_ANNOUNCE:
+			case RTSP::TYPE_RECORD:
+				return send(header, RTSP_CODE_405, "Allow: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n");
+			default:
+				return send(header, RTSP_CODE_501);
+		}
+		WARN(name(), " ", RTSP::TypeToString(header.type), " ", header.url, ", ", ex);
+		send(header, RTSP::ErrorToCode(Session::ToError(ex)));
+	}) {
+}
+
+RTSPSession::~RTSPSession() {
+	if (_pSubscription)
+		delete _pSubscription;
+}
+
+Socket::Decoder* RTSPSession::newDecoder() {
+	RTSPDecoder* pDecoder = new RTSPDecoder(api.handler);
+	pDecoder->onRequest = _onRequest;
+	return pDecoder;
+}
+
+void RTSPSession::parseURL(const RTSP::Header& header, string& stream, UInt8& track) {
+	// rtsp://host/app/stream or rtsp://host/app/stream/trackID=<track>
+	Path path(header.path);
+	track = 0xFF;
+	if (String::ICompare(path.name(), EXPAND("trackID=")) == 0) {
+		if (!String::ToNumber(path.name().c_str() + 8, track))
+			track = 0xFF;
+		path.set(string(path.parent()));
+	}
+	stream = path.baseName();
+	if (!peer) {
+		peer.setPath(path.parent());
+		peer.setQuery(string(header.query));
+	}
+}
+
+bool RTSPSession::getStream(Exception& ex, const string& name) {
+	if (_pStream && _pStream->name == name && !_pStream->ended())
+		return true;
+	if (_pStream)
+		_pStream->leave(self);
+	return (_pStream = protocol<RTSProtocol>().stream(ex, name)) ? true : false;
+}
+
+bool RTSPSession::processSetup(Exception& ex, const RTSP::Header& header, const string& stream, UInt8 track, string& fields) {
+	if (!getStream(ex, stream))
+		return false;
+	if (track == 0xFF) {
+		// no control, take the single track of the stream
+		if (_pStream->hasTrack(RTSPStream::TRACK_VIDEO) == _pStream->hasTrack(RTSPStream::TRACK_AUDIO)) {
+			ex.set<Ex::Protocol>("SETUP without track control ", header.url);
+			return false;
+		}
+		track = _pStream->hasTrack(RTSPStream::TRACK_VIDEO) ? RTSPStream::TRACK_VIDEO : RTSPStream::TRACK_AUDIO;
+	} else if (!_pStream->hasTrack(track)) {
+		ex.set<Ex::Unfound>("Track ", track, " unfound in ", _pStream->name);
+		return false;
+	}
+
+	const char* value(header.getString("transport"));
+	if (!value) {
+		ex.set<Ex::Protocol>("SETUP without Transport");
+		return false;
+	}
+	RTSP::Transport proposal(value);
+	if (proposal.multicast || (!proposal.tcp && (!proposal.clientPort || !protocol<RTSProtocol>().udpPort()))) {
+		ex.set<Ex::Unsupported>("Transport ", value, " unsupported");
+		return false;
+	}
+	Transport transport;
+	transport.channel = proposal.interleaved ? proposal.channel : _pStream->channel(track);
+	UInt16 clientPort(proposal.clientPort);
+	if (proposal.tcp)
+		String::Append(fields, "Transport: RTP/AVP/TCP;unicast;interleaved=", transport.channel, '-', transport.channel + 1, "\r\n");
+	else {
+		transport.rtp.set(peer.address.host(), clientPort);
+		transport.rtcp.set(peer.address.host(), clientPort + 1);
+		UInt16 serverPort(protocol<RTSProtocol>().udpPort());
+		String::Append(fields, "Transport: RTP/AVP;unicast;client_port=", clientPort, '-', clientPort + 1, ";server_port=", serverPort, '-', serverPort + 1, "\r\n");
+	}
+	transport.setup = true;
+	_transports[track] = move(transport);
+
+	if (_sessionId.empty())
+		String::Append(_sessionId, Util::Random<UInt32>());
+	String::Append(fields, "Session: ", _sessionId, ";timeout=", protocol().getNumber<UInt32>("timeout"), "\r\n");
+	return true;
+}
+
+bool RTSPSession::processPlay(Exception& ex, const RTSP::Header& header) {
+	if (_sessionId.empty()) {
+		ex.set<Ex::Protocol>("PLAY before SETUP");
+		return false;
+	}
+	if (_pStream->ended() && !getStream(ex, _pStream->name))
+		return false; // publication stopped
+	if (!_pSubscription)
+		_pSubscription = new Subscription(_writer);
+	else
+		api.unsubscribe(peer, *_pSubscription);
+	if (!api.subscribe(ex, peer, _pStream->name, *_pSubscription, peer.query.c_str()))
+		return false;
+	_playCSeq = header.cseq;
+	_playURL = header.url;
+	if (_playURL.back() != '/')
+		_playURL += '/';
+	// start on a video key frame if video is played
+	_waitKey = _transports[RTSPStream::TRACK_VIDEO].setup;
+	return true;
+}
+
+void RTSPSession::sendPlay(const UInt8* rtp) {
+	string fields("Range: npt=0.000-\r\n");
+	bool first(true);
+	for (UInt8 track = 0; track < RTSPStream::TRACK_COUNT; ++track) {
+		if (!_transports[track].setup)
+			continue;
+		UInt16 sequence;
+		UInt32 time;
+		if (track == RTSPStream::TRACK_VIDEO) {
+			if (!rtp)
+				continue;
+			// first packet sent
+			BinaryReader reader(rtp + 2, 6);
+			sequence = reader.read16();
+			time = reader.read32();
+		} else if (_pStream->rtpInfo(track, sequence, time))
+			++sequence; // next packet
+		else
+			continue;
+		String::Append(fields, first ? "RTP-Info: " : ",", "url=", _playURL, "trackID=", track, ";seq=", sequence, ";rtptime=", time);
+		first = false;
+	}
+	if (!first)
+		fields.append("\r\n");
+	String::Append(fields, "Session: ", _sessionId, "\r\n");
+	send(_playCSeq, RTSP_CODE_200, fields);
+	_playURL.clear();
+}
+
+void RTSPSession::stop() {
+	if (_pStream)
+		_pStream->leave(self);
+	if (_pSubscription)
+		api.unsubscribe(peer, *_pSubscription);
+	for (Transport& transport : _transports)
+		transport = Transport();
+	_waitKey = false;
+	_playURL.clear();
+}
+
+void RTSPSession::send(UInt32 cseq, const char* code, const string& fields, const string& content) {
+	shared<Buffer> pBuffer(SET);
+	String::Append(*pBuffer, "RTSP/1.0 ", code, "\r\nCSeq: ", cseq, "\r\nServer: Mona\r\n", fields);
+	if (!content.empty())
+		String::Append(*pBuffer, "Content-Length: ", content.size(), "\r\n");
+	String::Append(*pBuffer, "\r\n", content);
+	Exception ex;
+	DUMP_RESPONSE(name(), pBuffer->data(), pBuffer->size(), peer.address);
+	AUTO_ERROR(TCPClient::send(ex, Packet(pBuffer)), name());
+}
+
+void RTSPSession::writeRTP(UInt8 track, const Packet& packet, bool isRTCP, bool isKey) {
+	Transport& transport(_transports[track]);
+	if (!transport.setup)
+		return;
+	if (_waitKey) {
+		if (!isKey)
+			return;
+		_waitKey = false;
+		if (!_playURL.empty())
+			sendPlay(packet.data() + 4); // after interleaved framing
+	}
+	Exception ex;
+	if (transport.rtp) {
+		// UDP, without interleaved framing
+		AUTO_WARN(protocol<RTSProtocol>().send(ex, Packet(packet, packet.data() + 4, packet.size() - 4), isRTCP ? transport.rtcp : transport.rtp, isRTCP), name());
+		return;
+	}
+	UInt8 channel(transport.channel + (isRTCP ? 1 : 0));
+	if (packet.data()[1] == channel) {
+		AUTO_ERROR(TCPClient::send(ex, packet), name());
+		return;
+	}
+	// client has chosen its interleaved channels, patch the framing
+	shared<Buffer> pBuffer(SET, packet.data(), packet.size());
+	pBuffer->data()[1] = channel;
+	AUTO_ERROR(TCPClient::send(ex, Packet(pBuffer)), name());
+}
+
+bool RTSPSession::manage() {
+	if (!TCPSession::manage())
+		return false;
+	// check subscription
+	if (_pSubscription) {
+		switch (_pSubscription->ejected()) {
+			case Subscription::EJECTED_NONE:
+				break;
+			case Subscription::EJECTED_BANDWITDH:
+				kill(ERROR_CONGESTED, String("Insufficient bandwidth to play ", _pSubscription->name()).c_str());
+				return false;
+			case Subscription::EJECTED_ERROR:
+				kill(ERROR_SOCKET);
+				return false;
+		}
+	}
+	return true;
+}
+
+void RTSPSession::kill(Int32 error, const char* reason) {
+	if (died)
+		return;
+	_onRequest = nullptr;
+	// delete subscription on RTSPSession destruction to avoid a crash if this kill is called by subscription itself!
+	stop();
+	_pStream.reset();
+	TCPSession::kill(error, reason);
+}
+
+
+} // namespace Mona
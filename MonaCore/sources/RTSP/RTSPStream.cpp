@@ -0,0 +1,176 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/RTSP/RTSPStream.h"
+#include "Mona/ServerAPI.h"
+#include "Mona/RTPWriter.h"
+#include "Mona/RTP_H264.h"
+#include "Mona/RTP_AAC.h"
+#include "Mona/RTP_MPEG.h"
+#include "Mona/AVC.h"
+#include "Mona/MPEG4.h"
+#include "Mona/SDP.h"
+
+using namespace std;
+
+namespace Mona {
+
+RTSPStream::RTSPStream(ServerAPI& api, const Publication& publication) : _api(api), name(publication.name()), _subscription(self), _keyFrame(false), _ended(false) {
+	SDP sdp;
+	sdp.sessionId = Util::Random<UInt32>();
+	sdp.sessionName = name;
+	sdp.attributes.emplace_back("control:*");
+	sdp.attributes.emplace_back("range:npt=0-");
+
+	// Video, first H264 track
+	if (publication.videos.size()) {
+		const Media::Video::Config& config = publication.videos.front().config;
+		if (config.codec == Media::Video::CODEC_H264) {
+			SDPMedia& media = *sdp.addMedia("video", 0, "RTP/AVP");
+			media.formats.emplace_back(96);
+			media.attributes.emplace_back("rtpmap:96 H264/90000");
+			string fmtp("fmtp:96 packetization-mode=1");
+			Packet sps, pps;
+			if (config && AVC::ParseVideoConfig(config, sps, pps)) {
+				if (sps.size() > 3)
+					String::Append(fmtp, ";profile-level-id=", String::Hex(sps.data() + 1, 3));
+				Util::ToBase64(sps.data(), sps.size(), fmtp.append(";sprop-parameter-sets="), true);
+				if (pps)
+					Util::ToBase64(pps.data(), pps.size(), fmtp.append(","), true);
+			} // else parameter sets in-band
+			media.attributes.emplace_back(move(fmtp));
+			media.attributes.emplace_back("control:trackID=0");
+			_tracks[TRACK_VIDEO].pWriter.set<RTPWriter<RTP_H264>>(96);
+		} else if (config.codec)
+			WARN("RTSP stream ", name, " doesn't support ", Media::Video::CodecToString(config.codec), " video");
+	}
+	// Audio, first AAC or MP3 track
+	if (publication.audios.size()) {
+		const Media::Audio::Config& config = publication.audios.front().config;
+		if (config.codec == Media::Audio::CODEC_AAC) {
+			UInt32 rate(config.rate);
+			UInt8 channels(config.channels);
+			UInt8 buffer[2];
+			Packet specific(config);
+			if (!config || !MPEG4::ReadAudioConfig(config.data(), config.size(), rate, channels))
+				specific.set(MPEG4::WriteAudioConfig(2, rate, channels, buffer), sizeof(buffer)); // AAC LC
+			SDPMedia& media = *sdp.addMedia("audio", 0, "RTP/AVP");
+			media.formats.emplace_back(97);
+			media.attributes.emplace_back(String("rtpmap:97 MPEG4-GENERIC/", rate, '/', channels));
+			media.attributes.emplace_back(String("fmtp:97 streamtype=5;profile-level-id=15;mode=AAC-hbr;sizelength=13;indexlength=3;indexdeltalength=3;config=", String::Hex(specific.data(), specific.size())));
+			media.attributes.emplace_back("control:trackID=1");
+			_tracks[TRACK_AUDIO].pWriter.set<RTPWriter<RTP_AAC>>(97);
+		} else if (config.codec == Media::Audio::CODEC_MP3) {
+			SDPMedia& media = *sdp.addMedia("audio", 0, "RTP/AVP");
+			media.formats.emplace_back(14); // static MPA playload type
+			media.attributes.emplace_back("rtpmap:14 MPA/90000");
+			media.attributes.emplace_back("control:trackID=1");
+			_tracks[TRACK_AUDIO].pWriter.set<RTPWriter<RTP_MPEG>>(14);
+		} else if (config.codec)
+			WARN("RTSP stream ", name, " doesn't support ", Media::Audio::CodecToString(config.codec), " audio");
+	}
+	sdp.build((string&)description);
+
+	// SDP medias are ordered by name (audio first), interleaved channels follow this order
+	UInt8 channel(0);
+	for (UInt8 track : { TRACK_AUDIO, TRACK_VIDEO }) {
+		Track& current(_tracks[track]);
+		if (!current)
+			continue;
+		current.channel = channel;
+		channel += 2;
+		current.onWrite = [this, track](const Packet& packet) {
+			Track& current(_tracks[track]);
+			// RTCP packet type 200 to 204 has to be distinguished of RTP marker + playload type, RFC 5761
+			bool isRTCP(packet.size() > 1 && packet.data()[1] >= 200 && packet.data()[1] <= 204);
+			bool isKey(false);
+			if (!isRTCP) {
+				BinaryReader reader(packet.data() + 2, packet.size() - 2);
+				current.sequence = reader.read16();
+				current.time = reader.read32();
+				current.sent = true;
+				isKey = track == TRACK_VIDEO && _keyFrame;
+				_keyFrame = false;
+			}
+			shared<Buffer> pBuffer(SET);
+			BinaryWriter(*pBuffer).write8('$').write8(current.channel + (isRTCP ? 1 : 0)).write16(packet.size()).write(packet.data(), packet.size());
+			Packet framed(pBuffer);
+			for (Viewer* pViewer : _viewers)
+				pViewer->writeRTP(track, framed, isRTCP, isKey);
+		};
+	}
+}
+
+RTSPStream::~RTSPStream() {
+	_api.unsubscribe(_subscription);
+}
+
+bool RTSPStream::start(Exception& ex) {
+	if (!_tracks[TRACK_VIDEO] && !_tracks[TRACK_AUDIO]) {
+		ex.set<Ex::Unsupported>("RTSP stream ", name, " has no track supported");
+		return false;
+	}
+	return _api.subscribe(ex, name, _subscription);
+}
+
+bool RTSPStream::rtpInfo(UInt8 track, UInt16& sequence, UInt32& time) const {
+	if (!hasTrack(track) || !_tracks[track].sent)
+		return false;
+	sequence = _tracks[track].sequence;
+	time = _tracks[track].time;
+	return true;
+}
+
+bool RTSPStream::beginMedia(const string& name) {
+	if (_ended)
+		return true; // a new publication requires a new stream (codecs can have changed)
+	for (Track& track : _tracks) {
+		if (track)
+			track.pWriter->beginMedia(track.onWrite);
+	}
+	return true;
+}
+
+bool RTSPStream::writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, bool reliable) {
+	// config is given by SDP
+	if (track == 1 && !tag.isConfig && !_ended && _tracks[TRACK_AUDIO])
+		_tracks[TRACK_AUDIO].pWriter->writeAudio(track, tag, packet, _tracks[TRACK_AUDIO].onWrite);
+	return true;
+}
+
+bool RTSPStream::writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, bool reliable) {
+	if (track != 1 || _ended || !_tracks[TRACK_VIDEO])
+		return true;
+	_keyFrame = tag.frame == Media::Video::FRAME_KEY;
+	_tracks[TRACK_VIDEO].pWriter->writeVideo(track, tag, packet, _tracks[TRACK_VIDEO].onWrite);
+	return true;
+}
+
+bool RTSPStream::endMedia() {
+	if (_ended)
+		return true;
+	for (Track& track : _tracks) {
+		if (track)
+			track.pWriter->endMedia(track.onWrite); // RTCP BYE
+	}
+	_ended = true;
+	return true;
+}
+
+
+} // namespace Mona
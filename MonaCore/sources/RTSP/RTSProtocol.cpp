@@ -0,0 +1,86 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+
+#include "Mona/RTSP/RTSProtocol.h"
+#include "Mona/ServerAPI.h"
+
+using namespace std;
+
+namespace Mona {
+
+RTSProtocol::RTSProtocol(const char* name, ServerAPI& api, Sessions& sessions) : TCProtocol(name, api, sessions), _rtp(api.ioSocket), _rtcp(api.ioSocket), _udpPort(0) {
+	setNumber("port", 554);
+	setNumber("timeout", 60); // RTSP session timeout
+	setNumber("udpPort", 6970); // RTP port, RTCP is on udpPort+1, 0 to disable UDP transport
+
+	_rtp.onError = _rtcp.onError = [this](const Exception& ex) { DEBUG("Protocol ", this->name, ", ", ex); }; // client port closed for example
+	_rtp.onPacket = _rtcp.onPacket = [](shared<Buffer>& pBuffer, const SocketAddress& address) {}; // RTCP receiver reports ignored
+
+	onConnection = [this](const shared<Socket>& pSocket) {
+		// Create session
+		this->sessions.create<RTSPSession>(self, pSocket).connect();
+	};
+}
+
+SocketAddress RTSProtocol::load(Exception& ex) {
+	UInt16 port(getNumber<UInt16>("udpPort"));
+	if (port) {
+		if (_rtp.bind(ex, SocketAddress(address.host(), port)) && _rtcp.bind(ex, SocketAddress(address.host(), port + 1))) {
+			initSocket(*_rtp);
+			initSocket(*_rtcp);
+			_udpPort = port;
+		} else {
+			WARN("Protocol ", name, " UDP transport disabled, ", ex);
+			_rtp.close();
+			_rtcp.close();
+			ex = nullptr;
+		}
+	}
+	return TCProtocol::load(ex);
+}
+
+void RTSProtocol::manage() {
+	auto it = _streams.begin();
+	while (it != _streams.end()) {
+		if (it->second.expired())
+			it = _streams.erase(it);
+		else
+			++it;
+	}
+}
+
+shared<RTSPStream> RTSProtocol::stream(Exception& ex, const string& name) {
+	weak<RTSPStream>& wStream(_streams[name]);
+	shared<RTSPStream> pStream(wStream.lock());
+	if (pStream && !pStream->ended())
+		return pStream;
+	const auto& it = api.publications().find(name);
+	if (it == api.publications().end() || !it->second.publishing()) {
+		ex.set<Ex::Unfound>("Publication ", name, " unfound");
+		return nullptr;
+	}
+	pStream.set(api, it->second);
+	if (!pStream->start(ex))
+		return nullptr;
+	wStream = pStream;
+	return pStream;
+}
+
+
+} // namespace Mona
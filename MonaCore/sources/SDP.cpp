@@ -245,8 +245,45 @@ bool SDP::build(Exception& ex, const char* text) {
 	return String::Split(text, "\r\n", forEach, SPLIT_IGNORE_EMPTY | SPLIT_TRIM)!=string::npos;
 }
 
-void SDP::build() {
-	// TODO
+string& SDP::build(string& text) const {
+	const char* addressType(unicastAddress.family() == IPAddress::IPv6 ? "IP6" : "IP4");
+	String::Append(text, "v=", version, "\r\n");
+	String::Append(text, "o=", user.empty() ? "-" : user, ' ', sessionId, ' ', sessionVersion, " IN ", addressType, ' ', unicastAddress, "\r\n");
+	String::Append(text, "s=", sessionName.empty() ? " " : sessionName, "\r\n");
+	if (!sessionInfos.empty())
+		String::Append(text, "i=", sessionInfos, "\r\n");
+	if (!uri.empty())
+		String::Append(text, "u=", uri, "\r\n");
+	if (!email.empty())
+		String::Append(text, "e=", email, "\r\n");
+	if (!phone.empty())
+		String::Append(text, "p=", phone, "\r\n");
+	String::Append(text, "c=IN ", addressType, ' ', IPAddress::Wildcard(unicastAddress.family()), "\r\n");
+	text.append(EXPAND("t=0 0\r\n"));
+	if (!encryptKey.empty())
+		String::Append(text, "k=", encryptKey, "\r\n");
+	for (const auto& it : groups) {
+		String::Append(text, "a=group:", it.first);
+		for (const string& value : it.second)
+			String::Append(text, ' ', value);
+		text.append(EXPAND("\r\n"));
+	}
+	if (!iceUFrag.empty())
+		String::Append(text, "a=ice-ufrag:", iceUFrag, "\r\n");
+	if (!icePwd.empty())
+		String::Append(text, "a=ice-pwd:", icePwd, "\r\n");
+	for (const string& attribute : attributes)
+		String::Append(text, "a=", attribute, "\r\n");
+
+	for (const auto& it : _medias) {
+		String::Append(text, "m=", it.first, ' ', it.second->port, ' ', it.second->codec);
+		for (UInt8 format : it.second->formats)
+			String::Append(text, ' ', format);
+		text.append(EXPAND("\r\n"));
+		for (const string& attribute : it.second->attributes)
+			String::Append(text, "a=", attribute, "\r\n");
+	}
+	return text;
 }
 
 
@@ -43,6 +43,47 @@ size_t Segment::ReadName(const string& name, UInt32& sequence, UInt16& duration)
 
 
 
+Segment::Record::Record(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) : _packet(move(packet)), // keep the buffer received, no copy
+	_type(Media::TYPE_AUDIO), _track(track), _codec(tag.codec), _info(tag.channels), _isConfig(tag.isConfig), _time(tag.time), _rate(tag.rate) {
+}
+Segment::Record::Record(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) : _packet(move(packet)),
+	_type(Media::TYPE_VIDEO), _track(track), _codec(tag.codec), _info(tag.frame), _isConfig(tag.frame == Media::Video::FRAME_CONFIG), _time(tag.time), _rate(tag.compositionOffset) {
+}
+Segment::Record::Record(Media::Data::Type type, const Packet& packet, UInt8 track, bool isProperties) : _packet(move(packet)),
+	_type(Media::TYPE_DATA), _track(track), _codec(type), _info(isProperties), _isConfig(false), _time(0), _rate(0) {
+}
+Segment::Record::Record(const Record& other) : _packet(move(other._packet)), // share the buffer
+	_type(other._type), _track(other._track), _codec(other._codec), _info(other._info), _isConfig(other._isConfig), _time(other._time), _rate(other._rate) {
+}
+Segment::Record::Record(Record&& other) noexcept : _packet(move(other._packet)),
+	_type(other._type), _track(other._track), _codec(other._codec), _info(other._info), _isConfig(other._isConfig), _time(other._time), _rate(other._rate) {
+}
+
+void Segment::Record::write(Media::Source& source) const {
+	switch (_type) {
+		case Media::TYPE_AUDIO: {
+			Media::Audio::Tag tag((Media::Audio::Codec)_codec);
+			tag.time = _time;
+			tag.rate = _rate;
+			tag.channels = _info;
+			tag.isConfig = _isConfig;
+			return source.writeAudio(tag, _packet, _track);
+		}
+		case Media::TYPE_VIDEO: {
+			Media::Video::Tag tag((Media::Video::Codec)_codec);
+			tag.time = _time;
+			tag.frame = Media::Video::Frame(_info);
+			tag.compositionOffset = UInt16(_rate);
+			return source.writeVideo(tag, _packet, _track);
+		}
+		default:
+			if (_info) // isProperties
+				return source.addProperties(_track, Media::Data::Type(_codec), _packet);
+			source.writeData(Media::Data::Type(_codec), _packet, _track);
+	}
+}
+
+
 bool Segment::add(UInt32 time) {
 	if (!_pFirstTime) {
 		_pFirstTime.set(_lastTime = time);
@@ -16,12 +16,59 @@ details (or else see http://mozilla.org/MPL/2.0/).
 
 #include "Mona/Segments.h"
 #include "Mona/FileWriter.h"
+#include "Mona/Subscription.h"
+#include "Mona/TSWriter.h"
 #include "Mona/Util.h"
 
 using namespace std;
 
 namespace Mona {
 
+static Metrics::Gauge SegmentsMemory("mona_segments_memory_bytes", "Media bytes of closed live segments retained in memory");
+static Metrics::Gauge SegmentsSpilled("mona_segments_spilled_bytes", "Media bytes of closed live segments spilled on disk (DVR mode)");
+
+// DVR mode, accessed just by the server thread
+static IOFile*	_PSpillIO(NULL);
+static string	_SpillDirectory;
+static UInt64	_SpillBudget(0);
+static UInt32	_Spills(0); // to get a unique file name by spilled segment
+
+/*!
+Serialize a segment in TS, as HTTPSegmentSender does it for a segment request */
+struct SegmentSerializer : private Media::Target, virtual Object {
+	SegmentSerializer(const Segment& segment, Buffer& buffer) : _subscription(self),
+		_onWrite([&buffer](const Packet& packet) { buffer.append(packet.data(), packet.size()); }) {
+		for (const Segment::Record& media : segment) {
+			_lastTime = media.time(); // fix time (have to be strictly absolute, subscription is on a isolated segment)
+			media.write(_subscription);
+		}
+		_subscription.reset();
+	}
+private:
+	bool beginMedia(const string& name) override { _writer.beginMedia(_onWrite); return true; }
+	bool writeProperties(const Media::Properties& properties) override { _writer.writeProperties(properties, _onWrite); return true; }
+	bool writeAudio(UInt8 track, const Media::Audio::Tag& tag, const Packet& packet, bool reliable) override { _writer.writeAudio(track, Media::Audio::Tag(tag, _lastTime), packet, _onWrite); return true; }
+	bool writeVideo(UInt8 track, const Media::Video::Tag& tag, const Packet& packet, bool reliable) override { _writer.writeVideo(track, Media::Video::Tag(tag, _lastTime), packet, _onWrite); return true; }
+	bool writeData(UInt8 track, Media::Data::Type type, const Packet& packet, bool reliable) override { _writer.writeData(track, type, packet, _onWrite); return true; }
+	bool endMedia() override { _writer.endMedia(_onWrite); return true; }
+
+	TSWriter				_writer;
+	MediaWriter::OnWrite	_onWrite;
+	UInt32					_lastTime;
+	Subscription			_subscription;
+};
+
+void Segments::EnableSpill(IOFile& io, const Path& directory, UInt64 budget) {
+	_PSpillIO = &io;
+	_SpillDirectory = directory;
+	FileSystem::MakeFolder(_SpillDirectory);
+	_SpillBudget = budget;
+}
+
+void Segments::DisableSpill() {
+	_SpillBudget = 0;
+}
+
 bool Segments::Init(Exception& ex, IOFile& io, Playlist& playlist, bool append) {
 	playlist.reset();
 
@@ -207,11 +254,20 @@ void Segments::Writer::writeVideo(UInt8 track, const Media::Video::Tag& tag, con
 
 /// SEGMENTS //////
 
-Segments::Segments(UInt8 maxSegments) : _started(false), _duration(0), _maxSegments(maxSegments), _sequence(0), _writer(self) {
+Segments::Segments(UInt16 maxSegments) : _started(false), _duration(0), _maxSegments(maxSegments), _sequence(0), _writer(self) {
 	init();
 }
 Segments::Segments(Segments&& segments) : _started(false), _duration(segments._duration), _maxSegments(segments._maxSegments), _sequence(segments._sequence), _writer(self) {
 	init();
+	// cancel spillings in progress (callbacks are on the moved object), segments stay in memory
+	for (auto& it : segments._spillings) {
+		UInt32 size = segments._segments[it.first - segments._sequence].size();
+		SegmentsSpilled -= size;
+		SegmentsMemory += size;
+		if (_SpillBudget)
+			it.second.erase();
+	}
+	segments._spillings.clear(); // unsubscribe (events deleted)
 	segments._sequence += segments.count();
 	segments._duration = 0;
 	_segments = std::move(segments._segments);
@@ -223,22 +279,87 @@ void Segments::init() {
 		_segment.add(_segment.time() + duration);
 		_duration += duration;
 		_segments.emplace_back(move(_segment));
+		// one contiguous allocation by segment: exact size for the closed one, and the next one reserved with the same count
+		_segments.back()._medias.shrink_to_fit();
+		_segment.reserve(_segments.back().count());
+		SegmentsMemory += _segments.back().size();
 		setMaxSegments(_maxSegments); // clean segments
+		spill();
 		onSegment(duration);
 	};
 }
 
-UInt8 Segments::setMaxSegments(UInt8 maxSegments) {
+Segments::~Segments() {
+	UInt32 sequence = _sequence;
+	for (Segment& segment : _segments)
+		release(segment, sequence++);
+}
+
+UInt16 Segments::setMaxSegments(UInt16 maxSegments) {
 	// erase obsolete segments (keep one more if maxDuration not reached)
-	UInt32 maxDuration = maxSegments * this->maxDuration();
+	UInt32 maxDuration = UInt32(maxSegments) * this->maxDuration();
 	while (_segments.size() > (maxSegments+1u) || _duration > maxDuration) {
-		++_sequence; // increments just on remove
 		_duration -= _segments.front().duration();
+		release(_segments.front(), _sequence++); // increments just on remove
 		_segments.pop_front();
 	}
 	return _maxSegments = maxSegments;;
 }
 
+void Segments::spill() {
+	if (!_SpillBudget)
+		return;
+	// spill the oldest segments in memory while budget is exceeded, except the last one (live edge, the more requested)
+	UInt32 sequence = _sequence;
+	for (auto it = _segments.begin(); (it + 1) < _segments.end() && SegmentsMemory() > Int64(_SpillBudget); ++it, ++sequence) {
+		Segment& segment = *it;
+		if (!segment.count() || _spillings.count(sequence))
+			continue; // already spilled or spilling
+		shared<Buffer> pBuffer(SET);
+		SegmentSerializer serializer(segment, *pBuffer);
+		// open before to assign events to ignore the immediate onFlush call
+		FileWriter& writer = _spillings.emplace(SET, forward_as_tuple(sequence), forward_as_tuple(*_PSpillIO)).first->second;
+		writer.open(Path(_SpillDirectory, _Spills++, ".ts")).write(Packet(pBuffer));
+		writer.onError = [this, sequence](const Exception& ex) {
+			WARN("Segment ", sequence, " spilling, ", ex); // stays in memory
+			UInt32 size = _segments[sequence - _sequence].size();
+			SegmentsSpilled -= size;
+			SegmentsMemory += size;
+			const auto& it = _spillings.find(sequence);
+			if (_SpillBudget)
+				it->second.erase();
+			_spillings.erase(it);
+		};
+		writer.onFlush = [this, sequence](bool deletion) {
+			// written => evict medias from memory
+			const auto& it = _spillings.find(sequence);
+			Segment& segment = _segments[sequence - _sequence];
+			segment._spill = it->second->path();
+			segment._medias.clear();
+			segment._medias.shrink_to_fit();
+			_spillings.erase(it);
+		};
+		// count it as spilled from now, to not exceed the budget on disk writing latency
+		SegmentsMemory -= segment.size();
+		SegmentsSpilled += segment.size();
+	}
+}
+
+void Segments::release(Segment& segment, UInt32 sequence) {
+	const auto& it = _spillings.find(sequence);
+	if (it != _spillings.end()) {
+		SegmentsSpilled -= segment.size();
+		if (_SpillBudget)
+			it->second.erase(); // after writing (same file)
+		_spillings.erase(it); // unsubscribe (events deleted)
+	} else if (segment.spill()) {
+		SegmentsSpilled -= segment.size();
+		if (_SpillBudget)
+			FileWriter::Erase(segment.spill(), *_PSpillIO); // asynchronous deletion!
+	} else
+		SegmentsMemory -= segment.size();
+}
+
 bool Segments::beginMedia(const string& name) {
 	// can be called multiple time, just do a _writer.endMedia() on double call
 	if (_started)
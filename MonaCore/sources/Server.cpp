@@ -19,6 +19,8 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/Server.h"
 #include "Mona/BufferPool.h"
 #include "Mona/MediaLogs.h"
+#include "Mona/Session.h"
+#include "Mona/Metrics.h"
 
 using namespace std;
 
@@ -26,7 +28,7 @@ using namespace std;
 namespace Mona {
 
 
-Server::Server(UInt16 cores) : Thread("Server"), ServerAPI(_www, _publications, _handler, _protocols, _timer, cores), _protocols(*this) {
+Server::Server(UInt16 cores) : Thread("Server"), ServerAPI(_www, _publications, _handler, _protocols, _timer, cores), _protocols(*this), _pullTimeout(30) {
 	DEBUG(threadPool.threads(), " threads in server threadPool");
 }
  
@@ -58,8 +60,25 @@ Parameters& Server::start(const Parameters& parameters) {
 }
 
 bool Server::run(Exception&, const volatile bool& requestStop) {
+	Metrics::Trace::Rate = getNumber<UInt32, 0>("traceRate");
 	if (getBoolean<true>("poolBuffers"))
 		Buffer::Allocator::Set<BufferPool>();
+	Buffer::Tag::Enable(getBoolean<false>("bufferTags"));
+	// mapped files cache budget in MB, disabled by default (a file truncated by an other process while read from its mapping raises SIGBUS)
+	ioFile.cache.setBudget(UInt64(getNumber<UInt32, 0>("fileCache")) * 0x100000);
+	// DVR, memory budget in MB of the live segments before to spill them on disk
+	UInt32 segmentsBudget = getNumber<UInt32, 0>("segmentsBudget");
+	if (segmentsBudget) {
+		Exception ex;
+		// spilled files in a subfolder owned by the server, to clean files of a previous run without touching other files of segmentsDir
+		string directory(FileSystem::MakeFolder(getString("segmentsDir", "dvr/")).append("spill/"));
+		if (FileSystem::Exists(directory))
+			AUTO_WARN(FileSystem::Delete(ex, directory, FileSystem::MODE_HEAVY), "Segments spill directory cleaning");
+		if (FileSystem::CreateDirectory(ex, directory, FileSystem::MODE_HEAVY))
+			Segments::EnableSpill(ioFile, directory, UInt64(segmentsBudget) * 0x100000);
+		else
+			ERROR("Segments directory creation, ", ex);
+	}
 
 	{ // encapsulate Sessions
 		Sessions sessions;
@@ -80,6 +99,15 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 				WARN("No TLS/SSL server protocols, no ", key.name(), " file")
 			else
 				AUTO_ERROR(TLS::Create(ex = nullptr, cert, key, pTLSServer), "SSL Server");
+			if (pTLSServer) {
+				// resumption to avoid full handshakes on reconnection
+				pTLSServer->setSessionCache(getNumber<UInt32, 0x4000>("TLS.sessionCache"), getNumber<UInt32, 300>("TLS.sessionTimeout"));
+				pTLSServer->setTicketRotation(getNumber<UInt32, 3600>("TLS.ticketRotation"));
+				// SNI certificates
+				const char* certificates = getString("TLS.certificates");
+				if (certificates && *certificates)
+					AUTO_WARN(pTLSServer->loadCertificates(ex = nullptr, Path(MAKE_FOLDER(certificates))) || !ex, "SNI certificates");
+			}
 
 			UInt32 countClient(0);
 			
@@ -90,6 +118,59 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 			// Start streams after onStart to get onPublish/onSubscribe permissions!
 			loadIniStreams();
 
+			// Federation, origins to pull a publication unfound
+			const char* origins = getString("federation.origins");
+			if (origins)
+				String::Split(origins, ",", _origins, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+			_pullTimeout = getNumber<UInt32, 30>("federation.idleTimeout");
+			if (!_origins.empty())
+				INFO("Federation edge with ", _origins.size(), " origins");
+
+			// Load balancing, after protocols start to report their public addresses
+			AUTO_ERROR(balancer.start(ex = nullptr, self), "Balancer");
+
+			// Metrics of the server state, Metrics::Write is called on this thread (HTTP metrics path, Lua mona:metrics())
+			Metrics::Collector metrics([&](Metrics::Writer& writer) {
+				map<string, UInt32, String::IComparator> counts;
+				for (const auto& it : _protocols)
+					counts[it.first];
+				for (const auto& it : sessions)
+					++counts[it.second->protocol().name];
+				string label;
+				for (const auto& it : counts)
+					writer.write(Metrics::Metric::TYPE_GAUGE, "mona_sessions", "Sessions by protocol", String("protocol=\"", Metrics::Writer::Escape(it.first.c_str(), label), '"').c_str(), it.second);
+				writer.write(Metrics::Metric::TYPE_GAUGE, "mona_clients", "Clients connected", NULL, clients.size());
+
+				vector<String> labels;
+				labels.reserve(_publications.size());
+				for (const auto& it : _publications)
+					labels.emplace_back("publication=\"", Metrics::Writer::Escape(it.first.c_str(), label), '"');
+				UInt32 i(0);
+				for (const auto& it : _publications)
+					writer.write(Metrics::Metric::TYPE_GAUGE, "mona_publication_ingress_bytes_per_second", "Publication ingress byte rate", labels[i++].c_str(), it.second.byteRate());
+				i = 0;
+				for (const auto& it : _publications)
+					writer.write(Metrics::Metric::TYPE_GAUGE, "mona_publication_egress_bytes_per_second", "Publication byte rate distributed to subscriptions", labels[i++].c_str(), it.second.egressByteRate());
+				i = 0;
+				for (const auto& it : _publications)
+					writer.write(Metrics::Metric::TYPE_GAUGE, "mona_publication_lost_rate", "Publication ingress lost rate", labels[i++].c_str(), it.second.lostRate());
+				i = 0;
+				for (const auto& it : _publications)
+					writer.write(Metrics::Metric::TYPE_GAUGE, "mona_publication_subscriptions", "Publication subscriptions", labels[i++].c_str(), it.second.subscriptions.size());
+				// latencies by stage of the media traced (traceRate)
+				i = 0;
+				String stageLabels;
+				for (const auto& it : _publications) {
+					const String& publicationLabels(labels[i++]);
+					for (UInt8 stage = 0; stage < Publication::STAGE_COUNT; ++stage) {
+						const Metrics::Samples* pLatencies = it.second.latencies(Publication::Stage(stage));
+						if (!pLatencies)
+							break;
+						pLatencies->write(writer, "mona_publication_latency_seconds", "Publication latency by stage of the media traced", String::Assign(stageLabels, publicationLabels, ",stage=\"", Publication::StageToString(Publication::Stage(stage)), '"').c_str());
+					}
+				}
+			});
+
 			onManage = ([&](UInt32) {
 				sessions.manage(); // in first to detect session useless died
 				_protocols.manage(); // manage custom protocol manage (resource protocols)
@@ -113,6 +194,7 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 					else
 						it.first->start(self);
 				}
+				managePulls();
 
 				this->onManage(); // client manage (script, etc..)
 				if (clients.size() != countClient)
@@ -137,6 +219,7 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 	#endif
 		// Stop onManage (useless now)
 		_timer.set(onManage, 0);
+		balancer.stop();
 
 		// do a handler flush here too because few MediaStream like MediaLogger can have tasks to do after 
 		_handler.flush();
@@ -148,6 +231,8 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 				unsubscribe(*it.second);
 		}
 		_iniStreams.clear(); // before onStop because MediaStream::onDelete can call unpublish!
+		_pulls.clear(); // before onStop for the same reason
+		_origins.clear();
 		// unsubscribe streamSubscriptions  => before onStop to get onUnsubscribe event before onStop!
 		for (const auto& it : _streamSubscriptions)
 			unsubscribe(*it.second);
@@ -163,6 +248,8 @@ bool Server::run(Exception&, const volatile bool& requestStop) {
 	// stop socket sending (it waits the end of sending last session messages)
 	threadPool.join();
 
+	// stop to spill segments on disk before to finish writing file
+	Segments::DisableSpill();
 	// finish writing file before to detach buffer allocator
 	ioFile.join();
 
@@ -249,6 +336,61 @@ void Server::loadIniStreams() {
 	}
 }
 
+void Server::pull(Publication& publication) {
+	if (_origins.empty() || !running())
+		return;
+	auto it = _pulls.lower_bound(publication.name());
+	if (it != _pulls.end() && it->first == publication.name())
+		return; // already pulling, one upstream for all the subscribers
+	it = _pulls.emplace_hint(it, SET, forward_as_tuple(publication.name()), forward_as_tuple());
+	if (!upstream(it->first, it->second))
+		_pulls.erase(it);
+}
+
+bool Server::upstream(const string& publication, Pull& pull) {
+	string description(_origins[pull.origin]);
+	size_t found(0);
+	while ((found = description.find('*', found)) != string::npos) {
+		description.replace(found, 1, publication);
+		found += publication.size();
+	}
+	pull.pStream = stream(publication, description, true);
+	if (!pull.pStream)
+		return false;
+	pull.pStream->start(self);
+	return true;
+}
+
+void Server::managePulls() {
+	auto it = _pulls.begin();
+	while (it != _pulls.end()) {
+		Pull& pull = it->second;
+		const auto& itPublication = _publications.find(it->first);
+		if (itPublication == _publications.end() || itPublication->second.subscriptions.empty()) {
+			if (!pull.idleTime)
+				pull.idleTime = Time::Now();
+			else if ((Time::Now() - pull.idleTime) >= (_pullTimeout * 1000ll)) {
+				INFO("Federation releases ", pull.pStream->description, " without subscriber");
+				it = _pulls.erase(it); // unpublish
+				continue;
+			}
+		} else
+			pull.idleTime = 0;
+		if (pull.pStream->state() != MediaStream::STATE_RUNNING && pull.pStream->ex && _origins.size() > 1) {
+			// origin fails, try the next one
+			WARN("Federation, ", pull.pStream->description, " fails, try next origin");
+			pull.pStream.reset(); // unpublish before to publish again
+			pull.origin = (pull.origin + 1) % _origins.size();
+			if (!upstream(it->first, pull)) {
+				it = _pulls.erase(it);
+				continue;
+			}
+		} else
+			pull.pStream->start(self); // pulse
+		++it;
+	}
+}
+
 shared<MediaStream> Server::stream(const string& publication, const string& description, bool isSource) {
 	shared<MediaStream> pStream;
 	if(isSource) { // is source
@@ -29,7 +29,7 @@ namespace Mona {
 
 ServerAPI::ServerAPI(std::string& www, map<string, Publication>& publications, const Handler& handler, const Protocols& protocols, const Timer& timer, UInt16 cores) :
 	www(www), _publications(publications), threadPool(cores), protocols(protocols), timer(timer), handler(handler),
-	ioSocket(handler, threadPool), ioFile(handler, threadPool, cores), clients(), resources(timer) {
+	ioSocket(handler, threadPool), ioFile(handler, threadPool, cores), clients(), resources(timer), dnsResolver(ioSocket, timer), balancer(self) {
 	resources.onCreate = [](const string& name, const string& type, UInt32 lifeTime) {
 		INFO("New ", name , ' ', type, " resource alive during ", lifeTime, "ms");
 	};
@@ -224,6 +224,8 @@ bool ServerAPI::subscribe(Exception& ex, const string& stream, Subscription& sub
 		unsubscribe(subscription, subscription.pPublication, pClient);
 		subscription.pPublication = &publication; // do next!
 	};
+	if (!it->second.publishing())
+		pull(it->second);
 	return true;
 }
 
@@ -20,11 +20,17 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/Publication.h"
 #include "Mona/Util.h"
 #include "Mona/Logs.h"
+#include "Mona/Metrics.h"
 
 using namespace std;
 
 namespace Mona {
 
+static Metrics::Counter AudioDrops("mona_subscription_dropped_total", "Media packets dropped by subscriptions (insufficient bandwidth or key frame waiting)", "type=\"audio\"");
+static Metrics::Counter VideoDrops("mona_subscription_dropped_total", "Media packets dropped by subscriptions (insufficient bandwidth or key frame waiting)", "type=\"video\"");
+static Metrics::Counter DataDrops("mona_subscription_dropped_total", "Media packets dropped by subscriptions (insufficient bandwidth or key frame waiting)", "type=\"data\"");
+static Metrics::Counter Ejections("mona_subscription_ejected_total", "Subscriptions ejected for insufficient bandwidth");
+
 bool Subscription::MediaTrack::setLastTime(UInt32 time) {
 	if (_started && Util::Distance(lastTime, time) < 0) {
 		WARN("Non-monotonic ", typeid(self) == typeid(MediaTrack) ? "audio" : "video", " time ", time, ", packet ignored");
@@ -417,11 +423,13 @@ void Subscription::writeData(Media::Data::Type type, const Packet& packet, UInt8
 	if (congestion) {
 		if (_datas.reliable || congestion>=Net::RTO_MAX) {
 			_ejected = EJECTED_BANDWITDH;
+			++Ejections;
 			WARN(TypeOf(_target), " data timeout, insufficient bandwidth to play ", name());
 			return;
 		}
 		// if data is unreliable, drop the packet
 		++_datas.dropped;
+		++DataDrops;
 		WARN(TypeOf(_target), " data packet dropped, insufficient bandwidth to play ", name());
 		return;
 	}
@@ -453,12 +461,14 @@ void Subscription::writeAudio(const Media::Audio::Tag& tag, const Packet& packet
 	if (congestion) {
 		if (_audios.reliable || congestion>=Net::RTO_MAX) {
 			_ejected = EJECTED_BANDWITDH;
+			++Ejections;
 			WARN(TypeOf(_target), " audio timeout, insufficient bandwidth to play ", name());
 			return;
 		}
 		if (!tag.isConfig) {
 			// if it's not config packet and audio is unreliable, drop the packet
 			++_audios.dropped;
+			++AudioDrops;
 			WARN(TypeOf(_target), " audio packet dropped, insufficient bandwidth to play ", name());
 			return;
 		}
@@ -507,6 +517,7 @@ void Subscription::writeVideo(const Media::Video::Tag& tag, const Packet& packet
 		} else if(pVideo && pVideo->waitKeyFrame) {
 			_medias.clear(); // remove audio between two inter frames
 			++_videos.dropped;
+			++VideoDrops;
 			if (pVideo->waitKeyFrame > 1)
 				return;
 			pVideo->waitKeyFrame = 2;
@@ -520,12 +531,14 @@ void Subscription::writeVideo(const Media::Video::Tag& tag, const Packet& packet
 	if (congestion) {
 		if (_videos.reliable || congestion >= Net::RTO_MAX) {
 			_ejected = EJECTED_BANDWITDH;
+			++Ejections;
 			WARN(TypeOf(_target), " video timeout, insufficient bandwidth to play ", name());
 			return;
 		}
 		if(!isConfig) {
 			// if it's not config packet and video is unreliable, drop the packet
 			++_videos.dropped;
+			++VideoDrops;
 			WARN(TypeOf(_target), " video frame dropped, insufficient bandwidth to play ", name());
 			if(pVideo)
 				pVideo->waitKeyFrame = 1;
@@ -86,11 +86,14 @@ UInt32 TSReader::parse(Packet& buffer, Media::Source& source) {
 		bool hasContent(byte & 0x10 ? true : false);	// has payload data
 		// technically hasPD without hasAF is an error, see spec
 			
+		bool randomAccess(false);
 		if (byte & 0x20) { // has adaptation field
 			 // process adaptation field and PCR
 			UInt8 length(reader.read8());
-			if (length >= 7) {
-				if (reader.read8() & 0x10)
+			if (length) {
+				UInt8 flags(reader.read8());
+				randomAccess = flags & 0x40 ? true : false; // random access indicator (keyframe)
+				if ((flags & 0x10) && length >= 7)
 					length -= reader.next(6);
 				/*if (reader.read8() & 0x10) {
 					length -= 6;
@@ -145,8 +148,11 @@ UInt32 TSReader::parse(Packet& buffer, Media::Source& source) {
 		}
 		it->second.sequence = sequence;
 	
-		if (hasHeader)
+		if (hasHeader) {
 			readPESHeader(reader, it->second);
+			if (onKeyFrame && !it->second.waitHeader && (randomAccess || it->second.type == Media::TYPE_AUDIO))
+				onKeyFrame(it->second.type, it->second->time, position(buffer, reader.data()) - 1); // 47 signature position
+		}
 
 		if (hasContent) {
 			if (it->second.waitHeader)
@@ -387,6 +393,21 @@ void TSReader::readPESHeader(BinaryReader& reader, Program& pProgram) {
 		reader.next(length);
 }
 
+bool TSReader::resume(UInt64 position, Media::Source& source) {
+	if (!seek(position))
+		return false;
+	// keep PAT/PMT and start time, but wait a new PES header for every program
+	for (auto& it : _programs) {
+		if (!it.second)
+			continue;
+		it.second->flush(source);
+		it.second.waitHeader = true;
+		it.second.sequence = 0xFF; // no lost report on the jump
+	}
+	_syncFound = false;
+	return true;
+}
+
 void TSReader::onFlush(Packet& buffer, Media::Source& source) {
 	for (auto& it : _programs) {
 		if (it.second)
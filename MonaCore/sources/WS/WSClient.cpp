@@ -56,10 +56,11 @@ void WSClient::disconnect() {
 	_onResponse = nullptr;
 	_onMessage = nullptr;
 	_pHTTPHeader = nullptr;
+	_pWSDecoder.reset();
 	_url.clear();
 	(SocketAddress&)this->address = nullptr;
 	(SocketAddress&)this->serverAddress = nullptr;
-	disconnect(); // disconnect can delete this!
+	TCPClient::disconnect(); // disconnect can delete this!
 }
 
 bool WSClient::connect(Exception& ex, const SocketAddress& addr, const string& request) {
@@ -89,7 +90,8 @@ bool WSClient::connect(Exception& ex, const SocketAddress& addr, const string& r
 			return disconnect();
 		}
 		_pHTTPHeader = response;
-		response.pWSDecoder->onMessage = _onMessage;
+		_pWSDecoder = response.pWSDecoder;
+		_pWSDecoder->onMessage = _onMessage;
 		setPing(connection.elapsed()); // set the ping immediatly with the first response!
 	};
 	_onMessage = [this](WS::Message& message) {
@@ -21,6 +21,7 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/UDPSocket.h"
 #include "Mona/WS/WSClient.h"
 #include "Mona/SRT.h"
+#include "Mona/Metrics.h"
 #include "LUAMap.h"
 #include "LUAIPAddress.h"
 #include "LUASocketAddress.h"
@@ -38,6 +39,12 @@ static int time(lua_State *pState) {
 		SCRIPT_WRITE_DOUBLE(Time::Now())
 	SCRIPT_CALLBACK_RETURN
 }
+static int metrics(lua_State *pState) {
+	SCRIPT_CALLBACK(ServerAPI, api)
+		string text;
+		SCRIPT_WRITE_STRING(Metrics::Write(text))
+	SCRIPT_CALLBACK_RETURN
+}
 static int newIPAddress(lua_State *pState) {
 	SCRIPT_CALLBACK_TRY(ServerAPI, api)
 		if (SCRIPT_NEXT_READABLE) {
@@ -277,6 +284,7 @@ template<> void Script::ObjInit(lua_State *pState, ServerAPI& api) {
 		else
 			SCRIPT_DEFINE_BOOLEAN("littleEndian", true)
 		SCRIPT_DEFINE_FUNCTION("time", &time);
+		SCRIPT_DEFINE_FUNCTION("metrics", &metrics);
 		SCRIPT_DEFINE_FUNCTION("newPath", &newPath);
 		SCRIPT_DEFINE_FUNCTION("newIPAddress", &newIPAddress);
 		SCRIPT_DEFINE_FUNCTION("newSocketAddress", &newSocketAddress);
@@ -53,6 +53,21 @@ static int sendLostRate(lua_State *pState) {
 		SCRIPT_WRITE_DOUBLE(stats.sendLostRate());
 	SCRIPT_CALLBACK_RETURN;
 }
+static int sendRepeatRate(lua_State *pState) {
+	SCRIPT_CALLBACK(Net::Stats, stats);
+		SCRIPT_WRITE_DOUBLE(stats.sendRepeatRate());
+	SCRIPT_CALLBACK_RETURN;
+}
+static int sendWindow(lua_State *pState) {
+	SCRIPT_CALLBACK(Net::Stats, stats);
+		SCRIPT_WRITE_INT(stats.sendWindow());
+	SCRIPT_CALLBACK_RETURN;
+}
+static int sendPacingRate(lua_State *pState) {
+	SCRIPT_CALLBACK(Net::Stats, stats);
+		SCRIPT_WRITE_DOUBLE(stats.sendPacingRate());
+	SCRIPT_CALLBACK_RETURN;
+}
 static int queueing(lua_State *pState) {
 	SCRIPT_CALLBACK(Net::Stats, stats);
 		SCRIPT_WRITE_DOUBLE(stats.queueing());
@@ -67,6 +82,9 @@ template<> void Script::ObjInit(lua_State *pState, Net::Stats& stats) {
 		SCRIPT_DEFINE_FUNCTION("sendTime", sendTime);
 		SCRIPT_DEFINE_FUNCTION("sendByteRate", sendByteRate);
 		SCRIPT_DEFINE_FUNCTION("sendLostRate", sendLostRate);
+		SCRIPT_DEFINE_FUNCTION("sendRepeatRate", sendRepeatRate);
+		SCRIPT_DEFINE_FUNCTION("sendWindow", sendWindow);
+		SCRIPT_DEFINE_FUNCTION("sendPacingRate", sendPacingRate);
 		SCRIPT_DEFINE_FUNCTION("queueing", queueing);
 	SCRIPT_END;
 }
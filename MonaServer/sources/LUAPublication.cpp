@@ -79,6 +79,28 @@ static int latency(lua_State *pState) {
 	SCRIPT_CALLBACK_RETURN
 }
 
+static int latencies(lua_State *pState) {
+	SCRIPT_CALLBACK(Publication, publication)
+		// {stage={p50, p99, max, count}} in milliseconds, empty if no media traced (see traceRate)
+		lua_newtable(pState);
+		for (UInt8 stage = 0; stage < Publication::STAGE_COUNT; ++stage) {
+			const Metrics::Samples* pLatencies = publication.latencies(Publication::Stage(stage));
+			if (!pLatencies)
+				break;
+			lua_newtable(pState);
+			SCRIPT_WRITE_DOUBLE(pLatencies->percentile(0.5) / 1000.0)
+			lua_setfield(pState, -2, "p50");
+			SCRIPT_WRITE_DOUBLE(pLatencies->percentile(0.99) / 1000.0)
+			lua_setfield(pState, -2, "p99");
+			SCRIPT_WRITE_DOUBLE(pLatencies->max() / 1000.0)
+			lua_setfield(pState, -2, "max");
+			SCRIPT_WRITE_DOUBLE(pLatencies->count())
+			lua_setfield(pState, -2, "count");
+			lua_setfield(pState, -2, Publication::StageToString(Publication::Stage(stage)));
+		}
+	SCRIPT_CALLBACK_RETURN
+}
+
 template<> void Script::ObjInit(lua_State *pState, Publication& publication) {
 	AddType<Media::Source>(pState, publication);
 
@@ -92,6 +114,7 @@ template<> void Script::ObjInit(lua_State *pState, Publication& publication) {
 		SCRIPT_DEFINE("videos", AddObject(pState, publication.videos));
 		SCRIPT_DEFINE("datas", AddObject(pState, publication.datas));
 		SCRIPT_DEFINE_FUNCTION("latency", &latency);
+		SCRIPT_DEFINE_FUNCTION("latencies", &latencies);
 		SCRIPT_DEFINE_FUNCTION("byteRate", &byteRate<const Publication>);
 		SCRIPT_DEFINE_FUNCTION("lostRate", &lostRate<const Publication>);
 	SCRIPT_END;
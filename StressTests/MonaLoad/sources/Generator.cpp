@@ -0,0 +1,73 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "Generator.h"
+#include "Mona/Metrics.h"
+
+using namespace std;
+
+namespace Mona {
+
+// Baseline 640x480 parameters, enough for the server and the segmenters to describe the stream
+static const UInt8 SPS[] = { 0x67, 0x42, 0x00, 0x1E, 0x95, 0xA8, 0x28, 0x0F, 0x64 };
+static const UInt8 PPS[] = { 0x68, 0xCE, 0x3C, 0x80 };
+
+#define MARKER_SIZE 27 // "LGN" + 8 hex digits of sequence + 16 hex digits of time
+
+Generator::Generator(UInt16 fps, UInt32 bitrate, UInt16 keyInterval) : fps(fps ? fps : 1), keyInterval(keyInterval ? keyInterval : 1),
+	frameSize(max(bitrate / 8 / (fps ? fps : 1), UInt32(5 + MARKER_SIZE))) {
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	writer.write32(sizeof(SPS)).write(SPS, sizeof(SPS)).write32(sizeof(PPS)).write(PPS, sizeof(PPS)); // Mona config format, NALs with their size
+	_config.set(pBuffer);
+}
+
+Packet Generator::frame(UInt32 sequence, Media::Video::Tag& tag) const {
+	tag.codec = Media::Video::CODEC_H264;
+	tag.frame = ((sequence - 1) % keyInterval) ? Media::Video::FRAME_INTER : Media::Video::FRAME_KEY;
+	tag.compositionOffset = 0;
+	tag.time = UInt32(UInt64(sequence - 1) * 1000 / fps);
+
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	writer.write32(frameSize - 4); // NAL size
+	writer.write8(tag.frame == Media::Video::FRAME_KEY ? 0x65 : 0x41); // IDR or non-IDR slice
+	UInt64 time = Metrics::Microseconds();
+	String::Append(*pBuffer, "LGN", String::Format<UInt32>("%08X", sequence), String::Format<UInt32>("%08X", UInt32(time >> 32)), String::Format<UInt32>("%08X", UInt32(time)));
+	pBuffer->append(frameSize - pBuffer->size(), 0xAA);
+	return Packet(pBuffer);
+}
+
+bool Generator::Probe(const Packet& packet, UInt32& sequence, Int64& time) {
+	// marker is just after the NAL size and type, or after few NALs inserted by a segmenter (AUD, SPS, PPS)
+	const char* data = STR packet.data();
+	const char* end = data + min(packet.size(), 256u);
+	while ((end - data) >= MARKER_SIZE) {
+		data = (const char*)memchr(data, 'L', end - data - MARKER_SIZE + 1);
+		if (!data)
+			return false;
+		UInt64 value;
+		if (memcmp(data, EXPAND("LGN")) == 0 && String::ToNumber(data + 3, 8, sequence, BASE_16) && String::ToNumber(data + 11, 16, value, BASE_16)) {
+			time = Int64(value);
+			return true;
+		}
+		++data;
+	}
+	return false;
+}
+
+} // namespace Mona
@@ -0,0 +1,53 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Media.h"
+
+namespace Mona {
+
+/*!
+Synthetic H264 video (AVCC format) with a fixed frame size, each frame carries a marker with its sequence number
+and its generation time in microseconds (see Metrics::Microseconds), in hexadecimal text to survive the Annex B conversion
+of MPEG-TS (payload has no zero byte, so no start code emulation) */
+struct Generator : virtual Object {
+	/*!
+	fps frames by second, bitrate in bits by second, a key frame every keyInterval frames */
+	Generator(UInt16 fps, UInt32 bitrate, UInt16 keyInterval);
+
+	const UInt16	fps;
+	const UInt32	frameSize;
+	const UInt16	keyInterval;
+
+	/*!
+	H264 configuration to send before the first frame, SPS and PPS NALs with their size (Mona format) */
+	const Packet&	config() const { return _config; }
+	/*!
+	Build the frame of this sequence number (starting at 1) and set its tag */
+	Packet			frame(UInt32 sequence, Media::Video::Tag& tag) const;
+
+	/*!
+	Find the marker in the first bytes of a received frame (AVCC or Annex B) */
+	static bool		Probe(const Packet& packet, UInt32& sequence, Int64& time);
+
+private:
+	Packet	_config;
+};
+
+} // namespace Mona
@@ -0,0 +1,200 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "HLSLoadClient.h"
+#include "LoadWorker.h"
+
+using namespace std;
+
+namespace Mona {
+
+HLSLoadClient::HLSLoadClient(LoadWorker& worker, const string& stream) : LoadClient(worker, false, stream), TCPClient(worker.io),
+	_sequence(-1), _targetDuration(0), _nextPoll(0), _playlist(false), _length(-1), _chunked(false), _chunkEnd(false), _code(0) {
+	onData = [this](Packet& buffer) { return receive(buffer); };
+	onError = [this](const Exception& ex) { fail(ex); };
+	onDisconnection = [this](const SocketAddress& address) { fail<Ex::Net::Socket>("HLS disconnection"); };
+}
+
+HLSLoadClient::~HLSLoadClient() {
+	onDisconnection = nullptr;
+	onError = nullptr;
+	onData = nullptr;
+}
+
+bool HLSLoadClient::connect(Exception& ex) {
+	if (!TCPClient::connect(ex, worker.config.playAddress))
+		return false;
+	next(Metrics::Microseconds());
+	return !dead();
+}
+
+void HLSLoadClient::tick(Int64 now) {
+	if (_nextPoll && now >= _nextPoll)
+		next(now);
+}
+
+void HLSLoadClient::next(Int64 now) {
+	string path("/");
+	if (_segments.empty()) {
+		if (now < _nextPoll)
+			return; // wait polling time
+		String::Append(path, stream, ".m3u8");
+		_playlist = true;
+	} else {
+		path = move(_segments.front());
+		_segments.pop_front();
+		_playlist = false;
+	}
+	_nextPoll = 0;
+	shared<Buffer> pBuffer(SET);
+	String::Append(*pBuffer, "GET ", path, " HTTP/1.1\r\nHost: ", worker.config.playAddress, "\r\nUser-Agent: MonaLoad\r\n\r\n");
+	Exception ex;
+	if (!TCPClient::send(ex, Packet(pBuffer)))
+		fail(ex);
+}
+
+UInt32 HLSLoadClient::receive(Packet& buffer) {
+	while (buffer) {
+		if (_length < 0) {
+			// HEADER
+			if (buffer.size() < 4)
+				return buffer.size();
+			const char* end = STR buffer.data();
+			const char* last = end + buffer.size() - 3;
+			while (end < last && memcmp(end, EXPAND("\r\n\r\n")))
+				++end;
+			if (end >= last) {
+				if (buffer.size() <= 0x2000)
+					return buffer.size();
+				fail<Ex::Protocol>("HTTP header too large (>8KB)");
+				return 0;
+			}
+			String::Scoped scoped(end);
+			const char* line = STR buffer.data();
+			// HTTP/1.1 200 OK
+			line = strchr(line, ' ');
+			if (!line || !String::ToNumber(line + 1, 3, _code)) {
+				fail<Ex::Protocol>("Invalid HTTP response");
+				return 0;
+			}
+			_length = 0;
+			_chunked = false;
+			while ((line = strstr(line, "\r\n"))) {
+				line += 2;
+				if (String::ICompare(line, "content-length:", 15) == 0) {
+					const char* value = line + 15 + strspn(line + 15, " ");
+					String::ToNumber(value, strcspn(value, "\r"), _length);
+				} else if (String::ICompare(line, "transfer-encoding:", 18) == 0)
+					_chunked = true; // only chunked is possible with HTTP/1.1
+			}
+			buffer += UInt32(end - STR buffer.data()) + 4;
+			if (_playlist)
+				_pPlaylist.set();
+		}
+
+		if (_chunked && !_length) {
+			// CHUNK SIZE LINE, preceded by the CRLF of the previous chunk
+			const UInt8* cur = buffer.data();
+			const UInt8* last = cur + buffer.size();
+			if (_chunkEnd) {
+				if (buffer.size() < 2)
+					return buffer.size();
+				cur += 2;
+			}
+			while (cur < last && isxdigit(*cur))
+				_length = (_length << 4) | (isdigit(*cur) ? (*cur++ - '0') : (tolower(*cur++) - 'a' + 10));
+			while (cur < last && *cur != '\n') // ignore chunk extensions
+				++cur;
+			if (cur == last) {
+				_length = 0;
+				if (buffer.size() <= 0x400)
+					return buffer.size();
+				fail<Ex::Protocol>("Invalid HTTP chunk");
+				return 0;
+			}
+			if (!_length) {
+				// last chunk, wait the final CRLF (trailers are not expected)
+				if ((last - ++cur) < 2)
+					return buffer.size();
+				buffer += UInt32(cur - buffer.data()) + 2;
+				_chunkEnd = false;
+			} else {
+				buffer += UInt32(++cur - buffer.data());
+				_chunkEnd = true;
+			}
+		}
+
+		// BODY
+		UInt32 size = UInt32(min(Int64(buffer.size()), _length));
+		if (_code == 200) {
+			if (_playlist)
+				_pPlaylist->append(buffer.data(), size);
+			else
+				_reader.read(Packet(buffer, buffer.data(), size), self);
+		}
+		buffer += size;
+		if ((_length -= size))
+			return 0; // wait end of body
+		if (_chunked && (size || _chunkEnd))
+			continue; // next chunk
+		_length = -1;
+
+		// END OF RESPONSE
+		Int64 now = Metrics::Microseconds();
+		if (_playlist) {
+			if (_code == 200) {
+				LoadClient::connected();
+				parse(STR _pPlaylist->data(), _pPlaylist->size());
+			}
+			// poll on half target duration (or 1 second if no playlist yet)
+			_nextPoll = now + (_targetDuration ? max(_targetDuration * 500, 500000u) : 1000000);
+			_pPlaylist.reset();
+		}
+		next(now);
+		if (dead())
+			return 0;
+	}
+	return 0;
+}
+
+void HLSLoadClient::parse(const char* playlist, UInt32 size) {
+	UInt64 sequence(0);
+	vector<string> segments;
+	String::ForEach forEach([&](UInt32 index, const char* line) {
+		if (*line != '#') {
+			const char* url = strstr(line, "://");
+			if (url) // absolute URL, keep path
+				line = strchr(url + 3, '/');
+			if (line) // relative to the playlist which is at the root
+				segments.emplace_back(*line == '/' ? string(line) : String('/', line));
+		} else if (String::ICompare(line, EXPAND("#EXT-X-MEDIA-SEQUENCE:")) == 0)
+			String::ToNumber(line + 22, sequence);
+		else if (String::ICompare(line, EXPAND("#EXT-X-TARGETDURATION:")) == 0)
+			_targetDuration = String::ToNumber<UInt32, 0>(line + 22) * 1000;
+		return true;
+	});
+	String::Split(playlist, size, "\r\n", forEach, SPLIT_IGNORE_EMPTY | SPLIT_TRIM);
+	if (segments.empty())
+		return;
+	// live edge on start, then every new segment
+	UInt64 last = sequence + segments.size() - 1;
+	for (UInt64 i = _sequence < 0 ? last : max(UInt64(_sequence + 1), sequence); i <= last; ++i)
+		_segments.emplace_back(move(segments[size_t(i - sequence)]));
+	_sequence = max(_sequence, Int64(last));
+}
+
+} // namespace Mona
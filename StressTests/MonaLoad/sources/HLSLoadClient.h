@@ -0,0 +1,63 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/TCPClient.h"
+#include "Mona/TSReader.h"
+#include "LoadClient.h"
+#include <deque>
+
+namespace Mona {
+
+/*!
+HLS viewer on a keep-alive HTTP connection: polls the playlist, starts on the live edge (last segment)
+and downloads each new segment, MPEG-TS segments are read progressively by a TSReader */
+struct HLSLoadClient : LoadClient, private TCPClient, virtual Object {
+	HLSLoadClient(LoadWorker& worker, const std::string& stream);
+	~HLSLoadClient();
+
+	void tick(Int64 now);
+
+private:
+	bool	connect(Exception& ex);
+
+	UInt32	receive(Packet& buffer);
+	/*!
+	Parse playlist and queue the new segments */
+	void	parse(const char* playlist, UInt32 size);
+	/*!
+	Send the next request, segment queued or playlist on its polling time */
+	void	next(Int64 now);
+
+	TSReader				_reader;
+	std::deque<std::string>	_segments;
+	Int64					_sequence; // media sequence of the last queued segment, -1 before the first playlist
+	UInt32					_targetDuration; // ms
+	Int64					_nextPoll; // 0 while a request is running
+
+	// response parsing
+	bool					_playlist; // response of playlist request
+	Int64					_length; // body (or chunk) remaining size, -1 while header parsing
+	bool					_chunked;
+	bool					_chunkEnd; // CRLF of the previous chunk to skip
+	shared<Buffer>			_pPlaylist;
+	UInt16					_code;
+};
+
+} // namespace Mona
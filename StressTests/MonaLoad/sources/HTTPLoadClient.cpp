@@ -0,0 +1,81 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "HTTPLoadClient.h"
+#include "LoadWorker.h"
+
+using namespace std;
+
+namespace Mona {
+
+HTTPLoadClient::HTTPLoadClient(LoadWorker& worker, bool publisher, const string& stream) : LoadClient(worker, publisher, stream) {
+}
+
+HTTPLoadClient::~HTTPLoadClient() {
+	if (!_pStream)
+		return;
+	_pStream->onNewTarget = nullptr;
+	_pStream->onRunning = nullptr;
+	_pStream->onStop = nullptr;
+	_pTarget.reset();
+	_pStream.reset();
+}
+
+bool HTTPLoadClient::connect(Exception& ex) {
+	// http://address/name.flv?query
+	size_t query = stream.find('?');
+	string description("http://");
+	String::Append(description, publisher ? worker.config.publishAddress : worker.config.playAddress, '/', string(stream, 0, query), ".flv");
+	if (query != string::npos)
+		description.append(stream, query, string::npos);
+
+	if (publisher)
+		_pStream = MediaStream::New(ex, description, worker.timer, worker.ioFile, worker.io);
+	else
+		_pStream = MediaStream::New(ex, self, description, worker.timer, worker.ioFile, worker.io);
+	if (!_pStream)
+		return false;
+	_pStream->onNewTarget = [this](const shared<Media::Target>& pTarget) { _pTarget = pTarget; };
+	_pStream->onRunning = [this]() { connected(); };
+	_pStream->onStop = [this]() {
+		if (_pStream->ex)
+			return fail(_pStream->ex);
+		fail<Ex::Net::Socket>(_pStream->description, " stopped");
+	};
+	if (!_pStream->start()) {
+		ex = _pStream->ex;
+		return false;
+	}
+	if (!publisher)
+		return true; // wait onRunning
+	// POST request on the first media
+	if (!_pTarget || !_pTarget->beginMedia(string(stream, 0, query))) {
+		ex.set<Ex::Net::Socket>(_pStream->description, " publication failed");
+		return false;
+	}
+	connected(); // no connection event for a writer, established on the publication request
+	return true;
+}
+
+bool HTTPLoadClient::write(const Media::Video::Tag& tag, const Packet& packet) {
+	if (_pTarget && _pTarget->writeVideo(1, tag, packet, true))
+		return true;
+	fail<Ex::Net::Socket>(_pStream->description, " writing failed");
+	return false;
+}
+
+} // namespace Mona
@@ -0,0 +1,41 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/MediaStream.h"
+#include "LoadClient.h"
+
+namespace Mona {
+
+/*!
+HTTP-FLV client built on MediaSocket streams, publishes with a POST (MediaSocket::Writer)
+or plays with a GET (MediaSocket::Reader) */
+struct HTTPLoadClient : LoadClient, virtual Object {
+	HTTPLoadClient(LoadWorker& worker, bool publisher, const std::string& stream);
+	~HTTPLoadClient();
+
+private:
+	bool connect(Exception& ex);
+	bool write(const Media::Video::Tag& tag, const Packet& packet);
+
+	unique<MediaStream>		_pStream;
+	shared<Media::Target>	_pTarget;
+};
+
+} // namespace Mona
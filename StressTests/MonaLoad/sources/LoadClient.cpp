@@ -0,0 +1,155 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "LoadClient.h"
+#include "LoadWorker.h"
+#include "RTMPLoadClient.h"
+#include "WSLoadClient.h"
+#include "HTTPLoadClient.h"
+#include "SRTLoadClient.h"
+#include "HLSLoadClient.h"
+
+using namespace std;
+
+namespace Mona {
+
+const char* LoadClient::ProtocolToString(Protocol protocol) {
+	static const char* Strings[] = { "rtmp", "http", "hls", "ws", "srt" };
+	return Strings[protocol];
+}
+
+bool LoadClient::ParseProtocol(const char* value, Protocol& protocol) {
+	for (UInt8 i = PROTOCOL_RTMP; i <= PROTOCOL_SRT; ++i) {
+		if (String::ICompare(value, ProtocolToString(Protocol(i))) == 0) {
+			protocol = Protocol(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+unique<LoadClient> LoadClient::New(Exception& ex, LoadWorker& worker, Protocol protocol, bool publisher, const string& stream) {
+	unique<LoadClient> pClient;
+	switch (protocol) {
+		case PROTOCOL_RTMP:
+			pClient.set<RTMPLoadClient>(worker, publisher, stream);
+			break;
+		case PROTOCOL_WS:
+			pClient.set<WSLoadClient>(worker, publisher, stream);
+			break;
+		case PROTOCOL_HLS:
+			if (publisher) {
+				ex.set<Ex::Unsupported>("HLS publication unsupported");
+				return nullptr;
+			}
+			pClient.set<HLSLoadClient>(worker, stream);
+			break;
+		case PROTOCOL_HTTP:
+			pClient.set<HTTPLoadClient>(worker, publisher, stream);
+			break;
+		case PROTOCOL_SRT:
+#if defined(SRT_API)
+			pClient.set<SRTLoadClient>(worker, publisher, stream);
+			break;
+#else
+			ex.set<Ex::Unsupported>("SRT unsupported, build MonaBase with SRT support");
+			return nullptr;
+#endif
+	}
+	if (!pClient->connect(ex))
+		pClient->fail(ex); // removed by the worker on next tick
+	return pClient;
+}
+
+LoadClient::LoadClient(LoadWorker& worker, bool publisher, const string& stream) : worker(worker), publisher(publisher), stream(stream),
+	stats(publisher ? worker.publishers : worker.viewers), _start(Metrics::Microseconds()), _connection(0), _firstFrame(0), _transit(0),
+	_sequence(0), _connected(false), _dead(false) {
+}
+
+LoadClient::~LoadClient() {
+	if (_connected)
+		--stats.connected;
+}
+
+void LoadClient::connected() {
+	if (_connected || _dead)
+		return;
+	_connected = true;
+	_connection = Metrics::Microseconds();
+	stats.connectTime.record(_connection - _start);
+	++stats.connections;
+	++stats.connected;
+}
+
+void LoadClient::fail(const Exception& ex) {
+	if (_dead)
+		return;
+	_dead = true;
+	++stats.failures;
+	if (_connected) {
+		_connected = false;
+		--stats.connected;
+	}
+	DEBUG(publisher ? "Publisher " : "Viewer ", stream, ", ", ex);
+}
+
+void LoadClient::tick(Int64 now) {
+	if (!publisher || !_connected)
+		return;
+	Media::Video::Tag tag(Media::Video::CODEC_H264);
+	if (!_sequence) {
+		tag.frame = Media::Video::FRAME_CONFIG;
+		if (!write(tag, worker.generator.config()))
+			return;
+	}
+	// real-time, frames due since the connection
+	UInt32 due = UInt32((now - _connection) * worker.generator.fps / 1000000) + 1;
+	while (_sequence < due) {
+		Packet packet(worker.generator.frame(++_sequence, tag));
+		if (!write(tag, packet))
+			return;
+		++stats.frames;
+		stats.bytes += packet.size();
+	}
+}
+
+void LoadClient::writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) {
+	if (tag.frame == Media::Video::FRAME_CONFIG)
+		return;
+	Int64 now = Metrics::Microseconds();
+	++stats.frames;
+	stats.bytes += packet.size();
+	// transit variation between two frames
+	Int64 transit = now - Int64(tag.time) * 1000;
+	if (!_firstFrame)
+		stats.firstFrame.record((_firstFrame = now) - _start);
+	else
+		stats.jitter.record(abs(transit - _transit));
+	_transit = transit;
+
+	UInt32 sequence;
+	Int64 time;
+	if (!Generator::Probe(packet, sequence, time))
+		return;
+	if (_sequence && sequence > (_sequence + 1))
+		stats.drops += sequence - _sequence - 1;
+	if (sequence > _sequence)
+		_sequence = sequence;
+	stats.latency.record(now - time);
+}
+
+} // namespace Mona
@@ -0,0 +1,99 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Media.h"
+#include "LoadStats.h"
+
+namespace Mona {
+
+struct LoadWorker;
+
+/*!
+Publisher or viewer of the load generator, all its events are handled by the thread of its worker.
+A publisher starts to publish on connected() the frames of the worker generator in real-time on tick(),
+a viewer measures what it receives through its Media::Source interface.
+On failure the client is just marked dead (to be deleted on next tick by its worker) */
+struct LoadClient : Media::Source, virtual Object {
+	enum Protocol {
+		PROTOCOL_RTMP = 0,
+		PROTOCOL_HTTP, // HTTP-FLV, POST to publish and GET to play
+		PROTOCOL_HLS, // viewer only, playlist polling and MPEG-TS segments
+		PROTOCOL_WS,
+		PROTOCOL_SRT // MPEG-TS, requires MonaBase built with SRT support
+	};
+	static const char*	ProtocolToString(Protocol protocol);
+	static bool			ParseProtocol(const char* value, Protocol& protocol);
+
+	/*!
+	Create and connect a new client, returns null if protocol is unsupported for this role */
+	static unique<LoadClient> New(Exception& ex, LoadWorker& worker, Protocol protocol, bool publisher, const std::string& stream);
+
+	virtual ~LoadClient();
+
+	const bool			publisher;
+	const std::string	stream;
+
+	bool		 dead() const { return _dead; }
+	/*!
+	Called every worker tick, publishes the frames due if publisher */
+	virtual void tick(Int64 now);
+
+	const std::string& name() const { return stream; }
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track = 1) {}
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track = 1);
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track = 0) {}
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) {}
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track = 0) {} // drops are detected with the frame sequence
+	void flush() {}
+	void reset() {}
+
+protected:
+	LoadClient(LoadWorker& worker, bool publisher, const std::string& stream);
+
+	virtual bool connect(Exception& ex) = 0;
+	/*!
+	Publisher writing, returns false on failure */
+	virtual bool write(const Media::Video::Tag& tag, const Packet& packet) { return false; }
+
+	/*!
+	Protocol session established, records the connect time */
+	void connected();
+	void fail(const Exception& ex);
+	template<typename ExType, typename ...Args>
+	void fail(Args&&... args) {
+		Exception ex;
+		ex.set<ExType>(std::forward<Args>(args)...);
+		fail(ex);
+	}
+
+	LoadWorker&	worker;
+	LoadStats&	stats;
+
+private:
+	Int64	_start;
+	Int64	_connection;
+	Int64	_firstFrame;
+	Int64	_transit;
+	UInt32	_sequence; // last sent or received
+	bool	_connected;
+	bool	_dead;
+};
+
+} // namespace Mona
@@ -0,0 +1,67 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "LoadStats.h"
+
+using namespace std;
+
+namespace Mona {
+
+LoadStats::LoadStats(const char* role, const char* protocol) : labels(String("role=\"", role, "\",protocol=\"", protocol, '"')),
+	connected("load_connected", "Current connected clients", labels.c_str()),
+	connections("load_connections_total", "Client connections established", labels.c_str()),
+	failures("load_failures_total", "Client connection failures and unexpected disconnections", labels.c_str()),
+	frames("load_frames_total", "Video frames sent by publishers or received by viewers", labels.c_str()),
+	bytes("load_bytes_total", "Video bytes sent by publishers or received by viewers", labels.c_str()),
+	drops("load_drops_total", "Video frames lost, detected with the generator sequence number", labels.c_str()),
+	connectTime("load_connect_seconds", "Time to establish the protocol session", labels.c_str()),
+	firstFrame("load_first_frame_seconds", "Time from the connection attempt to the first video frame", labels.c_str()),
+	jitter("load_jitter_seconds", "Transit variation between two successive video frames", labels.c_str()),
+	latency("load_latency_seconds", "Time from the frame generation to its reception", labels.c_str()),
+	_start(Metrics::Microseconds()), _time(_start), _frames(0), _bytes(0) {
+}
+
+string& LoadStats::report(string& line, const char* name, UInt32 expected) {
+	Int64 now = Metrics::Microseconds();
+	UInt64 frames = this->frames(), bytes = this->bytes();
+	append(line, name, expected, frames - _frames, bytes - _bytes, now - _time);
+	_time = now;
+	_frames = frames;
+	_bytes = bytes;
+	return line;
+}
+
+string& LoadStats::summary(string& line, const char* name, UInt32 expected) {
+	return append(line, name, expected, frames(), bytes(), Metrics::Microseconds() - _start);
+}
+
+string& LoadStats::append(string& line, const char* name, UInt32 expected, UInt64 frames, UInt64 bytes, Int64 elapsed) {
+	double seconds = elapsed > 0 ? elapsed / 1000000.0 : 1;
+	String::Append(line, name, ' ', connected(), '/', expected, " connected (", failures(), " failures), ");
+	String::Append(line, UInt64(frames / seconds), " fps, ", String::Format<double>("%.2f", bytes * 8 / seconds / 1000000), " Mbit/s");
+	if (connectTime.count())
+		String::Append(line, ", connect ", String::Format<double>("%.1f", connectTime.percentile(0.5) / 1000.0), '/', String::Format<double>("%.1f", connectTime.percentile(0.99) / 1000.0), "ms");
+	if (firstFrame.count())
+		String::Append(line, ", first frame ", String::Format<double>("%.1f", firstFrame.percentile(0.5) / 1000.0), '/', String::Format<double>("%.1f", firstFrame.percentile(0.99) / 1000.0), "ms");
+	if (jitter.count())
+		String::Append(line, ", jitter ", String::Format<double>("%.1f", jitter.percentile(0.5) / 1000.0), '/', String::Format<double>("%.1f", jitter.percentile(0.99) / 1000.0), "ms");
+	if (latency.count())
+		String::Append(line, ", latency ", String::Format<double>("%.1f", latency.percentile(0.5) / 1000.0), '/', String::Format<double>("%.1f", latency.percentile(0.99) / 1000.0), "ms");
+	return String::Append(line, ", ", drops(), " drops");
+}
+
+} // namespace Mona
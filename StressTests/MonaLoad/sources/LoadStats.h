@@ -0,0 +1,68 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Metrics.h"
+
+namespace Mona {
+
+/*!
+Load statistics of a role (publishers or viewers), recorded from any worker thread with Metrics lock-free objects,
+durations are in microseconds */
+struct LoadStats : virtual Object {
+	LoadStats(const char* role, const char* protocol);
+
+	const std::string	labels; // before metrics which keep a pointer on it
+
+	Metrics::Gauge		connected;
+	Metrics::Counter	connections;
+	Metrics::Counter	failures;
+	Metrics::Counter	frames;
+	Metrics::Counter	bytes;
+	Metrics::Counter	drops;
+	/*!
+	Time to establish the protocol session (TCP connection, RTMP NetConnection, first HLS playlist...) */
+	Metrics::Histogram	connectTime;
+	/*!
+	Time from the connection attempt to the first video frame */
+	Metrics::Histogram	firstFrame;
+	/*!
+	Transit variation between two successive frames (arrival delta - timestamp delta) */
+	Metrics::Histogram	jitter;
+	/*!
+	Time from the frame generation to its reception, valid because publishers and viewers share the same clock */
+	Metrics::Histogram	latency;
+
+	/*!
+	Append a report line, rates are computed since the previous report call */
+	std::string& report(std::string& line, const char* name, UInt32 expected);
+	/*!
+	Append a summary line, rates are computed since the stats creation */
+	std::string& summary(std::string& line, const char* name, UInt32 expected);
+
+private:
+	std::string& append(std::string& line, const char* name, UInt32 expected, UInt64 frames, UInt64 bytes, Int64 elapsed);
+
+	Int64	_start;
+	Int64	_time;
+	UInt64	_frames;
+	UInt64	_bytes;
+};
+
+} // namespace Mona
@@ -0,0 +1,86 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "LoadWorker.h"
+
+using namespace std;
+
+namespace Mona {
+
+LoadWorker::LoadWorker(UInt16 index, const Config& config, const Generator& generator, const ThreadPool& threadPool, LoadStats& publishers, LoadStats& viewers) :
+	Thread("LoadWorker"), index(index), config(config), generator(generator), publishers(publishers), viewers(viewers),
+	timer(_timer), io(_handler, threadPool, "LoadIOSocket"), ioFile(_handler, threadPool) {
+	_handler.reset(wakeUp);
+}
+
+void LoadWorker::newClient(UInt32 index) {
+	bool publisher = index < config.publishers;
+	string stream(config.name);
+	if (publisher) {
+		String::Append(stream, index);
+		if (!config.query.empty())
+			String::Append(stream, '?', config.query);
+	} else
+		String::Append(stream, (index - config.publishers) % (config.publishers ? config.publishers : config.streams));
+
+	Exception ex;
+	unique<LoadClient> pClient = LoadClient::New(ex, self, publisher ? config.publishProtocol : config.playProtocol, publisher, stream);
+	if (!pClient) {
+		++(publisher ? publishers : viewers).failures;
+		DEBUG(publisher ? "Publisher " : "Viewer ", stream, ", ", ex);
+		return;
+	}
+	_clients.emplace_back(move(pClient));
+}
+
+bool LoadWorker::run(Exception&, const volatile bool& requestStop) {
+	UInt32 total = config.publishers + config.viewers;
+	UInt32 next = index;
+	Int64 start = Metrics::Microseconds();
+
+	Timer::OnTimer onTick([&](UInt32 delay) {
+		Int64 now = Metrics::Microseconds();
+		// ramp-up, client of global index i starts at i/ramp seconds
+		while (next < total && (!config.ramp || (now - start) >= Int64(next * 1000000.0 / config.ramp))) {
+			newClient(next);
+			next += config.threads;
+		}
+		// tick and remove dead clients
+		auto it = _clients.begin();
+		while (it != _clients.end()) {
+			if ((*it)->dead()) {
+				it = _clients.erase(it);
+				continue;
+			}
+			(*it++)->tick(now);
+		}
+		return 10;
+	});
+	_timer.set(onTick, onTick());
+
+	while (!requestStop) {
+		if (wakeUp.wait(_timer.raise()))
+			_handler.flush();
+	}
+
+	_timer.set(onTick, 0);
+	_clients.clear();
+	_handler.flush();
+	return true;
+}
+
+} // namespace Mona
@@ -0,0 +1,76 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Thread.h"
+#include "Mona/Handler.h"
+#include "Mona/Timer.h"
+#include "Mona/IOSocket.h"
+#include "Mona/IOFile.h"
+#include "LoadClient.h"
+#include "Generator.h"
+
+namespace Mona {
+
+/*!
+Thread owning a share of the clients with its own handler, timer and sockets poller,
+it creates its clients progressively (ramp-up) and ticks them every 10ms */
+struct LoadWorker : Thread, virtual Object {
+	struct Config : virtual Object {
+		Config() : publishProtocol(LoadClient::PROTOCOL_RTMP), playProtocol(LoadClient::PROTOCOL_RTMP), publishers(0), viewers(0), streams(1), ramp(0), threads(1) {}
+
+		LoadClient::Protocol	publishProtocol;
+		SocketAddress			publishAddress;
+		LoadClient::Protocol	playProtocol;
+		SocketAddress			playAddress;
+		UInt32					publishers;
+		UInt32					viewers;
+		UInt32					streams; // streams to play if there is no publisher
+		std::string				name; // stream name prefix, stream index is appended
+		std::string				query; // publication parameters ("segments=4" for HLS for example)
+		double					ramp; // new clients by second for all the workers, 0 = all immediately
+		UInt16					threads;
+	};
+
+	LoadWorker(UInt16 index, const Config& config, const Generator& generator, const ThreadPool& threadPool, LoadStats& publishers, LoadStats& viewers);
+	~LoadWorker() { stop(); }
+
+private:
+	Handler					_handler;
+	Timer					_timer;
+public:
+	const UInt16			index;
+	const Config&			config;
+	const Generator&		generator;
+	LoadStats&				publishers;
+	LoadStats&				viewers;
+	const Timer&			timer;
+	IOSocket				io;
+	IOFile					ioFile;
+
+private:
+	bool run(Exception& ex, const volatile bool& requestStop);
+	/*!
+	Create the client of this global index, publishers first and then viewers */
+	void newClient(UInt32 index);
+
+	std::vector<unique<LoadClient>>	_clients;
+};
+
+} // namespace Mona
@@ -0,0 +1,264 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "RTMPLoadClient.h"
+#include "LoadWorker.h"
+#include "Mona/AMFWriter.h"
+#include "Mona/AMFReader.h"
+#include "Mona/AVC.h"
+#include "Mona/FLVReader.h"
+#include "Mona/FLVWriter.h"
+#include "Mona/MapWriter.h"
+
+using namespace std;
+
+namespace Mona {
+
+#define HEADER_RESERVED 16 // full header (12 bytes) + extended time
+
+RTMPLoadClient::RTMPLoadClient(LoadWorker& worker, bool publisher, const string& stream) : LoadClient(worker, publisher, stream), TCPClient(worker.io),
+	_address(publisher ? worker.config.publishAddress : worker.config.playAddress),
+	_handshaken(false), _chunkSize(128), _winAckSize(0), _unackBytes(0), _received(0), _streamId(0) {
+	onData = [this](Packet& buffer) { return receive(buffer); };
+	onError = [this](const Exception& ex) { fail(ex); };
+	onDisconnection = [this](const SocketAddress& address) { fail<Ex::Net::Socket>("RTMP disconnection"); };
+}
+
+RTMPLoadClient::~RTMPLoadClient() {
+	onDisconnection = nullptr;
+	onError = nullptr;
+	onData = nullptr;
+}
+
+bool RTMPLoadClient::connect(Exception& ex) {
+	if (!TCPClient::connect(ex, _address))
+		return false;
+	// C0 + C1 (simple handshake: time, zero, random)
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	writer.write8(3).write32(0).write32(0).writeRandom(1528);
+	return TCPClient::send(ex, Packet(pBuffer));
+}
+
+UInt32 RTMPLoadClient::receive(Packet& buffer) {
+	if (!_handshaken) {
+		// S0 + S1 + S2
+		if (buffer.size() < 3073)
+			return buffer.size();
+		_handshaken = true;
+		Exception ex;
+		// C2 = S1 echo, then a chunk size change to send messages without chunking, and "connect"
+		shared<Buffer> pBuffer(SET, buffer.data() + 1, 1536);
+		shared<Buffer> pChunkSize(SET, HEADER_RESERVED);
+		BinaryWriter(*pChunkSize).write32(0x7FFFFFFF);
+		if (!TCPClient::send(ex, Packet(pBuffer)) || !sendMessage(AMF::TYPE_CHUNKSIZE, 2, 0, pChunkSize)) {
+			fail(ex);
+			return 0;
+		}
+		shared<Buffer> pConnect(SET, HEADER_RESERVED);
+		AMFWriter amf(*pConnect, true);
+		amf.writeString(EXPAND("connect"));
+		amf.writeNumber(1);
+		amf.beginObject();
+		amf.writeStringProperty("app", "");
+		amf.writeStringProperty("tcUrl", String("rtmp://", _address, '/'));
+		amf.endObject();
+		if (!sendMessage(AMF::TYPE_INVOCATION, 3, 0, pConnect))
+			return 0;
+		buffer += 3073;
+	}
+
+	while (buffer) {
+		BinaryReader reader(buffer.data(), buffer.size());
+		UInt8 byte = reader.read8();
+		UInt8 format = byte >> 6;
+		UInt32 id = byte & 0x3F;
+		UInt8 headerSize = format == 3 ? 1 : (12 - 4 * format);
+		if (id < 2)
+			headerSize += id + 1;
+		if (reader.size() < headerSize)
+			return buffer.size();
+		if (id < 2)
+			id = (id ? reader.read16() : reader.read8()) + 64;
+
+		Channel& channel = _channels[id];
+		UInt32 time = channel.delta;
+		if (format < 3) {
+			time = reader.read24();
+			if (format < 2) {
+				channel.bodySize = reader.read24();
+				channel.type = AMF::Type(reader.read8());
+				if (!format)
+					reader.next(4); // stream id
+			}
+		}
+		if (time >= 0xFFFFFF) {
+			if (reader.available() < 4)
+				return buffer.size();
+			time = reader.read32();
+		}
+
+		UInt32 size = channel.bodySize;
+		if (!channel.pBuffer) {
+			// new message
+			if (format)
+				channel.time += time;
+			else
+				channel.time = time;
+			channel.delta = time;
+			channel.pBuffer.set();
+		} else
+			size -= channel.pBuffer->size();
+		if (size > _chunkSize)
+			size = _chunkSize;
+		if (reader.available() < size)
+			return buffer.size();
+		channel.pBuffer->append(reader.current(), size);
+		buffer += reader.position() + size;
+
+		// ack if required (window of the server)
+		_received += reader.position() + size;
+		if (_winAckSize && (_unackBytes += reader.position() + size) >= (_winAckSize >> 1)) {
+			_unackBytes = 0;
+			shared<Buffer> pAck(SET, HEADER_RESERVED);
+			BinaryWriter(*pAck).write32(_received);
+			if (!sendMessage(AMF::TYPE_ACK, 2, 0, pAck))
+				return 0;
+		}
+
+		if (channel.pBuffer->size() < channel.bodySize)
+			continue;
+		Packet packet(channel.pBuffer);
+		process(channel.type, channel.time, packet);
+		if (dead())
+			return 0;
+	}
+	return 0;
+}
+
+void RTMPLoadClient::process(AMF::Type type, UInt32 time, const Packet& packet) {
+	BinaryReader reader(packet.data(), packet.size());
+	switch (type) {
+		case AMF::TYPE_CHUNKSIZE:
+			_chunkSize = reader.read32();
+			break;
+		case AMF::TYPE_WIN_ACKSIZE:
+			_winAckSize = reader.read32();
+			break;
+		case AMF::TYPE_RAW:
+			if (reader.read16() == 6) {
+				// ping => pong
+				shared<Buffer> pPong(SET, HEADER_RESERVED);
+				BinaryWriter(*pPong).write16(7).write32(reader.read32());
+				sendMessage(AMF::TYPE_RAW, 2, 0, pPong);
+			}
+			break;
+		case AMF::TYPE_VIDEO: {
+			if (!packet.size())
+				break;
+			Media::Video::Tag tag;
+			UInt8 headerSize = FLVReader::ReadMediaHeader(packet.data(), packet.size(), tag);
+			tag.time = time;
+			writeVideo(tag, Packet(packet, packet.data() + headerSize, packet.size() - headerSize));
+			break;
+		}
+		case AMF::TYPE_INVOCATION_AMF3:
+			reader.next(); // AMF0 inside AMF3 message
+		case AMF::TYPE_INVOCATION: {
+			AMFReader amf(Packet(packet, reader.current(), reader.available()));
+			string name;
+			double transaction(0);
+			amf.readString(name);
+			amf.readNumber(transaction);
+			if (name == "_error")
+				return fail<Ex::Protocol>("RTMP ", transaction == 1 ? "connection" : "stream creation", " rejected");
+			if (name == "onStatus") {
+				amf.readNull();
+				Parameters status;
+				MapWriter<Parameters> writer(status);
+				if (amf.read(AMFReader::OBJECT, writer) && String::ICompare(status.getString("level", ""), "error") == 0)
+					fail<Ex::Protocol>("RTMP ", status.getString("code", "error"), ", ", status.getString("description", ""));
+				return;
+			}
+			if (name != "_result")
+				return;
+			if (transaction == 1) {
+				invoke("createStream", 2);
+				return;
+			}
+			if (transaction != 2)
+				return;
+			amf.readNull();
+			double streamId(0);
+			amf.readNumber(streamId);
+			_streamId = UInt32(streamId);
+			if (invoke(publisher ? "publish" : "play", 0, stream))
+				LoadClient::connected(); // session established (connect + createStream)
+			break;
+		}
+		default:;
+	}
+}
+
+bool RTMPLoadClient::invoke(const char* name, double transaction, const string& argument) {
+	shared<Buffer> pBuffer(SET, HEADER_RESERVED);
+	AMFWriter amf(*pBuffer, true);
+	amf.writeString(name, strlen(name));
+	amf.writeNumber(transaction);
+	amf.writeNull();
+	if (!argument.empty())
+		amf.writeString(argument.data(), argument.size());
+	return sendMessage(AMF::TYPE_INVOCATION, _streamId ? 4 : 3, 0, pBuffer);
+}
+
+bool RTMPLoadClient::write(const Media::Video::Tag& tag, const Packet& packet) {
+	if (!_streamId)
+		return false; // wait stream creation
+	shared<Buffer> pBuffer(SET, HEADER_RESERVED);
+	BinaryWriter writer(*pBuffer);
+	writer.write8(FLVWriter::ToCodecs(tag));
+	writer.write8(tag.frame == Media::Video::FRAME_CONFIG ? 0 : 1); // AVCPacketType
+	writer.write24(tag.compositionOffset);
+	Packet sps, pps;
+	if (tag.frame == Media::Video::FRAME_CONFIG && AVC::ParseVideoConfig(packet, sps, pps))
+		AVC::WriteVideoConfig(writer, sps, pps); // avcC
+	else
+		writer.write(packet);
+	return sendMessage(AMF::TYPE_VIDEO, 6, tag.time, pBuffer);
+}
+
+bool RTMPLoadClient::sendMessage(AMF::Type type, UInt32 channel, UInt32 time, shared<Buffer>& pBuffer) {
+	UInt32 size = pBuffer->size() - HEADER_RESERVED;
+	UInt8 headerSize = time >= 0xFFFFFF ? 16 : 12;
+	pBuffer->clip(HEADER_RESERVED - headerSize);
+	BinaryWriter writer(pBuffer->data(), headerSize);
+	writer.write8(channel); // format 0, full header
+	writer.write24(min(time, 0xFFFFFFu));
+	writer.write24(size);
+	writer.write8(type);
+	UInt32 streamId = channel == 2 ? 0 : _streamId;
+	writer.write8(streamId).write8(streamId >> 8).write8(streamId >> 16).write8(streamId >> 24); // little endian
+	if (time >= 0xFFFFFF)
+		writer.write32(time);
+	Exception ex;
+	if (TCPClient::send(ex, Packet(pBuffer)))
+		return true;
+	fail(ex);
+	return false;
+}
+
+} // namespace Mona
@@ -0,0 +1,64 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/TCPClient.h"
+#include "Mona/AMF.h"
+#include "LoadClient.h"
+
+namespace Mona {
+
+/*!
+RTMP client with simple handshake, publishes with "publish" or plays with "play" on a stream created after "connect".
+Messages are sent without chunking after a chunk size change, received messages support chunks */
+struct RTMPLoadClient : LoadClient, private TCPClient, virtual Object {
+	RTMPLoadClient(LoadWorker& worker, bool publisher, const std::string& stream);
+	~RTMPLoadClient();
+
+private:
+	bool	connect(Exception& ex);
+	bool	write(const Media::Video::Tag& tag, const Packet& packet);
+
+	UInt32	receive(Packet& buffer);
+	void	process(AMF::Type type, UInt32 time, const Packet& packet);
+	/*!
+	Send a message, pBuffer has to start with 16 bytes reserved to the header */
+	bool	sendMessage(AMF::Type type, UInt32 channel, UInt32 time, shared<Buffer>& pBuffer);
+	bool	invoke(const char* name, double transaction, const std::string& argument = String::Empty());
+
+	struct Channel : virtual Object {
+		Channel() : type(AMF::TYPE_EMPTY), time(0), delta(0), bodySize(0) {}
+		AMF::Type		type;
+		UInt32			time; // absolute
+		UInt32			delta;
+		UInt32			bodySize;
+		shared<Buffer>	pBuffer;
+	};
+	std::map<UInt32, Channel>	_channels;
+
+	SocketAddress	_address;
+	bool			_handshaken;
+	UInt32			_chunkSize;
+	UInt32			_winAckSize;
+	UInt32			_unackBytes;
+	UInt32			_received;
+	UInt32			_streamId;
+};
+
+} // namespace Mona
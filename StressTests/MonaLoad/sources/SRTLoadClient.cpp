@@ -0,0 +1,74 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "SRTLoadClient.h"
+#include "LoadWorker.h"
+
+#if defined(SRT_API)
+
+using namespace std;
+
+namespace Mona {
+
+SRTLoadClient::SRTLoadClient(LoadWorker& worker, bool publisher, const string& stream) : LoadClient(worker, publisher, stream), _begun(false),
+	_onReceived([this](shared<Buffer>& pBuffer, const SocketAddress& address) { _reader.read(Packet(pBuffer), self); }),
+	_onFlush([this]() { connected(); }), // first flush = connection
+	_onError([this](const Exception& ex) { fail(ex); }),
+	_onDisconnection([this]() { fail<Ex::Net::Socket>("SRT disconnection"); }),
+	_onWrite([this](const Packet& packet) {
+		// MTU chunks like MediaSocket::Writer
+		Exception ex;
+		UInt32 size = 0;
+		Packet chunk(packet);
+		while (chunk += size) {
+			size = min(chunk.size(), UInt32(Net::MTU_RELIABLE_SIZE));
+			if (_pSocket->write(ex, Packet(chunk, chunk.data(), size)) < 0)
+				return fail(ex);
+		}
+	}) {
+}
+
+SRTLoadClient::~SRTLoadClient() {
+	if (_pSocket)
+		worker.io.unsubscribe(_pSocket);
+}
+
+bool SRTLoadClient::connect(Exception& ex) {
+	shared<SRT::Socket> pSocket(SET);
+	string streamId("#!::r=");
+	size_t query = stream.find('?');
+	String::Append(streamId.append(stream, 0, query), publisher ? ",m=publish" : ",m=request");
+	if (!pSocket->setStreamId(ex, streamId.data(), streamId.size()))
+		return false;
+	_pSocket = pSocket;
+	if (!worker.io.subscribe(ex, _pSocket, _onReceived, _onFlush, _onError, _onDisconnection))
+		return false;
+	return _pSocket->connect(ex, publisher ? worker.config.publishAddress : worker.config.playAddress);
+}
+
+bool SRTLoadClient::write(const Media::Video::Tag& tag, const Packet& packet) {
+	if (!_begun) {
+		_begun = true;
+		_writer.beginMedia(_onWrite);
+	}
+	_writer.writeVideo(1, tag, packet, _onWrite);
+	return !dead();
+}
+
+} // namespace Mona
+
+#endif
@@ -0,0 +1,54 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/SRT.h"
+#include "Mona/TSReader.h"
+#include "Mona/TSWriter.h"
+#include "LoadClient.h"
+
+#if defined(SRT_API)
+
+namespace Mona {
+
+/*!
+SRT caller in MPEG-TS, publishes or plays with a "#!::r=name,m=publish|request" streamid */
+struct SRTLoadClient : LoadClient, virtual Object {
+	SRTLoadClient(LoadWorker& worker, bool publisher, const std::string& stream);
+	~SRTLoadClient();
+
+private:
+	bool connect(Exception& ex);
+	bool write(const Media::Video::Tag& tag, const Packet& packet);
+
+	Socket::OnReceived		_onReceived;
+	Socket::OnFlush			_onFlush;
+	Socket::OnError			_onError;
+	Socket::OnDisconnection	_onDisconnection;
+	MediaWriter::OnWrite	_onWrite;
+
+	shared<Socket>			_pSocket;
+	TSReader				_reader;
+	TSWriter				_writer;
+	bool					_begun;
+};
+
+} // namespace Mona
+
+#endif
@@ -0,0 +1,69 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#include "WSLoadClient.h"
+#include "LoadWorker.h"
+
+using namespace std;
+
+namespace Mona {
+
+WSLoadClient::WSLoadClient(LoadWorker& worker, bool publisher, const string& stream) : LoadClient(worker, publisher, stream), _client(worker.io, "WSLoadClient") {
+	_client.onFlush = [this]() { connected(); }; // first flush = connection
+	_client.onError = [this](const Exception& ex) { fail(ex); };
+	_client.onDisconnection = [this](const SocketAddress& address) { fail<Ex::Net::Socket>("WebSocket disconnection"); };
+	_client.onMessage = [this](DataReader& message) {
+		if (!_client.binaryData)
+			return; // JSON message (server information)
+		Media::Audio::Tag audio;
+		Media::Video::Tag video;
+		Media::Data::Type data;
+		UInt8 track;
+		BinaryReader reader(message.data(), message.size());
+		if (Media::Unpack(reader, audio, video, data, track) == Media::TYPE_VIDEO)
+			writeVideo(video, Packet(message, reader.current(), reader.available()), track);
+	};
+}
+
+WSLoadClient::~WSLoadClient() {
+	_client.onMessage = nullptr;
+	_client.onDisconnection = nullptr;
+	_client.onError = nullptr;
+	_client.onFlush = nullptr;
+}
+
+bool WSLoadClient::connect(Exception& ex) {
+	if (!_client.connect(ex, publisher ? worker.config.publishAddress : worker.config.playAddress, "/"))
+		return false;
+	shared<Buffer> pBuffer(SET);
+	String::Append(*pBuffer, publisher ? "[\"@publish\",\"" : "[\"@subscribe\",\"", stream, "\"]");
+	return _client.send(ex, Packet(pBuffer), WS::TYPE_TEXT);
+}
+
+bool WSLoadClient::write(const Media::Video::Tag& tag, const Packet& packet) {
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	Media::Pack(writer, tag);
+	writer.write(packet);
+	Exception ex;
+	if (_client.send(ex, Packet(pBuffer), WS::TYPE_BINARY))
+		return true;
+	fail(ex);
+	return false;
+}
+
+} // namespace Mona
@@ -0,0 +1,40 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/WS/WSClient.h"
+#include "LoadClient.h"
+
+namespace Mona {
+
+/*!
+WebSocket client, publishes with "@publish" or plays with "@subscribe",
+media are binary messages prefixed by a Media::Pack header */
+struct WSLoadClient : LoadClient, virtual Object {
+	WSLoadClient(LoadWorker& worker, bool publisher, const std::string& stream);
+	~WSLoadClient();
+
+private:
+	bool connect(Exception& ex);
+	bool write(const Media::Video::Tag& tag, const Packet& packet);
+
+	WSClient	_client;
+};
+
+} // namespace Mona
@@ -0,0 +1,188 @@
+
+#include "Mona/ServerApplication.h"
+#include "Mona/File.h"
+#include "LoadWorker.h"
+#include "Version.h"
+
+#define VERSION		"1." STRINGIFY(MONA_VERSION)
+
+using namespace std;
+using namespace Mona;
+
+/*!
+Print publishers and viewers statistics every second, and stop the application when duration is elapsed */
+struct Reporter : Thread {
+	Reporter(TerminateSignal& terminateSignal, LoadStats& publishers, UInt32 expectedPublishers, LoadStats& viewers, UInt32 expectedViewers, UInt32 duration) :
+		Thread("LoadReporter"), _terminateSignal(terminateSignal), _publishers(publishers), _expectedPublishers(expectedPublishers),
+		_viewers(viewers), _expectedViewers(expectedViewers), _duration(duration) {}
+	~Reporter() { stop(); }
+
+private:
+	bool run(Exception&, const volatile bool& requestStop) {
+		Int64 start = Metrics::Microseconds();
+		while (!requestStop) {
+			if (wakeUp.wait(1000))
+				continue;
+			string line;
+			if (_expectedPublishers)
+				NOTE(_publishers.report(line, "Publishers", _expectedPublishers));
+			if (_expectedViewers)
+				NOTE(_viewers.report(line.assign(""), "Viewers", _expectedViewers));
+			if (_duration && (Metrics::Microseconds() - start) >= Int64(_duration) * 1000000) {
+				_terminateSignal.set();
+				break;
+			}
+		}
+		return true;
+	}
+
+	TerminateSignal&	_terminateSignal;
+	LoadStats&			_publishers;
+	UInt32				_expectedPublishers;
+	LoadStats&			_viewers;
+	UInt32				_expectedViewers;
+	UInt32				_duration;
+};
+
+struct LoadApp : ServerApplication  {
+
+	LoadApp() { setString("description", "MonaLoad, load generator for RTMP, HTTP-FLV, HLS, WebSocket and SRT"); }
+
+	const char* defineVersion() { return VERSION; }
+
+	void defineOptions(Exception& ex, Options& options) {
+		options.add(ex, "publish", "pub", "Publishing protocol: rtmp, http, ws or srt. Default value is rtmp.")
+			.argument("protocol");
+		options.add(ex, "play", "pl", "Playing protocol: rtmp, http, hls, ws or srt. Default value is rtmp.")
+			.argument("protocol");
+		options.add(ex, "host", "ho", "Server host, default value is 127.0.0.1, port is the protocol default port (1935 for RTMP, 80 for HTTP, HLS and WebSocket, 9710 for SRT).")
+			.argument("host");
+		options.add(ex, "publishAddress", "pa", "Publishing address (host:port), overrides host option for publishers.")
+			.argument("address");
+		options.add(ex, "playAddress", "pla", "Playing address (host:port), overrides host option for viewers.")
+			.argument("address");
+		options.add(ex, "publishers", "np", "Number of publishers, each one publishes its own stream. Default value is 1.")
+			.argument("number");
+		options.add(ex, "viewers", "nv", "Number of viewers, distributed on streams published. Default value is 0.")
+			.argument("number");
+		options.add(ex, "streams", "ns", "Number of streams to play when there is no publisher (streams already published by an other tool). Default value is 1.")
+			.argument("number");
+		options.add(ex, "name", "n", "Stream name prefix, stream index is appended. Default value is load.")
+			.argument("name");
+		options.add(ex, "query", "q", "Publication parameters, \"segments=4\" by default when playing with HLS.")
+			.argument("query");
+		options.add(ex, "fps", "f", "Frame rate of the generated video. Default value is 25.")
+			.argument("number");
+		options.add(ex, "bitrate", "b", "Bitrate of the generated video in kbps. Default value is 500.")
+			.argument("kbps");
+		options.add(ex, "keyInterval", "k", "Key frame interval in frames. Default value is twice fps.")
+			.argument("frames");
+		options.add(ex, "ramp", "ra", "Number of new clients by second, 0 creates all the clients immediately. Default value is 0.")
+			.argument("number");
+		options.add(ex, "threads", "t", String("Number of worker threads. Default value is ", Thread::ProcessorCount(), '.'))
+			.argument("number");
+		options.add(ex, "duration", "du", "Test duration in seconds, 0 runs until Ctrl+C. Default value is 0.")
+			.argument("seconds");
+		options.add(ex, "metrics", "m", "File where writing statistics in Prometheus text format at the end of the test.")
+			.argument("file");
+
+		// defines parent options
+		ServerApplication::defineOptions(ex, options);
+	}
+
+	bool resolve(Exception& ex, const char* option, LoadClient::Protocol protocol, SocketAddress& address) {
+		const char* value = getString(String("arguments.", option));
+		if (value)
+			return address.setWithDNS(ex, value);
+		UInt16 port;
+		switch (protocol) {
+			case LoadClient::PROTOCOL_RTMP: port = 1935; break;
+			case LoadClient::PROTOCOL_SRT: port = 9710; break;
+			default: port = 80;
+		}
+		return address.setWithDNS(ex, getString("arguments.host", "127.0.0.1"), port);
+	}
+
+///// MAIN
+	int main(TerminateSignal& terminateSignal) {
+		Exception ex;
+		LoadWorker::Config config;
+		if (!LoadClient::ParseProtocol(getString("arguments.publish", "rtmp"), config.publishProtocol) || config.publishProtocol == LoadClient::PROTOCOL_HLS) {
+			ERROR("Publishing protocol ", getString("arguments.publish"), " unsupported");
+			return Application::EXIT_USAGE;
+		}
+		if (!LoadClient::ParseProtocol(getString("arguments.play", "rtmp"), config.playProtocol)) {
+			ERROR("Playing protocol ", getString("arguments.play"), " unsupported");
+			return Application::EXIT_USAGE;
+		}
+#if !defined(SRT_API)
+		if (config.publishProtocol == LoadClient::PROTOCOL_SRT || config.playProtocol == LoadClient::PROTOCOL_SRT) {
+			ERROR("SRT unsupported, build with ENABLE_SRT");
+			return Application::EXIT_USAGE;
+		}
+#endif
+		config.publishers = getNumber<UInt32, 1>("arguments.publishers");
+		config.viewers = getNumber<UInt32>("arguments.viewers");
+		config.streams = max(getNumber<UInt32, 1>("arguments.streams"), 1u);
+		config.ramp = getNumber<double>("arguments.ramp");
+		config.threads = Thread::ProcessorCount();
+		getNumber("arguments.threads", config.threads);
+		if (!config.threads)
+			config.threads = 1;
+		config.name = getString("arguments.name", "load");
+		if(!getString("arguments.query", config.query) && config.playProtocol == LoadClient::PROTOCOL_HLS)
+			config.query = "segments=4";
+		if ((config.publishers && !resolve(ex, "publishAddress", config.publishProtocol, config.publishAddress)) ||
+			(config.viewers && !resolve(ex, "playAddress", config.playProtocol, config.playAddress))) {
+			ERROR(ex);
+			return Application::EXIT_NOHOST;
+		}
+
+		UInt16 fps = max(getNumber<UInt16, 25>("arguments.fps"), UInt16(1));
+		UInt16 keyInterval(fps * 2);
+		getNumber("arguments.keyInterval", keyInterval);
+		Generator generator(fps, getNumber<UInt32, 500>("arguments.bitrate") * 1000, max(keyInterval, UInt16(1)));
+
+		LoadStats publishers("publisher", LoadClient::ProtocolToString(config.publishProtocol));
+		LoadStats viewers("viewer", LoadClient::ProtocolToString(config.playProtocol));
+
+		NOTE(config.publishers, " ", LoadClient::ProtocolToString(config.publishProtocol), " publishers on ", config.publishAddress, ", ",
+			config.viewers, " ", LoadClient::ProtocolToString(config.playProtocol), " viewers on ", config.playAddress, ", ", config.threads, " threads");
+
+		ThreadPool threadPool;
+		vector<unique<LoadWorker>> workers;
+		for (UInt16 i = 0; i < config.threads; ++i) {
+			workers.emplace_back(SET, i, config, generator, threadPool, publishers, viewers);
+			workers.back()->start();
+		}
+		Reporter reporter(terminateSignal, publishers, config.publishers, viewers, config.viewers, getNumber<UInt32>("arguments.duration"));
+		reporter.start();
+
+		terminateSignal.wait();
+
+		reporter.stop();
+		string line;
+		if (config.publishers)
+			NOTE(publishers.summary(line, "Publishers summary", config.publishers));
+		if (config.viewers)
+			NOTE(viewers.summary(line.assign(""), "Viewers summary", config.viewers));
+		workers.clear();
+		threadPool.join();
+
+		const char* metrics = getString("arguments.metrics");
+		if (metrics) {
+			Metrics::Write(line.assign(""));
+			File file(metrics, File::MODE_WRITE);
+			if (!file.write(ex, line.data(), line.size())) {
+				ERROR(ex);
+				return Application::EXIT_CANTCREAT;
+			}
+		}
+		return Application::EXIT_OK;
+	}
+
+};
+
+int main(int argc, const char* argv[]) {
+	return LoadApp().run(argc, argv);
+}
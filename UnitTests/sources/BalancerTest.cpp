@@ -0,0 +1,99 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/Balancer.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace BalancerTest {
+
+typedef Balancer::Node Node;
+
+static Node NewNode(UInt64 id, Int64 time, UInt32 clients) {
+	Node node;
+	node.id = id;
+	node.time = time;
+	node.clients = clients;
+	node.byteRate = clients * 1000ull;
+	node.cpu = UInt8(clients);
+	return node;
+}
+
+ADD_TEST(Report) {
+	const Int64 time(1000000);
+	Node local = NewNode(1, time, 10);
+	local.addresses.emplace("RTMP", SocketAddress(IPAddress::Loopback(), 1935));
+	local.addresses.emplace("HTTP", SocketAddress(IPAddress::Wildcard(), 80)); // not explicit, ignored by the reader
+	map<SocketAddress, Node> nodes;
+	nodes.emplace(SocketAddress(IPAddress::Loopback(), 2000), NewNode(2, time - 500, 20));
+	nodes.emplace(SocketAddress(IPAddress::Loopback(), 3000), NewNode(3, time - 1500, 30));
+
+	Exception ex;
+	Int64 readTime;
+	Balancer::Records records;
+	shared<Buffer> pBuffer = Balancer::WriteReport("key", time, SocketAddress(IPAddress::Loopback(), 1000), local, nodes);
+	CHECK(Balancer::ReadReport(ex, "key", Packet(pBuffer), readTime, records) && !ex && readTime == time);
+	CHECK(records.size() == 3);
+	// sender first
+	CHECK(records[0].first == SocketAddress(IPAddress::Loopback(), 1000));
+	const Node& sender = records[0].second;
+	CHECK(sender.id == 1 && sender.time == time && sender.clients == 10 && sender.byteRate == 10000 && sender.cpu == 10);
+	CHECK(sender.addresses.size() == 1 && sender.addresses.begin()->first == "RTMP" && sender.addresses.begin()->second == SocketAddress(IPAddress::Loopback(), 1935));
+	// nodes known, with their age
+	CHECK(records[1].first == SocketAddress(IPAddress::Loopback(), 2000) && records[1].second.id == 2 && records[1].second.time == (time - 500) && records[1].second.clients == 20);
+	CHECK(records[2].first == SocketAddress(IPAddress::Loopback(), 3000) && records[2].second.id == 3 && records[2].second.time == (time - 1500) && records[2].second.clients == 30);
+
+	// sender without public address
+	records.clear();
+	pBuffer = Balancer::WriteReport("key", time, SocketAddress::Wildcard(), local, map<SocketAddress, Node>());
+	CHECK(Balancer::ReadReport(ex, "key", Packet(pBuffer), readTime, records) && !ex && records.size() == 1 && !records[0].first);
+}
+
+ADD_TEST(Signature) {
+	const Int64 time(1000000);
+	Node local = NewNode(1, time, 10);
+	shared<Buffer> pBuffer = Balancer::WriteReport("key", time, SocketAddress(IPAddress::Loopback(), 1000), local, map<SocketAddress, Node>());
+	Packet report(pBuffer);
+
+	Exception ex;
+	Int64 readTime;
+	Balancer::Records records;
+	// wrong key
+	CHECK(!Balancer::ReadReport(ex, "other", report, readTime, records) && ex && records.empty());
+	// sending time altered (replay with a new time)
+	ex = nullptr;
+	shared<Buffer> pAltered(SET, report.data(), report.size());
+	++pAltered->data()[8];
+	CHECK(!Balancer::ReadReport(ex, "key", Packet(pAltered), readTime, records) && ex && records.empty());
+	// truncated
+	ex = nullptr;
+	CHECK(!Balancer::ReadReport(ex, "key", Packet(report, report.data(), 10), readTime, records) && ex && records.empty());
+	// unsigned report, just its version is checked
+	ex = nullptr;
+	pBuffer = Balancer::WriteReport("", time, SocketAddress(IPAddress::Loopback(), 1000), local, map<SocketAddress, Node>());
+	report.set(pBuffer);
+	CHECK(Balancer::ReadReport(ex, "", report, readTime, records) && !ex && readTime == time && records.size() == 1);
+	records.clear();
+	pAltered.set(report.data(), report.size());
+	++pAltered->data()[0];
+	CHECK(!Balancer::ReadReport(ex, "", Packet(pAltered), readTime, records) && ex && ex.cast<Ex::Unsupported>() && records.empty());
+}
+
+}
@@ -18,6 +18,7 @@ details (or else see http://www.gnu.org/licenses/).
 
 #include "Mona/UnitTest.h"
 #include "Mona/BufferPool.h"
+#include "Mona/Packet.h"
 
 using namespace Mona;
 using namespace std;
@@ -78,4 +79,42 @@ ADD_TEST(BufferPool) {
 	CHECK(buffer1.capacity() == 1024);
 }
 
+ADD_TEST(BufferTag) {
+	Buffer::Tag& tag1(Buffer::Tag::Get("BufferTest1"));
+	Buffer::Tag& tag2(Buffer::Tag::Get("BufferTest2"));
+	CHECK(&Buffer::Tag::Get("BufferTest1") == &tag1 && tag1.owner == "BufferTest1");
+
+	Buffer::Tag::Enable(true);
+	{
+		shared<Buffer> pBuffer;
+		{
+			Buffer::Tag::Scope scope(tag1);
+			pBuffer.set(100);
+			CHECK(tag1.bytes() == 128);
+			pBuffer->resize(1000);
+			CHECK(tag1.bytes() == 1024);
+		}
+		Buffer buffer(10); // out of scope => "other"
+		CHECK(tag1.bytes() == 1024);
+
+		Packet packet(pBuffer);
+		tag2.adopt(packet.buffer());
+		CHECK(tag1.bytes() == 0 && tag2.bytes() == 1024);
+	}
+	CHECK(tag1.bytes() == 0 && tag2.bytes() == 0);
+
+	Buffer::Tag::Enable(false);
+	Buffer::Tag::Scope scope(tag1);
+	Buffer buffer(10);
+	CHECK(tag1.bytes() == 0);
+
+	// tags count limited, beyond owners share the tag of their prefix
+	for (UInt32 i = 0; i < Buffer::Tag::MAX_COUNT; ++i)
+		Buffer::Tag::Get(String("BufferTest/", i));
+	Buffer::Tag& shared(Buffer::Tag::Get("BufferTest/shared"));
+	CHECK(shared.owner == "BufferTest/*" && &Buffer::Tag::Get("BufferTest/other") == &shared);
+	CHECK(Buffer::Tag::Get("BufferTestOther").owner == "other");
+	CHECK(&Buffer::Tag::Get("BufferTest1") == &tag1);
+}
+
 }
@@ -18,6 +18,10 @@ details (or else see http://www.gnu.org/licenses/).
 
 #include "Mona/UnitTest.h"
 #include "Mona/DNS.h"
+#include "Mona/DNSResolver.h"
+#include "Mona/TCPServer.h"
+#include "Mona/BinaryWriter.h"
+#include "Mona/File.h"
 
 using namespace std;
 using namespace Mona;
@@ -69,5 +73,234 @@ ADD_TEST(HostByAddress) {
 	CHECK(ex)
 }
 
+
+struct MainHandler : Handler {
+	MainHandler() : Handler(_signal) {}
+	Timer timer;
+	bool join(const function<bool()>& joined) {
+		Time time;
+		while (flush(), !joined()) {
+			if (time.isElapsed(14000))
+				return false;
+			UInt32 timeout = timer.raise();
+			_signal.wait(timeout && timeout < 14000 ? timeout : 14000);
+		}
+		return true;
+	}
+private:
+	Signal _signal;
+};
+static ThreadPool _ThreadPool;
+
+/*!
+Stub DNS server answering on UDP and TCP:
+- mona.test => 1.2.3.4 and 2001:db8::1
+- alias.test => CNAME mona.test
+- big.test => truncated on UDP, 5.6.7.8 on TCP
+- other => NXDOMAIN */
+struct DNSServer : UDPSocket {
+	DNSServer(IOSocket& io) : UDPSocket(io), _tcp(io), requests(0), silent(false) {
+		onError = _tcp.onError = [](const Exception& ex) { FATAL_ERROR("DNSServer, ", ex); };
+		onPacket = [this](shared<Buffer>& pBuffer, const SocketAddress& address) {
+			++requests;
+			ports.emplace(address.port());
+			if (silent)
+				return;
+			shared<Buffer> pAnswer = answer(*pBuffer, false);
+			Exception ex;
+			CHECK(send(ex, Packet(pAnswer), address) && !ex);
+		};
+		_tcp.onConnection = [this](const shared<Socket>& pSocket) {
+			_connections.emplace_back(SET, _tcp.io);
+			TCPClient& connection = *_connections.back();
+			connection.onError = _tcp.onError;
+			connection.onData = [this, &connection](Packet& buffer) -> UInt32 {
+				if (buffer.size() < 2 || buffer.size() < (BinaryReader(buffer.data(), 2).read16() + 2u))
+					return buffer.size();
+				++requests;
+				Buffer request(buffer.size() - 2);
+				memcpy(request.data(), buffer.data() + 2, request.size());
+				shared<Buffer> pAnswer = answer(request, true);
+				Exception ex;
+				CHECK(connection.send(ex, Packet(pAnswer)) && !ex);
+				return 0;
+			};
+			Exception ex;
+			CHECK(connection.connect(ex, pSocket) && !ex);
+		};
+		Exception ex;
+		CHECK(bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && !ex);
+		CHECK(_tcp.start(ex, SocketAddress(IPAddress::Loopback(), self->address().port())) && !ex);
+	}
+	~DNSServer() {
+		for (unique<TCPClient>& pConnection : _connections) {
+			pConnection->onData = nullptr;
+			pConnection->onError = nullptr;
+		}
+		_tcp.onConnection = nullptr;
+		onPacket = nullptr;
+		onError = nullptr;
+		_tcp.onError = nullptr;
+	}
+
+	UInt32		requests;
+	set<UInt16>	ports; // source ports of UDP requests
+	bool		silent;
+
+private:
+	shared<Buffer> answer(const Buffer& request, bool tcp) {
+		BinaryReader reader(request.data(), request.size());
+		UInt16 id = reader.read16();
+		reader.next(10);
+		UInt32 position = reader.position();
+		string name;
+		while (UInt8 length = reader.read8()) {
+			if (!name.empty())
+				name += '.';
+			name.append(STR reader.current(), length);
+			reader.next(length);
+		}
+		UInt16 type = reader.read16();
+		reader.next(2);
+
+		shared<Buffer> pBuffer(SET);
+		BinaryWriter writer(*pBuffer);
+		if (tcp)
+			writer.write16(0);
+		UInt16 flags = 0x8180;
+		vector<pair<UInt16, string>> records;
+		if (name == "alias.test") {
+			records.emplace_back(5, string("\x04mona\x04test\x00", 11));
+			name = "mona.test";
+		}
+		if (name == "mona.test") {
+			if (type == 1)
+				records.emplace_back(1, string("\x01\x02\x03\x04", 4));
+			else
+				records.emplace_back(28, string("\x20\x01\x0d\xb8\0\0\0\0\0\0\0\0\0\0\0\x01", 16));
+		} else if (name == "big.test") {
+			if (!tcp)
+				flags |= 0x0200;
+			else if (type == 1)
+				records.emplace_back(1, string("\x05\x06\x07\x08", 4));
+		} else
+			flags |= 3; // NXDOMAIN
+		writer.write16(id).write16(flags).write16(1).write16(UInt16(records.size())).write16(0).write16(0);
+		writer.write(request.data() + position, reader.position() - position); // question
+		UInt16 owner = 0xC00C; // pointer on question name
+		for (auto& record : records) {
+			writer.write16(owner).write16(record.first).write16(1).write32(60).write16(UInt16(record.second.size()));
+			if (record.first == 5)
+				owner = 0xC000 | UInt16(pBuffer->size() - (tcp ? 2 : 0));
+			writer.write(record.second.data(), record.second.size());
+		}
+		if (tcp)
+			BinaryWriter(pBuffer->data(), 2).write16(pBuffer->size() - 2);
+		return pBuffer;
+	}
+
+	TCPServer			_tcp;
+	vector<unique<TCPClient>>	_connections;
+};
+
+ADD_TEST(Resolver) {
+	MainHandler handler;
+	IOSocket	io(handler, _ThreadPool);
+	DNSServer	server(io);
+	DNSResolver	resolver(io, handler.timer);
+	resolver.setServers({ SocketAddress(IPAddress::Loopback(), server->address().port()) });
+
+	UInt32 results = 0;
+	Exception ex;
+	unique<HostEntry> pHost;
+	DNSResolver::OnResolved onResolved([&](const Exception& exResult, const HostEntry& host) {
+		ex = exResult;
+		pHost.set(host);
+		++results;
+	});
+	function<bool(const char*)> has([&](const char* address) {
+		for (const IPAddress& ip : pHost->addresses()) {
+			if (ip == address)
+				return true;
+		}
+		return false;
+	});
+
+	// A and AAAA
+	resolver.resolve("Mona.Test.", onResolved);
+	CHECK(resolver.pending() == 1 && handler.join([&]() { return results == 1; }));
+	CHECK(!ex && pHost->name() == "mona.test" && pHost->addresses().size() == 2 && server.requests == 2);
+	CHECK(has("1.2.3.4") && has("2001:db8::1"));
+	CHECK(resolver.cached() == 1 && !resolver.pending());
+	CHECK(server.ports.size() == 2); // socket by request
+
+	// cache
+	resolver.resolve("mona.test", onResolved);
+	CHECK(handler.join([&]() { return results == 2; }) && !ex && pHost->addresses().size() == 2 && server.requests == 2);
+
+	// CNAME, and concurrent resolutions share the same requests
+	resolver.resolve("alias.test", onResolved);
+	resolver.resolve("alias.test", onResolved);
+	CHECK(handler.join([&]() { return results == 4; }) && !ex && server.requests == 4);
+	CHECK(pHost->name() == "mona.test" && pHost->aliases().size() == 1 && pHost->aliases()[0] == "alias.test" && pHost->addresses().size() == 2);
+
+	// truncated => TCP
+	resolver.resolve("big.test", onResolved);
+	CHECK(handler.join([&]() { return results == 5; }) && !ex && server.requests == 8); // A and AAAA on UDP then on TCP
+	CHECK(pHost->addresses().size() == 1 && *pHost->addresses().begin() == "5.6.7.8");
+
+	// not found
+	resolver.resolve("unknown.test", onResolved);
+	CHECK(handler.join([&]() { return results == 6; }) && ex && resolver.cached() == 3);
+
+	// IP address, without request
+	UInt32 requests = server.requests;
+	resolver.resolve("127.0.0.1", onResolved);
+	CHECK(handler.join([&]() { return results == 7; }) && !ex && pHost->addresses().size() == 1 && *pHost->addresses().begin() == IPAddress::Loopback() && server.requests == requests);
+
+	// hosts file
+	CHECK(File("temp.hosts", File::MODE_WRITE).write(ex, EXPAND("# comment\n10.0.0.1 myhost.test myalias # comment\n::1 myhost.test\n")) && !ex);
+	CHECK(resolver.loadHosts(ex, "temp.hosts") && !ex);
+	resolver.resolve("MyAlias", onResolved);
+	CHECK(handler.join([&]() { return results == 8; }) && !ex && pHost->name() == "myhost.test" && pHost->addresses().size() == 1 && server.requests == requests);
+	resolver.resolve("myhost.test", onResolved);
+	CHECK(handler.join([&]() { return results == 9; }) && !ex && pHost->addresses().size() == 2 && server.requests == requests);
+	CHECK(FileSystem::Delete(ex, "temp.hosts") && !ex);
+
+	// cache limited, entries which expire first are removed (same TTL, so the older)
+	resolver.setMaxCached(2);
+	resolver.clearCache();
+	resolver.resolve("mona.test", onResolved);
+	CHECK(handler.join([&]() { return results == 10; }) && !ex && resolver.cached() == 1);
+	Thread::Sleep(2); // expirations distinct
+	resolver.resolve("alias.test", onResolved);
+	CHECK(handler.join([&]() { return results == 11; }) && !ex && resolver.cached() == 2);
+	resolver.resolve("big.test", onResolved);
+	CHECK(handler.join([&]() { return results == 12; }) && !ex && resolver.cached() == 2);
+	requests = server.requests;
+	resolver.resolve("big.test", onResolved); // in cache
+	CHECK(handler.join([&]() { return results == 13; }) && !ex && server.requests == requests);
+	resolver.resolve("mona.test", onResolved); // removed
+	CHECK(handler.join([&]() { return results == 14; }) && !ex && server.requests == (requests + 2));
+	requests = server.requests;
+
+	// timeout
+	server.silent = true;
+	resolver.setTimeout(100);
+	resolver.setAttempts(2);
+	resolver.resolve("mona.test.", onResolved); // in cache
+	resolver.resolve("timeout.test", onResolved);
+	CHECK(handler.join([&]() { return results == 16; }) && ex && server.requests == (requests + 4));
+
+	// expired subscriber is not raised
+	{
+		DNSResolver::OnResolved onExpired([](const Exception& ex, const HostEntry& host) { FATAL_ERROR("Expired subscriber raised"); });
+		resolver.resolve("expired.test", onExpired);
+	}
+	CHECK(handler.join([&]() { return !resolver.pending(); }));
+
+	_ThreadPool.join();
+	handler.flush();
 }
 
+}
@@ -143,6 +143,10 @@ ADD_TEST(ParseISO8601) {
 	CHECK(Parse("2005-01-08", 2005, 1, 8,6, 0, 0, 0, 0, Timezone::LOCAL));
 
 	CHECK(Parse("2005", 2005, 1, 1, 6, 0, 0, 0, 0, Timezone::LOCAL,Date::FORMAT_ISO8601));
+
+	// shape
+	CHECK(Date::IsISO8601(EXPAND("2005-01-08T12:30:00Z")) && Date::IsISO8601(EXPAND("2005-01-08")) && Date::IsISO8601(EXPAND("2005-01-08 12:30:00")) && Date::IsISO8601(EXPAND("20050108T123000Z")));
+	CHECK(!Date::IsISO8601(EXPAND("2005")) && !Date::IsISO8601(EXPAND("2005-01-08X")) && !Date::IsISO8601(EXPAND("Sat, 8 Jan 05 12:30:00 GMT")) && !Date::IsISO8601(EXPAND("hello world")));
 }
 
 ADD_TEST(ParseISO8601Frac) {
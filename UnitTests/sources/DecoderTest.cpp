@@ -134,9 +134,10 @@ ADD_TEST(File) {
 		typedef Event<void(Decoded&)> ON(Decoded);
 		Decoder(const Handler& handler) : _handler(handler) {}
 	private:
-		UInt32 decode(shared<Buffer>& pBuffer, bool end) override {
+		UInt32 decode(shared<const Buffer>& pBuffer, bool end) override {
 			CHECK(Thread::CurrentId() != Thread::MainId);
 			Packet packet(pBuffer);
+			pBuffer.reset(); // captured
 			_handler.queue(onDecoded, packet, end);
 			if (end)
 				return 0;
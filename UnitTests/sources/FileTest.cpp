@@ -44,6 +44,11 @@ ADD_TEST(File) {
 		CHECK(file.read(ex, data, 20) == 10 && file.readen() == 10 && !ex && memcmp(data, EXPAND("SalutSalut")) == 0);
 		CHECK(!file.write(ex, data, sizeof(data)) && ex && ex.cast<Ex::Permission>());
 		ex = nullptr;
+		// random access
+		CHECK(file.reset(7) && file.readen() == 7);
+		CHECK(file.read(ex, data, 20) == 3 && !ex && memcmp(data, EXPAND("lut")) == 0);
+		CHECK(file.reset(2) && file.read(ex, data, 3) == 3 && !ex && memcmp(data, EXPAND("lut")) == 0);
+		CHECK(!file.reset(11));
 	}
 
 	{
@@ -66,6 +71,14 @@ struct MainHandler : Handler {
 		};
 		return count == (done += Handler::flush(true));
 	}
+	bool join(const function<bool()>& done) {
+		// keep signal (no last flush) to allow multiple joins
+		while (Handler::flush(), !done()) {
+			if (!_signal.wait(14000))
+				return false;
+		}
+		return true;
+	}
 
 private:
 	void flush() {}
@@ -73,6 +86,18 @@ private:
 };
 static ThreadPool	_ThreadPool;
 
+static Int64 Metric(const char* name) {
+	string text;
+	Metrics::Write(text);
+	size_t position = text.find(String("\n", name, ' '));
+	if (position == string::npos)
+		return 0;
+	position += strlen(name) + 2;
+	Int64 value(0);
+	String::ToNumber(text.data() + position, text.find('\n', position) - position, value);
+	return value;
+}
+
 ADD_TEST(FileReader) {
 	MainHandler handler;
 	IOFile		io(handler, _ThreadPool);
@@ -84,7 +109,7 @@ ADD_TEST(FileReader) {
 	reader.onError = [](const Exception& ex) {
 		FATAL_ERROR("FileReader, ", ex);
 	};
-	reader.onReaden = [&](shared<Buffer>& pBuffer, bool end) {
+	reader.onReaden = [&](shared<const Buffer>& pBuffer, bool end) {
 		if (pBuffer->size() > 3) {
 			CHECK(pBuffer->size() == 5 && memcmp(pBuffer->data(), EXPAND("Salut")) == 0 && end);
 			reader.close();
@@ -137,4 +162,112 @@ ADD_TEST(FileWriter) {
 	CHECK(FileSystem::Delete(ex, name) && !ex);
 }
 
+ADD_TEST(FileCache) {
+	MainHandler handler;
+	IOFile		io(handler, _ThreadPool);
+	io.cache.setBudget(0x10000);
+	io.cache.setStableDelay(0); // cache immediatly the file written
+	const char* name("temp.mona");
+	Exception ex;
+	CHECK(File(name, File::MODE_WRITE).write(ex, EXPAND("Salut")) && !ex);
+	Int64 hits = Metric("mona_filecache_hits_total");
+	Int64 misses = Metric("mona_filecache_misses_total");
+	Int64 mapped = Metric("mona_filecache_bytes");
+
+	FileReader reader(io);
+	reader.onError = [](const Exception& ex) {
+		FATAL_ERROR("FileReader, ", ex);
+	};
+	UInt32 readen = 0;
+	reader.onReaden = [&](shared<const Buffer>& pBuffer, bool end) {
+		CHECK(pBuffer->size() == 5 && memcmp(pBuffer->data(), EXPAND("Salut")) == 0 && end);
+		reader.close();
+		if (++readen < 2)
+			reader.open(name).read();
+	};
+	reader.open(name).read();
+	CHECK(handler.join([&]() { return readen == 2; }));
+	CHECK(io.cache.misses() == 1 && io.cache.hits() == 1 && io.cache.count() == 1 && io.cache.size() == 5);
+	CHECK(Metric("mona_filecache_hits_total") - hits == 1 && Metric("mona_filecache_misses_total") - misses == 1 && Metric("mona_filecache_bytes") - mapped == 5);
+
+	// truncated by an other writer, mapping is not readen beyond the new end
+	CHECK(File(name, File::MODE_WRITE).write(ex, EXPAND("Sa")) && !ex);
+	reader.onReaden = nullptr;
+	reader.onReaden = [&](shared<const Buffer>& pBuffer, bool end) {
+		CHECK(pBuffer->size() == 2 && memcmp(pBuffer->data(), EXPAND("Sa")) == 0 && end);
+		reader.close();
+		++readen;
+	};
+	reader.open(name).read();
+	CHECK(handler.join([&]() { return readen == 3; }));
+
+	// writing invalidates the cache
+	FileWriter writer(io);
+	writer.onError = [](const Exception& ex) {
+		FATAL_ERROR("FileWriter, ", ex);
+	};
+	writer.open(name, true).write(Packet(EXPAND("Salut")));
+	io.join();
+	CHECK(!io.cache.count() && !io.cache.size() && Metric("mona_filecache_bytes") == mapped);
+	writer.close();
+	CHECK(FileSystem::Delete(ex, name) && !ex);
+}
+
+ADD_TEST(FileWatcher) {
+	MainHandler handler;
+	IOFile		io(handler, _ThreadPool);
+	Exception	ex;
+	const char* folder("temp.watch/sub/");
+	CHECK(FileSystem::CreateDirectory(ex, folder, FileSystem::MODE_HEAVY) && !ex);
+	CHECK(File("temp.watch/first.txt", File::MODE_WRITE).write(ex, EXPAND("Salut")) && !ex);
+
+	UInt32 updates = 0;
+	bool exists = false;
+	FileWatcher::OnUpdate onUpdate([&](const Path& file, bool firstWatch) {
+		// first watch signals existing files
+		CHECK(firstWatch == !updates && file.name() == (firstWatch ? "first.txt" : "test.txt"));
+		exists = file.exists();
+		++updates;
+	});
+	shared<const FileWatcher> pWatcher(SET, Path("temp.watch/*.txt"), FileSystem::MODE_HEAVY);
+	io.watch(pWatcher, onUpdate);
+	CHECK(handler.join([&]() { return updates == 1; }) && exists);
+
+	Path path(folder, "test.txt");
+	CHECK(File(path, File::MODE_WRITE).write(ex, EXPAND("Salut")) && !ex);
+	CHECK(handler.join([&]() { return updates == 2; }) && exists);
+	CHECK(FileSystem::Delete(ex, path) && !ex);
+	CHECK(handler.join([&]() { return updates == 3; }) && !exists);
+
+	pWatcher.reset();
+	CHECK(FileSystem::Delete(ex, "temp.watch/", FileSystem::MODE_HEAVY) && !ex);
+}
+
+ADD_TEST(FileWatcherRelative) {
+	MainHandler handler;
+	IOFile		io(handler, _ThreadPool);
+	Exception	ex;
+	const char* name("temp.mona");
+	CHECK(File(name, File::MODE_WRITE).write(ex, EXPAND("Salut")) && !ex);
+
+	UInt32 updates = 0;
+	FileWatcher::OnUpdate onUpdate([&](const Path& file, bool firstWatch) {
+		CHECK(firstWatch == !updates && file == name);
+		++updates;
+	});
+	shared<const FileWatcher> pWatcher(SET, Path(name));
+	io.watch(pWatcher, onUpdate);
+	CHECK(handler.join([&]() { return updates == 1; }));
+
+	// file without folder is watched by inotify on the current directory: update immediate whereas polling waits stability (2 seconds)
+	Time time;
+	CHECK(File(name, File::MODE_WRITE).write(ex, EXPAND("Salut")) && !ex);
+	CHECK(handler.join([&]() { return updates == 2; }));
+#if !defined(_WIN32) && !defined(_BSD)
+	CHECK(!time.isElapsed(900));
+#endif
+	pWatcher.reset();
+	CHECK(FileSystem::Delete(ex, name) && !ex);
+}
+
 }
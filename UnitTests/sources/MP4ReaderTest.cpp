@@ -0,0 +1,132 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/MP4Reader.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace MP4ReaderTest {
+
+struct Box : virtual Object {
+	Box(BinaryWriter& writer, const char* name, bool large = false) : _writer(writer), _begin(writer.size()), _large(large) {
+		writer.write32(large ? 1 : 0).write(name, 4);
+		if (large)
+			writer.write64(0);
+	}
+	~Box() {
+		UInt8* size = BIN _writer.data() + _begin;
+		if (_large)
+			BinaryWriter(size + 8, 8).write64(_writer.size() - _begin);
+		else
+			BinaryWriter(size, 4).write32(_writer.size() - _begin);
+	}
+private:
+	BinaryWriter&	_writer;
+	UInt32			_begin;
+	bool			_large;
+};
+
+/*!
+Build a mp4 file with mdat before moov, one mp3 track of 3 samples "AAA0", "AAA1", "AAA2" every 26ms */
+static const Buffer& MP4File(bool largeMdat) {
+	static Buffer Files[2];
+	Buffer& file = Files[largeMdat];
+	if (file)
+		return file;
+	BinaryWriter writer(file);
+	{ Box ftyp(writer, "ftyp"); writer.write("isom").write32(0).write("isom"); }
+	UInt32 samples;
+	{
+		Box mdat(writer, "mdat", largeMdat);
+		samples = writer.size();
+		writer.write("AAA0AAA1AAA2");
+	}
+	Box moov(writer, "moov");
+	Box trak(writer, "trak");
+	Box mdia(writer, "mdia");
+	{ Box mdhd(writer, "mdhd"); writer.write32(0).write32(0).write32(0).write32(1000).write32(78).write16(0x55C4).write16(0); }
+	Box minf(writer, "minf");
+	Box stbl(writer, "stbl");
+	{
+		Box stsd(writer, "stsd");
+		writer.write32(0).write32(1); // version + flags, count
+		writer.write32(36).write(".mp3").next(6).write16(1); // size, type, reserved, data reference index
+		writer.write16(0).next(6).write16(2).write16(16).next(4).write16(44100).next(2); // version, revision + vendor, channels, sample size, compression + packet size, rate
+	}
+	{ Box stts(writer, "stts"); writer.write32(0).write32(1).write32(3).write32(26); }
+	{ Box stsc(writer, "stsc"); writer.write32(0).write32(1).write32(1).write32(3).write32(1); }
+	{ Box stsz(writer, "stsz"); writer.write32(0).write32(0).write32(3).write32(4).write32(4).write32(4); }
+	{ Box stco(writer, "stco"); writer.write32(0).write32(1).write32(samples); }
+	return file;
+}
+
+struct Source : Media::Source, virtual Object {
+	vector<string> samples;
+	vector<UInt32> times;
+private:
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) {
+		CHECK(tag.codec == Media::Audio::CODEC_MP3 && tag.rate == 44100 && tag.channels == 2 && track == 1);
+		samples.emplace_back(STR packet.data(), packet.size());
+		times.emplace_back(tag.time);
+	}
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) { CHECK(false); }
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track) { CHECK(false); }
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) {}
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track) { CHECK(false); }
+	void flush() {}
+	void reset() {}
+};
+
+/*!
+Read file by chunk as MediaFile::Reader does it, honoring the seeks requested */
+static void Read(const Buffer& file, UInt32 chunk, Source& source) {
+	MP4Reader reader;
+	reader.seekable = true;
+	UInt64 position = 0;
+	while (position < file.size()) {
+		shared<Buffer> pBuffer(SET, file.data() + position, min<UInt32>(chunk, UInt32(file.size() - position)));
+		UInt32 size = pBuffer->size();
+		reader.read(Packet(pBuffer), source);
+		if (!reader.seeking(position))
+			position += size;
+	}
+	reader.flush(source);
+}
+
+static void Check(bool largeMdat) {
+	const Buffer& file = MP4File(largeMdat);
+	for (UInt32 chunk : { 1u, 7u, 16u, 64u, UInt32(file.size()) }) {
+		Source source;
+		Read(file, chunk, source);
+		CHECK(source.samples.size() == 3);
+		CHECK(source.samples[0] == "AAA0" && source.samples[1] == "AAA1" && source.samples[2] == "AAA2");
+		CHECK(source.times[0] == 0 && source.times[1] == 26 && source.times[2] == 52);
+	}
+}
+
+ADD_TEST(MdatBeforeMoov) {
+	Check(false);
+}
+
+ADD_TEST(MdatBeforeMoovLargeSize) {
+	Check(true);
+}
+
+}
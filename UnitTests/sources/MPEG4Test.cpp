@@ -0,0 +1,120 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/MPEG4.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace MPEG4Test {
+
+/*!
+Byte per byte reference of MPEG4::FindStartCode (without block skipping) */
+static const UInt8* FindStartCode(const UInt8* cur, const UInt8* end, UInt8& zeros) {
+	while (cur < end) {
+		UInt8 value(*cur++);
+		if (!value) {
+			if (zeros < 3)
+				++zeros;
+			continue;
+		}
+		if (value == 0x01 && zeros >= 2)
+			return cur;
+		zeros = 0;
+	}
+	return NULL;
+}
+
+/*!
+Start codes found (position after 01 and zeros preceding it) when data is given by chunks, the last one is the trailing zeros */
+template<typename FindType>
+static vector<UInt32> Scan(const Buffer& data, UInt32 chunk, FindType find) {
+	vector<UInt32> founds;
+	UInt8 zeros = 0;
+	for (UInt32 position = 0; position < data.size(); position += chunk) {
+		const UInt8* cur = data.data() + position;
+		const UInt8* end = cur + min(chunk, data.size() - position);
+		while ((cur = find(cur, end, zeros))) {
+			founds.emplace_back(UInt32(cur - data.data()) << 2 | zeros);
+			zeros = 0;
+		}
+	}
+	founds.emplace_back(zeros);
+	return founds;
+}
+
+static void Check(const Buffer& data) {
+	for (UInt32 chunk : { 1u, 7u, 15u, 16u, 17u, 31u, 32u, 33u, 188u, data.size() }) {
+		vector<UInt32> founds = Scan(data, chunk, MPEG4::FindStartCode);
+		CHECK(founds == Scan(data, chunk, FindStartCode));
+	}
+}
+
+/*!
+Payload without start code, with isolated zeros and emulation prevention (00 00 03) */
+static Buffer& Fill(Buffer& data, UInt32 size, UInt32& seed) {
+	data.resize(size, false);
+	for (UInt32 i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345; // deterministic to reproduce a failure
+		UInt8& value = data.data()[i];
+		if ((value = UInt8(seed >> 16)) < 2)
+			value = (seed >> 24) & 1 ? 0 : 0x42; // isolated zero
+	}
+	for (UInt32 i = 0; i + 3 <= size; i += 97)
+		memcpy(data.data() + i, "\x00\x00\x03", 3);
+	return data;
+}
+
+ADD_TEST(StartCodeAcrossBlocks) {
+	// start codes of 3 and 4 bytes on every position around SIMD blocks (8, 16 and 32 bytes)
+	UInt32 seed = 0;
+	Buffer data;
+	for (UInt8 length : { 3, 4 }) {
+		for (UInt32 position = 0; position < 72; ++position) {
+			Fill(data, 128, seed);
+			memcpy(data.data() + position, "\x00\x00\x00\x01" + 4 - length, length);
+			vector<UInt32> founds = Scan(data, data.size(), MPEG4::FindStartCode);
+			CHECK(founds.size() >= 2 && (founds[0] >> 2) == (position + length) && (founds[0] & 3) >= UInt32(length - 1));
+			Check(data);
+		}
+	}
+	// trailing zeros carried to the next call
+	Fill(data, 100, seed);
+	data.append(3, 0);
+	vector<UInt32> founds = Scan(data, data.size(), MPEG4::FindStartCode);
+	CHECK(founds.back() == 3);
+	Check(data);
+}
+
+ADD_TEST(StartCodeStream) {
+	// NALs of random sizes, from a few bytes to several blocks
+	UInt32 seed = 1;
+	Buffer data, nal;
+	while (data.size() < 0x10000) {
+		if (seed & 1)
+			data.append(EXPAND("\x00\x00\x00\x01"));
+		else
+			data.append(EXPAND("\x00\x00\x01"));
+		Fill(nal, (seed >> 8) % 300 + 1, seed);
+		data.append(nal.data(), nal.size());
+	}
+	Check(data);
+}
+
+}
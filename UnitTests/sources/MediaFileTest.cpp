@@ -0,0 +1,159 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/MediaFile.h"
+#include "Mona/FLVReader.h"
+#include "Mona/FileSystem.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace MediaFileTest {
+
+static const UInt8 SPS[] = { 0x67, 0x42, 0x00, 0x1E, 0x95, 0xA8, 0x28, 0x0F, 0x64 };
+static const UInt8 PPS[] = { 0x68, 0xCE, 0x3C, 0x80 };
+
+/*!
+FLV of 3 seconds, 25 fps video with a keyframe every second */
+static const Buffer& FLV() {
+	static Buffer FLV;
+	if (FLV)
+		return FLV;
+	MediaWriter::OnWrite onWrite([](const Packet& packet) { FLV.append(packet.data(), packet.size()); });
+	Mona::unique<MediaWriter> pWriter = MediaWriter::New("flv");
+	pWriter->beginMedia(onWrite);
+	Media::Video::Tag tag(Media::Video::CODEC_H264);
+	tag.frame = Media::Video::FRAME_CONFIG;
+	Buffer buffer;
+	BinaryWriter(buffer).write32(sizeof(SPS)).write(SPS, sizeof(SPS)).write32(sizeof(PPS)).write(PPS, sizeof(PPS));
+	pWriter->writeVideo(1, tag, Packet(buffer.data(), buffer.size()), onWrite);
+	for (UInt32 i = 0; i < 75; ++i) {
+		tag.time = i * 40;
+		tag.frame = (i % 25) ? Media::Video::FRAME_INTER : Media::Video::FRAME_KEY;
+		BinaryWriter(buffer.clear()).write32(5).write8(tag.frame == Media::Video::FRAME_KEY ? 0x65 : 0x41).write32(i);
+		pWriter->writeVideo(1, tag, Packet(buffer.data(), buffer.size()), onWrite);
+	}
+	pWriter->endMedia(onWrite);
+	return FLV;
+}
+
+struct Source : Media::Source, virtual Object {
+	vector<UInt32>	times; // video times, configs excluded
+	UInt32			keys;
+	Source() : keys(0) {}
+private:
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) {}
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) {
+		if (tag.frame == Media::Video::FRAME_CONFIG)
+			return;
+		if (tag.frame == Media::Video::FRAME_KEY)
+			++keys;
+		times.emplace_back(tag.time);
+	}
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track) {}
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) {}
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track) {}
+	void flush() {}
+	void reset() {}
+};
+
+static shared<MediaFile::Index> BuildIndex(const Path& path) {
+	shared<MediaFile::Index> pIndex(SET, path);
+	FLVReader reader;
+	reader.onKeyFrame = [&pIndex](Media::Type type, UInt32 time, UInt64 position) { pIndex->add(type, time, position); };
+	reader.read(Packet(FLV().data(), FLV().size()), Media::Source::Null());
+	reader.flush(Media::Source::Null());
+	return pIndex;
+}
+
+ADD_TEST(Index) {
+	Exception ex;
+	Path path("temp.flv");
+	CHECK(File(path, File::MODE_WRITE).write(ex, FLV().data(), FLV().size()) && !ex);
+	CHECK(!MediaFile::Index::Get(path));
+
+	shared<MediaFile::Index> pIndex = BuildIndex(path);
+	CHECK(pIndex->count() == 3);
+	UInt64 position, first;
+	CHECK(pIndex->find(0, first) && pIndex->find(999, position) && position == first);
+	CHECK(pIndex->find(1000, position) && position > first);
+	UInt64 second = position;
+	CHECK(pIndex->find(1999, position) && position == second);
+	CHECK(pIndex->find(5000, position) && position > second);
+
+	// kept in memory while media file doesn't change
+	MediaFile::Index::Set(pIndex);
+	CHECK(MediaFile::Index::Get(path) == pIndex);
+	CHECK(File(path, File::MODE_APPEND).write(ex, EXPAND("change")) && !ex);
+	CHECK(!MediaFile::Index::Get(path));
+
+	CHECK(FileSystem::Delete(ex, path) && !ex);
+}
+
+ADD_TEST(IndexLimits) {
+	// least recently used indexes removed beyond MAX_COUNT
+	vector<shared<MediaFile::Index>> indexes;
+	for (UInt32 i = 0; i <= MediaFile::Index::MAX_COUNT; ++i) {
+		indexes.emplace_back(SET, Path(String("missing", i, ".flv")));
+		MediaFile::Index::Set(indexes.back());
+		if (i == MediaFile::Index::MAX_COUNT - 1)
+			CHECK(MediaFile::Index::Get(indexes.front()->path) == indexes.front()); // used => kept
+	}
+	CHECK(MediaFile::Index::Get(indexes.front()->path) == indexes.front());
+	CHECK(!MediaFile::Index::Get(indexes[1]->path));
+	CHECK(MediaFile::Index::Get(indexes.back()->path) == indexes.back());
+
+	// one building by media file
+	Path path("missing.flv");
+	CHECK(MediaFile::Index::Build(path) && !MediaFile::Index::Build(path));
+	MediaFile::Index::Cancel(path);
+	CHECK(MediaFile::Index::Build(path) && !MediaFile::Index::Build(path));
+	MediaFile::Index::Set(make_shared<MediaFile::Index>(path));
+	CHECK(MediaFile::Index::Get(path) && MediaFile::Index::Build(path));
+	MediaFile::Index::Cancel(path);
+}
+
+ADD_TEST(StartOnPreviousKeyFrame) {
+	Exception ex;
+	Path path("temp.flv");
+	CHECK(File(path, File::MODE_WRITE).write(ex, FLV().data(), FLV().size()) && !ex);
+	shared<MediaFile::Index> pIndex = BuildIndex(path);
+	CHECK(FileSystem::Delete(ex, path) && !ex);
+
+	// read headers and configs until first keyframe, then resume on "from" time as MediaFile::Reader does
+	UInt64 position, seeking;
+	CHECK(pIndex->find(0, position));
+	const Buffer& flv = FLV();
+	FLVReader reader;
+	reader.seekable = true;
+	Source source;
+	reader.read(Packet(flv.data(), UInt32(position)), source);
+	for (UInt32 from : { 1500u, 1000u, 2999u }) {
+		CHECK(pIndex->find(from, position));
+		CHECK(reader.resume(position, source) && reader.seeking(seeking) && seeking == position);
+		source.times.clear();
+		source.keys = 0;
+		reader.read(Packet(flv.data() + position, flv.size() - UInt32(position)), source);
+		CHECK(!source.times.empty() && source.times.front() == (from / 1000) * 1000 && source.times.back() == 2960);
+		CHECK(source.keys == 3 - from / 1000);
+	}
+	reader.flush(source);
+}
+
+}
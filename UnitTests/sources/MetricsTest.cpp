@@ -0,0 +1,149 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+
+#include "Mona/UnitTest.h"
+#include "Mona/Metrics.h"
+#include "Mona/Handler.h"
+#include <thread>
+
+using namespace Mona;
+using namespace std;
+
+namespace MetricsTest {
+
+ADD_TEST(Counter) {
+	static Metrics::Counter Counter("test_counter_total", "Counter test", "test=\"counter\"");
+	static Metrics::Gauge Gauge("test_gauge", "Gauge test");
+	vector<thread> threads;
+	for (UInt8 i = 0; i < 4; ++i) {
+		threads.emplace_back([]() {
+			for (UInt32 i = 0; i < 10000; ++i) {
+				++Counter;
+				++Gauge;
+			}
+			Gauge -= 5000;
+		});
+	}
+	for (thread& thread : threads)
+		thread.join();
+	CHECK(Counter() == 40000);
+	CHECK(Gauge() == 20000);
+
+	string text;
+	Metrics::Write(text);
+	CHECK(text.find("# HELP test_counter_total Counter test\n# TYPE test_counter_total counter\ntest_counter_total{test=\"counter\"} 40000\n") != string::npos);
+	CHECK(text.find("# TYPE test_gauge gauge\ntest_gauge 20000\n") != string::npos);
+}
+
+ADD_TEST(Histogram) {
+	// le semantic on power of two limits
+	CHECK(Metrics::Histogram::ComputeIndex(0) == 0 && Metrics::Histogram::ComputeIndex(1) == 0);
+	CHECK(Metrics::Histogram::ComputeIndex(8) == 7 && Metrics::Histogram::ComputeIndex(9) == 8);
+	CHECK(Metrics::Histogram::ComputeIndex(16) == 15 && Metrics::Histogram::ComputeIndex(17) == 16);
+	CHECK(Metrics::Histogram::ComputeIndex(1ull << 40) == Metrics::Histogram::BUCKETS - 2);
+	CHECK(Metrics::Histogram::ComputeIndex((1ull << 40) + 1) == Metrics::Histogram::BUCKETS - 1);
+
+	static Metrics::Histogram Histogram("test_seconds", "Histogram test");
+	for (UInt32 i = 1; i <= 1000; ++i)
+		Histogram.record(i);
+	CHECK(Histogram.count() == 1000 && Histogram.sum() == 500500);
+	// 12.5% precision
+	UInt64 value = Histogram.percentile(0.5);
+	CHECK(value >= 500 && value <= 500 * 1.125);
+	value = Histogram.percentile(0.99);
+	CHECK(value >= 990 && value <= 990 * 1.125);
+	CHECK(Histogram.percentile(1) >= 1000);
+
+	string text;
+	Metrics::Write(text);
+	CHECK(text.find("# TYPE test_seconds histogram\ntest_seconds_bucket{le=\"1e-06\"} 1\n") != string::npos);
+	CHECK(text.find("test_seconds_bucket{le=\"0.000512\"} 512\n") != string::npos);
+	CHECK(text.find("test_seconds_bucket{le=\"+Inf\"} 1000\ntest_seconds_sum 0.500") != string::npos); // 500500/1000000 in double
+	CHECK(text.find("test_seconds_count 1000\n") != string::npos);
+}
+
+ADD_TEST(Samples) {
+	Metrics::Samples samples;
+	CHECK(!samples.count() && !samples.percentile(0.5));
+	for (UInt32 i = 1; i <= 1000; ++i)
+		samples.record(i);
+	CHECK(samples.count() == 1000 && samples.sum() == 500500 && samples.max() == 1000);
+	UInt64 value = samples.percentile(0.9);
+	CHECK(value >= 900 && value <= 900 * 1.125);
+	samples.clear();
+	CHECK(!samples.count() && !samples.max());
+}
+
+ADD_TEST(Trace) {
+	struct MainHandler : Handler {
+		MainHandler() : Handler(_signal) {}
+		UInt32 join() {
+			_signal.wait(14000);
+			return Handler::flush(true);
+		}
+	private:
+		Signal _signal;
+	} handler;
+
+	struct Check : Runner, virtual Object {
+		Check(Metrics::Trace& trace) : Runner("Check"), _trace(trace) {}
+	private:
+		bool run(Exception& ex) { _trace = Metrics::Trace::Current(); return true; }
+		Metrics::Trace& _trace;
+	};
+
+	Metrics::Trace traced, untraced;
+	Metrics::Trace::Rate = 2; // 1 on 2
+	thread([&]() {
+		for (UInt8 i = 0; i < 2; ++i) {
+			Metrics::Trace::Scope trace(Metrics::Trace::Sample());
+			if (Metrics::Trace::Current()) // sampled
+				handler.queue<Check>(traced);
+			else
+				handler.queue<Check>(untraced);
+		}
+	}).join();
+	Metrics::Trace::Rate = 0;
+	CHECK(!Metrics::Trace::Current());
+	CHECK(handler.join() == 2);
+	CHECK(!Metrics::Trace::Current()); // restored
+	CHECK(traced && traced.queued >= traced.received && traced.ran >= traced.queued);
+	CHECK(!untraced && !untraced.queued && !untraced.ran);
+}
+
+ADD_TEST(HandlerQueue) {
+	struct Nothing : Runner, virtual Object {
+		Nothing() : Runner("Nothing") {}
+	private:
+		bool run(Exception& ex) { return true; }
+	};
+	Signal signal;
+	Handler handler(signal);
+	Int64 queue = Handler::Queue();
+	for (UInt8 i = 0; i < 3; ++i)
+		handler.queue<Nothing>();
+	CHECK(Handler::Queue() - queue == 3);
+	// runners dropped by reset are no more queued
+	handler.reset(signal);
+	CHECK(Handler::Queue() == queue && !handler.flush());
+	handler.queue<Nothing>();
+	CHECK(handler.flush() == 1 && Handler::Queue() == queue);
+}
+
+}
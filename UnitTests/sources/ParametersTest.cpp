@@ -85,4 +85,31 @@ ADD_TEST(MapParameters) {
 	CHECK(params.count() == 0);
 }
 
+ADD_TEST(IndexAndCopyOnWrite) {
+	struct Copy : Parameters {
+		Copy(const Parameters& other) : Parameters(other) {}
+	};
+	Parameters params;
+	// enough keys to be hash indexed
+	for (UInt32 i = 0; i < 100; ++i)
+		params.setNumber(String("Key", i), i);
+	CHECK(params.count() == 100);
+	CHECK(params.getNumber("key42") == 42 && params.getNumber("KEY99") == 99 && !params.hasKey("key100"));
+	CHECK(params.erase("KEY42") && !params.hasKey("key42") && params.getNumber("key43") == 43);
+	params.setNumber("key42", 42);
+	CHECK(params.getNumber("Key42") == 42 && params.count() == 100);
+	params.clear("key1");
+	CHECK(params.count() == 89 && !params.hasKey("key10") && params.hasKey("key2"));
+
+	// copy shares the map until a change
+	Copy copy(params);
+	CHECK(copy.count() == 89 && copy.getNumber("key50") == 50);
+	copy.setNumber("key50", 500);
+	CHECK(copy.getNumber("key50") == 500 && params.getNumber("key50") == 50);
+	params.erase("key60");
+	CHECK(!params.hasKey("key60") && copy.getNumber("key60") == 60);
+	copy.erase(copy.begin(), copy.find("key3"));
+	CHECK(copy.count() == 77 && params.count() == 88 && params.hasKey("key0"));
+}
+
 }
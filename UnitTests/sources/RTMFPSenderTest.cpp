@@ -0,0 +1,327 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/RTMFP/RTMFPSender.h"
+#include "Mona/RTMFP/RTMFPReceiver.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace RTMFPSenderTest {
+
+typedef RTMFPSender::Congestion Congestion;
+typedef shared<RTMFPSender::Packet> Sent;
+static const UInt32 P(RTMFP::SIZE_PACKET);
+
+/*!
+Send packets while window allows it, as the sender thread does */
+static void Fill(Congestion& congestion) {
+	while ((congestion.inflight() + P) <= congestion.window())
+		congestion.sent(P);
+}
+
+/*!
+One RTT: a window of packets acknowledged one by one, the sender refilling the window after each ack */
+static void Round(Congestion& congestion) {
+	UInt32 packets = congestion.window() / P;
+	Fill(congestion);
+	while (packets--) {
+		congestion.acked(P);
+		Fill(congestion);
+	}
+}
+
+ADD_TEST(SlowStart) {
+	Congestion congestion;
+	congestion.rtt = 100;
+	CHECK(congestion.window() == Congestion::WINDOW_INIT * P);
+	// window doubles every RTT
+	for (UInt32 packets = Congestion::WINDOW_INIT; packets < 200; packets *= 2) {
+		CHECK(congestion.window() == packets * P);
+		Round(congestion);
+	}
+	// application limited, window not used so not grown
+	Congestion limited;
+	limited.rtt = 100;
+	for (UInt8 i = 0; i < 10; ++i) {
+		limited.sent(P);
+		limited.acked(P);
+	}
+	CHECK(limited.window() == Congestion::WINDOW_INIT * P && !limited.inflight());
+}
+
+ADD_TEST(Reduction) {
+	Congestion congestion;
+	congestion.rtt = 100;
+	Round(congestion);
+	Round(congestion);
+	CHECK(congestion.window() == 24 * P);
+	// multiplicative decrease of 0.7
+	congestion.lost();
+	UInt32 window = congestion.window();
+	CHECK(window == UInt32(24 * 0.7 * P));
+	// one reduction by RTT
+	congestion.lost();
+	CHECK(congestion.window() == window);
+	// repetition after RTO restarts with the minimum window, then slow start until the previous threshold
+	congestion.timeout();
+	CHECK(congestion.window() == Congestion::WINDOW_MIN * P);
+	congestion.released(congestion.inflight());
+	Round(congestion);
+	CHECK(congestion.window() == 2 * Congestion::WINDOW_MIN * P);
+}
+
+ADD_TEST(CubicGrowth) {
+	Congestion congestion;
+	congestion.rtt = 100;
+	for (UInt8 i = 0; i < 4; ++i)
+		Round(congestion);
+	congestion.lost(); // 96 => 67.2 packets
+	congestion.released(congestion.inflight());
+	// concave region: just after loss the window stays near its reduced value (K = 2.8s)
+	UInt32 window = congestion.window();
+	Round(congestion);
+	CHECK(congestion.window() > window && congestion.window() < (window + 2 * P));
+	// convex region: long after loss (t given by RTT) window grows fast, at most 1.5 x by RTT
+	congestion.rtt = 10000;
+	window = congestion.window();
+	Round(congestion);
+	CHECK(congestion.window() > UInt32(window * 1.4) && congestion.window() <= UInt32(window * 1.5 + P));
+}
+
+ADD_TEST(Loss) {
+	// bottleneck of 50 packets by RTT, tail drop beyond, window must oscillate just under it
+	const UInt32 capacity = 50;
+	Congestion congestion;
+	congestion.rtt = 1;
+	UInt32 losses = 0, minWindow = 0xFFFFFFFF, maxWindow = 0;
+	for (UInt32 round = 0; round < 300; ++round) {
+		Round(congestion);
+		if (round >= 100) {
+			minWindow = min(minWindow, congestion.window());
+			maxWindow = max(maxWindow, congestion.window());
+		}
+		UInt32 packets = congestion.window() / P;
+		if (packets <= capacity)
+			continue;
+		// packets dropped, detected one RTT later
+		Thread::Sleep(2);
+		congestion.lost();
+		congestion.released((packets - capacity) * P);
+		++losses;
+	}
+	CHECK(losses >= 4);
+	CHECK(minWindow >= UInt32(capacity * 0.65 * P) && maxWindow <= (capacity + 2) * P);
+}
+
+/*!
+Ranges of an ack 0x51 (holes-1, received-1, ...) */
+static Packet Ranges(const initializer_list<UInt64>& values) {
+	shared<Buffer> pBuffer(SET);
+	BinaryWriter writer(*pBuffer);
+	for (UInt64 value : values)
+		writer.write7Bit<UInt64>(value, 10);
+	return Packet(pBuffer);
+}
+
+/*!
+Queue of a writer with packets sent on a session (RTT=100ms), acknowledgments are given to RTMFPAcquiter as RTMFPWriter does */
+struct Flow : virtual Object {
+	Flow() : pQueue(SET, 2, 0, string("signature")),
+		pSession(SET, shared<RTMFP::Session>(SET, 1, 2, _Key, sizeof(_Key), _Key, _Key, shared<RendezVous>()), shared<Socket>(SET, Socket::TYPE_DATAGRAM)),
+		_receiver(Socket::TYPE_DATAGRAM), _start(Time::Now()) {
+		Exception ex;
+		CHECK(_receiver.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && !ex);
+		pSession->congestion.rtt = 100;
+		pQueue->pSession = pSession;
+	}
+
+	shared<RTMFPSender::Queue>		pQueue;
+	shared<RTMFPSender::Session>	pSession;
+
+	/*!
+	Packet of fragments sent at time */
+	Sent send(UInt32 fragments, Int64 time, bool reliable = true) {
+		shared<Buffer> pBuffer(SET, P);
+		Sent pPacket(SET, pBuffer, fragments, reliable);
+		pPacket->setSent();
+		pPacket->sentTime = time;
+		pSession->congestion.sent(pPacket->sizeSent());
+		pQueue->stage = pQueue->stageSending += fragments;
+		pQueue->sending.emplace_back(pPacket);
+		return pPacket;
+	}
+	void ack(UInt64 stageAck, const Packet& ranges = Packet::Null()) {
+		shared<RTMFPAcquiter> pAcquiter(SET, pQueue, stageAck, ranges);
+		pAcquiter->pSession = pSession;
+		pAcquiter->address = _receiver.address();
+		((Runner&)*pAcquiter).run("RTMFPAcquiter");
+	}
+	/*!
+	Packet sent again since the flow creation */
+	bool repeated(const Sent& pPacket) const { return pPacket->sentTime >= _start; }
+
+private:
+	static const UInt8	_Key[16];
+	Socket				_receiver;
+	Int64				_start;
+};
+const UInt8 Flow::_Key[16] = { 0 };
+
+ADD_TEST(AckRanges) {
+	Flow flow;
+	Int64 time(Time::Now() - 50); // recent, inside the reordering window (RTT + RTT/4)
+	vector<Sent> packets;
+	for (UInt8 i = 0; i < 10; ++i)
+		packets.emplace_back(flow.send(1, time));
+	// stages 1-2 acknowledged, then received [4-5] and [8]
+	flow.ack(2, Ranges({ 0, 1, 1, 0 }));
+	CHECK(flow.pQueue->stageAck == 2 && flow.pQueue->sending.size() == 8);
+	for (UInt8 i = 0; i < 10; ++i) {
+		UInt8 stage(i + 1);
+		CHECK(packets[i]->acked == (stage <= 2 || stage == 4 || stage == 5 || stage == 8));
+		CHECK(!flow.repeated(packets[i]));
+	}
+	CHECK(flow.pSession->congestion.inflight() == 5 * P);
+
+	// older ack received after, already acknowledged packets are not counted again
+	flow.ack(1, Ranges({ 0, 0, 2, 0 })); // [3] and [7]
+	CHECK(flow.pQueue->stageAck == 2 && packets[2]->acked && packets[6]->acked && !packets[5]->acked && !packets[8]->acked);
+	CHECK(flow.pSession->congestion.inflight() == 3 * P);
+}
+
+ADD_TEST(AckFragments) {
+	Flow flow;
+	Int64 time(Time::Now() - 50);
+	// packets of stages 1-2, 3-6 and 7
+	Sent first(flow.send(2, time)), second(flow.send(4, time)), third(flow.send(1, time));
+	// received [2-3] and [5-6]: one fragment received means whole packet received, the second packet is on both ranges
+	flow.ack(0, Ranges({ 0, 1, 0, 1 }));
+	CHECK(first->acked && second->acked && !third->acked && flow.pQueue->sending.size() == 3);
+	CHECK(flow.pSession->congestion.inflight() == P); // second packet counted one time
+
+	// stageAck inside a packet acknowledges the whole packet
+	flow.ack(5);
+	CHECK(flow.pQueue->stageAck == 6 && flow.pQueue->sending.size() == 1 && !third->acked);
+}
+
+ADD_TEST(AckBeyond) {
+	Flow flow;
+	Int64 time(Time::Now() - 50);
+	vector<Sent> packets;
+	for (UInt8 i = 0; i < 4; ++i)
+		packets.emplace_back(flow.send(1, time));
+	// range beyond the stages sent is ignored
+	flow.ack(0, Ranges({ 9, 5 })); // [11-16]
+	for (const Sent& pPacket : packets)
+		CHECK(!pPacket->acked);
+	CHECK(flow.pSession->congestion.inflight() == 4 * P);
+	// range overlapping the last stage sent
+	flow.ack(0, Ranges({ 1, 10 })); // [3-13]
+	CHECK(!packets[0]->acked && !packets[1]->acked && packets[2]->acked && packets[3]->acked);
+	CHECK(flow.pSession->congestion.inflight() == 2 * P);
+	// stageAck beyond the stages sent is limited to them
+	flow.ack(10);
+	CHECK(flow.pQueue->stageAck == 4 && flow.pQueue->sending.empty() && !flow.pSession->congestion.inflight());
+}
+
+ADD_TEST(AckLoss) {
+	// RACK: packets sent before the most recent acknowledged one and older than the reordering window are repeated
+	Flow flow;
+	Int64 time(Time::Now() - 1000);
+	vector<Sent> packets;
+	for (UInt8 i = 0; i < 6; ++i)
+		packets.emplace_back(flow.send(1, time + i));
+	packets.emplace_back(flow.send(1, time + 100));
+	flow.ack(0, Ranges({ 3, 0 })); // [5]
+	CHECK(packets[4]->acked);
+	for (UInt8 i = 0; i < 4; ++i)
+		CHECK(!packets[i]->acked && flow.repeated(packets[i]));
+	CHECK(!flow.repeated(packets[5]) && !flow.repeated(packets[6])); // sent after the packet acknowledged
+	CHECK(flow.pSession->congestion.window() == UInt32((Congestion::WINDOW_INIT + 1) * 0.7 * P)); // grown by the packet acknowledged, then reduced
+	// repeated packets are not presumed lost again before the reordering window
+	Int64 repeatTime(packets[0]->sentTime);
+	flow.ack(0, Ranges({ 4, 0 })); // [6]
+	CHECK(packets[0]->sentTime == repeatTime && !flow.repeated(packets[6]));
+
+	// sent in the same millisecond, stage gives the order
+	Flow same;
+	packets.clear();
+	for (UInt8 i = 0; i < 4; ++i)
+		packets.emplace_back(same.send(1, time));
+	same.ack(0, Ranges({ 1, 0 })); // [3]
+	CHECK(same.repeated(packets[0]) && same.repeated(packets[1]) && packets[2]->acked && !same.repeated(packets[3]));
+
+	// at most one window of packets repeated
+	Flow window;
+	packets.clear();
+	for (UInt8 i = 0; i < 10; ++i)
+		packets.emplace_back(window.send(1, time + i));
+	window.ack(0, Ranges({ 8, 0 })); // [10]
+	UInt32 sendable(window.pSession->congestion.window() / P);
+	for (UInt8 i = 0; i < 9; ++i)
+		CHECK(window.repeated(packets[i]) == (i < sendable));
+}
+
+ADD_TEST(AckAbandon) {
+	Flow flow;
+	Int64 time(Time::Now() - 1000);
+	// unreliable packet lost is abandoned, not repeated
+	Sent unreliable(flow.send(1, time, false)), reliable(flow.send(1, time + 1)), lost(flow.send(1, time + 2)), after(flow.send(1, time + 3, false));
+	flow.ack(0, Ranges({ 0, 0, 0, 0 })); // [2] and [4]
+	CHECK(unreliable->acked && !flow.repeated(unreliable) && reliable->acked);
+	CHECK(!lost->acked && flow.repeated(lost) && after->acked);
+	CHECK(flow.pSession->congestion.inflight() == P); // just the packet repeated
+
+	// unreliable lost after a reliable packet not acknowledged can't be abandoned, receiver would drop the reliable one
+	Flow kept;
+	Sent first(kept.send(1, time)), second(kept.send(1, time + 1, false)), third(kept.send(1, time + 2));
+	kept.ack(0, Ranges({ 1, 0 })); // [3]
+	CHECK(kept.repeated(first) && !second->acked && !kept.repeated(second) && third->acked);
+}
+
+ADD_TEST(AckBitmap) {
+	auto convert = [](const Packet& bitmap) {
+		shared<Buffer> pBuffer(SET);
+		BinaryReader reader(bitmap.data(), bitmap.size());
+		BinaryWriter writer(*pBuffer);
+		RTMFPReceiver::WriteRanges(reader, writer);
+		return Packet(pBuffer);
+	};
+	// bit 0 = stage+2: [2-3], [5-6] and [17]
+	Packet ranges(convert(Packet(EXPAND("\x1B\x80"))));
+	CHECK(ranges == Ranges({ 0, 1, 0, 1, 9, 0 }));
+	CHECK(!convert(Packet(EXPAND("\x00\x00"))).size()); // nothing received
+	CHECK(convert(Packet(EXPAND("\xFF\xFF"))) == Ranges({ 0, 15 })); // [2-17]
+	CHECK(convert(Packet(EXPAND("\x01"))) == Ranges({ 0, 0 })); // [2], trailing holes ignored
+
+	// ranges converted acknowledge exactly the stages received
+	Flow flow;
+	Int64 time(Time::Now() - 50);
+	vector<Sent> packets;
+	for (UInt8 i = 0; i < 20; ++i)
+		packets.emplace_back(flow.send(1, time));
+	flow.ack(0, ranges);
+	for (UInt8 i = 0; i < 20; ++i) {
+		UInt8 stage(i + 1);
+		CHECK(packets[i]->acked == (stage == 2 || stage == 3 || stage == 5 || stage == 6 || stage == 17));
+	}
+}
+
+}
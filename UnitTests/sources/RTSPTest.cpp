@@ -0,0 +1,191 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/RTSP/RTSP.h"
+#include "Mona/RTPWriter.h"
+#include "Mona/RTP_H264.h"
+#include "Mona/RTP_AAC.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace RTSPTest {
+
+static const UInt32 MTU(100);
+
+/*!
+Packets written by a RTPWriter */
+struct Output : deque<Packet>, virtual Object {
+	Output() : onWrite([this](const Packet& packet) { emplace_back(move(packet)); }) {}
+	MediaWriter::OnWrite onWrite;
+
+	UInt16 sequence(UInt32 index) const { return BinaryReader(at(index).data() + 2, 2).read16(); }
+	UInt32 time(UInt32 index) const { return BinaryReader(at(index).data() + 4, 4).read32(); }
+	UInt32 ssrc(UInt32 index) const { return BinaryReader(at(index).data() + 8, 4).read32(); }
+	bool   marker(UInt32 index) const { return (at(index).data()[1] & 0x80) ? true : false; }
+};
+
+ADD_TEST(Header) {
+	// writable requests, fields are parsed in place as in the decoder buffer
+	char setup[] = "SETUP rtsp://host/app/stream/trackID=1 RTSP/1.0\r\nCSeq: 3\r\nSession: 12345;timeout=60\r\ntransport: RTP/AVP/TCP;unicast;interleaved=0-1\r\nContent-Length: 10\r\n\r\n";
+	RTSP::Header header(setup, sizeof(setup) - 1);
+	CHECK(!header.ex && header.type == RTSP::TYPE_SETUP);
+	CHECK(header.url == "rtsp://host/app/stream/trackID=1" && header.path.name() == "trackID=1");
+	CHECK(header.cseq == 3 && header.contentLength == 10);
+	CHECK(header.session == "12345"); // without its parameters
+	CHECK(header.getString("Transport") && strcmp(header.getString("Transport"), "RTP/AVP/TCP;unicast;interleaved=0-1") == 0);
+
+	char play[] = "play rtsp://host/app/stream?token=abc RTSP/1.0\r\nCSeq: 4\r\n\r\n";
+	RTSP::Header playHeader(play, sizeof(play) - 1);
+	CHECK(!playHeader.ex && playHeader.type == RTSP::TYPE_PLAY && playHeader.cseq == 4 && playHeader.query.find("token=abc") != string::npos && playHeader.session.empty());
+
+	// errors
+	char http[] = "PLAY rtsp://host/app/stream HTTP/1.1\r\nCSeq: 5\r\n\r\n";
+	CHECK(RTSP::Header(http, sizeof(http) - 1).ex);
+	char unknown[] = "RECORDS rtsp://host/app/stream RTSP/1.0\r\n\r\n";
+	CHECK(RTSP::Header(unknown, sizeof(unknown) - 1).ex);
+	char empty[] = "\r\n\r\n";
+	CHECK(RTSP::Header(empty, sizeof(empty) - 1).ex);
+}
+
+ADD_TEST(Transport) {
+	char tcpValue[] = "RTP/AVP/TCP;unicast;interleaved=4-5";
+	RTSP::Transport tcp(tcpValue);
+	CHECK(tcp.tcp && !tcp.multicast && tcp.interleaved && tcp.channel == 4 && !tcp.clientPort);
+	char udpValue[] = "RTP/AVP;unicast;client_port=5000-5001";
+	RTSP::Transport udp(udpValue);
+	CHECK(!udp.tcp && !udp.multicast && !udp.interleaved && udp.clientPort == 5000);
+	// first transport proposed only
+	char firstValue[] = "RTP/AVP;multicast;client_port=6000-6001,RTP/AVP/TCP;unicast;interleaved=0-1";
+	RTSP::Transport first(firstValue);
+	CHECK(!first.tcp && first.multicast && !first.interleaved && first.clientPort == 6000);
+	// case insensitive and trimmed
+	char trimmedValue[] = " rtp/avp/tcp ; unicast ; INTERLEAVED=2-3 ";
+	RTSP::Transport trimmed(trimmedValue);
+	CHECK(trimmed.tcp && trimmed.interleaved && trimmed.channel == 2);
+	// TCP without interleaved channels, server chooses them
+	char serverValue[] = "RTP/AVP/TCP;unicast";
+	RTSP::Transport server(serverValue);
+	CHECK(server.tcp && !server.interleaved);
+}
+
+ADD_TEST(H264) {
+	RTPWriter<RTP_H264> writer(MTU, UInt8(96));
+	Output output;
+	writer.beginMedia(output.onWrite);
+
+	// frame with one small NALU (SEI) and one NALU (IDR, NRI=3) requiring FU-A fragmentation
+	shared<Buffer> pFrame(SET);
+	BinaryWriter frame(*pFrame);
+	frame.write32(5).write8(0x06).write32(0x01020304);
+	frame.write32(250).write8(0x65);
+	for (UInt8 i = 0; i < 249; ++i)
+		frame.write8(i);
+	Media::Video::Tag tag(Media::Video::CODEC_H264);
+	tag.frame = Media::Video::FRAME_KEY;
+	tag.time = 1000;
+	tag.compositionOffset = 40;
+	writer.writeVideo(1, tag, Packet(pFrame), output.onWrite);
+
+	// single NALU packet, then 249 bytes of IDR fragmented in 86 + 86 + 77 bytes (MTU - RTP header - FU indicator - FU header)
+	CHECK(output.size() == 4);
+	for (UInt32 i = 0; i < output.size(); ++i) {
+		CHECK(output[i].data()[0] == 0x80 && (output[i].data()[1] & 0x7F) == 96);
+		CHECK(output.marker(i) == (i == 3)); // marker on the last packet of the frame only
+		CHECK(output.sequence(i) == UInt16(output.sequence(0) + i));
+		CHECK(output.time(i) == 93600 && output.ssrc(i) == output.ssrc(0)); // (1000 + 40) * 90
+	}
+	CHECK(output[0].size() == 17 && memcmp(output[0].data() + 12, EXPAND("\x06\x01\x02\x03\x04")) == 0);
+	CHECK(output[1].size() == MTU && output[2].size() == MTU && output[3].size() == (12 + 2 + 77));
+	// FU indicator keeps F and NRI of the NALU header, FU header has Start and End flags and NALU type
+	CHECK(output[1].data()[12] == 0x7C && output[1].data()[13] == 0x85 && output[1].data()[14] == 0);
+	CHECK(output[2].data()[12] == 0x7C && output[2].data()[13] == 0x05 && output[2].data()[14] == 86);
+	CHECK(output[3].data()[12] == 0x7C && output[3].data()[13] == 0x45 && output[3].data()[14] == 172 && output[3].data()[output[3].size() - 1] == 248);
+
+	// NRI carried over from the NALU header of an inter frame (NRI=2)
+	output.clear();
+	pFrame.set();
+	BinaryWriter(*pFrame).write32(200).write8(0x41).write(string(199, 'x'));
+	tag.frame = Media::Video::FRAME_INTER;
+	writer.writeVideo(1, tag, Packet(pFrame), output.onWrite);
+	CHECK(output.size() == 3 && output[0].data()[12] == 0x5C && output[0].data()[13] == 0x81 && output[1].data()[13] == 0x01 && output[2].data()[13] == 0x41);
+	CHECK(!output.marker(0) && !output.marker(1) && output.marker(2));
+}
+
+ADD_TEST(AAC) {
+	RTPWriter<RTP_AAC> writer(MTU, UInt8(97));
+	Output output;
+	writer.beginMedia(output.onWrite);
+
+	shared<Buffer> pFrame(SET, 200);
+	for (UInt8 i = 0; i < 200; ++i)
+		pFrame->data()[i] = i;
+	Media::Audio::Tag tag(Media::Audio::CODEC_AAC);
+	tag.rate = 44100;
+	tag.channels = 2;
+	tag.time = 1000;
+	writer.writeAudio(1, tag, Packet(pFrame), output.onWrite);
+
+	// 200 bytes fragmented in 84 + 84 + 32 bytes (MTU - RTP header - AU headers)
+	CHECK(output.size() == 3);
+	UInt8 value(0);
+	for (UInt32 i = 0; i < output.size(); ++i) {
+		CHECK((output[i].data()[1] & 0x7F) == 97 && output.marker(i) == (i == 2));
+		CHECK(output.time(i) == 44100); // clock rate = sampling rate
+		// AU-headers-length = 16 bits, AU-size = full size of the frame on every fragment, AU-Index = 0
+		BinaryReader reader(output[i].data() + 12, output[i].size() - 12);
+		CHECK(reader.read16() == 16 && reader.read16() == (200 << 3));
+		while (reader.available())
+			CHECK(reader.read8() == value++);
+	}
+	CHECK(value == 200 && output[0].size() == MTU && output[1].size() == MTU && output[2].size() == (12 + 4 + 32));
+}
+
+ADD_TEST(RTCP) {
+	RTPWriter<RTP_AAC> writer(MTU, UInt8(97));
+	writer.senderReportInterval = 0;
+	Output output;
+	writer.beginMedia(output.onWrite);
+	Int64 time(Time::Now());
+	Thread::Sleep(2); // elapsed interval
+	Media::Audio::Tag tag(Media::Audio::CODEC_AAC);
+	tag.rate = 44100;
+	tag.time = 2000;
+	writer.writeAudio(1, tag, Packet(EXPAND("frame")), output.onWrite);
+	CHECK(output.size() == 2);
+
+	// Sender Report after the RTP packet: length 6 (28 bytes), same SSRC, NTP time since 1900, RTP time, counts
+	UInt32 ssrc(output.ssrc(0));
+	const Packet& report(output[1]);
+	CHECK(report.size() == 28 && memcmp(report.data(), EXPAND("\x80\xC8\x00\x06")) == 0);
+	BinaryReader reader(report.data() + 4, report.size() - 4);
+	CHECK(reader.read32() == ssrc);
+	UInt32 seconds(reader.read32()), fraction(reader.read32());
+	Int64 ntp((seconds - 2208988800ll) * 1000 + ((UInt64(fraction) * 1000) >> 32));
+	CHECK(ntp >= time && ntp <= Time::Now());
+	CHECK(reader.read32() == 88200 && reader.read32() == 1 && reader.read32() == (4 + 5)); // RTP time, packets, bytes (AU header + frame)
+
+	// BYE: length 1 (8 bytes) with SSRC
+	output.clear();
+	writer.endMedia(output.onWrite);
+	CHECK(output.size() == 1 && output[0].size() == 8 && memcmp(output[0].data(), EXPAND("\x81\xCB\x00\x01")) == 0);
+	CHECK(BinaryReader(output[0].data() + 4, 4).read32() == ssrc);
+}
+
+}
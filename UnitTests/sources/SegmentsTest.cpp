@@ -0,0 +1,261 @@
+/*
+This file is a part of MonaSolutions Copyright 2017
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+*/
+
+#include "Mona/UnitTest.h"
+#include "Mona/Segments.h"
+#include "Mona/MediaReader.h"
+#include "Mona/FileSystem.h"
+
+using namespace std;
+using namespace Mona;
+
+namespace SegmentsTest {
+
+struct MainHandler : Handler {
+	MainHandler() : Handler(_signal) {}
+	bool join(const function<bool()>& done) {
+		while (Handler::flush(), !done()) {
+			if (!_signal.wait(14000))
+				return false;
+		}
+		return true;
+	}
+private:
+	void flush() {}
+	Signal _signal;
+};
+static ThreadPool	_ThreadPool;
+
+static const char*	Directory("temp.segments/");
+static const UInt32 FRAME_SIZE(417); // MP3 frame of 128kbps at 44100Hz
+static const UInt32 SEGMENT_SIZE(10 * FRAME_SIZE); // 1 second segment of audio frames every 100ms
+
+static Int64 Gauge(const char* name) {
+	string text;
+	Metrics::Write(text);
+	size_t position = text.find(String("\n", name, ' '));
+	if (position == string::npos)
+		return 0;
+	position += strlen(name) + 2;
+	Int64 value(0);
+	String::ToNumber(text.data() + position, text.find('\n', position) - position, value);
+	return value;
+}
+
+/*!
+Write frames up to close count segments of 1 second, each frame carries its index after the MP3 header */
+static void Write(Segments& segments, UInt32 count) {
+	Media::Audio::Tag tag(Media::Audio::CODEC_MP3);
+	tag.rate = 44100;
+	tag.channels = 2;
+	for (UInt32 i = 0; i <= count * 10; ++i) {
+		tag.time = i * 100;
+		shared<Buffer> pFrame(SET, FRAME_SIZE);
+		memset(pFrame->data(), 0, FRAME_SIZE);
+		BinaryWriter(pFrame->data(), FRAME_SIZE).write32(0xFFFB9064).write32(i);
+		segments.writeAudio(1, tag, Packet(pFrame));
+	}
+}
+
+struct Source : Media::Source, virtual Object {
+	vector<UInt32> frames;
+private:
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) {
+		CHECK(packet.size() == FRAME_SIZE && tag.codec == Media::Audio::CODEC_MP3);
+		frames.emplace_back(BinaryReader(packet.data() + 4, 4).read32());
+	}
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) { CHECK(false); }
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track) {}
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) {}
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track) { CHECK(false); }
+	void flush() {}
+	void reset() {}
+};
+
+static UInt32 CountFiles() {
+	Exception ex;
+	UInt32 count = 0;
+	FileSystem::ForEach forEach([&count](const string& file, UInt16 level) { ++count; return true; });
+	FileSystem::ListFiles(ex, Directory, forEach);
+	return count;
+}
+
+/*!
+Last media written by a record */
+struct Recorder : Media::Source, virtual Object {
+	Recorder() : type(Media::TYPE_NONE), dataType(Media::Data::TYPE_UNKNOWN), isProperties(false), track(0) {}
+	Media::Type			type;
+	Media::Audio::Tag	audio;
+	Media::Video::Tag	video;
+	Media::Data::Type	dataType;
+	bool				isProperties;
+	UInt8				track;
+	string				content;
+private:
+	void writeAudio(const Media::Audio::Tag& tag, const Packet& packet, UInt8 track) { audio.set(tag); set(Media::TYPE_AUDIO, packet, track); }
+	void writeVideo(const Media::Video::Tag& tag, const Packet& packet, UInt8 track) { video.set(tag); set(Media::TYPE_VIDEO, packet, track); }
+	void writeData(Media::Data::Type type, const Packet& packet, UInt8 track) { dataType = type; isProperties = false; set(Media::TYPE_DATA, packet, track); }
+	void addProperties(UInt8 track, Media::Data::Type type, const Packet& packet) { dataType = type; isProperties = true; set(Media::TYPE_DATA, packet, track); }
+	void reportLost(Media::Type type, UInt32 lost, UInt8 track) { CHECK(false); }
+	void flush() {}
+	void reset() {}
+
+	void set(Media::Type type, const Packet& packet, UInt8 track) {
+		this->type = type;
+		this->track = track;
+		content.assign(STR packet.data(), packet.size());
+	}
+};
+
+ADD_TEST(Record) {
+	Recorder recorder;
+	shared<Buffer> pBuffer(SET, EXPAND("config"));
+	Packet config(pBuffer);
+
+	// audio, buffer received kept without copy
+	Media::Audio::Tag audio(Media::Audio::CODEC_AAC);
+	audio.time = 1000;
+	audio.rate = 44100;
+	audio.channels = 2;
+	audio.isConfig = true;
+	Segment::Record record(audio, config, 3);
+	CHECK(record.type() == Media::TYPE_AUDIO && record.track() == 3 && !record.hasTime());
+	CHECK(record.packet().buffer() == config.buffer() && record.packet().data() == config.data());
+	record.write(recorder);
+	CHECK(recorder.type == Media::TYPE_AUDIO && recorder.track == 3 && recorder.content == "config");
+	CHECK(recorder.audio.codec == Media::Audio::CODEC_AAC && recorder.audio.time == 1000 && recorder.audio.rate == 44100 && recorder.audio.channels == 2 && recorder.audio.isConfig);
+	audio.isConfig = false;
+	CHECK(Segment::Record(audio, config).hasTime());
+
+	// video, unbuffered packet is bufferized
+	char frame[] = "frame";
+	Media::Video::Tag video(Media::Video::CODEC_H264);
+	video.time = 2000;
+	video.frame = Media::Video::FRAME_KEY;
+	video.compositionOffset = 80;
+	Segment::Record key(video, Packet(frame, 5), 2);
+	frame[0] = 'F';
+	CHECK(key.type() == Media::TYPE_VIDEO && key.time() == 2000 && key.hasTime() && key.packet().buffer());
+	key.write(recorder);
+	CHECK(recorder.type == Media::TYPE_VIDEO && recorder.track == 2 && recorder.content == "frame");
+	CHECK(recorder.video.codec == Media::Video::CODEC_H264 && recorder.video.time == 2000 && recorder.video.frame == Media::Video::FRAME_KEY && recorder.video.compositionOffset == 80);
+	video.frame = Media::Video::FRAME_CONFIG;
+	Segment::Record(video, config).write(recorder);
+	CHECK(recorder.video.frame == Media::Video::FRAME_CONFIG && !Segment::Record(video, config).hasTime());
+
+	// copy and move keep the buffer
+	Segment::Record copy(key);
+	Segment::Record moved(move(key));
+	CHECK(copy.packet().data() == moved.packet().data() && copy.packet().buffer() == moved.packet().buffer());
+	copy.write(recorder);
+	CHECK(recorder.content == "frame" && recorder.video.frame == Media::Video::FRAME_KEY && recorder.video.time == 2000);
+
+	// data and properties
+	Segment::Record data(Media::Data::TYPE_JSON, Packet(EXPAND("[1]")), 1);
+	CHECK(data.type() == Media::TYPE_DATA && !data.hasTime());
+	data.write(recorder);
+	CHECK(recorder.type == Media::TYPE_DATA && recorder.dataType == Media::Data::TYPE_JSON && !recorder.isProperties && recorder.track == 1 && recorder.content == "[1]");
+	Segment::Record(Media::Data::TYPE_AMF, config, 0, true).write(recorder);
+	CHECK(recorder.type == Media::TYPE_DATA && recorder.dataType == Media::Data::TYPE_AMF && recorder.isProperties && !recorder.track && recorder.content == "config");
+
+	// empty
+	Segment::Record empty(Media::Data::TYPE_TEXT, Packet());
+	CHECK(!empty.packet() && !empty.packet().buffer());
+}
+
+ADD_TEST(Spill) {
+	MainHandler handler;
+	IOFile		io(handler, _ThreadPool);
+	Exception	ex;
+	CHECK(FileSystem::CreateDirectory(ex, Directory) && !ex);
+	Int64 memory = Gauge("mona_segments_memory_bytes");
+	Int64 spilled = Gauge("mona_segments_spilled_bytes");
+	Segments::EnableSpill(io, Directory, 10000);
+	{
+		Segments segments(100);
+		Write(segments, 6);
+		CHECK(segments.count() == 6);
+		// budget accounting: oldest segments counted as spilled from now except the live edge
+		CHECK(Gauge("mona_segments_memory_bytes") - memory == 2 * SEGMENT_SIZE);
+		CHECK(Gauge("mona_segments_spilled_bytes") - spilled == 4 * SEGMENT_SIZE);
+		// eviction on flush: medias stay in memory until written
+		for (const Segment& segment : segments)
+			CHECK(segment.count() == 10 && !segment.spill());
+		CHECK(handler.join([&]() { return !segments(0).count() && !segments(1).count() && !segments(2).count() && !segments(3).count(); }));
+		UInt32 sequence = segments.sequence();
+		for (const Segment& segment : segments) {
+			bool evicted = sequence++ < 4;
+			CHECK(evicted ? (!segment.count() && segment.spill() && segment) : (segment.count() == 10 && !segment.spill()));
+			CHECK(segment.size() == SEGMENT_SIZE && segment.duration() == 1000);
+		}
+		CHECK(CountFiles() == 4);
+
+		// serve a spilled segment: TS file readable as it, with the frames of the segment
+		const Segment& segment = segments(1);
+		Buffer file;
+		file.resize(UInt32(segment.spill().size(true)), false);
+		CHECK(File(segment.spill(), File::MODE_READ).read(ex, file.data(), file.size()) == int(file.size()) && !ex);
+		Source source;
+		Mona::unique<MediaReader> pReader = MediaReader::New("ts");
+		pReader->read(Packet(file.data(), file.size()), source);
+		pReader->flush(source);
+		CHECK(source.frames.size() == 10);
+		for (UInt32 i = 0; i < source.frames.size(); ++i)
+			CHECK(source.frames[i] == 10 + i);
+
+		// release of spilled segments erases their files
+		segments.setMaxSegments(0);
+		CHECK(!segments.count());
+		CHECK(Gauge("mona_segments_memory_bytes") == memory && Gauge("mona_segments_spilled_bytes") == spilled);
+		io.join();
+		CHECK(!CountFiles());
+	}
+	Segments::DisableSpill();
+	CHECK(FileSystem::Delete(ex, Directory, FileSystem::MODE_HEAVY) && !ex);
+}
+
+ADD_TEST(SpillMove) {
+	MainHandler handler;
+	IOFile		io(handler, _ThreadPool);
+	Exception	ex;
+	CHECK(FileSystem::CreateDirectory(ex, Directory) && !ex);
+	Int64 memory = Gauge("mona_segments_memory_bytes");
+	Int64 spilled = Gauge("mona_segments_spilled_bytes");
+	Segments::EnableSpill(io, Directory, 10000);
+	{
+		Segments segments(100);
+		Write(segments, 6);
+		CHECK(Gauge("mona_segments_spilled_bytes") - spilled == 4 * SEGMENT_SIZE);
+		// moved while spilling: spillings are canceled, segments stay in memory
+		Segments moved(move(segments));
+		CHECK(!segments.count() && segments.sequence() == 6);
+		CHECK(moved.count() == 6 && !moved.sequence());
+		CHECK(Gauge("mona_segments_memory_bytes") - memory == 6 * SEGMENT_SIZE);
+		CHECK(Gauge("mona_segments_spilled_bytes") == spilled);
+		io.join();
+		CHECK(handler.join([]() { return true; }));
+		for (const Segment& segment : moved)
+			CHECK(segment.count() == 10 && !segment.spill());
+		CHECK(!CountFiles());
+	}
+	CHECK(Gauge("mona_segments_memory_bytes") == memory);
+	Segments::DisableSpill();
+	CHECK(FileSystem::Delete(ex, Directory, FileSystem::MODE_HEAVY) && !ex);
+}
+
+}
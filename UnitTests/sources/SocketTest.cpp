@@ -22,6 +22,9 @@ details (or else see http://www.gnu.org/licenses/).
 #include "Mona/UDPSocket.h"
 #include "Mona/TLS.h"
 #include "Mona/Util.h"
+#include "Mona/File.h"
+#include OpenSSL(pem.h)
+#include OpenSSL(x509.h)
 #include <set>
 
 using namespace std;
@@ -436,6 +439,363 @@ ADD_TEST(TCP_SSL_NonBlocking) {
 	TestTCPNonBlocking(pClientTLS, pServerTLS);
 }
 
+static void WriteCertificate(const Path& cert, const Path& key, const char* host) {
+	// self-signed EC certificate
+	EVP_PKEY* pKey(NULL);
+	EVP_PKEY_CTX* pKeyCTX(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL));
+	CHECK(pKeyCTX && EVP_PKEY_keygen_init(pKeyCTX) == 1 && EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pKeyCTX, NID_X9_62_prime256v1) == 1 && EVP_PKEY_keygen(pKeyCTX, &pKey) == 1);
+	EVP_PKEY_CTX_free(pKeyCTX);
+	X509* pX509(X509_new());
+	ASN1_INTEGER_set(X509_get_serialNumber(pX509), 1);
+	X509_gmtime_adj(X509_getm_notBefore(pX509), 0);
+	X509_gmtime_adj(X509_getm_notAfter(pX509), 3600);
+	X509_set_pubkey(pX509, pKey);
+	X509_NAME_add_entry_by_txt(X509_get_subject_name(pX509), "CN", MBSTRING_ASC, (const UInt8*)host, -1, -1, 0);
+	X509_set_issuer_name(pX509, X509_get_subject_name(pX509));
+	CHECK(X509_sign(pX509, pKey, EVP_sha256()));
+	FILE* pFile(fopen(cert.c_str(), "wb"));
+	CHECK(pFile && PEM_write_X509(pFile, pX509));
+	fclose(pFile);
+	CHECK((pFile = fopen(key.c_str(), "wb")) && PEM_write_PrivateKey(pFile, pKey, NULL, NULL, 0, NULL, NULL));
+	fclose(pFile);
+	X509_free(pX509);
+	EVP_PKEY_free(pKey);
+}
+
+static SSL_SESSION* TLSConnect(SSL_CTX* pCTX, const SocketAddress& address, const char* host, SSL_SESSION* pSession, string& commonName) {
+	// raw OpenSSL client to control session resumption
+	Exception ex;
+	Socket socket(Socket::TYPE_STREAM);
+	CHECK(socket.connect(ex, address) && !ex);
+	SSL* ssl(SSL_new(pCTX));
+	CHECK(ssl && SSL_set_fd(ssl, socket) == 1 && SSL_set_tlsext_host_name(ssl, host) == 1);
+	if (pSession)
+		CHECK(SSL_set_session(ssl, pSession) == 1);
+	CHECK(SSL_connect(ssl) == 1);
+	// echo, to get session ticket of TLS 1.3 sent after handshake
+	char buffer[3];
+	CHECK(SSL_write(ssl, EXPAND("hi")) == 2 && SSL_read(ssl, buffer, sizeof(buffer)) == 2 && memcmp(buffer, EXPAND("hi")) == 0);
+	CHECK(!pSession || SSL_session_reused(ssl));
+	X509* pX509(SSL_get_peer_certificate(ssl));
+	CHECK(pX509);
+	char name[256];
+	int size(X509_NAME_get_text_by_NID(X509_get_subject_name(pX509), NID_commonName, name, sizeof(name)));
+	commonName.assign(name, size > 0 ? size : 0);
+	X509_free(pX509);
+	pSession = SSL_get1_session(ssl);
+	SSL_shutdown(ssl);
+	SSL_free(ssl);
+	return pSession;
+}
+
+ADD_TEST(TLS_Resumption) {
+	Exception ex;
+	const char* folder("temp.certs/");
+	CHECK(FileSystem::CreateDirectory(ex, folder) && !ex);
+	WriteCertificate(Path(folder, "sni.pem"), Path(folder, "sni.key"), "sni.mona");
+
+	shared<TLS> pTLS;
+	CHECK(TLS::Create(ex, "cert.pem", "key.pem", pTLS) && !ex);
+	CHECK(pTLS->loadCertificates(ex, folder) == 1 && !ex && pTLS->certificates() == 1);
+
+	Mona::unique<Server> pServer(SET, pTLS);
+	SocketAddress address(IPAddress::Loopback(), pServer->bind(SocketAddress(IPAddress::Wildcard(), 0)).port());
+	SSL_CTX* pCTX(SSL_CTX_new(SSLv23_method()));
+
+	// full handshake, with SNI certificate and default certificate
+	string commonName;
+	pServer->accept();
+	SSL_SESSION* pSession(TLSConnect(pCTX, address, "sni.mona", NULL, commonName));
+	CHECK(commonName == "sni.mona" && pTLS->fullHandshakes() == 1 && !pTLS->resumedHandshakes());
+	pServer->accept();
+	SSL_SESSION_free(TLSConnect(pCTX, address, "other.mona", NULL, commonName));
+	CHECK(commonName != "sni.mona" && pTLS->fullHandshakes() == 2);
+
+	// resumption by session ticket
+	pServer->accept();
+	SSL_SESSION* pResumed(TLSConnect(pCTX, address, "sni.mona", pSession, commonName));
+	CHECK(commonName == "sni.mona" && pTLS->fullHandshakes() == 2 && pTLS->resumedHandshakes() == 1);
+	SSL_SESSION_free(pResumed);
+	SSL_SESSION_free(pSession);
+
+	// ticket of a previous key (rotated) stays valid one more rotation
+	pTLS->setTicketRotation(1);
+	pServer->accept();
+	pSession = TLSConnect(pCTX, address, "sni.mona", NULL, commonName);
+	Thread::Sleep(1100);
+	pServer->accept();
+	SSL_SESSION_free(TLSConnect(pCTX, address, "sni.mona", pSession, commonName));
+	CHECK(pTLS->fullHandshakes() == 3 && pTLS->resumedHandshakes() == 2);
+	SSL_SESSION_free(pSession);
+
+	// resumption by session cache (without tickets)
+	pTLS->setTicketRotation(0);
+	pServer->accept();
+	pSession = TLSConnect(pCTX, address, "sni.mona", NULL, commonName);
+	pServer->accept();
+	pResumed = TLSConnect(pCTX, address, "sni.mona", pSession, commonName);
+	CHECK(pTLS->fullHandshakes() == 4 && pTLS->resumedHandshakes() == 3);
+	SSL_SESSION_free(pResumed);
+	SSL_SESSION_free(pSession);
+
+	// cache disabled => full handshake
+	pTLS->setSessionCache(0);
+	pServer->accept();
+	pSession = TLSConnect(pCTX, address, "sni.mona", NULL, commonName);
+	Socket socket(Socket::TYPE_STREAM);
+	pServer->accept();
+	SSL* ssl(SSL_new(pCTX));
+	CHECK(socket.connect(ex, address) && !ex && SSL_set_fd(ssl, socket) == 1 && SSL_set_session(ssl, pSession) == 1 && SSL_connect(ssl) == 1 && !SSL_session_reused(ssl));
+	SSL_shutdown(ssl);
+	SSL_free(ssl);
+	SSL_SESSION_free(pSession);
+
+	SSL_CTX_free(pCTX);
+	pServer.reset();
+	CHECK(FileSystem::Delete(ex, folder, FileSystem::MODE_HEAVY) && !ex);
+}
+
+ADD_TEST(TLS_Coalescing) {
+	Exception ex;
+	shared<TLS> pTLS;
+	CHECK(TLS::Create(ex, "cert.pem", "key.pem", pTLS) && !ex);
+	TLS::Socket server(Socket::TYPE_STREAM, pTLS);
+	CHECK(server.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && server.listen(ex) && !ex);
+	Socket client(Socket::TYPE_STREAM);
+	CHECK(client.connect(ex, server.address()) && !ex);
+	shared<Socket> pConnection;
+	CHECK(server.accept(ex, pConnection) && !ex && pConnection);
+
+	// small packets queued while handshake
+	CHECK(pConnection->setNonBlockingMode(ex, true) && !ex);
+	string data;
+	for (UInt8 i = 0; i < 100; ++i) {
+		data.append(100, char(i));
+		CHECK(pConnection->write(ex, Packet(data.data() + data.size() - 100, 100)) >= 0 && !ex);
+	}
+	CHECK(pConnection->queueing() == data.size());
+
+	SSL_CTX* pCTX(SSL_CTX_new(SSLv23_method()));
+	SSL* ssl(SSL_new(pCTX));
+	CHECK(client.setNonBlockingMode(ex, true) && !ex && SSL_set_fd(ssl, client) == 1);
+	SSL_set_connect_state(ssl);
+	string received;
+	char buffer[0x4000];
+	Time time;
+	while (received.size() < data.size() && !time.isElapsed(14000)) {
+		CHECK(pConnection->flush(ex) && !ex);
+		int count = SSL_read(ssl, buffer, sizeof(buffer));
+		if (count > 0)
+			received.append(buffer, count);
+		else if (SSL_get_error(ssl, count) == SSL_ERROR_WANT_READ)
+			Thread::Sleep(1);
+		else
+			FATAL_ERROR("SSL_read error ", Crypto::LastErrorMessage());
+		// server reads client finished message
+		pConnection->receive(ex, buffer, sizeof(buffer));
+		ex = nullptr;
+	}
+	CHECK(received == data && !pConnection->queueing());
+	// one record instead of 100
+	CHECK(pTLS->recordBytes() == data.size() && pTLS->records() == 1);
+
+	SSL_free(ssl);
+	SSL_CTX_free(pCTX);
+}
+
+ADD_TEST(TCP_Gathering) {
+	Exception ex;
+	Socket server(Socket::TYPE_STREAM);
+	CHECK(server.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && server.listen(ex) && !ex);
+	Socket client(Socket::TYPE_STREAM);
+	CHECK(client.connect(ex, server.address()) && !ex);
+	shared<Socket> pConnection;
+	CHECK(server.accept(ex, pConnection) && !ex && pConnection && pConnection->canGather());
+
+	// header + payload packets queued beyond IOV_MAX, sent partially by a small send buffer
+	CHECK(pConnection->setSendBufferSize(ex, 0x4000) && pConnection->setNonBlockingMode(ex, true) && !ex);
+	string data;
+	for (UInt32 i = 0; i < 3000; ++i) {
+		data.append(12, char(i));
+		data.append(i % 500, char(i + 1));
+	}
+	UInt32 offset(0);
+	for (UInt32 i = 0; i < 3000; ++i) {
+		CHECK(pConnection->write(ex, Packet(data.data() + offset, 12)) >= 0 && !ex);
+		CHECK(pConnection->write(ex, Packet(data.data() + offset + 12, i % 500)) >= 0 && !ex);
+		offset += 12 + i % 500;
+	}
+	CHECK(pConnection->queueing());
+	string received;
+	char buffer[0x10000];
+	CHECK(client.setNonBlockingMode(ex, true) && !ex);
+	Time time;
+	while (received.size() < data.size() && !time.isElapsed(14000)) {
+		CHECK(pConnection->flush(ex) && !ex);
+		int count = client.receive(ex, buffer, sizeof(buffer));
+		if (count < 0) {
+			CHECK(ex.cast<Ex::Net::Socket>().code == NET_EWOULDBLOCK);
+			ex = nullptr;
+			Thread::Sleep(1); // wait kernel sending
+		} else
+			received.append(buffer, count);
+	}
+	CHECK(received == data && !pConnection->queueing());
+}
+
+ADD_TEST(TCP_EmptyPacket) {
+	Exception ex;
+	Socket server(Socket::TYPE_STREAM);
+	CHECK(server.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && server.listen(ex) && !ex);
+	Socket client(Socket::TYPE_STREAM);
+	CHECK(client.connect(ex, server.address()) && !ex);
+	shared<Socket> pConnection;
+	CHECK(server.accept(ex, pConnection) && !ex && pConnection);
+
+	// empty packets queued behind a blocked sending, in the middle and at the end
+	CHECK(pConnection->setSendBufferSize(ex, 0x4000) && pConnection->setNonBlockingMode(ex, true) && !ex);
+	string data(0x80000, 'x');
+	CHECK(pConnection->write(ex, Packet(data.data(), data.size())) >= 0 && !ex && pConnection->queueing());
+	CHECK(pConnection->write(ex, Packet()) == 0 && !ex);
+	CHECK(pConnection->write(ex, Packet(EXPAND("end"))) == 0 && !ex);
+	CHECK(pConnection->write(ex, Packet()) == 0 && !ex);
+	data.append("end");
+
+	string received;
+	char buffer[0x10000];
+	CHECK(client.setNonBlockingMode(ex, true) && !ex);
+	Time time;
+	while (received.size() < data.size() && !time.isElapsed(14000)) {
+		CHECK(pConnection->flush(ex) && !ex);
+		int count = client.receive(ex, buffer, sizeof(buffer));
+		if (count < 0) {
+			CHECK(ex.cast<Ex::Net::Socket>().code == NET_EWOULDBLOCK);
+			ex = nullptr;
+			Thread::Sleep(1); // wait kernel sending
+		} else
+			received.append(buffer, count);
+	}
+	CHECK(received == data && !pConnection->queueing());
+	// empty packets released => sent immediatly
+	CHECK(pConnection->flush(ex) && !ex && pConnection->write(ex, Packet(EXPAND("next"))) == 4 && !ex);
+}
+
+ADD_TEST(TCP_SendFile) {
+	Exception ex;
+	Socket server(Socket::TYPE_STREAM);
+	CHECK(server.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && server.listen(ex) && !ex);
+	Socket client(Socket::TYPE_STREAM);
+	CHECK(client.connect(ex, server.address()) && !ex);
+	shared<Socket> pConnection;
+	CHECK(server.accept(ex, pConnection) && !ex && pConnection);
+	if (!pConnection->canSendFile())
+		return; // sendfile unsupported on this platform
+
+	const char* name("temp.sendfile");
+	string data(0x80000, '\0');
+	for (UInt32 i = 0; i < data.size(); ++i)
+		data[i] = char(i % 251);
+	CHECK(File(name, File::MODE_WRITE).write(ex, data.data(), data.size()) && !ex);
+	{
+		shared<File> pFile(SET, name, File::MODE_READ);
+		CHECK(pFile->load(ex) && !ex);
+		// small send buffer to be queued, and a packet after to check order
+		CHECK(pConnection->setSendBufferSize(ex, 0x4000) && pConnection->setNonBlockingMode(ex, true) && !ex);
+		CHECK(pConnection->write(ex, pFile, 1000, data.size() - 1000) >= 0 && !ex && pConnection->queueing());
+		CHECK(pConnection->write(ex, Packet(EXPAND("end"))) >= 0 && !ex);
+	}
+	string received;
+	char buffer[0x10000];
+	CHECK(client.setNonBlockingMode(ex, true) && !ex);
+	Time time;
+	while (received.size() < (data.size() - 1000 + 3) && !time.isElapsed(14000)) {
+		CHECK(pConnection->flush(ex) && !ex);
+		int count = client.receive(ex, buffer, sizeof(buffer));
+		if (count < 0) {
+			CHECK(ex.cast<Ex::Net::Socket>().code == NET_EWOULDBLOCK);
+			ex = nullptr;
+			Thread::Sleep(1); // wait kernel sending
+		} else
+			received.append(buffer, count);
+	}
+	CHECK(!pConnection->queueing() && received.size() == (data.size() - 1000 + 3));
+	CHECK(memcmp(received.data(), data.data() + 1000, data.size() - 1000) == 0 && received.compare(data.size() - 1000, 3, "end") == 0);
+
+	// TLS socket without kernel TLS can't use sendfile
+	shared<TLS> pTLS;
+	CHECK(TLS::Create(ex, pTLS) && !ex);
+	CHECK(!TLS::Socket(Socket::TYPE_STREAM, pTLS).canSendFile());
+	CHECK(FileSystem::Delete(ex, name) && !ex);
+}
+
+ADD_TEST(TLS_KTLS_SendFile) {
+	Exception ex;
+	shared<TLS> pTLS;
+	CHECK(TLS::Create(ex, "cert.pem", "key.pem", pTLS) && !ex);
+	TLS::Socket server(Socket::TYPE_STREAM, pTLS);
+	CHECK(server.bind(ex, SocketAddress(IPAddress::Loopback(), 0)) && server.listen(ex) && !ex);
+	Socket client(Socket::TYPE_STREAM);
+	CHECK(client.connect(ex, server.address()) && !ex);
+	shared<Socket> pConnection;
+	CHECK(server.accept(ex, pConnection) && !ex && pConnection);
+	TLS::Socket& connection = (TLS::Socket&)*pConnection;
+	CHECK(connection.setNonBlockingMode(ex, true) && !ex);
+
+	// handshake, then a message to finish it on server side
+	SSL_CTX* pCTX(SSL_CTX_new(SSLv23_method()));
+	SSL* ssl(SSL_new(pCTX));
+	CHECK(client.setNonBlockingMode(ex, true) && !ex && SSL_set_fd(ssl, client) == 1);
+	SSL_set_connect_state(ssl);
+	char buffer[0x4000];
+	Time time;
+	int result;
+	while ((result = SSL_write(ssl, EXPAND("hi"))) <= 0 && !time.isElapsed(14000)) {
+		CHECK(SSL_get_error(ssl, result) == SSL_ERROR_WANT_READ);
+		connection.receive(ex, buffer, sizeof(buffer));
+		ex = nullptr;
+		Thread::Sleep(1);
+	}
+	CHECK(result == 2);
+	while ((result = connection.receive(ex, buffer, sizeof(buffer))) < 0 && !time.isElapsed(14000)) {
+		ex = nullptr;
+		Thread::Sleep(1);
+	}
+	CHECK(result == 2 && memcmp(buffer, EXPAND("hi")) == 0);
+
+	if (connection.isKTLS()) {
+		// sendfile through kernel TLS, followed by a packet to check order
+		CHECK(TLS::KTLSSockets() && connection.canSendFile());
+		const char* name("temp.ktls");
+		string data(0x80000, '\0');
+		for (UInt32 i = 0; i < data.size(); ++i)
+			data[i] = char(i % 251);
+		CHECK(File(name, File::MODE_WRITE).write(ex, data.data(), data.size()) && !ex);
+		{
+			shared<File> pFile(SET, name, File::MODE_READ);
+			CHECK(pFile->load(ex) && !ex);
+			CHECK(connection.write(ex, pFile, 0, data.size()) >= 0 && !ex);
+			CHECK(connection.write(ex, Packet(EXPAND("end"))) >= 0 && !ex);
+		}
+		data.append("end");
+		string received;
+		while (received.size() < data.size() && !time.isElapsed(14000)) {
+			CHECK(connection.flush(ex) && !ex);
+			int count = SSL_read(ssl, buffer, sizeof(buffer));
+			if (count > 0)
+				received.append(buffer, count);
+			else if (SSL_get_error(ssl, count) == SSL_ERROR_WANT_READ)
+				Thread::Sleep(1);
+			else
+				FATAL_ERROR("SSL_read error ", Crypto::LastErrorMessage());
+		}
+		CHECK(received == data && !connection.queueing());
+		CHECK(FileSystem::Delete(ex, name) && !ex);
+	} else
+		CHECK(!connection.canSendFile()); // kernel TLS unavailable (tls module or OpenSSL without kTLS) => skipped
+
+	SSL_free(ssl);
+	SSL_CTX_free(pCTX);
+}
 
 ADD_TEST(TestTCPLoad) {
 	Exception ex;